@@ -752,6 +752,21 @@ AC_DEFUN([AX_PROG_BINUTILS],
            ]
 	 )
 
+         # BFD can only be called from several threads since binutils 2.42
+         AC_MSG_CHECKING([whether bfd_thread_init is defined in bfd.h])
+	 AC_LINK_IFELSE(
+	   [AC_LANG_PROGRAM([[ #include <bfd.h> ]],
+             [[
+	         bool res = bfd_thread_init ((bfd_lock_unlock_fn_type) 0, (bfd_lock_unlock_fn_type) 0, (void*)0);
+	     ]])],
+           [
+	     AC_DEFINE(HAVE_BFD_THREAD_INIT, [1], [Defined to 1 if bfd.h contains bfd_thread_init])
+             AC_MSG_RESULT([yes])
+	   ],[
+	     AC_MSG_RESULT([no])
+           ]
+	 )
+
       else
          AC_MSG_RESULT([no, see config.log for further details])
       fi
@@ -1442,6 +1457,73 @@ AC_DEFUN([AX_CHECK_LIBZ],
    AX_FLAGS_RESTORE()
 ])
 
+# AX_CHECK_LIBZSTD
+# ------------
+AC_DEFUN([AX_CHECK_LIBZSTD],
+[
+   AX_FLAGS_SAVE()
+
+   AC_ARG_WITH(zstd,
+      AC_HELP_STRING(
+         [--with-zstd@<:@=DIR@:>@],
+         [specify where to find zstd libraries and includes]
+      ),
+      [zstd_paths="${withval}"],
+      [zstd_paths="/usr/local /usr"] dnl List of possible default paths
+   )
+
+   ZSTD_HOME=""
+   if test "${zstd_paths}" != "no" ; then
+      for zstdhome_dir in [${zstd_paths} "not found"]; do
+         if test -f "${zstdhome_dir}/include/zstd.h" ; then
+            for zstdlib_dir in lib${BITS} lib/${multiarch_triplet} lib ; do
+               if test -f "${zstdhome_dir}/${zstdlib_dir}/libzstd.a" -o \
+                       -f "${zstdhome_dir}/${zstdlib_dir}/libzstd.so" -o \
+                       -f "${zstdhome_dir}/${zstdlib_dir}/libzstd.dylib" ; then
+                  ZSTD_HOME="${zstdhome_dir}"
+                  ZSTD_LIBSDIR="${zstdhome_dir}/${zstdlib_dir}"
+                  break
+               fi
+            done
+            if test -n "${ZSTD_HOME}" ; then
+               break
+            fi
+         fi
+      done
+   fi
+
+   ZSTD_INSTALLED="no"
+   if test -n "${ZSTD_HOME}" ; then
+      ZSTD_CFLAGS="-I${ZSTD_HOME}/include"
+      ZSTD_LIBS="-lzstd"
+      ZSTD_LDFLAGS="-L${ZSTD_LIBSDIR}"
+      ZSTD_SHAREDLIBSDIR=${ZSTD_LIBSDIR}
+
+      CFLAGS="${CFLAGS} ${ZSTD_CFLAGS}"
+      LIBS="${LIBS} ${ZSTD_LIBS}"
+      LDFLAGS="${LDFLAGS} ${ZSTD_LDFLAGS}"
+
+      AC_CHECK_LIB(zstd, ZSTD_compress, [zstd_cv_libzstd=yes], [zstd_cv_libzstd=no])
+      AC_CHECK_HEADER(zstd.h, [zstd_cv_zstd_h=yes], [zstd_cv_zstd_h=no])
+
+      if test "${zstd_cv_libzstd}" = "yes" -a "${zstd_cv_zstd_h}" = "yes" ; then
+         AC_DEFINE([HAVE_ZSTD], [1], [Zstd available])
+         ZSTD_INSTALLED="yes"
+      fi
+   fi
+
+   AC_SUBST(ZSTD_HOME)
+   AC_SUBST(ZSTD_CFLAGS)
+   AC_SUBST(ZSTD_LIBSDIR)
+   AC_SUBST(ZSTD_SHAREDLIBSDIR)
+   AC_SUBST(ZSTD_LIBS)
+   AC_SUBST(ZSTD_LDFLAGS)
+
+   AM_CONDITIONAL(HAVE_ZSTD, test "${ZSTD_INSTALLED}" = "yes")
+
+   AX_FLAGS_RESTORE()
+])
+
 # AX_PROG_LIBEXECINFO
 # -------------
 AC_DEFUN([AX_PROG_LIBEXECINFO],
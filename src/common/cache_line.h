@@ -0,0 +1,91 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#ifndef _CACHE_LINE_H_
+#define _CACHE_LINE_H_
+
+#ifdef HAVE_STDIO_H
+# include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
+
+#include "debug.h"
+
+/* Per-thread state that is written on every event is kept in arrays of
+   slots, where each slot spans a whole number of cache lines. This way a
+   thread updating its own slot does not invalidate the slots of the other
+   threads (false sharing). Declare the slots as
+
+     typedef union
+     {
+       my_state_t s;
+       char pad[EXTRAE_CACHE_LINE_ROUNDUP(sizeof(my_state_t))];
+     } my_slot_t;
+
+   and (re)allocate the arrays with Extrae_CacheLine_Realloc. */
+
+#if !defined(EXTRAE_CACHE_LINE_SIZE)
+# define EXTRAE_CACHE_LINE_SIZE 64
+#endif
+
+#define EXTRAE_CACHE_LINE_ROUNDUP(size) \
+	((((size) + EXTRAE_CACHE_LINE_SIZE - 1) / EXTRAE_CACHE_LINE_SIZE) * EXTRAE_CACHE_LINE_SIZE)
+
+/**
+ * Resizes an array of slots keeping it aligned to the cache line size. The
+ * contents of the first old_size bytes are kept and the rest is zeroed.
+ * \param ptr The array to resize (may be NULL).
+ * \param old_size The size in bytes of the array pointed by ptr.
+ * \param new_size The requested size in bytes.
+ * \return The resized array.
+ */
+static __inline void * Extrae_CacheLine_Realloc (void *ptr, size_t old_size,
+	size_t new_size)
+{
+	void *res;
+
+#if defined(HAVE_POSIX_MEMALIGN)
+	if (posix_memalign (&res, EXTRAE_CACHE_LINE_SIZE, new_size) != 0)
+		res = NULL;
+#else
+	res = malloc (new_size);
+#endif
+	ASSERT(res != NULL, "Error allocating memory.");
+
+	if (ptr != NULL)
+		memcpy (res, ptr, (old_size < new_size) ? old_size : new_size);
+	else
+		old_size = 0;
+	if (new_size > old_size)
+		memset (((char *) res) + old_size, 0, new_size - old_size);
+	free (ptr);
+
+	return res;
+}
+
+#endif /* _CACHE_LINE_H_ */
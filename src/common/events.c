@@ -93,7 +93,7 @@ unsigned IsMPI (unsigned EvType)
 /******************************************************************************
  ***  IsMISC
  ******************************************************************************/
-#define MISC_EVENTS 69
+#define MISC_EVENTS 70
 static unsigned misc_events[] = {FLUSH_EV, OPEN_EV, FOPEN_EV, READ_EV, WRITE_EV, FREAD_EV, FWRITE_EV, 
         PREAD_EV, PWRITE_EV, READV_EV, WRITEV_EV, PREADV_EV, PWRITEV_EV, APPL_EV, USER_EV,
 	HWC_DEF_EV, HWC_CHANGE_EV, HWC_EV, TRACING_EV, SET_TRACE_EV, CALLER_EV,
@@ -109,7 +109,7 @@ static unsigned misc_events[] = {FLUSH_EV, OPEN_EV, FOPEN_EV, READ_EV, WRITE_EV,
 	MEMKIND_MALLOC_EV, MEMKIND_CALLOC_EV, MEMKIND_REALLOC_EV, MEMKIND_POSIX_MEMALIGN_EV, MEMKIND_FREE_EV,
 	MEMKIND_PARTITION_EV, SYSCALL_EV,
 	KMPC_MALLOC_EV, KMPC_FREE_EV, KMPC_CALLOC_EV, KMPC_REALLOC_EV, KMPC_ALIGNED_MALLOC_EV,
-	IOCTL_EV
+	IOCTL_EV, IO_STATS_EV
  };
 
 unsigned IsMISC (unsigned EvType)
@@ -155,12 +155,12 @@ unsigned IsOpenMP (unsigned EvType)
 /******************************************************************************
  ***  IsPthread
  ******************************************************************************/
-#define PTHREAD_EVENTS 14
+#define PTHREAD_EVENTS 15
 static unsigned pthread_events[] = { PTHREAD_CREATE_EV, PTHREAD_JOIN_EV,
 	PTHREAD_DETACH_EV, PTHREAD_FUNC_EV, PTHREAD_RWLOCK_WR_EV, PTHREAD_RWLOCK_RD_EV,
 	PTHREAD_RWLOCK_UNLOCK_EV, PTHREAD_MUTEX_LOCK_EV, PTHREAD_MUTEX_UNLOCK_EV,
 	PTHREAD_COND_SIGNAL_EV, PTHREAD_COND_BROADCAST_EV, PTHREAD_COND_WAIT_EV,
-	PTHREAD_EXIT_EV, PTHREAD_BARRIER_WAIT_EV };
+	PTHREAD_EXIT_EV, PTHREAD_BARRIER_WAIT_EV, PTHREAD_LOCK_STATS_EV };
 
 unsigned IsPthread (unsigned EvType)
 {
@@ -433,3 +433,34 @@ EventType_t getEventType (unsigned EvType, unsigned *Type)
 	return FALSE;
 }
 
+/******************************************************************************
+ ***  getEventTypeRanges
+ ***  Calls 'range' for every event (or range of events) classified by
+ ***  getEventType, so that its users can precompute it.
+ ******************************************************************************/
+
+void getEventTypeRanges (void (*range)(unsigned min, unsigned max))
+{
+	unsigned evt;
+
+	for (evt = 0; evt < MPI_EVENTS; evt++)
+		range (mpi_events[evt], mpi_events[evt]);
+	range (CALLER_EV, CALLER_EV+MAX_CALLERS);
+	range (SAMPLING_EV, SAMPLING_EV+MAX_CALLERS);
+	for (evt = 0; evt < MISC_EVENTS; evt++)
+		range (misc_events[evt], misc_events[evt]);
+	for (evt = 0; evt < OMP_EVENTS; evt++)
+		range (omp_events[evt], omp_events[evt]);
+	for (evt = 0; evt < PTHREAD_EVENTS; evt++)
+		range (pthread_events[evt], pthread_events[evt]);
+	for (evt = 0; evt < CUDA_EVENTS; evt++)
+		range (cuda_events[evt], cuda_events[evt]);
+	for (evt = 0; evt < OPENCL_EVENTS; evt++)
+		range (opencl_events[evt], opencl_events[evt]);
+	for (evt = 0; evt < OPENSHMEM_EVENTS; evt++)
+		range (openshmem_events[evt], openshmem_events[evt]);
+	for (evt = 0; evt < JAVA_EVENTS; evt++)
+		range (java_events[evt], java_events[evt]);
+	range (MPI_ALIAS_COMM_CREATE_EV, MPI_ALIAS_COMM_CREATE_EV);
+}
+
@@ -204,6 +204,7 @@ enum
 #define FOPEN_EV                 40000061
 #define IOCTL_EV                 40000067
 #define IOCTL_REQUEST_EV         40000068
+#define IO_STATS_EV              40000071
 
 #define ADDRESSES_FOR_BINARY_EV  41000000
 
@@ -238,6 +239,21 @@ enum {
    MEMUSAGE_EVENTS_COUNT /* Total number of memusage events */
 };
 
+#define IO_STATS_BASE            47000000
+#define IO_STATS_HISTOGRAM_BINS  32 /* log2 buckets of the call size, the last one is open */
+enum {
+   IO_STATS_DESCRIPTOR_EV = 0,
+   IO_STATS_READ_CALLS_EV,
+   IO_STATS_READ_BYTES_EV,
+   IO_STATS_READ_TIME_EV,
+   IO_STATS_WRITE_CALLS_EV,
+   IO_STATS_WRITE_BYTES_EV,
+   IO_STATS_WRITE_TIME_EV,
+   IO_STATS_READ_HISTOGRAM_EV,
+   IO_STATS_WRITE_HISTOGRAM_EV = IO_STATS_READ_HISTOGRAM_EV + IO_STATS_HISTOGRAM_BINS,
+   IO_STATS_EVENTS_COUNT = IO_STATS_WRITE_HISTOGRAM_EV + IO_STATS_HISTOGRAM_BINS
+};
+
 #define JAVA_JVMTI_GARBAGECOLLECTOR_EV     48000001
 #define JAVA_JVMTI_EXCEPTION_EV            48000002
 #define JAVA_JVMTI_OBJECT_ALLOC_EV         48000003
@@ -555,6 +571,21 @@ enum {
 #define PTHREAD_COND_BROADCAST_EV  61000011
 #define PTHREAD_COND_WAIT_EV       61000012
 #define PTHREAD_BARRIER_WAIT_EV    61000013
+#define PTHREAD_LOCK_STATS_EV      61000014
+
+#define PTHREAD_LOCK_STATS_BASE    61100000
+enum {
+   PTHREAD_LOCK_STATS_ADDRESS_EV = 0,
+   PTHREAD_LOCK_STATS_KIND_EV,
+   PTHREAD_LOCK_STATS_CALLER_EV,
+   PTHREAD_LOCK_STATS_ACQUISITIONS_EV,
+   PTHREAD_LOCK_STATS_CONTENDED_EV,
+   PTHREAD_LOCK_STATS_WAIT_TIME_EV,
+   PTHREAD_LOCK_STATS_HOLD_TIME_EV,
+   PTHREAD_LOCK_STATS_OBJECT_EV,      /* Only emitted by the merger */
+   PTHREAD_LOCK_STATS_CALLER_LINE_EV, /* Only emitted by the merger */
+   PTHREAD_LOCK_STATS_EVENTS_COUNT
+};
 
 #define PTHREAD_FUNC_EV          60000020
 #define PTHREAD_FUNC_LINE_EV     60000120
@@ -1036,5 +1067,6 @@ typedef enum
 } ExtraeDescriptorType_t;
 
 EventType_t getEventType (unsigned EvType, unsigned *Type);
+void getEventTypeRanges (void (*range)(unsigned min, unsigned max));
 
 #endif /* __EVENTS_H_INCLUDED__ */
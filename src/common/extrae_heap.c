@@ -0,0 +1,142 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include "common.h"
+#include "extrae_heap.h"
+
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#ifdef HAVE_STDIO_H
+# include <stdio.h>
+#endif
+
+#include "debug.h"
+
+#define EXTRAE_HEAP_ALLOC_SIZE 32
+
+#define LESS_THAN(a,b) \
+	((a)->key < (b)->key || \
+	 ((a)->key == (b)->key && ((a)->tie < (b)->tie || \
+	   ((a)->tie == (b)->tie && (a)->id < (b)->id))))
+
+static void Extrae_Heap_SiftUp (Extrae_Heap_t *h, unsigned pos)
+{
+	Extrae_Heap_Item_t item = h->items[pos];
+
+	while (pos > 0)
+	{
+		unsigned parent = (pos-1)/2;
+		if (!LESS_THAN(&item, &h->items[parent]))
+			break;
+		h->items[pos] = h->items[parent];
+		pos = parent;
+	}
+	h->items[pos] = item;
+}
+
+static void Extrae_Heap_SiftDown (Extrae_Heap_t *h, unsigned pos)
+{
+	Extrae_Heap_Item_t item = h->items[pos];
+
+	while (2*pos+1 < h->count)
+	{
+		unsigned child = 2*pos+1;
+		if (child+1 < h->count && LESS_THAN(&h->items[child+1], &h->items[child]))
+			child++;
+		if (!LESS_THAN(&h->items[child], &item))
+			break;
+		h->items[pos] = h->items[child];
+		pos = child;
+	}
+	h->items[pos] = item;
+}
+
+void Extrae_Heap_Init (Extrae_Heap_t *h)
+{
+	h->items = NULL;
+	h->count = h->allocated = 0;
+}
+
+void Extrae_Heap_Destroy (Extrae_Heap_t *h)
+{
+	if (h->items != NULL)
+		free (h->items);
+	h->items = NULL;
+	h->count = h->allocated = 0;
+}
+
+void Extrae_Heap_Clear (Extrae_Heap_t *h)
+{
+	h->count = 0;
+}
+
+void Extrae_Heap_Push (Extrae_Heap_t *h, unsigned long long key, int tie,
+	unsigned id)
+{
+	if (h->count == h->allocated)
+	{
+		h->items = (Extrae_Heap_Item_t*) realloc (
+		  h->items, (h->allocated+EXTRAE_HEAP_ALLOC_SIZE)*sizeof(Extrae_Heap_Item_t));
+		if (h->items == NULL)
+		{
+			fprintf (stderr, "Extrae (%s,%d): Fatal error! Cannot allocate memory for Extrae_Heap_Push\n", __FILE__, __LINE__);
+			exit (-1);
+		}
+		h->allocated += EXTRAE_HEAP_ALLOC_SIZE;
+	}
+	h->items[h->count].key = key;
+	h->items[h->count].tie = tie;
+	h->items[h->count].id = id;
+	h->count++;
+	Extrae_Heap_SiftUp (h, h->count-1);
+}
+
+unsigned Extrae_Heap_Count (Extrae_Heap_t *h)
+{
+	return h->count;
+}
+
+Extrae_Heap_Item_t * Extrae_Heap_Top (Extrae_Heap_t *h)
+{
+	return (h->count > 0) ? &h->items[0] : NULL;
+}
+
+void Extrae_Heap_Pop (Extrae_Heap_t *h)
+{
+	ASSERT(h->count>0, "Extrae_Heap_Pop on an empty heap")
+	h->count--;
+	if (h->count > 0)
+	{
+		h->items[0] = h->items[h->count];
+		Extrae_Heap_SiftDown (h, 0);
+	}
+}
+
+void Extrae_Heap_UpdateTop (Extrae_Heap_t *h, unsigned long long key, int tie)
+{
+	ASSERT(h->count>0, "Extrae_Heap_UpdateTop on an empty heap")
+	h->items[0].key = key;
+	h->items[0].tie = tie;
+	Extrae_Heap_SiftDown (h, 0);
+}
@@ -0,0 +1,72 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#ifndef _EXTRAE_HEAP_H_
+
+#define _EXTRAE_HEAP_H_
+
+/* Binary min-heap used to merge several sorted streams. Every stream is
+   identified by its id and is ordered by its key, then by its tie value and
+   then by its id, so that the minimum is the same that a linear scan over
+   the streams would select. */
+
+typedef struct Extrae_Heap_Item_st
+{
+	unsigned long long key;
+	int tie;
+	unsigned id;
+} Extrae_Heap_Item_t;
+
+typedef struct Extrae_Heap_st
+{
+	Extrae_Heap_Item_t *items;
+	unsigned count;
+	unsigned allocated;
+} Extrae_Heap_t;
+
+/* Initialize heap structure */
+void Extrae_Heap_Init (Extrae_Heap_t *h);
+
+/* Destroy heap structure */
+void Extrae_Heap_Destroy (Extrae_Heap_t *h);
+
+/* Remove all the elements but keep the allocated memory */
+void Extrae_Heap_Clear (Extrae_Heap_t *h);
+
+/* Add a new stream into the structure */
+void Extrae_Heap_Push (Extrae_Heap_t *h, unsigned long long key, int tie,
+	unsigned id);
+
+/* Get the number of streams within the structure */
+unsigned Extrae_Heap_Count (Extrae_Heap_t *h);
+
+/* Get the minimum stream (NULL if empty) */
+Extrae_Heap_Item_t * Extrae_Heap_Top (Extrae_Heap_t *h);
+
+/* Remove the minimum stream */
+void Extrae_Heap_Pop (Extrae_Heap_t *h);
+
+/* Change the key of the minimum stream after it has advanced */
+void Extrae_Heap_UpdateTop (Extrae_Heap_t *h, unsigned long long key, int tie);
+
+#endif /* _EXTRAE_HEAP_H_ */
@@ -0,0 +1,230 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include "common.h"
+
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
+
+#include "mpit_events.h"
+
+#define FLAG_VALUE       (1 << 0)  /* value is not zero */
+#define FLAG_PARAMS      (1 << 1)  /* some word of the parameters is not zero */
+#define FLAG_HWC         (1 << 2)  /* counters were read */
+#define FLAG_SAME_TYPE   (1 << 3)  /* type of the previous event */
+
+#define PARAM_WORDS      (sizeof(u_param)/sizeof(UINT32))
+#define HWC_MASK_BYTES   ((MAX_HWC+7)/8)
+
+#define ZIGZAG(x)    ((((UINT64)(x)) << 1) ^ ((UINT64)(((INT64)(x)) >> 63)))
+#define UNZIGZAG(x)  ((INT64)(((x) >> 1) ^ (~((x) & 1) + 1)))
+
+static unsigned char * put_varint (unsigned char *p, UINT64 v)
+{
+	while (v >= 0x80)
+	{
+		*p++ = (unsigned char) (v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (unsigned char) v;
+	return p;
+}
+
+static const unsigned char * get_varint (const unsigned char *p,
+	const unsigned char *end, UINT64 *v)
+{
+	UINT64 res = 0;
+	unsigned shift;
+
+	for (shift = 0; p < end && shift < 64; shift += 7)
+	{
+		unsigned char b = *p++;
+
+		res |= ((UINT64) (b & 0x7f)) << shift;
+		if (!(b & 0x80))
+		{
+			*v = res;
+			return p;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Encodes a block of events.
+ * \param events The events
+ * \param n Number of events
+ * \param block Where to leave the block, at least MPIT_BLOCK_MAX_SIZE(n) bytes
+ * \return The size of the block, header included
+ */
+size_t MPIT_Events_Encode (const event_t *events, unsigned n, unsigned char *block)
+{
+	unsigned char *p = block + sizeof(MPIT_Block_t);
+	MPIT_Block_t header;
+	UINT64 time = 0;
+	INT32 type = 0;
+	unsigned i, j;
+
+	for (i = 0; i < n; i++)
+	{
+		const event_t *ev = &events[i];
+		unsigned char *flags = p++;
+		UINT32 words[PARAM_WORDS];
+		unsigned char mask;
+
+		*flags = 0;
+		p = put_varint (p, ZIGZAG(ev->time - time));
+		time = ev->time;
+
+		if (i > 0 && ev->event == type)
+			*flags |= FLAG_SAME_TYPE;
+		else
+			p = put_varint (p, ZIGZAG(ev->event));
+		type = ev->event;
+
+		if (ev->value != 0)
+		{
+			*flags |= FLAG_VALUE;
+			p = put_varint (p, ev->value);
+		}
+
+		memcpy (words, &(ev->param), sizeof(u_param));
+		for (j = 0, mask = 0; j < PARAM_WORDS; j++)
+			if (words[j] != 0)
+				mask |= 1 << j;
+		if (mask != 0)
+		{
+			*flags |= FLAG_PARAMS;
+			*p++ = mask;
+			for (j = 0; j < PARAM_WORDS; j++)
+				if (words[j] != 0)
+					p = put_varint (p, words[j]);
+		}
+
+		/* Counters are only meaningful if they were read */
+		if (ev->HWCReadSet != 0)
+		{
+			unsigned char *hwc_mask = p;
+
+			*flags |= FLAG_HWC;
+			p = put_varint (p + HWC_MASK_BYTES, ZIGZAG(ev->HWCReadSet));
+			memset (hwc_mask, 0, HWC_MASK_BYTES);
+			for (j = 0; j < MAX_HWC; j++)
+				if (ev->HWCValues[j] != 0)
+				{
+					hwc_mask[j/8] |= 1 << (j%8);
+					p = put_varint (p, ZIGZAG(ev->HWCValues[j]));
+				}
+		}
+	}
+
+	header.NumEvents = n;
+	header.Size = (p - block) - sizeof(MPIT_Block_t);
+	memcpy (block, &header, sizeof(MPIT_Block_t));
+
+	return p - block;
+}
+
+/**
+ * Decodes a block of events.
+ * \param header The header of the block
+ * \param data The header->Size bytes that follow the header
+ * \param events Where to leave the header->NumEvents events
+ * \return 0 on success, -1 if the block is malformed
+ */
+int MPIT_Events_Decode (const MPIT_Block_t *header, const unsigned char *data,
+	event_t *events)
+{
+	const unsigned char *p = data, *end = data + header->Size;
+	UINT64 time = 0, v;
+	INT32 type = 0;
+	unsigned i, j;
+
+	for (i = 0; i < header->NumEvents; i++)
+	{
+		event_t *ev = &events[i];
+		UINT32 words[PARAM_WORDS];
+		unsigned char flags;
+
+		if (p >= end)
+			return -1;
+		flags = *p++;
+
+		if ((p = get_varint (p, end, &v)) == NULL)
+			return -1;
+		time += UNZIGZAG(v);
+		ev->time = time;
+
+		if (!(flags & FLAG_SAME_TYPE))
+		{
+			if ((p = get_varint (p, end, &v)) == NULL)
+				return -1;
+			type = (INT32) UNZIGZAG(v);
+		}
+		ev->event = type;
+
+		ev->value = 0;
+		if ((flags & FLAG_VALUE) && (p = get_varint (p, end, &(ev->value))) == NULL)
+			return -1;
+
+		memset (words, 0, sizeof(words));
+		if (flags & FLAG_PARAMS)
+		{
+			unsigned char mask;
+
+			if (p >= end)
+				return -1;
+			mask = *p++;
+			for (j = 0; j < PARAM_WORDS; j++)
+				if (mask & (1 << j))
+				{
+					if ((p = get_varint (p, end, &v)) == NULL)
+						return -1;
+					words[j] = (UINT32) v;
+				}
+		}
+		memcpy (&(ev->param), words, sizeof(u_param));
+
+		ev->HWCReadSet = 0;
+		memset (ev->HWCValues, 0, sizeof(ev->HWCValues));
+		if (flags & FLAG_HWC)
+		{
+			const unsigned char *hwc_mask = p;
+
+			if (p + HWC_MASK_BYTES > end ||
+			    (p = get_varint (p + HWC_MASK_BYTES, end, &v)) == NULL)
+				return -1;
+			ev->HWCReadSet = (INT32) UNZIGZAG(v);
+			for (j = 0; j < MAX_HWC; j++)
+				if (hwc_mask[j/8] & (1 << (j%8)))
+				{
+					if ((p = get_varint (p, end, &v)) == NULL)
+						return -1;
+					ev->HWCValues[j] = UNZIGZAG(v);
+				}
+		}
+	}
+
+	return (p == end) ? 0 : -1;
+}
@@ -0,0 +1,58 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#ifndef __MPIT_EVENTS_H__
+#define __MPIT_EVENTS_H__
+
+#include "record.h"
+
+/*
+ * Compact encoding of the events (MPIT_VERSION_COMPACT). After the header,
+ * the file is a sequence of blocks, each one a MPIT_Block_t followed by
+ * Size bytes with NumEvents encoded events. Blocks can be decoded on their
+ * own, so the buffers of a thread (and their caches) can append blocks to
+ * the same file in any order.
+ *
+ * Each event stores a flags byte, its time as a varint delta from the
+ * previous event of the block, and then its type (unless it repeats), its
+ * value, the non-zero 32-bit words of its parameters and its hardware
+ * counters, each of them only if present.
+ */
+
+typedef struct
+{
+	UINT32 NumEvents;
+	UINT32 Size;
+} MPIT_Block_t;
+
+#define MPIT_EVENT_MAX_SIZE \
+	(1 + 10 + 5 + 10 + 1 + 5*(sizeof(u_param)/sizeof(UINT32)) + \
+	 5 + (MAX_HWC+7)/8 + 10*MAX_HWC)
+#define MPIT_BLOCK_MAX_SIZE(n) \
+	(sizeof(MPIT_Block_t) + (size_t)(n)*MPIT_EVENT_MAX_SIZE)
+
+size_t MPIT_Events_Encode (const event_t *events, unsigned n, unsigned char *block);
+int MPIT_Events_Decode (const MPIT_Block_t *header, const unsigned char *data,
+	event_t *events);
+
+#endif /* __MPIT_EVENTS_H__ */
@@ -28,7 +28,11 @@
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
 #include "mpit_header.h"
+#include "num_hwc.h"
 #include "utils.h"
 
 MPIT_Header_t * new_MPIT_Header()
@@ -39,6 +43,17 @@ MPIT_Header_t * new_MPIT_Header()
 	return new_header;
 }
 
+/* Fills the fields that tell how the events of the file are encoded */
+void MPIT_Header_Init(MPIT_Header_t * header)
+{
+	memset(header, 0, sizeof(MPIT_Header_t));
+	header->Signature = MPIT_SIGNATURE;
+	header->Version = MPIT_VERSION;
+	header->Endianness = MPIT_ENDIANNESS;
+	header->bits = sizeof(void*) * 8;
+	header->HWCs = MAX_HWC;
+}
+
 void free_MPIT_Header(MPIT_Header_t * header)
 {
 	xfree(header);
@@ -70,3 +85,32 @@ MPIT_Header_t * MPIT_Header_Read(int fd)
 	return header;
 }
 
+/* Returns the encoding of the events of the file (MPIT_VERSION_*), or
+   MPIT_VERSION_INCOMPATIBLE if they were written by an incompatible tracer,
+   or MPIT_VERSION_OTHER_ENDIANNESS if they were written with a header on a
+   host of the other endianness */
+int MPIT_Header_Version(int fd)
+{
+	off_t prev_offset;
+	MPIT_Header_t header;
+	ssize_t res;
+
+	prev_offset = lseek(fd, 0, SEEK_CUR);
+	lseek(fd, 0, SEEK_SET);
+	res = read(fd, &header, sizeof(MPIT_Header_t));
+	lseek(fd, prev_offset, SEEK_SET);
+
+	/* Files from older tracers have no header and start with an event */
+	if (res != sizeof(MPIT_Header_t))
+		return MPIT_VERSION_RAW;
+	if (header.Signature == MPIT_SIGNATURE_SWAPPED)
+		return MPIT_VERSION_OTHER_ENDIANNESS;
+	if (header.Signature != MPIT_SIGNATURE)
+		return MPIT_VERSION_RAW;
+
+	if (header.Endianness != MPIT_ENDIANNESS || header.HWCs != MAX_HWC ||
+	    header.Version <= MPIT_VERSION_RAW || header.Version > MPIT_VERSION)
+		return MPIT_VERSION_INCOMPATIBLE;
+
+	return header.Version;
+}
@@ -42,6 +42,28 @@ typedef struct
 	int ConfigXML;
 } MPIT_Header_t;
 
+#define MPIT_SIGNATURE          0x5449504D  /* "MPIT" */
+#define MPIT_SIGNATURE_SWAPPED  0x4D504954  /* Written on a host of the other endianness */
+#define MPIT_ENDIANNESS         0x01020304
+
+/* Encodings of the events in the .mpit (and .sample/.online) files. Files
+   without a header are plain arrays of event_t. The header and the blocks of
+   the compact files are written in the byte order of the tracer host */
+#define MPIT_VERSION_RAW      0
+#define MPIT_VERSION_COMPACT  1      /* Blocks of encoded events, see mpit_events.h */
+#define MPIT_VERSION          MPIT_VERSION_COMPACT
+
+/* Errors returned by MPIT_Header_Version */
+#define MPIT_VERSION_INCOMPATIBLE     (-1)
+#define MPIT_VERSION_OTHER_ENDIANNESS (-2)
+
+MPIT_Header_t * new_MPIT_Header (void);
+void free_MPIT_Header (MPIT_Header_t * header);
+void MPIT_Header_Init (MPIT_Header_t * header);
+void MPIT_Header_Write (int fd, MPIT_Header_t * header);
+MPIT_Header_t * MPIT_Header_Read (int fd);
+int MPIT_Header_Version (int fd);
+
 /*
  Write header
 ??? Si buffer circular emitir un 1er evento que sea una marca de buffer overflow para controlar si es un pedazo de traza intermedio... 
@@ -32,13 +32,24 @@
 
 #include "object_tree.h"
 
+/* The regions are kept in an AVL tree ordered by AddressBegin and augmented
+   with the highest AddressEnd of every subtree (an interval tree), so that
+   adding, removing and finding the region that contains an address take
+   O(log n). Nodes live in a single array and are linked by index, and
+   removed nodes are chained in a free list for reuse. */
+
+#define REGION_NIL ((uint32_t)-1)
+
 struct AddressSpaceRegion_st
 {
 	uint64_t AddressBegin;
 	uint64_t AddressEnd;
+	uint64_t MaxAddressEnd; /* Highest AddressEnd in this subtree */
 	uint64_t CallerAddresses[MAX_CALLERS];
 	uint32_t CallerType;
-	int in_use;
+	uint32_t left;          /* Also links the free list */
+	uint32_t right;
+	int height;
 };
 
 struct AddressSpace_st
@@ -46,10 +57,15 @@ struct AddressSpace_st
 	struct AddressSpaceRegion_st *Regions;
 	uint32_t nRegions;  /* number of regions */
 	uint32_t aRegions;  /* number of allocated regions */
+	uint32_t root;
+	uint32_t freeRegions;
 };
 
 #define ADDRESS_SPACE_ALLOC_SIZE 256
 
+#define HEIGHT(as,n)  ((n) == REGION_NIL ? 0 : (as)->Regions[n].height)
+#define MAXEND(as,n)  ((n) == REGION_NIL ? 0 : (as)->Regions[n].MaxAddressEnd)
+
 struct AddressSpace_st* AddressSpace_create (void)
 {
 	struct AddressSpace_st * as = (struct AddressSpace_st*) malloc (
@@ -61,20 +77,142 @@ struct AddressSpace_st* AddressSpace_create (void)
 	}
 	as->Regions = NULL;
 	as->nRegions = as->aRegions = 0;
+	as->root = as->freeRegions = REGION_NIL;
 	return as;
 }
 
+static void AddressSpace_update (struct AddressSpace_st *as, uint32_t n)
+{
+	struct AddressSpaceRegion_st *r = &as->Regions[n];
+	int hl = HEIGHT(as, r->left), hr = HEIGHT(as, r->right);
+	uint64_t ml = MAXEND(as, r->left), mr = MAXEND(as, r->right);
+
+	r->height = 1 + (hl > hr ? hl : hr);
+	r->MaxAddressEnd = r->AddressEnd;
+	if (ml > r->MaxAddressEnd)
+		r->MaxAddressEnd = ml;
+	if (mr > r->MaxAddressEnd)
+		r->MaxAddressEnd = mr;
+}
+
+static uint32_t AddressSpace_rotateRight (struct AddressSpace_st *as, uint32_t n)
+{
+	uint32_t l = as->Regions[n].left;
+
+	as->Regions[n].left = as->Regions[l].right;
+	as->Regions[l].right = n;
+	AddressSpace_update (as, n);
+	AddressSpace_update (as, l);
+	return l;
+}
+
+static uint32_t AddressSpace_rotateLeft (struct AddressSpace_st *as, uint32_t n)
+{
+	uint32_t r = as->Regions[n].right;
+
+	as->Regions[n].right = as->Regions[r].left;
+	as->Regions[r].left = n;
+	AddressSpace_update (as, n);
+	AddressSpace_update (as, r);
+	return r;
+}
+
+static uint32_t AddressSpace_balance (struct AddressSpace_st *as, uint32_t n)
+{
+	struct AddressSpaceRegion_st *r;
+	int balance;
+
+	AddressSpace_update (as, n);
+	r = &as->Regions[n];
+	balance = HEIGHT(as, r->left) - HEIGHT(as, r->right);
+
+	if (balance > 1)
+	{
+		uint32_t l = r->left;
+		if (HEIGHT(as, as->Regions[l].left) < HEIGHT(as, as->Regions[l].right))
+			r->left = AddressSpace_rotateLeft (as, l);
+		return AddressSpace_rotateRight (as, n);
+	}
+	else if (balance < -1)
+	{
+		uint32_t rr = r->right;
+		if (HEIGHT(as, as->Regions[rr].right) < HEIGHT(as, as->Regions[rr].left))
+			r->right = AddressSpace_rotateRight (as, rr);
+		return AddressSpace_rotateLeft (as, n);
+	}
+	return n;
+}
+
+static uint32_t AddressSpace_insert (struct AddressSpace_st *as, uint32_t n,
+	uint32_t node)
+{
+	if (n == REGION_NIL)
+		return node;
+
+	if (as->Regions[node].AddressBegin < as->Regions[n].AddressBegin)
+		as->Regions[n].left = AddressSpace_insert (as, as->Regions[n].left, node);
+	else
+		as->Regions[n].right = AddressSpace_insert (as, as->Regions[n].right, node);
+
+	return AddressSpace_balance (as, n);
+}
+
+/* Unlinks the leftmost node of the subtree n and returns it through min */
+static uint32_t AddressSpace_unlinkMin (struct AddressSpace_st *as, uint32_t n,
+	uint32_t *min)
+{
+	if (as->Regions[n].left == REGION_NIL)
+	{
+		*min = n;
+		return as->Regions[n].right;
+	}
+
+	as->Regions[n].left = AddressSpace_unlinkMin (as, as->Regions[n].left, min);
+	return AddressSpace_balance (as, n);
+}
+
+static uint32_t AddressSpace_delete (struct AddressSpace_st *as, uint32_t n,
+	uint64_t AddressBegin, uint32_t *deleted)
+{
+	if (n == REGION_NIL)
+		return REGION_NIL;
+
+	if (AddressBegin < as->Regions[n].AddressBegin)
+		as->Regions[n].left = AddressSpace_delete (as, as->Regions[n].left,
+		  AddressBegin, deleted);
+	else if (AddressBegin > as->Regions[n].AddressBegin)
+		as->Regions[n].right = AddressSpace_delete (as, as->Regions[n].right,
+		  AddressBegin, deleted);
+	else
+	{
+		uint32_t l = as->Regions[n].left, r = as->Regions[n].right, min;
+
+		*deleted = n;
+		if (r == REGION_NIL)
+			return l;
+
+		/* Replace the node by its in-order successor */
+		r = AddressSpace_unlinkMin (as, r, &min);
+		as->Regions[min].left = l;
+		as->Regions[min].right = r;
+		return AddressSpace_balance (as, min);
+	}
+
+	return AddressSpace_balance (as, n);
+}
+
 void AddressSpace_add (struct AddressSpace_st *as, uint64_t AddressBegin,
 	uint64_t AddressEnd, uint64_t *CallerAddresses,
 	uint32_t CallerType)
 {
-	unsigned u;
+	struct AddressSpaceRegion_st *r;
+	uint32_t u;
 	unsigned v;
 
-	if (as->nRegions == as->aRegions)
+	if (as->freeRegions == REGION_NIL)
 	{
 		as->Regions = (struct AddressSpaceRegion_st *) realloc (as->Regions,
-		  (as->nRegions+ADDRESS_SPACE_ALLOC_SIZE)*sizeof(struct AddressSpaceRegion_st));
+		  (as->aRegions+ADDRESS_SPACE_ALLOC_SIZE)*sizeof(struct AddressSpaceRegion_st));
 		if (NULL == as->Regions)
 		{
 			fprintf (stderr, PACKAGE_NAME": Error! Cannot allocate memory to allocate address space!\n");
@@ -82,58 +220,68 @@ void AddressSpace_add (struct AddressSpace_st *as, uint64_t AddressBegin,
 		}
 
 		for (u = as->aRegions; u < as->aRegions+ADDRESS_SPACE_ALLOC_SIZE; u++)
-			as->Regions[u].in_use = FALSE;
+		{
+			as->Regions[u].left = as->freeRegions;
+			as->freeRegions = u;
+		}
 		as->aRegions += ADDRESS_SPACE_ALLOC_SIZE;
 	}
 
-	for (u = 0; u < as->aRegions; u++)
-		if (!as->Regions[u].in_use)
-		{
-			as->Regions[u].AddressBegin = AddressBegin;
-			as->Regions[u].AddressEnd = AddressEnd;
-			as->Regions[u].CallerType = CallerType;
-			for (v = 0; v < MAX_CALLERS; v++)
-				as->Regions[u].CallerAddresses[v] = CallerAddresses[v];
-			as->Regions[u].in_use = TRUE;
-			as->nRegions++;
-			break;
-		}
+	u = as->freeRegions;
+	r = &as->Regions[u];
+	as->freeRegions = r->left;
+
+	r->AddressBegin = AddressBegin;
+	r->AddressEnd = AddressEnd;
+	r->CallerType = CallerType;
+	for (v = 0; v < MAX_CALLERS; v++)
+		r->CallerAddresses[v] = CallerAddresses[v];
+	r->left = r->right = REGION_NIL;
+	AddressSpace_update (as, u);
+
+	as->root = AddressSpace_insert (as, as->root, u);
+	as->nRegions++;
 }
 
 void AddressSpace_remove (struct AddressSpace_st *as, uint64_t AddressBegin)
 {
-	unsigned u;
-	unsigned v;
+	uint32_t deleted = REGION_NIL;
 
-	for (u = 0; u < as->aRegions; u++)
-		if (as->Regions[u].in_use && as->Regions[u].AddressBegin == AddressBegin)
-		{
-			as->Regions[u].in_use = FALSE;
-			as->Regions[u].AddressBegin = 0;
-			as->Regions[u].AddressEnd = 0;
-			as->Regions[u].CallerType = 0;
-			for (v = 0; v < MAX_CALLERS; v++)
-				as->Regions[u].CallerAddresses[v] = 0;
-			as->nRegions--;
-			break;
-		}
+	as->root = AddressSpace_delete (as, as->root, AddressBegin, &deleted);
+	if (deleted != REGION_NIL)
+	{
+		as->Regions[deleted].left = as->freeRegions;
+		as->freeRegions = deleted;
+		as->nRegions--;
+	}
 }
 
 int AddressSpace_search (struct AddressSpace_st *as, uint64_t Address,
 	uint64_t **CallerAddresses, uint32_t *CallerType)
 {
-	unsigned u;
+	uint32_t n = as->root;
+
+	while (n != REGION_NIL)
+	{
+		struct AddressSpaceRegion_st *r = &as->Regions[n];
 
-	for (u = 0; u < as->aRegions; u++)
-		if (as->Regions[u].in_use)
-			if (as->Regions[u].AddressBegin <= Address &&
-			    Address <= as->Regions[u].AddressEnd)
+		if (r->AddressBegin <= Address && Address <= r->AddressEnd)
 		{
 			if (CallerAddresses)
-				*CallerAddresses = as->Regions[u].CallerAddresses;
+				*CallerAddresses = r->CallerAddresses;
 			if (CallerType)
-				*CallerType = as->Regions[u].CallerType;
+				*CallerType = r->CallerType;
 			return TRUE;
 		}
+
+		/* If a region on the left reaches the address, either it contains
+		   the address or no region does */
+		if (r->left != REGION_NIL && as->Regions[r->left].MaxAddressEnd >= Address)
+			n = r->left;
+		else if (r->AddressBegin <= Address)
+			n = r->right;
+		else
+			break;
+	}
 	return FALSE;
 }
@@ -45,23 +45,66 @@ void AddressCollector_Initialize (struct address_collector_t *ac)
 	ac->types = NULL;
 	ac->tasks = NULL;
 	ac->ptasks = NULL;
+	ac->hash = NULL;
+	ac->hash_size = 0;
 }
 
-static int AddresCollector_Search (struct address_collector_t *ac,
+static unsigned AddressCollector_Hash (UINT64 address, int type)
+{
+	UINT64 h = address ^ ((UINT64) type << 56);
+
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return (unsigned) h;
+}
+
+/* Returns the hash slot of the (address, type) pair, which is empty if the
+   pair has not been collected yet */
+static unsigned AddressCollector_Slot (struct address_collector_t *ac,
 	UINT64 address, int type)
 {
-	unsigned i;
-	for (i = 0; i < ac->count; i++)
+	unsigned mask = ac->hash_size - 1;
+	unsigned slot = AddressCollector_Hash (address, type) & mask;
+
+	while (ac->hash[slot] != 0)
+	{
+		unsigned i = ac->hash[slot] - 1;
 		if (ac->addresses[i] == address && ac->types[i] == type)
-			return TRUE;
+			break;
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
 
-	return FALSE;
+static void AddressCollector_Rehash (struct address_collector_t *ac)
+{
+	unsigned i;
+
+	ac->hash_size = (ac->hash_size == 0) ? 2*AC_ALLOC_CHUNK : 2*ac->hash_size;
+	free (ac->hash);
+	ac->hash = (unsigned*) calloc (ac->hash_size, sizeof(unsigned));
+	if (ac->hash == NULL)
+	{
+		fprintf (stderr, "mpi2prv: Error when reallocating address_collector_t in AdressCollector_Add\n");
+		exit (-1);
+	}
+
+	for (i = 0; i < ac->count; i++)
+		ac->hash[AddressCollector_Slot (ac, ac->addresses[i], ac->types[i])] = i + 1;
 }
 
 void AddressCollector_Add (struct address_collector_t *ac, unsigned ptask,
 	unsigned task, UINT64 address, int type)
 {
-	if (!AddresCollector_Search (ac, address, type))
+	unsigned slot;
+
+	/* Keep the index at most half full */
+	if (2*(ac->count+1) > ac->hash_size)
+		AddressCollector_Rehash (ac);
+
+	slot = AddressCollector_Slot (ac, address, type);
+	if (ac->hash[slot] == 0)
 	{
 		if (ac->allocated == ac->count)
 		{
@@ -96,6 +139,7 @@ void AddressCollector_Add (struct address_collector_t *ac, unsigned ptask,
 		ac->addresses[ac->count] = address;
 		ac->types[ac->count] = type;
 		ac->count++;
+		ac->hash[slot] = ac->count;
 	}
 }
 
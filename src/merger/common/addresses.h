@@ -32,6 +32,8 @@ struct address_collector_t
 	unsigned *tasks;
 	unsigned count;
 	unsigned allocated;
+	unsigned *hash;        /* Open addressing index of the entries (+1) */
+	unsigned hash_size;    /* Power of two */
 };
 
 void AddressCollector_Initialize (struct address_collector_t *ac);
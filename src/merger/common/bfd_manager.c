@@ -46,6 +46,32 @@ static unsigned numLoadedModules = 0;
 static bfd *default_bfdImage = NULL;
 static asymbol **default_bfdSymbols = NULL;
 
+#if HAVE_BFD_GET_SECTION_SIZE || HAVE_BFD_SECTION_SIZE || HAVE_BFD_GET_SECTION_SIZE_BEFORE_RELOC
+# define BFDMANAGER_SORTED_SECTIONS
+#endif
+
+#if defined(BFDMANAGER_SORTED_SECTIONS)
+/* Allocated sections of a binary sorted by start address, so that the
+   section holding an address is found through a binary search instead of
+   walking all of them. The table is attached to the image through its
+   usrdata field. */
+typedef struct BFDmanager_section_st
+{
+	bfd_vma start;
+	bfd_vma end;
+	bfd_vma max_end; /* Highest end among this and the preceding sections */
+	asection *section;
+} BFDmanager_section_t;
+
+typedef struct BFDmanager_sectionTable_st
+{
+	unsigned nsections;
+	BFDmanager_section_t *sections;
+} BFDmanager_sectionTable_t;
+
+static void BFDmanager_buildSectionTable (bfd *bfdImage);
+#endif
+
 void BFDmanager_init (void)
 {
 	bfd_init();
@@ -94,6 +120,10 @@ static void BFDmanager_loadBFDdata (char *file, bfd **image, asymbol ***symbols,
 		                "         Addresses will not be translated into source code references\n",
 		  file, errmsg);
 	}
+#if defined(BFDMANAGER_SORTED_SECTIONS)
+	else
+		BFDmanager_buildSectionTable (bfdImage);
+#endif
 
 	/* Load the mini-Symbol Table */
 	if (bfd_get_file_flags (bfdImage) & HAS_SYMS)
@@ -281,6 +311,128 @@ static void BFDmanager_findAddressInSection (bfd * abfd, asection * section, PTR
 	  &symdata->line);
 }
 
+#if defined(BFDMANAGER_SORTED_SECTIONS)
+/** BFDmanager_collectSection
+ *
+ * Appends the given section to the section table if it is loaded in memory.
+ */
+static void BFDmanager_collectSection (bfd * abfd, asection * section, PTR data)
+{
+	BFDmanager_sectionTable_t *table = (BFDmanager_sectionTable_t*) data;
+	bfd_size_type size;
+	bfd_vma vma;
+
+#if HAVE_BFD_GET_SECTION_FLAGS
+	if ((bfd_get_section_flags (abfd, section) & SEC_ALLOC) == 0)
+		return;
+#elif HAVE_BFD_SECTION_FLAGS
+	if ((bfd_section_flags (section) & SEC_ALLOC) == 0)
+		return;
+#endif
+
+#ifdef HAVE_BFD_GET_SECTION_VMA
+	vma = bfd_get_section_vma (abfd, section);
+#elif HAVE_BFD_SECTION_VMA
+	vma = bfd_section_vma (section);
+#endif
+
+#if HAVE_BFD_GET_SECTION_SIZE
+	size = bfd_get_section_size (section);
+#elif HAVE_BFD_SECTION_SIZE
+	size = bfd_section_size (section);
+#elif HAVE_BFD_GET_SECTION_SIZE_BEFORE_RELOC
+	size = bfd_get_section_size_before_reloc (section);
+#endif
+
+	if (size == 0)
+		return;
+
+	table->sections = (BFDmanager_section_t*) realloc (table->sections,
+	  (table->nsections+1)*sizeof(BFDmanager_section_t));
+	if (table->sections == NULL)
+		FATAL_ERROR ("Cannot allocate memory to sort the binary sections\n");
+
+	table->sections[table->nsections].start = vma;
+	table->sections[table->nsections].end = vma + size;
+	table->sections[table->nsections].section = section;
+	table->nsections++;
+}
+
+static int BFDmanager_compareSections (const void *a, const void *b)
+{
+	const BFDmanager_section_t *s1 = (const BFDmanager_section_t*) a;
+	const BFDmanager_section_t *s2 = (const BFDmanager_section_t*) b;
+
+	if (s1->start < s2->start)
+		return -1;
+	else if (s1->start > s2->start)
+		return 1;
+	else
+		return 0;
+}
+
+/** BFDmanager_buildSectionTable
+ *
+ * Builds the table of allocated sections of the image sorted by address.
+ */
+static void BFDmanager_buildSectionTable (bfd *bfdImage)
+{
+	BFDmanager_sectionTable_t *table;
+	unsigned u;
+
+	table = (BFDmanager_sectionTable_t*) malloc (sizeof(BFDmanager_sectionTable_t));
+	if (table == NULL)
+		FATAL_ERROR ("Cannot allocate memory to sort the binary sections\n");
+	table->nsections = 0;
+	table->sections = NULL;
+
+	bfd_map_over_sections (bfdImage, BFDmanager_collectSection, table);
+
+	if (table->nsections > 0)
+		qsort (table->sections, table->nsections, sizeof(BFDmanager_section_t),
+		  BFDmanager_compareSections);
+
+	for (u = 0; u < table->nsections; u++)
+	{
+		table->sections[u].max_end = table->sections[u].end;
+		if (u > 0 && table->sections[u-1].max_end > table->sections[u].max_end)
+			table->sections[u].max_end = table->sections[u-1].max_end;
+	}
+
+	bfdImage->usrdata = table;
+}
+
+/** BFDmanager_searchSectionTable
+ *
+ * Binary searches the last section starting at or before pc, then walks
+ * back over the (rarely) overlapping sections that may still contain it.
+ */
+static void BFDmanager_searchSectionTable (bfd *abfd,
+	BFDmanager_sectionTable_t *table, BFDmanager_symbolInfo_t *symdata)
+{
+	unsigned lo = 0, hi = table->nsections;
+
+	while (lo < hi)
+	{
+		unsigned mid = lo + (hi - lo) / 2;
+		if (table->sections[mid].start <= symdata->pc)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (; lo > 0 && !symdata->found && table->sections[lo-1].max_end > symdata->pc; lo--)
+	{
+		BFDmanager_section_t *s = &(table->sections[lo-1]);
+
+		if (symdata->pc < s->end)
+			symdata->found = bfd_find_nearest_line (abfd, s->section,
+			  symdata->symbols, symdata->pc - s->start, &symdata->filename,
+			  &symdata->function, &symdata->line);
+	}
+}
+#endif /* BFDMANAGER_SORTED_SECTIONS */
+
 int BFDmanager_translateAddress (bfd *bfdImage, asymbol **bfdSymbols,
 	void *address, char **function, char **file, int *line)
 {
@@ -302,6 +454,13 @@ int BFDmanager_translateAddress (bfd *bfdImage, asymbol **bfdSymbols,
 		syminfo.pc = bfd_scan_vma (caddress, NULL, 16);
 		syminfo.symbols = bfdSymbols;
 
+#if defined(BFDMANAGER_SORTED_SECTIONS)
+		/* Look up the section in the sorted table of the image, if any */
+		if (bfdImage->usrdata != NULL)
+			BFDmanager_searchSectionTable (bfdImage,
+			  (BFDmanager_sectionTable_t*) bfdImage->usrdata, &syminfo);
+		else
+#endif
 		/* Iterate through sections of the given bfd image */
 		bfd_map_over_sections (bfdImage, BFDmanager_findAddressInSection, &syminfo);
 
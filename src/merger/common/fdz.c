@@ -0,0 +1,457 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include "common.h"
+
+#ifdef HAVE_STDIO_H
+# include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
+#if defined(FDZ_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+# include <pthread.h>
+# define FDZ_THREADS
+#endif
+#ifdef HAVE_ZSTD
+# include <zstd.h>
+#endif
+
+#include "fdz.h"
+
+/******************************************************************************
+ *** Block-parallel compressed output
+ ***
+ *** The output is split in blocks of whole lines. Every block is compressed
+ *** independently into a gzip member or a zstd frame by a pool of threads,
+ *** while the caller keeps filling the following blocks. Blocks are written
+ *** in order. A concatenation of gzip members is a valid gzip file. For zstd,
+ *** a seek table (zstd seekable format) is appended at the end so that readers
+ *** can decompress any frame alone. Since the records are sorted by time,
+ *** the first record of every frame tells which time range it covers.
+ ******************************************************************************/
+
+#define FDZ_BLOCK_SIZE (4*1024*1024)
+
+#define FDZ_GZIP_LEVEL 6
+#define FDZ_ZSTD_LEVEL 3
+
+#define ZSTD_SKIPPABLE_MAGIC 0x184D2A5E
+#define ZSTD_SEEKABLE_MAGIC  0x8F92EAB1
+
+enum
+{
+	BLOCK_FREE = 0,
+	BLOCK_PENDING,
+	BLOCK_DONE
+};
+
+typedef struct
+{
+	char *in;
+	size_t in_size;
+	size_t in_allocated;
+	char *out;
+	size_t out_size;
+	size_t out_allocated;
+	int state;
+	int error;
+} FDZ_Block_t;
+
+struct FDZ_Parallel_st
+{
+	FILE *handle;
+	int codec;
+	FDZ_Block_t *blocks;
+	unsigned nblocks;
+	unsigned long long filling;    /* Block being filled by the caller */
+	unsigned long long writing;    /* Oldest block not written yet */
+	unsigned long long compressing;/* Next block to be taken by a thread */
+	unsigned long long position;   /* Uncompressed bytes given */
+	int error;
+
+	/* Seek table for the zstd seekable format */
+	unsigned *frame_csize;
+	unsigned *frame_dsize;
+	unsigned nframes;
+	unsigned maxframes;
+
+#if defined(FDZ_THREADS)
+	unsigned nthreads;
+	pthread_t *threads;
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+	int finish;
+#endif
+};
+
+static void FDZ_Parallel_Reserve (char **buffer, size_t *allocated, size_t size)
+{
+	if (size > *allocated)
+	{
+		*buffer = (char*) realloc (*buffer, size);
+		if (*buffer == NULL)
+		{
+			fprintf (stderr, "mpi2prv: Error! Cannot allocate memory for the compressed output\n");
+			exit (-1);
+		}
+		*allocated = size;
+	}
+}
+
+static int FDZ_Parallel_CompressGZ (FDZ_Block_t *b)
+{
+#if defined(HAVE_ZLIB)
+	z_stream z;
+	int res;
+
+	memset (&z, 0, sizeof(z));
+	/* 15 + 16 windowBits generate a gzip member instead of a zlib stream */
+	if (deflateInit2 (&z, FDZ_GZIP_LEVEL, Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return FALSE;
+
+	FDZ_Parallel_Reserve (&b->out, &b->out_allocated,
+	  deflateBound (&z, b->in_size) + 32);
+
+	z.next_in = (Bytef*) b->in;
+	z.avail_in = b->in_size;
+	z.next_out = (Bytef*) b->out;
+	z.avail_out = b->out_allocated;
+	res = deflate (&z, Z_FINISH);
+	b->out_size = b->out_allocated - z.avail_out;
+	deflateEnd (&z);
+
+	return res == Z_STREAM_END;
+#else
+	UNREFERENCED_PARAMETER(b);
+	return FALSE;
+#endif
+}
+
+static int FDZ_Parallel_CompressZSTD (FDZ_Block_t *b)
+{
+#if defined(HAVE_ZSTD)
+	size_t res;
+
+	FDZ_Parallel_Reserve (&b->out, &b->out_allocated, ZSTD_compressBound (b->in_size));
+
+	res = ZSTD_compress (b->out, b->out_allocated, b->in, b->in_size, FDZ_ZSTD_LEVEL);
+	if (ZSTD_isError (res))
+		return FALSE;
+	b->out_size = res;
+
+	return TRUE;
+#else
+	UNREFERENCED_PARAMETER(b);
+	return FALSE;
+#endif
+}
+
+static void FDZ_Parallel_Compress (FDZ_Parallel_t *pz, FDZ_Block_t *b)
+{
+	if (FDZ_CODEC_ZSTD == pz->codec)
+		b->error = !FDZ_Parallel_CompressZSTD (b);
+	else
+		b->error = !FDZ_Parallel_CompressGZ (b);
+}
+
+#if defined(FDZ_THREADS)
+static void * FDZ_Parallel_Thread (void *arg)
+{
+	FDZ_Parallel_t *pz = (FDZ_Parallel_t*) arg;
+	FDZ_Block_t *b;
+
+	pthread_mutex_lock (&pz->lock);
+	while (TRUE)
+	{
+		while (!pz->finish && pz->compressing == pz->filling)
+			pthread_cond_wait (&pz->work, &pz->lock);
+		if (pz->compressing == pz->filling)
+			break;
+
+		b = &pz->blocks[pz->compressing % pz->nblocks];
+		pz->compressing++;
+		pthread_mutex_unlock (&pz->lock);
+
+		FDZ_Parallel_Compress (pz, b);
+
+		pthread_mutex_lock (&pz->lock);
+		b->state = BLOCK_DONE;
+		pthread_cond_broadcast (&pz->done);
+	}
+	pthread_mutex_unlock (&pz->lock);
+
+	return NULL;
+}
+#endif
+
+/* Writes the oldest block into the file once it has been compressed */
+static void FDZ_Parallel_WriteBlock (FDZ_Parallel_t *pz)
+{
+	FDZ_Block_t *b = &pz->blocks[pz->writing % pz->nblocks];
+
+#if defined(FDZ_THREADS)
+	if (pz->nthreads > 0)
+	{
+		pthread_mutex_lock (&pz->lock);
+		while (b->state != BLOCK_DONE)
+			pthread_cond_wait (&pz->done, &pz->lock);
+		pthread_mutex_unlock (&pz->lock);
+	}
+	else
+#endif
+		FDZ_Parallel_Compress (pz, b);
+
+	if (b->error || fwrite (b->out, 1, b->out_size, pz->handle) != b->out_size)
+		pz->error = TRUE;
+
+	if (FDZ_CODEC_ZSTD == pz->codec)
+	{
+		if (pz->nframes == pz->maxframes)
+		{
+			pz->maxframes += 1024;
+			pz->frame_csize = (unsigned*) realloc (pz->frame_csize, pz->maxframes*sizeof(unsigned));
+			pz->frame_dsize = (unsigned*) realloc (pz->frame_dsize, pz->maxframes*sizeof(unsigned));
+			if (pz->frame_csize == NULL || pz->frame_dsize == NULL)
+			{
+				fprintf (stderr, "mpi2prv: Error! Cannot allocate memory for the zstd seek table\n");
+				exit (-1);
+			}
+		}
+		pz->frame_csize[pz->nframes] = b->out_size;
+		pz->frame_dsize[pz->nframes] = b->in_size;
+		pz->nframes++;
+	}
+
+	b->in_size = b->out_size = 0;
+	b->state = BLOCK_FREE;
+	pz->writing++;
+}
+
+/* Hands the block being filled to the compressing threads */
+static void FDZ_Parallel_Submit (FDZ_Parallel_t *pz)
+{
+	FDZ_Block_t *b = &pz->blocks[pz->filling % pz->nblocks];
+
+	if (b->in_size == 0)
+		return;
+
+#if defined(FDZ_THREADS)
+	pthread_mutex_lock (&pz->lock);
+	b->state = BLOCK_PENDING;
+	pz->filling++;
+	pthread_cond_signal (&pz->work);
+	pthread_mutex_unlock (&pz->lock);
+#else
+	b->state = BLOCK_PENDING;
+	pz->filling++;
+#endif
+
+	/* Wait for the oldest block if the ring is full */
+	while (pz->filling - pz->writing >= pz->nblocks)
+		FDZ_Parallel_WriteBlock (pz);
+}
+
+FDZ_Parallel_t * FDZ_Parallel_Open (const char *name, int codec, int threads)
+{
+	FDZ_Parallel_t *pz;
+	unsigned i;
+
+	pz = (FDZ_Parallel_t*) malloc (sizeof(FDZ_Parallel_t));
+	if (pz == NULL)
+		return NULL;
+	memset (pz, 0, sizeof(FDZ_Parallel_t));
+
+#if HAVE_FOPEN64
+	pz->handle = fopen64 (name, "w");
+#else
+	pz->handle = fopen (name, "w");
+#endif
+	if (pz->handle == NULL)
+	{
+		free (pz);
+		return NULL;
+	}
+	pz->codec = codec;
+
+#if defined(FDZ_THREADS)
+	pz->nthreads = (threads > 0) ? threads : 0;
+	pz->nblocks = (pz->nthreads > 0) ? 2*pz->nthreads : 1;
+#else
+	UNREFERENCED_PARAMETER(threads);
+	pz->nblocks = 1;
+#endif
+
+	pz->blocks = (FDZ_Block_t*) malloc (pz->nblocks*sizeof(FDZ_Block_t));
+	if (pz->blocks == NULL)
+	{
+		fclose (pz->handle);
+		free (pz);
+		return NULL;
+	}
+	memset (pz->blocks, 0, pz->nblocks*sizeof(FDZ_Block_t));
+	for (i = 0; i < pz->nblocks; i++)
+		FDZ_Parallel_Reserve (&pz->blocks[i].in, &pz->blocks[i].in_allocated, FDZ_BLOCK_SIZE);
+
+#if defined(FDZ_THREADS)
+	if (pz->nthreads > 0)
+	{
+		pthread_mutex_init (&pz->lock, NULL);
+		pthread_cond_init (&pz->work, NULL);
+		pthread_cond_init (&pz->done, NULL);
+		pz->threads = (pthread_t*) malloc (pz->nthreads*sizeof(pthread_t));
+		if (pz->threads == NULL)
+		{
+			fprintf (stderr, "mpi2prv: Error! Cannot allocate memory for the compressing threads\n");
+			exit (-1);
+		}
+		for (i = 0; i < pz->nthreads; i++)
+			if (pthread_create (&pz->threads[i], NULL, FDZ_Parallel_Thread, pz) != 0)
+			{
+				fprintf (stderr, "mpi2prv: Error! Cannot create the compressing threads\n");
+				exit (-1);
+			}
+	}
+#endif
+
+	return pz;
+}
+
+int FDZ_Parallel_Dump (FDZ_Parallel_t *pz, const char *buffer, size_t size)
+{
+	FDZ_Block_t *b = &pz->blocks[pz->filling % pz->nblocks];
+
+	FDZ_Parallel_Reserve (&b->in, &b->in_allocated, b->in_size + size);
+	memcpy (&b->in[b->in_size], buffer, size);
+	b->in_size += size;
+	pz->position += size;
+
+	/* Blocks end at a line boundary, so that every frame starts by a record */
+	if (b->in_size >= FDZ_BLOCK_SIZE && b->in[b->in_size-1] == '\n')
+		FDZ_Parallel_Submit (pz);
+
+	return pz->error ? -1 : (int) size;
+}
+
+int FDZ_Parallel_Write (FDZ_Parallel_t *pz, const char *buffer)
+{
+	return FDZ_Parallel_Dump (pz, buffer, strlen (buffer));
+}
+
+int FDZ_Parallel_Flush (FDZ_Parallel_t *pz)
+{
+	FDZ_Parallel_Submit (pz);
+	while (pz->writing < pz->filling)
+		FDZ_Parallel_WriteBlock (pz);
+
+	return pz->error ? -1 : fflush (pz->handle);
+}
+
+long long FDZ_Parallel_Tell (FDZ_Parallel_t *pz)
+{
+	return pz->position;
+}
+
+static void FDZ_Parallel_Put32 (unsigned char *p, unsigned v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+static void FDZ_Parallel_WriteSeekTable (FDZ_Parallel_t *pz)
+{
+	unsigned char entry[8];
+	unsigned i;
+
+	/* Skippable frame header: magic and size of the content */
+	FDZ_Parallel_Put32 (entry, ZSTD_SKIPPABLE_MAGIC);
+	FDZ_Parallel_Put32 (&entry[4], 8*pz->nframes + 9);
+	if (fwrite (entry, 1, 8, pz->handle) != 8)
+		pz->error = TRUE;
+
+	for (i = 0; i < pz->nframes; i++)
+	{
+		FDZ_Parallel_Put32 (entry, pz->frame_csize[i]);
+		FDZ_Parallel_Put32 (&entry[4], pz->frame_dsize[i]);
+		if (fwrite (entry, 1, 8, pz->handle) != 8)
+			pz->error = TRUE;
+	}
+
+	/* Footer: number of frames, descriptor (no checksums) and magic */
+	FDZ_Parallel_Put32 (entry, pz->nframes);
+	entry[4] = 0;
+	if (fwrite (entry, 1, 5, pz->handle) != 5)
+		pz->error = TRUE;
+	FDZ_Parallel_Put32 (entry, ZSTD_SEEKABLE_MAGIC);
+	if (fwrite (entry, 1, 4, pz->handle) != 4)
+		pz->error = TRUE;
+}
+
+int FDZ_Parallel_Close (FDZ_Parallel_t *pz)
+{
+	unsigned i;
+	int error;
+
+	FDZ_Parallel_Flush (pz);
+
+#if defined(FDZ_THREADS)
+	if (pz->nthreads > 0)
+	{
+		pthread_mutex_lock (&pz->lock);
+		pz->finish = TRUE;
+		pthread_cond_broadcast (&pz->work);
+		pthread_mutex_unlock (&pz->lock);
+		for (i = 0; i < pz->nthreads; i++)
+			pthread_join (pz->threads[i], NULL);
+		free (pz->threads);
+		pthread_mutex_destroy (&pz->lock);
+		pthread_cond_destroy (&pz->work);
+		pthread_cond_destroy (&pz->done);
+	}
+#endif
+
+	if (FDZ_CODEC_ZSTD == pz->codec)
+		FDZ_Parallel_WriteSeekTable (pz);
+
+	error = pz->error;
+	if (fclose (pz->handle) != 0)
+		error = TRUE;
+
+	for (i = 0; i < pz->nblocks; i++)
+	{
+		free (pz->blocks[i].in);
+		free (pz->blocks[i].out);
+	}
+	free (pz->blocks);
+	free (pz->frame_csize);
+	free (pz->frame_dsize);
+	free (pz);
+
+	return error ? EOF : 0;
+}
@@ -26,6 +26,26 @@
 
 #include <config.h>
 
+#ifdef HAVE_STDIO_H
+# include <stdio.h>
+#endif
+
+/* Block-parallel compressed output (see fdz.c) */
+enum
+{
+	FDZ_CODEC_GZIP = 0,
+	FDZ_CODEC_ZSTD
+};
+
+typedef struct FDZ_Parallel_st FDZ_Parallel_t;
+
+FDZ_Parallel_t * FDZ_Parallel_Open (const char *name, int codec, int threads);
+int FDZ_Parallel_Write (FDZ_Parallel_t *pz, const char *buffer);
+int FDZ_Parallel_Dump (FDZ_Parallel_t *pz, const char *buffer, size_t size);
+int FDZ_Parallel_Flush (FDZ_Parallel_t *pz);
+long long FDZ_Parallel_Tell (FDZ_Parallel_t *pz);
+int FDZ_Parallel_Close (FDZ_Parallel_t *pz);
+
 #ifdef HAVE_ZLIB
 
 # include <zlib.h>
@@ -34,34 +54,42 @@ struct fdz_fitxer
 {
   FILE *handle;
   gzFile handleGZ;
+  FDZ_Parallel_t *handlePZ;
 };
 #else
 struct fdz_fitxer
 {
   FILE *handle;
+  FDZ_Parallel_t *handlePZ;
 };
 #endif
 
 #ifdef HAVE_ZLIB
 # define FDZ_CLOSE(x) \
-	(x.handleGZ!=NULL)?gzclose(x.handleGZ):fclose(x.handle)
+	(x.handlePZ!=NULL)?FDZ_Parallel_Close(x.handlePZ):(x.handleGZ!=NULL)?gzclose(x.handleGZ):fclose(x.handle)
 # define FDZ_WRITE(x,buffer) \
-	(x.handleGZ!=NULL)?gzputs(x.handleGZ,buffer):fputs(buffer,x.handle)
+	(x.handlePZ!=NULL)?FDZ_Parallel_Write(x.handlePZ,buffer):(x.handleGZ!=NULL)?gzputs(x.handleGZ,buffer):fputs(buffer,x.handle)
 # define FDZ_DUMP(x,buffer,size) \
-  (x.handleGZ!=NULL)?:write(fileno(x.handle),buffer,size)
+  (x.handlePZ!=NULL)?FDZ_Parallel_Dump(x.handlePZ,buffer,size):(x.handleGZ!=NULL)?:write(fileno(x.handle),buffer,size)
 # define FDZ_FLUSH(x) \
-	(x.handleGZ!=NULL)?gzflush(x.handleGZ,Z_FULL_FLUSH):fflush(x.handle)
+	(x.handlePZ!=NULL)?FDZ_Parallel_Flush(x.handlePZ):(x.handleGZ!=NULL)?gzflush(x.handleGZ,Z_FULL_FLUSH):fflush(x.handle)
 # define FDZ_TELL(x) \
-	(x.handleGZ!=NULL)?gztell(x.handleGZ):ftell(x.handle)
+	(x.handlePZ!=NULL)?FDZ_Parallel_Tell(x.handlePZ):(x.handleGZ!=NULL)?gztell(x.handleGZ):ftell(x.handle)
 # define FDZ_SEEK_SET(x,offset) \
-	(x.handleGZ!=NULL)?gzseek(x.handleGZ,offset,SEEK_SET):fseek(x.handle,offset,SEEK_SET)
+	(x.handlePZ!=NULL)?-1:(x.handleGZ!=NULL)?gzseek(x.handleGZ,offset,SEEK_SET):fseek(x.handle,offset,SEEK_SET)
 #else
-# define FDZ_CLOSE(x) fclose(x.handle)
-# define FDZ_WRITE(x,buffer) fputs(buffer,x.handle)
-# define FDZ_DUMP(x,buffer,size) write(fileno(x.handle),buffer,size)
-# define FDZ_FLUSH(x) fflush(x.handle)
-# define FDZ_TELL(x) ftell(x.handle)
-# define FDZ_SEEK_SET(x,offset) fseek(x.handle,offset,SEEK_SET)
+# define FDZ_CLOSE(x) \
+	(x.handlePZ!=NULL)?FDZ_Parallel_Close(x.handlePZ):fclose(x.handle)
+# define FDZ_WRITE(x,buffer) \
+	(x.handlePZ!=NULL)?FDZ_Parallel_Write(x.handlePZ,buffer):fputs(buffer,x.handle)
+# define FDZ_DUMP(x,buffer,size) \
+	(x.handlePZ!=NULL)?FDZ_Parallel_Dump(x.handlePZ,buffer,size):write(fileno(x.handle),buffer,size)
+# define FDZ_FLUSH(x) \
+	(x.handlePZ!=NULL)?FDZ_Parallel_Flush(x.handlePZ):fflush(x.handle)
+# define FDZ_TELL(x) \
+	(x.handlePZ!=NULL)?FDZ_Parallel_Tell(x.handlePZ):ftell(x.handle)
+# define FDZ_SEEK_SET(x,offset) \
+	(x.handlePZ!=NULL)?-1:fseek(x.handle,offset,SEEK_SET)
 #endif
 
 #endif
@@ -108,6 +108,11 @@ void Help (const char *ProgName)
 		  "    -syn-node            Synchronize traces at the MPI node-level using the MPI_Init information.\n"
 		  "    -no-syn              Do not synchronize traces at the end of MPI_Init.\n"
 		  "    -maxmem M            Uses up to M megabytes of memory at the last step of merging process.\n"
+		  "    -maxmem-input M      Keeps at most M megabytes of the input files in memory while translating.\n"
+		  "    -maxmem-exchange M   Uses up to M megabytes to exchange the communications among merger processes.\n"
+		  "    -exchange-collective Exchanges the communications among merger processes in a single collective.\n"
+		  "    -compress-threads N  Compresses the output trace (.prv.gz or .prv.zst) in blocks using N threads.\n"
+		  "    -threads N           Loads the intermediate files and resolves addresses using N threads.\n"
 		  "    -dimemas             Force the generation of a Dimemas trace.\n"
 		  "    -paraver             Force the generation of a Paraver trace.\n"
 		  "    -keep-mpits          Keeps MPIT files after trace generation (default)\n"
@@ -854,6 +859,95 @@ void ProcessArgs (int rank, int argc, char *argv[])
 			}
 			continue;
 		}
+		if (!strcmp (argv[CurArg], "-maxmem-input"))
+		{
+			CurArg++;
+			if (CurArg < argc)
+			{
+				int tmp = atoi(argv[CurArg]);
+				if (tmp <= 0)
+				{
+					if (0 == rank)
+						fprintf (stderr, "mpi2prv: Error! Invalid parameter for -maxmem-input option. Ignoring it\n");
+					tmp = 0;
+				}
+				set_option_merge_InputMaxMem (tmp);
+			}
+			else
+			{
+				if (0 == rank)
+					fprintf (stderr, "mpi2prv: WARNING: Invalid value for -maxmem-input parameter\n");
+			}
+			continue;
+		}
+		if (!strcmp (argv[CurArg], "-exchange-collective"))
+		{
+			set_option_merge_ExchangeCollective (TRUE);
+			continue;
+		}
+		if (!strcmp (argv[CurArg], "-maxmem-exchange"))
+		{
+			CurArg++;
+			if (CurArg < argc)
+			{
+				int tmp = atoi(argv[CurArg]);
+				if (tmp <= 0)
+				{
+					if (0 == rank)
+						fprintf (stderr, "mpi2prv: Error! Invalid parameter for -maxmem-exchange option. Ignoring it\n");
+					tmp = 0;
+				}
+				set_option_merge_ExchangeMaxMem (tmp);
+			}
+			else
+			{
+				if (0 == rank)
+					fprintf (stderr, "mpi2prv: WARNING: Invalid value for -maxmem-exchange parameter\n");
+			}
+			continue;
+		}
+		if (!strcmp (argv[CurArg], "-compress-threads"))
+		{
+			CurArg++;
+			if (CurArg < argc)
+			{
+				int tmp = atoi(argv[CurArg]);
+				if (tmp <= 0)
+				{
+					if (0 == rank)
+						fprintf (stderr, "mpi2prv: Error! Invalid parameter for -compress-threads option. Ignoring it\n");
+					tmp = 0;
+				}
+				set_option_merge_CompressThreads (tmp);
+			}
+			else
+			{
+				if (0 == rank)
+					fprintf (stderr, "mpi2prv: WARNING: Invalid value for -compress-threads parameter\n");
+			}
+			continue;
+		}
+		if (!strcmp (argv[CurArg], "-threads"))
+		{
+			CurArg++;
+			if (CurArg < argc)
+			{
+				int tmp = atoi(argv[CurArg]);
+				if (tmp <= 0)
+				{
+					if (0 == rank)
+						fprintf (stderr, "mpi2prv: Error! Invalid parameter for -threads option. Ignoring it\n");
+					tmp = 1;
+				}
+				set_option_merge_NumThreads (tmp);
+			}
+			else
+			{
+				if (0 == rank)
+					fprintf (stderr, "mpi2prv: WARNING: Invalid value for -threads parameter\n");
+			}
+			continue;
+		}
 		if (!strcmp (argv[CurArg], "-dimemas"))
 		{
 			set_option_merge_ForceFormat (TRUE);
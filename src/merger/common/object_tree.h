@@ -142,8 +142,8 @@ typedef struct task_st
 	/* Controls whether this task matches comms or not */
 	int MatchingComms;
 	int match_zone;
-	NewQueue_t *recv_queue;
-	NewQueue_t *send_queue;
+	CommunicationQueue_t *recv_queue;
+	CommunicationQueue_t *send_queue;
 
 	/* Arrangement of thread dependencies within the task level */
 	struct ThreadDependencies_st * thread_dependencies;
@@ -85,6 +85,26 @@ static int option_merge_MaxMem = 512;
 int get_option_merge_MaxMem (void) { return option_merge_MaxMem; }
 void set_option_merge_MaxMem (int mm) { option_merge_MaxMem = mm; }
 
+static int option_merge_InputMaxMem = 0;
+int get_option_merge_InputMaxMem (void) { return option_merge_InputMaxMem; }
+void set_option_merge_InputMaxMem (int mm) { option_merge_InputMaxMem = mm; }
+
+static int option_merge_ExchangeMaxMem = 0;
+int get_option_merge_ExchangeMaxMem (void) { return option_merge_ExchangeMaxMem; }
+void set_option_merge_ExchangeMaxMem (int mm) { option_merge_ExchangeMaxMem = mm; }
+
+static int option_merge_ExchangeCollective = FALSE;
+int get_option_merge_ExchangeCollective (void) { return option_merge_ExchangeCollective; }
+void set_option_merge_ExchangeCollective (int b) { option_merge_ExchangeCollective = b; }
+
+static int option_merge_CompressThreads = 0;
+int get_option_merge_CompressThreads (void) { return option_merge_CompressThreads; }
+void set_option_merge_CompressThreads (int n) { option_merge_CompressThreads = n; }
+
+static int option_merge_NumThreads = 1;
+int get_option_merge_NumThreads (void) { return option_merge_NumThreads; }
+void set_option_merge_NumThreads (int n) { option_merge_NumThreads = n; }
+
 static int option_merge_ForceFormat = FALSE;
 int get_option_merge_ForceFormat (void) { return option_merge_ForceFormat; }
 void set_option_merge_ForceFormat (int b) { option_merge_ForceFormat = b; }
@@ -68,6 +68,18 @@ void set_option_merge_TreeFanOut (int tfo);
 
 int get_option_merge_MaxMem (void);
 void set_option_merge_MaxMem (int mm);
+int get_option_merge_InputMaxMem (void);
+void set_option_merge_InputMaxMem (int mm);
+int get_option_merge_ExchangeMaxMem (void);
+void set_option_merge_ExchangeMaxMem (int mm);
+int get_option_merge_ExchangeCollective (void);
+void set_option_merge_ExchangeCollective (int b);
+
+int get_option_merge_CompressThreads (void);
+void set_option_merge_CompressThreads (int n);
+
+int get_option_merge_NumThreads (void);
+void set_option_merge_NumThreads (int n);
 
 int get_option_merge_ForceFormat (void);
 void set_option_merge_ForceFormat (int b);
@@ -26,6 +26,9 @@
 #ifdef HAVE_STDIO_H
 # include <stdio.h>
 #endif
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
 
 #include "utils.h"
 #include "semantics.h"
@@ -46,9 +49,27 @@
 int num_Registered_Handlers = 0;
 RangeEv_Handler_t *Event_Handlers = NULL;
 
+/* Disjoint ranges of events sorted by range_min, each one with the event
+   type given by getEventType (0 if unknown) and its registered handler. It
+   is built once from Event_Handlers and looked up through binary search. */
+typedef struct
+{
+	unsigned range_min;
+	unsigned range_max;
+	unsigned type;
+	Ev_Handler_t *handler;
+} Dispatch_Entry_t;
+
+static unsigned num_Dispatch_Entries = 0;
+static Dispatch_Entry_t *Dispatch_Table = NULL;
+
+static unsigned num_Boundaries = 0, max_Boundaries = 0;
+static unsigned long long *Boundaries = NULL;
+
 static void Register_Handler (int range_min, int range_max, Ev_Handler_t *handler);
 static void Register_Event_Handlers (SingleEv_Handler_t list[]);
 static void Register_Range_Handlers  (RangeEv_Handler_t list[]);
+static void Build_Dispatch_Table (void);
 
 int SkipHandler (event_t *p1, unsigned long long p2, unsigned int p3, unsigned int p4, unsigned int p5, unsigned int p6, FileSet_t *p7)
 {
@@ -86,6 +107,7 @@ void Semantics_Initialize (int output_format)
 			Register_Event_Handlers (PRV_Java_Event_Handlers);
 			break;
 	}
+	Build_Dispatch_Table ();
 }
 
 static void Register_Handler (int range_min, int range_max, Ev_Handler_t *handler)
@@ -120,13 +142,22 @@ static void Register_Range_Handlers (RangeEv_Handler_t list[])
 	}
 }
 
-Ev_Handler_t * Semantics_getEventHandler (int event)
+/******************************************************************************
+ ***  Build_Dispatch_Table
+ ***  Splits the event space at the limits of every registered handler and of
+ ***  every event known by getEventType. Within each resulting piece both the
+ ***  handler and the type are constant, so they are computed once through
+ ***  the linear searches and adjacent pieces with the same pair are joined.
+ ******************************************************************************/
+
+static Ev_Handler_t * Search_Registered_Handler (unsigned event)
 {
 	int i = 0;
 
 	while (i < num_Registered_Handlers)
 	{	
-		if ((event >= Event_Handlers[i].range_min) && (event <= Event_Handlers[i].range_max))
+		if ((event >= (unsigned) Event_Handlers[i].range_min) &&
+		    (event <= (unsigned) Event_Handlers[i].range_max))
 		{
 			return Event_Handlers[i].handler;
 		}
@@ -134,3 +165,113 @@ Ev_Handler_t * Semantics_getEventHandler (int event)
 	}
 	return NULL;
 }
+
+static void Add_Boundaries (unsigned range_min, unsigned range_max)
+{
+	if (num_Boundaries + 2 > max_Boundaries)
+	{
+		max_Boundaries += 512;
+		xrealloc(Boundaries, Boundaries, max_Boundaries * sizeof(unsigned long long));
+	}
+	Boundaries[num_Boundaries++] = range_min;
+	Boundaries[num_Boundaries++] = ((unsigned long long) range_max) + 1;
+}
+
+static int Compare_Boundaries (const void *a, const void *b)
+{
+	unsigned long long ba = *(unsigned long long*) a;
+	unsigned long long bb = *(unsigned long long*) b;
+
+	return (ba < bb) ? -1 : (ba > bb) ? 1 : 0;
+}
+
+static void Build_Dispatch_Table (void)
+{
+	unsigned i, type;
+	Ev_Handler_t *handler;
+
+	xfree(Dispatch_Table);
+	num_Dispatch_Entries = num_Boundaries = 0;
+
+	for (i = 0; i < (unsigned) num_Registered_Handlers; i++)
+		Add_Boundaries (Event_Handlers[i].range_min, Event_Handlers[i].range_max);
+	getEventTypeRanges (Add_Boundaries);
+
+	qsort (Boundaries, num_Boundaries, sizeof(unsigned long long), Compare_Boundaries);
+
+	/* There are at most num_Boundaries-1 pieces */
+	xmalloc(Dispatch_Table, num_Boundaries * sizeof(Dispatch_Entry_t));
+
+	for (i = 0; i + 1 < num_Boundaries; i++)
+	{
+		unsigned range_min = Boundaries[i];
+		Dispatch_Entry_t *last = (num_Dispatch_Entries > 0) ?
+		  &Dispatch_Table[num_Dispatch_Entries-1] : NULL;
+
+		if (Boundaries[i] == Boundaries[i+1])
+			continue;
+
+		if (!getEventType (range_min, &type))
+			type = 0;
+		handler = Search_Registered_Handler (range_min);
+		if (type == 0 && handler == NULL)
+			continue;
+
+		if (last != NULL && last->range_max + 1 == range_min &&
+		    last->type == type && last->handler == handler)
+		{
+			last->range_max = Boundaries[i+1] - 1;
+		}
+		else
+		{
+			Dispatch_Table[num_Dispatch_Entries].range_min = range_min;
+			Dispatch_Table[num_Dispatch_Entries].range_max = Boundaries[i+1] - 1;
+			Dispatch_Table[num_Dispatch_Entries].type = type;
+			Dispatch_Table[num_Dispatch_Entries].handler = handler;
+			num_Dispatch_Entries ++;
+		}
+	}
+
+	xfree(Boundaries);
+	num_Boundaries = max_Boundaries = 0;
+}
+
+static Dispatch_Entry_t * Search_Dispatch_Table (unsigned event)
+{
+	unsigned lo = 0, hi = num_Dispatch_Entries;
+
+	while (lo < hi)
+	{
+		unsigned mid = lo + (hi - lo) / 2;
+
+		if (event < Dispatch_Table[mid].range_min)
+			hi = mid;
+		else if (event > Dispatch_Table[mid].range_max)
+			lo = mid + 1;
+		else
+			return &Dispatch_Table[mid];
+	}
+	return NULL;
+}
+
+Ev_Handler_t * Semantics_getEventHandler (int event)
+{
+	Dispatch_Entry_t *entry = Search_Dispatch_Table (event);
+
+	return (entry != NULL) ? entry->handler : NULL;
+}
+
+/* Same result as getEventType followed by Semantics_getEventHandler */
+int Semantics_getEventDispatch (unsigned event, unsigned *type, Ev_Handler_t **handler)
+{
+	Dispatch_Entry_t *entry = Search_Dispatch_Table (event);
+
+	if (entry != NULL && entry->type != 0)
+	{
+		*type = entry->type;
+		*handler = entry->handler;
+		return TRUE;
+	}
+	*handler = (entry != NULL) ? entry->handler : NULL;
+	return FALSE;
+}
@@ -51,6 +51,7 @@ typedef struct
 /* public: */
 void Semantics_Initialize (int output_format);
 Ev_Handler_t * Semantics_getEventHandler (int event);
+int Semantics_getEventDispatch (unsigned event, unsigned *type, Ev_Handler_t **handler);
 int SkipHandler (event_t *, unsigned long long, unsigned int, unsigned int, unsigned int, unsigned int, FileSet_t *);
 
 #endif /* __SEMANTICS_H_INCLUDED__ */
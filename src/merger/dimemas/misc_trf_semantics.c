@@ -174,6 +174,7 @@ SingleEv_Handler_t TRF_MISC_Event_Handlers[] = {
 	{ RUSAGE_EV, SkipHandler },
 	{ MEMUSAGE_EV, SkipHandler },
 	{ MPI_STATS_EV, SkipHandler },
+	{ IO_STATS_EV, SkipHandler },
 	{ USRFUNC_EV, SkipHandler },
 	{ SAMPLING_EV, SkipHandler },
 	{ HWC_SET_OVERFLOW_EV, Set_Overflow_Event },
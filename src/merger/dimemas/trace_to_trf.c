@@ -170,6 +170,7 @@ int Dimemas_ProcessTraceFiles (char *outName, unsigned long nfiles,
 	char envName[PATH_MAX], *tmp;
 	unsigned int cpu, ptask, task, thread, error;
 	unsigned int Type, EvType, current_file, count;
+	Ev_Handler_t *handler;
 	unsigned long long current_time = 0;
 	unsigned long long num_of_events, parsed_events, tmp_nevents;
 	unsigned long long trace_size;
@@ -441,14 +442,13 @@ int Dimemas_ProcessTraceFiles (char *outName, unsigned long nfiles,
 
 		EvType = Get_EvEvent (current_event);
 
-		if (getEventType (EvType, &Type))
+		if (Semantics_getEventDispatch (EvType, &Type, &handler))
 		{
 			current_time = Dimemas_hr_to_relative (Get_EvTime (current_event));
 
 			if (Type == PTHREAD_TYPE || Type == OPENMP_TYPE ||
 			    Type == MISC_TYPE || Type == MPI_TYPE)
 			{
-				Ev_Handler_t *handler = Semantics_getEventHandler (EvType);
 				if (handler != NULL)
 				{
 					handler (current_event, current_time, cpu, ptask, task, thread, fset);
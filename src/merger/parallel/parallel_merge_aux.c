@@ -26,6 +26,9 @@
 #ifdef HAVE_STDLIB_H
 # include <stdlib.h>
 #endif
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
 #ifdef HAVE_STDIO_H
 # ifdef HAVE_FOPEN64
 #  define __USE_LARGEFILE64
@@ -61,9 +64,25 @@ struct PendingComms_t
 };
 
 
+/* The foreign receives of every group are indexed by (sender_app, sender,
+   recver_app, recver, match_zone, tag). Each bucket keeps a FIFO (linked
+   through 'next', in the order the receives were recorded) of the receives
+   not yet matched, and its key is taken from the receive 'key'. */
+struct ForeignRecvBucket_t
+{
+	int key, head, tail;
+};
+struct ForeignRecvIndex_t
+{
+	struct ForeignRecvBucket_t *buckets;
+	int *next;
+	unsigned mask;
+};
+
 static struct ForeignRecv_t **myForeignRecvs;
 static int *myForeignRecvs_count;
 static char **myForeignRecvs_used;
+static struct ForeignRecvIndex_t *myForeignRecvs_index;
 
 struct IntraCommunicator_t
 {
@@ -258,20 +277,16 @@ void InitForeignRecvs (int numtasks)
 
 static void MatchRecv (int fd, off_t offset, UINT64 physic_time, UINT64 logic_time)
 {
-	paraver_rec_t r;
 	ssize_t size;
 	off_t ret;
 	unsigned long long receives[NUM_COMMUNICATION_TYPE];
-	long offset_in_struct;
-
-	/* Search offset of receives within the paraver_rec_t struct */
-	offset_in_struct = ((long) &r.receive) - ((long) &r);
 
 	receives[LOGICAL_COMMUNICATION] = logic_time;
 	receives[PHYSICAL_COMMUNICATION] = physic_time;
 
-	ret = lseek (fd, offset+offset_in_struct, SEEK_SET);
-	if (ret != offset)
+	/* Receives are kept at a fixed offset of the encoded record */
+	ret = lseek (fd, offset+PRV_RECORD_RECEIVE_OFFSET, SEEK_SET);
+	if (ret != offset+PRV_RECORD_RECEIVE_OFFSET)
 	{
 		perror ("lseek");
 #if SIZEOF_OFF_T == SIZEOF_LONG
@@ -288,7 +303,7 @@ static void MatchRecv (int fd, off_t offset, UINT64 physic_time, UINT64 logic_ti
 	if (sizeof(receives) != size)
 	{
 		perror ("write");
-		fprintf (stderr, "mpi2prv: Error on MatchRecv! Unable to write (fd = %d, size = %ld, written = %Zu)\n", fd, sizeof(r), size);
+		fprintf (stderr, "mpi2prv: Error on MatchRecv! Unable to write (fd = %d, size = %ld, written = %Zu)\n", fd, sizeof(receives), size);
 		exit (-2);
 	}
 }
@@ -319,8 +334,83 @@ static int MatchRecvs (struct ForeignRecv_t *data, int count)
 }
 
 
+static unsigned ForeignRecvHash (int sender_app, int sender, int recver_app,
+	int recver, int tag, int mz)
+{
+	UINT64 h = (unsigned) sender_app;
+
+	h = h * 0x100000001b3ULL ^ (unsigned) sender;
+	h = h * 0x100000001b3ULL ^ (unsigned) recver_app;
+	h = h * 0x100000001b3ULL ^ (unsigned) recver;
+	h = h * 0x100000001b3ULL ^ (unsigned) tag;
+	h = h * 0x100000001b3ULL ^ (unsigned) mz;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return (unsigned) h;
+}
+
+#define FOREIGN_RECV_KEY_EQ(r,sa,s,ra,r_,t,m) \
+	((r)->sender == (s) && (r)->sender_app == (sa) && (r)->recver == (r_) && \
+	 (r)->recver_app == (ra) && (r)->tag == (t) && (r)->match_zone == (m))
+
+static struct ForeignRecvBucket_t * FindForeignRecvBucket (
+	struct ForeignRecvIndex_t *index, struct ForeignRecv_t *data,
+	int sender_app, int sender, int recver_app, int recver, int tag, int mz)
+{
+	unsigned pos = ForeignRecvHash (sender_app, sender, recver_app, recver, tag, mz) & index->mask;
+
+	while (index->buckets[pos].key != -1)
+	{
+		struct ForeignRecv_t *r = &data[index->buckets[pos].key];
+		if (FOREIGN_RECV_KEY_EQ(r, sender_app, sender, recver_app, recver, tag, mz))
+			return &index->buckets[pos];
+		pos = (pos + 1) & index->mask;
+	}
+	return &index->buckets[pos];
+}
+
+static void BuildForeignRecvIndex (struct ForeignRecvIndex_t *index,
+	struct ForeignRecv_t *data, int count)
+{
+	unsigned i, size = 16;
+
+	/* Keep the table at most half full */
+	while (size < 2 * (unsigned) count)
+		size <<= 1;
+
+	index->mask = size - 1;
+	index->buckets = (struct ForeignRecvBucket_t*) malloc (size*sizeof(struct ForeignRecvBucket_t));
+	index->next = (int*) malloc (count*sizeof(int));
+	if (NULL == index->buckets || NULL == index->next)
+	{
+		fprintf (stderr, "mpi2prv: Error! Cannot allocate memory to index the foreign receives!\n");
+		exit (-1);
+	}
+	for (i = 0; i < size; i++)
+		index->buckets[i].key = index->buckets[i].head = index->buckets[i].tail = -1;
+
+	for (i = 0; i < (unsigned) count; i++)
+	{
+		struct ForeignRecvBucket_t *b = FindForeignRecvBucket (index, data,
+		  data[i].sender_app, data[i].sender, data[i].recver_app, data[i].recver,
+		  data[i].tag, data[i].match_zone);
+
+		index->next[i] = -1;
+		if (b->key == -1)
+		{
+			b->key = b->head = i;
+		}
+		else
+			index->next[b->tail] = i;
+		b->tail = i;
+	}
+}
+
 struct ForeignRecv_t* SearchForeignRecv (int group, int sender_app, int sender, int recver_app, int recver, int tag, int mz)
 {
+	struct ForeignRecvIndex_t *index;
+	struct ForeignRecvBucket_t *exact = NULL, *any, *b;
 	int i;
 
 #if defined(DEBUG)
@@ -328,60 +418,72 @@ struct ForeignRecv_t* SearchForeignRecv (int group, int sender_app, int sender,
 		group, sender, sender_app, recver, recver_app, tag);
 #endif
 
-	if (myForeignRecvs_count != NULL && myForeignRecvs != NULL)
-	{
-		if (myForeignRecvs[group] != NULL)
-			for (i = 0; i < myForeignRecvs_count[group]; i++)
-			{
-#if defined(DEBUG)
-				fprintf (stdout, "DEBUG: (sender/app = %d/%d, recver/app = %d/%d, tag = %d) vs (sender/app = %d/%d, recver = %d/%d, tag = %d)\n",
-				  sender, sender_app, recver, recver_app, tag,
-				  myForeignRecvs[group][i].sender, myForeignRecvs[group][i].sender_app,
-				  myForeignRecvs[group][i].recver, myForeignRecvs[group][i].recver_app,
-				  myForeignRecvs[group][i].tag);
-#endif
-				if (myForeignRecvs[group][i].match_zone == mz &&
-				    myForeignRecvs[group][i].sender == sender &&
-				    myForeignRecvs[group][i].sender_app == sender_app &&
-				    myForeignRecvs[group][i].recver == recver &&
-				    myForeignRecvs[group][i].recver_app == recver_app &&
-			  	  (myForeignRecvs[group][i].tag == tag || myForeignRecvs[group][i].tag == MPI_ANY_TAG) &&
-			    	!myForeignRecvs_used[group][i])
-				{
-					myForeignRecvs_used[group][i] = TRUE;
-					return &myForeignRecvs[group][i];
-				}
-			}
-	}
-	return NULL;
+	if (myForeignRecvs_count == NULL || myForeignRecvs == NULL || myForeignRecvs[group] == NULL)
+		return NULL;
+
+	/* The receive that matches is the oldest one still pending either with
+	   the very same tag or posted with MPI_ANY_TAG */
+	index = &myForeignRecvs_index[group];
+	if (tag != MPI_ANY_TAG)
+		exact = FindForeignRecvBucket (index, myForeignRecvs[group], sender_app, sender, recver_app, recver, tag, mz);
+	any = FindForeignRecvBucket (index, myForeignRecvs[group], sender_app, sender, recver_app, recver, MPI_ANY_TAG, mz);
+
+	if (exact != NULL && exact->head != -1 && (any->head == -1 || exact->head < any->head))
+		b = exact;
+	else if (any->head != -1)
+		b = any;
+	else
+		return NULL;
+
+	i = b->head;
+	b->head = index->next[i];
+	myForeignRecvs_used[group][i] = TRUE;
+	return &myForeignRecvs[group][i];
 }
 
-static int RecvMine (int taskid, int from, int match, int *out_count, struct ForeignRecv_t **out, char **used)
+/* Describes struct ForeignRecv_t so that it can be exchanged among
+   heterogeneous merger processes */
+static MPI_Datatype ForeignRecv_Datatype (void)
 {
-	MPI_Status s;
-	int res, count;
-	struct ForeignRecv_t *data;
-	int num_match = 0;
+	struct ForeignRecv_t r;
+	int i, res, blocklens[3] = { 2, 6, 2 };
+	MPI_Aint base, displs[3];
+	MPI_Datatype types[3] = { MPI_UNSIGNED_LONG_LONG, MPI_INT, MPI_UNSIGNED };
+	MPI_Datatype tmp, type;
+
+	MPI_Get_address (&r, &base);
+	MPI_Get_address (&r.physic, &displs[0]);
+	MPI_Get_address (&r.sender, &displs[1]);
+	MPI_Get_address (&r.thread, &displs[2]);
+	for (i = 0; i < 3; i++)
+		displs[i] -= base;
+
+	res = MPI_Type_create_struct (3, blocklens, displs, types, &tmp);
+	MPI_CHECK(res, MPI_Type_create_struct, "Failed to describe foreign receives");
+	res = MPI_Type_create_resized (tmp, 0, sizeof(struct ForeignRecv_t), &type);
+	MPI_CHECK(res, MPI_Type_create_resized, "Failed to describe foreign receives");
+	MPI_Type_free (&tmp);
+	res = MPI_Type_commit (&type);
+	MPI_CHECK(res, MPI_Type_commit, "Failed to describe foreign receives");
+
+	return type;
+}
 
-	res = MPI_Recv (&count, 1, MPI_INT, from, HOWMANY_FOREIGN_RECVS_TAG, MPI_COMM_WORLD, &s);
-	MPI_CHECK(res, MPI_Recv, "Failed to receive count of foreign receives");
+/* Either matches the foreign receives coming from processor 'from' against
+   the pending communications (and frees them), or keeps them indexed for the
+   translation. Returns the number of communications matched */
+static int StoreForeignRecvs (int taskid, int from, int match,
+	struct ForeignRecv_t *data, int count, int owned)
+{
+	int num_match = 0;
 
 	if (count > 0)
 	{
-		data = (struct ForeignRecv_t*) malloc (count*sizeof(struct ForeignRecv_t));
-		if (NULL == data)
-		{
-			fprintf (stderr, "mpi2prv: Error! Failed to allocate memory to receive foreign receives\n");
-			fflush (stderr);
-			exit (0);
-		}
-
-		res = MPI_Recv (data, count*sizeof(struct ForeignRecv_t), MPI_BYTE, from, BUFFER_FOREIGN_RECVS_TAG, MPI_COMM_WORLD, &s);
-		MPI_CHECK(res, MPI_Recv, "Failed to receive foreign receives");
 		if (match)
 		{
 			num_match = MatchRecvs (data, count);
-			free (data);
+			if (owned)
+				free (data);
 		}
 		else
 		{
@@ -397,9 +499,11 @@ static int RecvMine (int taskid, int from, int match, int *out_count, struct For
 			for (i = 0; i < count; i++)
 				data_used[i] = FALSE;
 
-			*used = data_used;
-			*out_count = count;
-			*out = data;
+			myForeignRecvs_used[from] = data_used;
+			myForeignRecvs_count[from] = count;
+			myForeignRecvs[from] = data;
+
+			BuildForeignRecvIndex (&myForeignRecvs_index[from], data, count);
 		}
 	}
 
@@ -413,42 +517,168 @@ static int RecvMine (int taskid, int from, int match, int *out_count, struct For
 				fprintf (stdout, "mpi2prv: Processor %d did not receive communications from processor %d\n", taskid, from);
 		}
 	}
-	
-	fflush (stdout);
 
 	return num_match;
 }
 
-static void SendMine (int taskid, int to, MPI_Request *req1, MPI_Request *req2)
-{	
-	int res;
+/* Exchanges all the foreign receives at once. The receives of every
+   processor are left in a single buffer that is kept for the translation
+   (unless they are matched right away) */
+static void ExchangeForeignRecvs_Alltoallv (int numtasks, int taskid, int match,
+	MPI_Datatype type, int *sendcounts, int *recvcounts)
+{
+	int *sdispls, *rdispls;
+	int i, res, total_send = 0, total_recv = 0;
+	struct ForeignRecv_t *sendbuf = NULL, *recvbuf = NULL;
 
-	/* Send info on how many recvs will be transmitted */
-	res = MPI_Isend (&(ForeignRecvs[to].count), 1, MPI_INT, to, HOWMANY_FOREIGN_RECVS_TAG, MPI_COMM_WORLD, req1);
-	MPI_CHECK(res, MPI_Isend, "Failed to send quantity of foreign receives");
+	sdispls = (int*) malloc (sizeof(int)*numtasks);
+	rdispls = (int*) malloc (sizeof(int)*numtasks);
+	if (NULL == sdispls || NULL == rdispls)
+	{
+		fprintf (stderr, "mpi2prv: Error! Cannot allocate memory to exchange foreign receives!\n");
+		exit (-1);
+	}
+	for (i = 0; i < numtasks; i++)
+	{
+		sdispls[i] = total_send;
+		rdispls[i] = total_recv;
+		total_send += sendcounts[i];
+		total_recv += recvcounts[i];
+	}
 
-	if (ForeignRecvs[to].count > 0)
+	if (total_send > 0)
 	{
-		if (get_option_merge_VerboseLevel() >= 1)
+		sendbuf = (struct ForeignRecv_t*) malloc (total_send*sizeof(struct ForeignRecv_t));
+		if (NULL == sendbuf)
 		{
-			fprintf (stdout, "mpi2prv: Processor %d distributes %d foreign receives to processor %d\n", taskid, ForeignRecvs[to].count, to);
-			fflush (stdout);
+			fprintf (stderr, "mpi2prv: Error! Cannot allocate memory to send foreign receives!\n");
+			exit (-1);
 		}
+	}
+	if (total_recv > 0)
+	{
+		recvbuf = (struct ForeignRecv_t*) malloc (total_recv*sizeof(struct ForeignRecv_t));
+		if (NULL == recvbuf)
+		{
+			fprintf (stderr, "mpi2prv: Error! Failed to allocate memory to receive foreign receives\n");
+			exit (-1);
+		}
+	}
 
-		/* Send data */
-		res = MPI_Isend (ForeignRecvs[to].data, ForeignRecvs[to].count*sizeof(struct ForeignRecv_t), MPI_BYTE, to, BUFFER_FOREIGN_RECVS_TAG, MPI_COMM_WORLD, req2);
-		MPI_CHECK(res, MPI_Isend, "Failed to send foreign receives");
+	for (i = 0; i < numtasks; i++)
+	{
+		if (sendcounts[i] > 0)
+		{
+			memcpy (&sendbuf[sdispls[i]], ForeignRecvs[i].data, sendcounts[i]*sizeof(struct ForeignRecv_t));
+			if (get_option_merge_VerboseLevel() >= 1)
+				fprintf (stdout, "mpi2prv: Processor %d distributes %d foreign receives to processor %d\n", taskid, sendcounts[i], i);
+		}
+		free (ForeignRecvs[i].data);
+		ForeignRecvs[i].data = NULL;
 	}
-	else
+
+	res = MPI_Alltoallv (sendbuf, sendcounts, sdispls, type,
+	  recvbuf, recvcounts, rdispls, type, MPI_COMM_WORLD);
+	MPI_CHECK(res, MPI_Alltoallv, "Failed to exchange foreign receives");
+
+	if (sendbuf != NULL)
+		free (sendbuf);
+
+	for (i = 0; i < numtasks; i++)
+		if (i != taskid)
+			StoreForeignRecvs (taskid, i, match, &recvbuf[rdispls[i]], recvcounts[i], FALSE);
+
+	if (match && recvbuf != NULL)
+		free (recvbuf);
+
+	free (sdispls);
+	free (rdispls);
+}
+
+/* Exchanges the foreign receives with 'window' processors at a time, so that
+   the receives in flight are bounded. With a window of one, this is the
+   skewed pairwise exchange: in round 'skew' every processor sends to
+   taskid+skew and receives from taskid-skew */
+static void ExchangeForeignRecvs_Windowed (int numtasks, int taskid, int match,
+	MPI_Datatype type, int *sendcounts, int *recvcounts, int window)
+{
+	MPI_Request *reqs;
+	struct ForeignRecv_t **recvbufs;
+	int first, skew, nreqs, res;
+
+	reqs = (MPI_Request*) malloc (2*window*sizeof(MPI_Request));
+	recvbufs = (struct ForeignRecv_t**) malloc (window*sizeof(struct ForeignRecv_t*));
+	if (NULL == reqs || NULL == recvbufs)
 	{
-		if (get_option_merge_VerboseLevel() >= 1)
-			fprintf(stdout, "mpi2prv: Processor %d does not have foreign receives for processor %d\n", taskid, to);
+		fprintf (stderr, "mpi2prv: Error! Cannot allocate memory to exchange foreign receives!\n");
+		exit (-1);
 	}
+
+	for (first = 1; first < numtasks; first += window)
+	{
+		int last = (first + window < numtasks) ? first + window : numtasks;
+
+		nreqs = 0;
+		for (skew = first; skew < last; skew++)
+		{
+			int from = (taskid - skew + numtasks) % numtasks;
+
+			recvbufs[skew-first] = NULL;
+			if (recvcounts[from] > 0)
+			{
+				recvbufs[skew-first] = (struct ForeignRecv_t*) malloc (recvcounts[from]*sizeof(struct ForeignRecv_t));
+				if (NULL == recvbufs[skew-first])
+				{
+					fprintf (stderr, "mpi2prv: Error! Failed to allocate memory to receive foreign receives\n");
+					exit (-1);
+				}
+				res = MPI_Irecv (recvbufs[skew-first], recvcounts[from], type, from,
+				  BUFFER_FOREIGN_RECVS_TAG, MPI_COMM_WORLD, &reqs[nreqs++]);
+				MPI_CHECK(res, MPI_Irecv, "Failed to receive foreign receives");
+			}
+		}
+		for (skew = first; skew < last; skew++)
+		{
+			int to = (taskid + skew) % numtasks;
+
+			if (sendcounts[to] > 0)
+			{
+				if (get_option_merge_VerboseLevel() >= 1)
+					fprintf (stdout, "mpi2prv: Processor %d distributes %d foreign receives to processor %d\n", taskid, sendcounts[to], to);
+				res = MPI_Isend (ForeignRecvs[to].data, sendcounts[to], type, to,
+				  BUFFER_FOREIGN_RECVS_TAG, MPI_COMM_WORLD, &reqs[nreqs++]);
+				MPI_CHECK(res, MPI_Isend, "Failed to send foreign receives");
+			}
+		}
+
+		res = MPI_Waitall (nreqs, reqs, MPI_STATUSES_IGNORE);
+		MPI_CHECK(res, MPI_Waitall, "Failed to exchange foreign receives");
+
+		for (skew = first; skew < last; skew++)
+		{
+			int to = (taskid + skew) % numtasks;
+			int from = (taskid - skew + numtasks) % numtasks;
+
+			StoreForeignRecvs (taskid, from, match, recvbufs[skew-first], recvcounts[from], TRUE);
+			free (ForeignRecvs[to].data);
+			ForeignRecvs[to].data = NULL;
+		}
+	}
+
+	/* The receives a processor has for itself are never sent */
+	free (ForeignRecvs[taskid].data);
+	ForeignRecvs[taskid].data = NULL;
+
+	free (reqs);
+	free (recvbufs);
 }
 
 void NewDistributePendingComms (int numtasks, int taskid, int match)
 {
-	int i, skew, res;
+	MPI_Datatype type;
+	int *sendcounts, *recvcounts;
+	int i, res;
+	long long bytes, max_bytes, max_peer_bytes, bound;
 
 	if (0 == taskid)
 	{
@@ -476,41 +706,98 @@ void NewDistributePendingComms (int numtasks, int taskid, int match)
 			fprintf (stderr, "mpi2prv: Error! Cannot allocate memory to control the number of foreign receives!\n");
 			exit (-1);
 		}
+		myForeignRecvs_index = (struct ForeignRecvIndex_t*) malloc (sizeof(struct ForeignRecvIndex_t)*numtasks);
+		if (NULL == myForeignRecvs_index)
+		{
+			fprintf (stderr, "mpi2prv: Error! Cannot allocate memory to index foreign receives!\n");
+			exit (-1);
+		}
 		for (i = 0; i < numtasks; i++)
 		{
 			myForeignRecvs_count[i] = 0;
 			myForeignRecvs[i] = NULL;
 			myForeignRecvs_used[i] = NULL;
+			myForeignRecvs_index[i].buckets = NULL;
+			myForeignRecvs_index[i].next = NULL;
+			myForeignRecvs_index[i].mask = 0;
 		}
 	}
 
-	for (skew = 1; skew < numtasks; skew++)
+	/* Tell every processor how many receives it will get from this one */
+	sendcounts = (int*) malloc (sizeof(int)*numtasks);
+	recvcounts = (int*) malloc (sizeof(int)*numtasks);
+	if (NULL == sendcounts || NULL == recvcounts)
+	{
+		fprintf (stderr, "mpi2prv: Error! Cannot allocate memory to exchange foreign receives!\n");
+		exit (-1);
+	}
+	for (i = 0; i < numtasks; i++)
+		sendcounts[i] = (i != taskid) ? ForeignRecvs[i].count : 0;
+
+	res = MPI_Alltoall (sendcounts, 1, MPI_INT, recvcounts, 1, MPI_INT, MPI_COMM_WORLD);
+	MPI_CHECK(res, MPI_Alltoall, "Failed to exchange the number of foreign receives");
+
+	if (get_option_merge_VerboseLevel() >= 1)
+		for (i = 0; i < numtasks; i++)
+			if (i != taskid && sendcounts[i] == 0)
+				fprintf(stdout, "mpi2prv: Processor %d does not have foreign receives for processor %d\n", taskid, i);
+
+	/* By default, the receives are exchanged with one processor at a time
+	   in skewed rounds. If a memory bound is given, the rounds are widened
+	   so that up to that memory is in flight, and if a single collective is
+	   requested it is used unless a processor would need more memory than
+	   allowed for it (the data being sent is packed) */
+	type = ForeignRecv_Datatype ();
+	bound = ((long long) get_option_merge_ExchangeMaxMem()) << 20;
+	if (bound > 0)
 	{
-		MPI_Request send_req1, send_req2;
-		MPI_Status sts;
-		int to, from;
+		long long peer[2], max_peer[2];
 
-		to = (taskid + skew) % numtasks;
-		from = (taskid - skew + numtasks) % numtasks;
+		for (i = 0, bytes = 0, max_peer_bytes = 0; i < numtasks; i++)
+		{
+			long long b = ((long long) sendcounts[i] + recvcounts[i]) * sizeof(struct ForeignRecv_t);
+			bytes += b + (long long) sendcounts[i] * sizeof(struct ForeignRecv_t);
+			if (b > max_peer_bytes)
+				max_peer_bytes = b;
+		}
+		peer[0] = bytes;
+		peer[1] = max_peer_bytes;
+		res = MPI_Allreduce (peer, max_peer, 2, MPI_LONG_LONG_INT, MPI_MAX, MPI_COMM_WORLD);
+		MPI_CHECK(res, MPI_Allreduce, "Failed to share the size of foreign receives");
+		max_bytes = max_peer[0];
+		max_peer_bytes = max_peer[1];
+	}
+	else
+		max_bytes = max_peer_bytes = 0;
 
-		SendMine (taskid, to, &send_req1, &send_req2);
-		RecvMine (taskid, from, match, &myForeignRecvs_count[from], &myForeignRecvs[from], &myForeignRecvs_used[from]);
+	if (get_option_merge_ExchangeCollective() && (bound == 0 || max_bytes <= bound))
+	{
+		if (0 == taskid)
+			fprintf (stdout, "mpi2prv: Exchanging foreign receives in a single collective.\n");
 
-		MPI_Wait (&send_req1, &sts);
-		if (ForeignRecvs[to].count > 0)
-			MPI_Wait (&send_req2, &sts);
+		ExchangeForeignRecvs_Alltoallv (numtasks, taskid, match, type, sendcounts, recvcounts);
+	}
+	else
+	{
+		int window = 1;
+
+		if (bound > 0)
+		{
+			window = (max_peer_bytes > 0 && bound / max_peer_bytes < numtasks) ?
+			  (int) (bound / max_peer_bytes) : numtasks;
+			if (window < 1)
+				window = 1;
 
-		/* Free data */
-		free (ForeignRecvs[to].data);
+			if (0 == taskid)
+				fprintf (stdout, "mpi2prv: Exchanging foreign receives with %d processors at a time.\n", window);
+		}
 
-/*
-		res = MPI_Barrier (MPI_COMM_WORLD);
-		MPI_CHECK(res, MPI_Barrier, "Failed to synchronize distribution of pending communications");
-*/
+		ExchangeForeignRecvs_Windowed (numtasks, taskid, match, type, sendcounts, recvcounts, window);
 	}
 
-	res = MPI_Barrier (MPI_COMM_WORLD);
-	MPI_CHECK(res, MPI_Barrier, "Failed to synchronize distribution of pending communications");
+	MPI_Type_free (&type);
+	free (sendcounts);
+	free (recvcounts);
 
 	if (!match)
 	{
@@ -520,7 +807,7 @@ void NewDistributePendingComms (int numtasks, int taskid, int match)
 			total += myForeignRecvs_count[i];
 
 		fprintf (stdout, "mpi2prv: Processor %d is storing %d foreign receives (%lld Kbytes) for the next phase.\n",
-			taskid, total, (((long long) total)*(sizeof(struct ForeignRecv_t)+sizeof(char)))/1024);
+			taskid, total, (((long long) total)*(sizeof(struct ForeignRecv_t)+sizeof(char)+sizeof(int)+2*sizeof(struct ForeignRecvBucket_t)))/1024);
 	}
 
 	if (0 == taskid)
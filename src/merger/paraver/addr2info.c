@@ -38,6 +38,9 @@
 #ifdef HAVE_LIBGEN_H
 # include <libgen.h>
 #endif
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+# include <pthread.h>
+#endif
 
 // #define DEBUG
 
@@ -379,6 +382,28 @@ UINT64 Address2Info_Translate_MemReference (unsigned ptask, unsigned task, UINT6
 #endif
 }
 
+#if defined(HAVE_BFD)
+/** Address2Info_CallerAddress
+ *
+ * Returns the address to translate for the given query. Return addresses
+ * of MPI and CUDA calls point to the instruction after the call, so they
+ * are moved back into the call instruction.
+ */
+static UINT64 Address2Info_CallerAddress (UINT64 address, int query)
+{
+	switch (query)
+	{
+		case ADDR2MPI_FUNCTION:
+		case ADDR2MPI_LINE:
+		case ADDR2CUDA_FUNCTION:
+		case ADDR2CUDA_LINE:
+			return address - 1;
+		default:
+			return address;
+	}
+}
+#endif /* HAVE_BFD */
+
 /** Address2Info_Translate
  *
  * 
@@ -455,43 +480,39 @@ UINT64 Address2Info_Translate (unsigned ptask, unsigned task, UINT64 address,
 		case ADDR2MPI_FUNCTION:
 		case ADDR2MPI_LINE:
 			Address2Info_Labels[A2I_MPI] = TRUE;
-			caller_address = address - 1;
 			addr_type = uniqueID?UNIQUE_TYPE:MPI_CALLER_TYPE;
 			break;
 		case ADDR2OMP_FUNCTION:
 		case ADDR2OMP_LINE:
 			Address2Info_Labels[A2I_OMP] = TRUE;
-			caller_address = address;
 			addr_type = uniqueID?UNIQUE_TYPE:OUTLINED_OPENMP_TYPE;
 			break;
 		case ADDR2CUDA_FUNCTION:
 		case ADDR2CUDA_LINE:
 			Address2Info_Labels[A2I_CUDA] = TRUE;
-			caller_address = address-1;
 			addr_type = uniqueID?UNIQUE_TYPE:CUDAKERNEL_TYPE;
 			break;
 		case ADDR2UF_FUNCTION:
 		case ADDR2UF_LINE:
 			Address2Info_Labels[A2I_UF] = TRUE;
-			caller_address = address;
 			addr_type = uniqueID?UNIQUE_TYPE:USER_FUNCTION_TYPE;
 			break;
 		case ADDR2SAMPLE_FUNCTION:
 		case ADDR2SAMPLE_LINE:
 			Address2Info_Labels[A2I_SAMPLE] = TRUE;
-			caller_address = address;
 			addr_type = uniqueID?UNIQUE_TYPE:SAMPLE_TYPE;
 			break;
 		case ADDR2OTHERS_FUNCTION:
 		case ADDR2OTHERS_LINE:
 			Address2Info_Labels[A2I_OTHERS] = TRUE;
-			caller_address = address;
 			addr_type = uniqueID?UNIQUE_TYPE:OTHER_FUNCTION_TYPE;
 			break;
 		default:
 			return address;
 	}
 
+	caller_address = Address2Info_CallerAddress (address, query);
+
 /* Traduciremos caller_address para obtener la linea exacta del codigo, pero
  * escribiremos address en el PCF.
  * En un objdump y utilidades similares, no podemos buscar
@@ -516,6 +537,7 @@ UINT64 Address2Info_Translate (unsigned ptask, unsigned task, UINT64 address,
 				already_translated = TRUE;
 				function_id = AddressTable[addr_type]->address[i].function_id;
 				line_id = i;
+				Addr2Info_HashCache_CountResolution (ADDR2INFO_LEVEL_TABLE);
 				break;
 			}
 		}
@@ -531,6 +553,7 @@ UINT64 Address2Info_Translate (unsigned ptask, unsigned task, UINT64 address,
 		char * module;
 
 		Translate_Address (caller_address, ptask, task, &module, &funcname, &filename, &line);
+		Addr2Info_HashCache_CountResolution (ADDR2INFO_LEVEL_BINARY);
 
 		/* Samples can be taken anywhere in the code. It can happen that two
 		   samples at the different addresses refer to the same combination of
@@ -771,10 +794,269 @@ static void Translate_Address_Data (UINT64 address, unsigned ptask, unsigned tas
 #endif /* HAVE_BFD */
 
 #if defined(HAVE_BFD)
+/** Translate_Address_BFD
+ *
+ * Looks up the address in the binary object that contains it (or in the
+ * main binary if none does) through BFD.
+ */
+static int Translate_Address_BFD (binary_object_t *obj, UINT64 address,
+	char **function, char **file, int *line)
+{
+	int found = FALSE;
+
+	if (obj)
+	{
+		found = BFDmanager_translateAddress (obj->bfdImage, obj->bfdSymbols,
+		  (void*) address, function, file, line);
+
+		/* If we didn't find the address, then the function is possibly in a shared
+		   library. Substract base address and retry.
+		   If we found it, just ensure we don't get the module name for the main binary */
+		if (!found)
+		{
+			found = BFDmanager_translateAddress (obj->bfdImage, obj->bfdSymbols,
+			  (void*) (address - obj->start_address), function, file, line);
+		}
+	}
+	else
+	{
+		found = BFDmanager_translateAddress (BFDmanager_getDefaultImage(),
+		  BFDmanager_getDefaultSymbols(), (void*) address, function, file, line);
+	}
+
+	return found;
+}
+
+/* Addresses resolved in bulk by Address2Info_ResolveBatch, sorted by image,
+   object and address so that Translate_Address finds them with a binary
+   search. All the objects sharing a BFD image are contiguous, and they are
+   resolved by a single thread as BFD images are not thread-safe. The names
+   are copied, as BFD may reuse the memory they point to. */
+typedef struct
+{
+	bfd *image;
+	binary_object_t *obj;
+	UINT64 address;
+	int found;
+	char *function;
+	char *file;
+	int line;
+} Address2Info_Resolved_t;
+
+static Address2Info_Resolved_t *ResolvedAddresses = NULL;
+static unsigned nResolvedAddresses = 0;
+
+static int Address2Info_Resolved_compare (const void *p1, const void *p2)
+{
+	const Address2Info_Resolved_t *r1 = (const Address2Info_Resolved_t*) p1;
+	const Address2Info_Resolved_t *r2 = (const Address2Info_Resolved_t*) p2;
+
+	if (r1->image != r2->image)
+		return ((uintptr_t) r1->image < (uintptr_t) r2->image) ? -1 : 1;
+	if (r1->obj != r2->obj)
+		return ((uintptr_t) r1->obj < (uintptr_t) r2->obj) ? -1 : 1;
+	if (r1->address != r2->address)
+		return (r1->address < r2->address) ? -1 : 1;
+	return 0;
+}
+
+static Address2Info_Resolved_t * Address2Info_Resolved_search (
+	binary_object_t *obj, UINT64 address)
+{
+	Address2Info_Resolved_t key;
+
+	if (nResolvedAddresses == 0)
+		return NULL;
+
+	key.image = obj ? obj->bfdImage : BFDmanager_getDefaultImage();
+	key.obj = obj;
+	key.address = address;
+
+	return (Address2Info_Resolved_t*) bsearch (&key, ResolvedAddresses,
+	  nResolvedAddresses, sizeof(Address2Info_Resolved_t),
+	  Address2Info_Resolved_compare);
+}
+
+static void Address2Info_Resolved_free (void)
+{
+	unsigned i;
+
+	for (i = 0; i < nResolvedAddresses; i++)
+	{
+		xfree (ResolvedAddresses[i].function);
+		xfree (ResolvedAddresses[i].file);
+	}
+	xfree (ResolvedAddresses);
+	nResolvedAddresses = 0;
+}
+
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+# if defined(HAVE_BFD_THREAD_INIT)
+static pthread_mutex_t Address2Info_BFD_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static bool Address2Info_BFD_lock (void *data)
+{
+	return pthread_mutex_lock ((pthread_mutex_t*) data) == 0;
+}
+
+static bool Address2Info_BFD_unlock (void *data)
+{
+	return pthread_mutex_unlock ((pthread_mutex_t*) data) == 0;
+}
+# endif
+
+/* Tells whether BFD can be called from several threads at once. This needs
+   bfd_thread_init (binutils 2.42 and later), otherwise its global state
+   (e.g. the error status and the caches) is shared without any lock. */
+static int Address2Info_BFD_isThreadSafe (void)
+{
+# if defined(HAVE_BFD_THREAD_INIT)
+	static int initialized = FALSE, thread_safe = FALSE;
+
+	if (!initialized)
+	{
+		thread_safe = bfd_thread_init (Address2Info_BFD_lock,
+		  Address2Info_BFD_unlock, &Address2Info_BFD_mutex);
+		initialized = TRUE;
+	}
+	return thread_safe;
+# else
+	return FALSE;
+# endif
+}
+#endif
+
+typedef struct
+{
+	unsigned next;      /* First entry not resolved yet */
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+	pthread_mutex_t lock;
+#endif
+} ResolveQueue_t;
+
+static void * Address2Info_ResolveBatch_Worker (void *arg)
+{
+	ResolveQueue_t *queue = (ResolveQueue_t *) arg;
+	unsigned first, last, i;
+
+	while (1)
+	{
+		/* Take the next run of entries sharing a BFD image */
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+		pthread_mutex_lock (&(queue->lock));
+#endif
+		first = queue->next;
+		for (last = first; last < nResolvedAddresses &&
+		  ResolvedAddresses[last].image == ResolvedAddresses[first].image; last++);
+		queue->next = last;
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+		pthread_mutex_unlock (&(queue->lock));
+#endif
+		if (first >= nResolvedAddresses)
+			break;
+
+		for (i = first; i < last; i++)
+		{
+			Address2Info_Resolved_t *r = &ResolvedAddresses[i];
+			char *function = NULL, *file = NULL;
+
+			r->line = 0;
+			r->found = Translate_Address_BFD (r->obj, r->address, &function,
+			  &file, &r->line);
+			r->function = (function != NULL) ? strdup (function) : NULL;
+			r->file = (file != NULL) ? strdup (file) : NULL;
+		}
+	}
+
+	return NULL;
+}
+
+/** Address2Info_ResolveBatch
+ *
+ * Resolves at once the distinct addresses that will be later translated
+ * through Address2Info_Translate, so that these only look up the result
+ * instead of querying BFD. The addresses of every binary image are sorted
+ * and images are resolved on up to get_option_merge_NumThreads() threads.
+ */
+void Address2Info_ResolveBatch (unsigned count, unsigned *ptasks,
+	unsigned *tasks, UINT64 *addresses, int *queries)
+{
+	ResolveQueue_t queue;
+	unsigned i, n;
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+	pthread_t *threads = NULL;
+	unsigned nimages, nthreads = 0;
+#endif
+
+	if (!Translate_Addresses || count == 0)
+		return;
+
+	Address2Info_Resolved_free ();
+	xmalloc (ResolvedAddresses, count * sizeof(Address2Info_Resolved_t));
+
+	for (i = 0; i < count; i++)
+	{
+		Address2Info_Resolved_t r;
+
+		if (addresses[i] == 0)
+			continue;
+
+		r.address = Address2Info_CallerAddress (addresses[i], queries[i]);
+		r.obj = ObjectTable_GetBinaryObjectAt (ptasks[i], tasks[i], r.address);
+		r.image = r.obj ? r.obj->bfdImage : BFDmanager_getDefaultImage();
+		r.function = r.file = NULL;
+		if (r.image != NULL)
+			ResolvedAddresses[nResolvedAddresses++] = r;
+	}
+
+	/* Sort and remove duplicates (e.g. the FUNCTION and LINE queries) */
+	qsort (ResolvedAddresses, nResolvedAddresses, sizeof(Address2Info_Resolved_t),
+	  Address2Info_Resolved_compare);
+	for (i = 0, n = 0; i < nResolvedAddresses; i++)
+		if (n == 0 || Address2Info_Resolved_compare (&ResolvedAddresses[n-1],
+		    &ResolvedAddresses[i]) != 0)
+			ResolvedAddresses[n++] = ResolvedAddresses[i];
+	nResolvedAddresses = n;
+
+	queue.next = 0;
+
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+	pthread_mutex_init (&(queue.lock), NULL);
+
+	for (i = 0, nimages = 0; i < nResolvedAddresses; i++)
+		if (i == 0 || ResolvedAddresses[i].image != ResolvedAddresses[i-1].image)
+			nimages++;
+
+	/* Without a thread-safe BFD, all the images are resolved by this thread */
+	if (get_option_merge_NumThreads() > 1 && nimages > 1 &&
+	    Address2Info_BFD_isThreadSafe())
+	{
+		unsigned max = MIN((unsigned) get_option_merge_NumThreads(), nimages) - 1;
+
+		xmalloc (threads, max * sizeof(pthread_t));
+		for (nthreads = 0; nthreads < max; nthreads++)
+			if (pthread_create (&threads[nthreads], NULL,
+			    Address2Info_ResolveBatch_Worker, &queue) != 0)
+				break;
+	}
+#endif
+
+	/* This thread also resolves images, all of them if there are no more threads */
+	Address2Info_ResolveBatch_Worker (&queue);
+
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+	for (i = 0; i < nthreads; i++)
+		pthread_join (threads[i], NULL);
+	xfree (threads);
+	pthread_mutex_destroy (&(queue.lock));
+#endif
+}
+
 static void Translate_Address (UINT64 address, unsigned ptask, unsigned task,
 	char **module, char ** funcname, char ** filename, int * line)
 {
 	binary_object_t *obj;
+	Address2Info_Resolved_t *resolved;
 	int found = FALSE;
 	char *translated_function = NULL;
 	char *translated_filename = NULL;
@@ -799,27 +1081,17 @@ static void Translate_Address (UINT64 address, unsigned ptask, unsigned task,
 		printf ("obj = NULL for address %llx\n", address);
 # endif
 
-	if (obj)
+	/* Use the result of the batch resolution if the address was in it */
+	if ((resolved = Address2Info_Resolved_search (obj, address)) != NULL)
 	{
-		found = BFDmanager_translateAddress (obj->bfdImage, obj->bfdSymbols,
-		  (void*) address, &translated_function, &translated_filename, &translated_line);
-
-		/* If we didn't find the address, then the function is possibly in a shared
-		   library. Substract base address and retry.
-		   If we found it, just ensure we don't get the module name for the main binary */
-		if (!found)
-		{
-			found = BFDmanager_translateAddress (obj->bfdImage, obj->bfdSymbols,
-			  (void*) (address - obj->start_address), &translated_function,
-			  &translated_filename, &translated_line);
-		}
+		found = resolved->found;
+		translated_function = resolved->function;
+		translated_filename = resolved->file;
+		translated_line = resolved->line;
 	}
 	else
-	{
-		found = BFDmanager_translateAddress (BFDmanager_getDefaultImage(),
-		  BFDmanager_getDefaultSymbols(), (void*) address, &translated_function,
+		found = Translate_Address_BFD (obj, address, &translated_function,
 		  &translated_filename, &translated_line);
-	}
 
 	if (!found) 
 	{
@@ -873,6 +1145,16 @@ static void Translate_Address (UINT64 address, unsigned ptask, unsigned task,
 		if (obj->module != NULL)
 			*module = strdup (basename ((char*) obj->module));
 }
+#else /* HAVE_BFD */
+void Address2Info_ResolveBatch (unsigned count, unsigned *ptasks,
+	unsigned *tasks, UINT64 *addresses, int *queries)
+{
+	UNREFERENCED_PARAMETER(count);
+	UNREFERENCED_PARAMETER(ptasks);
+	UNREFERENCED_PARAMETER(tasks);
+	UNREFERENCED_PARAMETER(addresses);
+	UNREFERENCED_PARAMETER(queries);
+}
 #endif /* HAVE_BFD */
 
 UINT64 Address2Info_GetLibraryID (unsigned ptask, unsigned task, UINT64 address)
@@ -1004,11 +1286,47 @@ void Address2Info_Write_MPI_Labels (FILE * pcf_fd, int uniqueid)
 	}
 }
 
-void Address2Info_Write_MemReferenceCaller_Labels (FILE * pcf_fd)
+static void Address2Info_Write_MemReference_Values (FILE * pcf_fd)
 {
 	int i;
 	char short_label[1+SHORT_STRING_PREFIX+SHORT_STRING_SUFFIX+strlen(SHORT_STRING_INFIX)];
 
+	if (AddressObjectInfo.num_objects > 0)
+		fprintf (pcf_fd, "%s\n0   %s\n", VALUES_LABEL, EVT_END_LBL);
+
+	for (i = 0; i < AddressObjectInfo.num_objects; i++)
+	{
+		struct address_object_info_st *obj = &(AddressObjectInfo.objects[i]);
+
+		if (obj->is_static)
+		{
+			int shortened = __Extrae_Utils_shorten_string (SHORT_STRING_PREFIX,
+			  SHORT_STRING_SUFFIX, SHORT_STRING_INFIX,
+			  sizeof(short_label), short_label, obj->name);
+			if (!shortened)
+				fprintf (pcf_fd, "%d %s\n", i+1, obj->name);
+			else
+				fprintf (pcf_fd, "%d %s [%s]\n", i+1, short_label, obj->name);
+		}
+		else
+		{
+			int shortened = __Extrae_Utils_shorten_string (SHORT_STRING_PREFIX,
+			  SHORT_STRING_SUFFIX, SHORT_STRING_INFIX,
+			  sizeof(short_label), short_label, obj->file_name);
+			if (!shortened)
+				fprintf (pcf_fd, "%d (%s)\n", i+1, obj->file_name);
+			else
+				fprintf (pcf_fd, "%d (%s) [%s]\n", i+1, short_label,
+				  obj->file_name);
+		}
+	}
+
+	if (AddressObjectInfo.num_objects > 0)
+		LET_SPACES(pcf_fd);
+}
+
+void Address2Info_Write_MemReferenceCaller_Labels (FILE * pcf_fd)
+{
 	if (Address2Info_Initialized())
 	{
 		fprintf(pcf_fd, "%s\n", TYPE_LABEL);
@@ -1017,38 +1335,24 @@ void Address2Info_Write_MemReferenceCaller_Labels (FILE * pcf_fd)
 		fprintf(pcf_fd, "0    %d    %s\n", SAMPLING_ADDRESS_ALLOCATED_OBJECT_ALLOC_EV,
 		  SAMPLING_ADDRESS_ALLOCATED_OBJECT_ALLOC_LBL);
 
-		if (AddressObjectInfo.num_objects > 0)
-			fprintf (pcf_fd, "%s\n0   %s\n", VALUES_LABEL, EVT_END_LBL);
-
-		for (i = 0; i < AddressObjectInfo.num_objects; i++)
-		{
-			struct address_object_info_st *obj = &(AddressObjectInfo.objects[i]);
+		Address2Info_Write_MemReference_Values (pcf_fd);
+	}
+}
 
-			if (obj->is_static)
-			{
-				int shortened = __Extrae_Utils_shorten_string (SHORT_STRING_PREFIX,
-				  SHORT_STRING_SUFFIX, SHORT_STRING_INFIX,
-				  sizeof(short_label), short_label, obj->name);
-				if (!shortened)
-					fprintf (pcf_fd, "%d %s\n", i+1, obj->name);
-				else
-					fprintf (pcf_fd, "%d %s [%s]\n", i+1, short_label, obj->name);
-			}
-			else
-			{
-				int shortened = __Extrae_Utils_shorten_string (SHORT_STRING_PREFIX,
-				  SHORT_STRING_SUFFIX, SHORT_STRING_INFIX,
-				  sizeof(short_label), short_label, obj->file_name);
-				if (!shortened)
-					fprintf (pcf_fd, "%d (%s)\n", i+1, obj->file_name);
-				else
-					fprintf (pcf_fd, "%d (%s) [%s]\n", i+1, short_label,
-					  obj->file_name);
-			}
-		}
+/** Address2Info_Write_MemReferenceObject_Labels
+ *
+ * Writes the data objects translated with MEM_REFERENCE_STATIC as the values
+ * of the given event type.
+ */
+void Address2Info_Write_MemReferenceObject_Labels (FILE * pcf_fd, int eventtype,
+	char *eventtype_description)
+{
+	if (Address2Info_Initialized())
+	{
+		fprintf(pcf_fd, "%s\n", TYPE_LABEL);
+		fprintf(pcf_fd, "0    %d    %s\n", eventtype, eventtype_description);
 
-		if (AddressObjectInfo.num_objects > 0)
-			LET_SPACES(pcf_fd);
+		Address2Info_Write_MemReference_Values (pcf_fd);
 	}
 }
 
@@ -54,6 +54,8 @@ void Address2Info_Initialize (char * binary);
 int Address2Info_Initialized (void);
 UINT64 Address2Info_Translate (unsigned ptask, unsigned task, UINT64 address,
 	int event_type, int uniqueID);
+void Address2Info_ResolveBatch (unsigned count, unsigned *ptasks,
+	unsigned *tasks, UINT64 *addresses, int *queries);
 UINT64 Address2Info_Translate_MemReference (unsigned ptask, unsigned task,
 	UINT64 address, int event_type, UINT64 *calleraddresses);
 void Address2Info_Write_CUDA_Labels (FILE * pcf_fd, int uniqueid);
@@ -66,6 +68,8 @@ void Address2Info_Write_OTHERS_Labels (FILE * pcf_fd, int uniqueid, int nlabels,
 	codelocation_label_t *labels);
 void Address2Info_Write_Sample_Labels (FILE * pcf_fd, int uniqueid);
 void Address2Info_Write_MemReferenceCaller_Labels (FILE * pcf_fd);
+void Address2Info_Write_MemReferenceObject_Labels (FILE * pcf_fd, int eventtype,
+	char *eventtype_description);
 void Address2Info_AddSymbol (UINT64 address, int addr_type, char * funcname,
   char * filename, int line);
 void Address2Info_Sort (int unique_ids);
@@ -24,8 +24,14 @@
 #include "common.h"
 #include <stdio.h>
 
-#define CACHE_SIZE 32768
-#define CACHE_MASK 0x7fff
+#include "addr2info_hashcache.h"
+
+/* The cache is organized in CACHE_SETS sets of CACHE_WAYS entries. Each set
+   is kept in most-recently-used order, so a hit moves the entry to the front
+   of its set and an insertion evicts the last (least-recently-used) entry. */
+#define CACHE_WAYS     8
+#define CACHE_SETS     16384
+#define CACHE_SET_MASK (CACHE_SETS-1)
 
 struct Addr2Info_HashCache_Entry
 {
@@ -34,77 +40,125 @@ struct Addr2Info_HashCache_Entry
 	int function_number;
 };
 
-static struct Addr2Info_HashCache_Entry Addr2Info_HashCache[CACHE_SIZE];
-static int Addr2Info_HashCache_Hits;
-static int Addr2Info_HashCache_Misses;
-static int Addr2Info_HashCache_Replacements;
+static struct Addr2Info_HashCache_Entry Addr2Info_HashCache[CACHE_SETS][CACHE_WAYS];
+static unsigned long long Addr2Info_HashCache_Hits;
+static unsigned long long Addr2Info_HashCache_Misses;
+static unsigned long long Addr2Info_HashCache_Replacements;
+static unsigned long long Addr2Info_HashCache_Resolutions[ADDR2INFO_NUM_LEVELS];
 
-static int Addr2Info_HashCache_HashFunction (UINT64 address)
+static unsigned Addr2Info_HashCache_HashFunction (UINT64 address)
 {
-	return address & CACHE_MASK;
+	/* Mix all the bits of the address (MurmurHash3 finalizer) so that
+	   addresses sharing their low bits do not fall into the same set */
+	address ^= address >> 33;
+	address *= 0xff51afd7ed558ccdULL;
+	address ^= address >> 33;
+	address *= 0xc4ceb9fe1a85ec53ULL;
+	address ^= address >> 33;
+
+	return (unsigned) (address & CACHE_SET_MASK);
 }
 
 void Addr2Info_HashCache_Initialize (void)
 {
 	int i;
 
-	for (i = 0; i < CACHE_SIZE; i++)
-		Addr2Info_HashCache[i].address = 0;
+	Addr2Info_HashCache_Clean();
+
 	Addr2Info_HashCache_Hits =
 	  Addr2Info_HashCache_Misses =
 	  Addr2Info_HashCache_Replacements = 0;
+	for (i = 0; i < ADDR2INFO_NUM_LEVELS; i++)
+		Addr2Info_HashCache_Resolutions[i] = 0;
 }
 
 void Addr2Info_HashCache_Clean (void)
 {
-	int i;
+	int i, j;
 
-	for (i = 0; i < CACHE_SIZE; i++)
-		Addr2Info_HashCache[i].address = 0;
+	for (i = 0; i < CACHE_SETS; i++)
+		for (j = 0; j < CACHE_WAYS; j++)
+			Addr2Info_HashCache[i][j].address = 0;
 }
 
 int Addr2Info_HashCache_Search (UINT64 address, int *line, int *function)
 {
-	int index;
+	struct Addr2Info_HashCache_Entry *set, hit;
+	int way;
 
-	index = Addr2Info_HashCache_HashFunction (address);
-	if (Addr2Info_HashCache[index].address == address)
+	set = Addr2Info_HashCache[Addr2Info_HashCache_HashFunction (address)];
+	for (way = 0; way < CACHE_WAYS && set[way].address != 0; way++)
 	{
-		Addr2Info_HashCache_Hits++;
-		*line = Addr2Info_HashCache[index].line_number;
-		*function = Addr2Info_HashCache[index].function_number;
-		return TRUE;
-	}
-	else
-	{
-		Addr2Info_HashCache_Misses++;
-		return FALSE;
+		if (set[way].address == address)
+		{
+			/* Move the entry to the front of the set */
+			hit = set[way];
+			for (; way > 0; way--)
+				set[way] = set[way-1];
+			set[0] = hit;
+
+			Addr2Info_HashCache_Hits++;
+			Addr2Info_HashCache_Resolutions[ADDR2INFO_LEVEL_CACHE]++;
+			*line = hit.line_number;
+			*function = hit.function_number;
+			return TRUE;
+		}
 	}
+
+	Addr2Info_HashCache_Misses++;
+	return FALSE;
 }
 
 void Addr2Info_HashCache_Insert (UINT64 address, int line, int function)
 {
-	int index;
+	struct Addr2Info_HashCache_Entry *set;
+	int way;
 
-	index = Addr2Info_HashCache_HashFunction (address);
-	if (Addr2Info_HashCache[index].address != address)
+	set = Addr2Info_HashCache[Addr2Info_HashCache_HashFunction (address)];
+	for (way = 0; way < CACHE_WAYS && set[way].address != 0; way++)
+		if (set[way].address == address)
+			return;
+
+	/* Evict the least recently used entry if the set is full */
+	if (way == CACHE_WAYS)
 	{
 		Addr2Info_HashCache_Replacements++;
-		Addr2Info_HashCache[index].address = address;
-		Addr2Info_HashCache[index].line_number = line;
-		Addr2Info_HashCache[index].function_number = function;
+		way--;
 	}
+
+	for (; way > 0; way--)
+		set[way] = set[way-1];
+	set[0].address = address;
+	set[0].line_number = line;
+	set[0].function_number = function;
+}
+
+void Addr2Info_HashCache_CountResolution (int level)
+{
+	if (level >= 0 && level < ADDR2INFO_NUM_LEVELS)
+		Addr2Info_HashCache_Resolutions[level]++;
 }
 
 void Addr2Info_HashCache_ShowStatistics (void)
 {
-	fprintf (stdout, "mpi2prv: Addr2Info Hash Cache statistics:\n"
-	                 "mpi2prv: Number of searches : %d\n"
-	                 "mpi2prv: Number of hits : %d\n"
-	                 "mpi2prv: Number of misses : %d\n"
-	                 "mpi2prv: Number of replacements : %d\n",
-	  Addr2Info_HashCache_Hits+Addr2Info_HashCache_Misses,
+	static const char *LevelNames[ADDR2INFO_NUM_LEVELS] =
+	  { "cache", "address table", "binary" };
+	unsigned long long searches = Addr2Info_HashCache_Hits+Addr2Info_HashCache_Misses;
+	int i;
+
+	fprintf (stdout, "mpi2prv: Addr2Info Hash Cache statistics (%d sets x %d ways):\n"
+	                 "mpi2prv: Number of searches : %llu\n"
+	                 "mpi2prv: Number of hits : %llu\n"
+	                 "mpi2prv: Number of misses : %llu\n"
+	                 "mpi2prv: Number of replacements : %llu\n",
+	  CACHE_SETS, CACHE_WAYS,
+	  searches,
 	  Addr2Info_HashCache_Hits,
 	  Addr2Info_HashCache_Misses,
 	  Addr2Info_HashCache_Replacements);
+
+	for (i = 0; i < ADDR2INFO_NUM_LEVELS; i++)
+		fprintf (stdout, "mpi2prv: Addresses resolved by the %s : %llu (%.2f%%)\n",
+		  LevelNames[i], Addr2Info_HashCache_Resolutions[i],
+		  searches > 0 ? (100.0 * Addr2Info_HashCache_Resolutions[i]) / searches : 0.0);
 }
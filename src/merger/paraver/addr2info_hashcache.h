@@ -24,10 +24,21 @@
 #ifndef ADDR2INFO_HASHCACHE_INCLUDED
 #define ADDR2INFO_HASHCACHE_INCLUDED
 
+/* Levels through which an address can be resolved, from cheapest to most
+   expensive, used to report where the translations come from */
+enum
+{
+	ADDR2INFO_LEVEL_CACHE = 0,
+	ADDR2INFO_LEVEL_TABLE,
+	ADDR2INFO_LEVEL_BINARY,
+	ADDR2INFO_NUM_LEVELS
+};
+
 void Addr2Info_HashCache_Initialize (void);
 void Addr2Info_HashCache_Clean (void);
 int Addr2Info_HashCache_Search (UINT64 address, int *line, int *function);
 void Addr2Info_HashCache_Insert (UINT64 address, int line, int function);
+void Addr2Info_HashCache_CountResolution (int level);
 void Addr2Info_HashCache_ShowStatistics (void);
 
 #endif
@@ -23,7 +23,14 @@
 
 #include "common.h"
 
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
 #include <stdio.h>
+#include "utils.h"
 #include "communication_queues.h"
 
 #ifndef HAVE_MPI_H
@@ -35,7 +42,13 @@
 /* #define DEBUG */
 
 /**************************************************************************
-*** SEND PART
+*** INDEXED QUEUE
+***
+*** Every pending communication is linked in two FIFO lists: the list of
+*** the communications with its partner, tag and key (BY_TAG) and the list
+*** of the communications with its partner and key whatever their tag
+*** (BY_PARTNER). The lists are found through hash tables, so looking for
+*** the oldest communication that matches and removing it are O(1).
 **************************************************************************/
 
 typedef struct
@@ -52,12 +65,290 @@ typedef struct
 SendData_t;
 
 typedef struct
+{
+	event_t *recv_begin;
+	event_t *recv_end;
+	long long key;
+	unsigned partner;
+	unsigned thread;
+	unsigned vthread;
+	unsigned tag;
+} 
+RecvData_t;
+
+enum
+{
+	BY_TAG = 0,
+	BY_PARTNER,
+	NUM_INDEXES
+};
+
+#define INITIAL_BUCKETS 64
+
+typedef struct CommEntry_st CommEntry_t;
+typedef struct CommList_st CommList_t;
+
+struct CommList_st
 {
 	long long key;
+	int partner;
 	int tag;
-	int target;
+	CommEntry_t *head;
+	CommEntry_t *tail;
+	CommList_t *next;    /* Within the hash bucket or the free lists */
+};
+
+struct CommEntry_st
+{
+	CommEntry_t *prev[NUM_INDEXES];
+	CommEntry_t *next[NUM_INDEXES];
+	CommList_t *list[NUM_INDEXES];
+	unsigned long long order;
+	union
+	{
+		SendData_t send;
+		RecvData_t recv;
+	} data;
+};
+
+typedef struct
+{
+	CommList_t **buckets;
+	unsigned nbuckets;
+	unsigned nlists;
+} CommIndex_t;
+
+struct CommunicationQueue_st
+{
+	CommIndex_t index[NUM_INDEXES];
+	CommEntry_t *free_entries;
+	CommList_t *free_lists;
+	unsigned long long order;
+};
+
+static unsigned CommIndex_Hash (int partner, int tag, long long key)
+{
+	unsigned long long h = (unsigned) partner;
+
+	h = h * 0x9E3779B97F4A7C15ULL + (unsigned) tag;
+	h = h * 0x9E3779B97F4A7C15ULL + (unsigned long long) key;
+	h ^= h >> 29;
+	return (unsigned) h;
+}
+
+static void CommIndex_Init (CommIndex_t *idx)
+{
+	idx->nbuckets = INITIAL_BUCKETS;
+	idx->nlists = 0;
+	xmalloc(idx->buckets, idx->nbuckets * sizeof(CommList_t*));
+	memset (idx->buckets, 0, idx->nbuckets * sizeof(CommList_t*));
+}
+
+static void CommIndex_Grow (CommIndex_t *idx)
+{
+	CommList_t **old = idx->buckets;
+	unsigned i, oldnbuckets = idx->nbuckets;
+
+	idx->nbuckets *= 2;
+	xmalloc(idx->buckets, idx->nbuckets * sizeof(CommList_t*));
+	memset (idx->buckets, 0, idx->nbuckets * sizeof(CommList_t*));
+
+	for (i = 0; i < oldnbuckets; i++)
+		while (old[i] != NULL)
+		{
+			CommList_t *l = old[i];
+			unsigned b = CommIndex_Hash (l->partner, l->tag, l->key) & (idx->nbuckets-1);
+
+			old[i] = l->next;
+			l->next = idx->buckets[b];
+			idx->buckets[b] = l;
+		}
+	xfree(old);
+}
+
+static CommList_t * CommIndex_Find (CommIndex_t *idx, int partner, int tag,
+	long long key)
+{
+	CommList_t *l = idx->buckets[CommIndex_Hash (partner, tag, key) & (idx->nbuckets-1)];
+
+	while (l != NULL && !(l->partner == partner && l->tag == tag && l->key == key))
+		l = l->next;
+	return l;
+}
+
+static CommList_t * CommIndex_Get (CommunicationQueue_t *q, CommIndex_t *idx,
+	int partner, int tag, long long key)
+{
+	CommList_t *l = CommIndex_Find (idx, partner, tag, key);
+	unsigned b;
+
+	if (l != NULL)
+		return l;
+
+	if (idx->nlists >= idx->nbuckets)
+		CommIndex_Grow (idx);
+
+	if (q->free_lists != NULL)
+	{
+		l = q->free_lists;
+		q->free_lists = l->next;
+	}
+	else
+		xmalloc(l, sizeof(CommList_t));
+
+	l->partner = partner;
+	l->tag = tag;
+	l->key = key;
+	l->head = l->tail = NULL;
+
+	b = CommIndex_Hash (partner, tag, key) & (idx->nbuckets-1);
+	l->next = idx->buckets[b];
+	idx->buckets[b] = l;
+	idx->nlists++;
+
+	return l;
+}
+
+static void CommIndex_Release (CommunicationQueue_t *q, CommIndex_t *idx,
+	CommList_t *l)
+{
+	CommList_t **p = &(idx->buckets[CommIndex_Hash (l->partner, l->tag, l->key) & (idx->nbuckets-1)]);
+
+	while (*p != l)
+		p = &((*p)->next);
+	*p = l->next;
+	idx->nlists--;
+
+	l->next = q->free_lists;
+	q->free_lists = l;
+}
+
+/* Appends a new communication. BY_TAG lists it under 'tag' */
+static CommEntry_t * CommQueue_Add (CommunicationQueue_t *q, int partner,
+	int tag, long long key)
+{
+	CommEntry_t *e;
+	int i;
+
+	if (q->free_entries != NULL)
+	{
+		e = q->free_entries;
+		q->free_entries = e->next[BY_TAG];
+	}
+	else
+		xmalloc(e, sizeof(CommEntry_t));
+
+	e->list[BY_TAG] = CommIndex_Get (q, &(q->index[BY_TAG]), partner, tag, key);
+	e->list[BY_PARTNER] = CommIndex_Get (q, &(q->index[BY_PARTNER]), partner, 0, key);
+	e->order = q->order++;
+
+	for (i = 0; i < NUM_INDEXES; i++)
+	{
+		CommList_t *l = e->list[i];
+
+		e->next[i] = NULL;
+		e->prev[i] = l->tail;
+		if (l->tail != NULL)
+			l->tail->next[i] = e;
+		else
+			l->head = e;
+		l->tail = e;
+	}
+	return e;
 }
-SendDataReference_t;
+
+static void CommQueue_Delete (CommunicationQueue_t *q, CommEntry_t *e)
+{
+	int i;
+
+	for (i = 0; i < NUM_INDEXES; i++)
+	{
+		CommList_t *l = e->list[i];
+
+		if (e->prev[i] != NULL)
+			e->prev[i]->next[i] = e->next[i];
+		else
+			l->head = e->next[i];
+		if (e->next[i] != NULL)
+			e->next[i]->prev[i] = e->prev[i];
+		else
+			l->tail = e->prev[i];
+
+		if (l->head == NULL)
+			CommIndex_Release (q, &(q->index[i]), l);
+	}
+
+	e->next[BY_TAG] = q->free_entries;
+	q->free_entries = e;
+}
+
+/* Oldest communication in the given index with partner, tag and key (the
+   tag is ignored in BY_PARTNER) */
+static CommEntry_t * CommQueue_First (CommunicationQueue_t *q, int index,
+	int partner, int tag, long long key)
+{
+	CommList_t *l = CommIndex_Find (&(q->index[index]), partner,
+	  (BY_TAG == index) ? tag : 0, key);
+
+	return (l != NULL) ? l->head : NULL;
+}
+
+static CommunicationQueue_t * CommQueue_Create (void)
+{
+	CommunicationQueue_t *q;
+	int i;
+
+	xmalloc(q, sizeof(CommunicationQueue_t));
+	for (i = 0; i < NUM_INDEXES; i++)
+		CommIndex_Init (&(q->index[i]));
+	q->free_entries = NULL;
+	q->free_lists = NULL;
+	q->order = 0;
+
+	return q;
+}
+
+static void CommQueue_Clear (CommunicationQueue_t *q)
+{
+	unsigned b;
+	int i;
+
+	/* Every entry is in a single BY_PARTNER list */
+	for (b = 0; b < q->index[BY_PARTNER].nbuckets; b++)
+	{
+		CommList_t *l;
+
+		for (l = q->index[BY_PARTNER].buckets[b]; l != NULL; l = l->next)
+			while (l->head != NULL)
+			{
+				CommEntry_t *e = l->head;
+
+				l->head = e->next[BY_PARTNER];
+				e->next[BY_TAG] = q->free_entries;
+				q->free_entries = e;
+			}
+	}
+
+	for (i = 0; i < NUM_INDEXES; i++)
+	{
+		CommIndex_t *idx = &(q->index[i]);
+
+		for (b = 0; b < idx->nbuckets; b++)
+			while (idx->buckets[b] != NULL)
+			{
+				CommList_t *l = idx->buckets[b];
+
+				idx->buckets[b] = l->next;
+				l->next = q->free_lists;
+				q->free_lists = l;
+			}
+		idx->nlists = 0;
+	}
+}
+
+/**************************************************************************
+*** SEND PART
+**************************************************************************/
 
 void queue_print_sends(void *data)
 {
@@ -65,65 +356,51 @@ void queue_print_sends(void *data)
   fprintf(stderr, "[DEBUG] queue_print_sends:: %d %d %lld\n", d->tag, d->partner, d->key);
 }
 
-void CommunicationQueues_QueueSend (NewQueue_t *qsend, event_t *send_begin,
+void CommunicationQueues_QueueSend (CommunicationQueue_t *qsend, event_t *send_begin,
 	event_t *send_end, off_t send_position, unsigned thread,
 	unsigned vthread, unsigned partner, unsigned tag, long long key)
 {
-	SendData_t tmp;
+	SendData_t *tmp;
 
 #if defined(DEBUG)
 	fprintf (stderr, "[DEBUG] CommunicationQueues_QueueSend (.. thread=%u, vthread=%u, partner=%d, tag=%u, key=%lld)\n", thread, vthread, partner, tag, key);
 #endif
 
-	tmp.send_begin = send_begin;
-	tmp.send_end = send_end;
-	tmp.send_position = send_position;
-	tmp.partner = partner;
-	tmp.thread = thread;
-	tmp.vthread = vthread;
-	tmp.tag = tag;
-	tmp.key = key;
-
-	NewQueue_add (qsend, &tmp);
-}
-
-static int CompareSend_cbk (void *reference, void *data)
-{
-	SendData_t *d = (SendData_t*) data;
-	SendDataReference_t *ref = (SendDataReference_t*) reference;
-
-#if defined(DEBUG)
-	fprintf (stderr, "[DEBUG] CompareSend_cbk (<tag=%d,target=%d,key=%lld>,<tag=%d,target=%d,key=%lld>)\n", ref->tag, ref->target, ref->key, d->tag, d->partner, d->key);
-#endif
+	tmp = &(CommQueue_Add (qsend, partner, tag, key)->data.send);
 
-	/* Return OK if the TAG, TARGET and KEY are the same */
-	/*   we look for senders, check whether the receiver is any tag */
-	return (ref->tag == d->tag || ref->tag == MPI_ANY_TAG) &&
-	  ref->target == d->partner && ref->key == d->key;
+	tmp->send_begin = send_begin;
+	tmp->send_end = send_end;
+	tmp->send_position = send_position;
+	tmp->partner = partner;
+	tmp->thread = thread;
+	tmp->vthread = vthread;
+	tmp->tag = tag;
+	tmp->key = key;
 }
 
-void CommunicationQueues_ExtractSend (NewQueue_t *qsend, int receiver,
+void CommunicationQueues_ExtractSend (CommunicationQueue_t *qsend, int receiver,
 	int tag, event_t **send_begin, event_t **send_end,
 	off_t *send_position, unsigned *thread, unsigned *vthread, long long key)
 {
+	CommEntry_t *e;
 	SendData_t *res;
-	SendDataReference_t reference;
-	reference.tag = tag;
-	reference.target = receiver;
-	reference.key = key;
 
-	/* DEBUG 
-	NewQueue_dump(qsend, queue_printer); */
-	res = (SendData_t*) NewQueue_search (qsend, &reference, CompareSend_cbk);
+	/* Look for the oldest send with the same TAG, TARGET and KEY. If the
+	   receiver is any tag, look for the oldest one with any TAG */
+	if (tag == MPI_ANY_TAG)
+		e = CommQueue_First (qsend, BY_PARTNER, receiver, tag, key);
+	else
+		e = CommQueue_First (qsend, BY_TAG, receiver, tag, key);
 
-	if (NULL != res)
+	if (NULL != e)
 	{
+		res = &(e->data.send);
 		*send_begin = res->send_begin;
 		*send_end = res->send_end;
 		*send_position = res->send_position;
 		*thread = res->thread;
 		*vthread = res->vthread;
-		NewQueue_delete (qsend, res);
+		CommQueue_Delete (qsend, e);
 	}
 	else
 	{
@@ -137,89 +414,64 @@ void CommunicationQueues_ExtractSend (NewQueue_t *qsend, int receiver,
 *** RECEIVE PART
 **************************************************************************/
 
-typedef struct
-{
-	event_t *recv_begin;
-	event_t *recv_end;
-	long long key;
-	unsigned partner;
-	unsigned thread;
-	unsigned vthread;
-	unsigned tag;
-} 
-RecvData_t;
-
-typedef struct
-{
-	long long key;
-	int tag;
-	int target;
-}
-RecvDataReference_t;
-
 void queue_print_recvs(void *data)
 {
   RecvData_t *d = (RecvData_t*) data;
   fprintf(stderr, "[DEBUG] queue_print_recvs:: %d %d %lld\n", d->tag, d->partner, d->key);
 }
 
-void CommunicationQueues_QueueRecv (NewQueue_t *qreceive, event_t *recv_begin,
+void CommunicationQueues_QueueRecv (CommunicationQueue_t *qreceive, event_t *recv_begin,
 	event_t *recv_end, unsigned thread, unsigned vthread,
 	unsigned partner, unsigned tag, long long key)
 {
-	RecvData_t tmp;
+	RecvData_t *tmp;
+	int index_tag = tag;
 
 #if defined(DEBUG)
 	fprintf (stderr, "[DEBUG] CommunicationQueues_QueueRecv (.. thread=%u, vthread=%u, partner=%d, tag=%u, key=%lld)\n", thread, vthread, partner, tag, key);
 #endif
 
-	tmp.recv_begin = recv_begin;
-	tmp.recv_end = recv_end;
-	tmp.partner = partner;
-	tmp.thread = thread;
-	tmp.vthread = vthread;
-	tmp.tag = tag;
-	tmp.key = key;
-
-	NewQueue_add (qreceive, &tmp);
-}
-
-static int CompareRecv_cbk (void *reference, void *data)
-{
-	RecvData_t *d = (RecvData_t*) data;
-	RecvDataReference_t *ref = (RecvDataReference_t*) reference;
+	/* Receives posted with any tag are listed together so that they can be
+	   matched by any send */
+	if (MPI_ANY_TAG == Get_EvTag(recv_end))
+		index_tag = MPI_ANY_TAG;
 
-#if defined(DEBUG)
-	fprintf (stderr, "[DEBUG] CompareRecv_cbk (<tag=%d,target=%d,key=%lld>,<tag=%d,target=%d,key=%lld>)\n", ref->tag, ref->target, ref->key, d->tag, d->partner, d->key);
-#endif
+	tmp = &(CommQueue_Add (qreceive, partner, index_tag, key)->data.recv);
 
-	/* Return OK if the TAG, TARGET and KEY are the same */
-	/*   we look for recvs, check whether the receiver is any tag */
-	return (ref->tag == d->tag || MPI_ANY_TAG == Get_EvTag(d->recv_end)) && 
-	  ref->target == d->partner && ref->key == d->key;
+	tmp->recv_begin = recv_begin;
+	tmp->recv_end = recv_end;
+	tmp->partner = partner;
+	tmp->thread = thread;
+	tmp->vthread = vthread;
+	tmp->tag = tag;
+	tmp->key = key;
 }
 
-void CommunicationQueues_ExtractRecv (NewQueue_t *qreceive, int sender,
+void CommunicationQueues_ExtractRecv (CommunicationQueue_t *qreceive, int sender,
 	int tag, event_t **recv_begin, event_t **recv_end, unsigned *thread,
 	unsigned *vthread, long long key)
 {
+	CommEntry_t *e, *any;
 	RecvData_t *res;
-	RecvDataReference_t reference;
-	reference.tag = tag;
-	reference.target = sender;
-	reference.key = key;
 
-	/* DEBUG
-	NewQueue_dump(qreceive, queue_printer); */
-	res = (RecvData_t*) NewQueue_search (qreceive, &reference, CompareRecv_cbk);
+	/* Look for the oldest recv with the same TAG, TARGET and KEY, or with the
+	   same TARGET and KEY that was posted with any tag */
+	e = CommQueue_First (qreceive, BY_TAG, sender, tag, key);
+	if (tag != MPI_ANY_TAG)
+	{
+		any = CommQueue_First (qreceive, BY_TAG, sender, MPI_ANY_TAG, key);
+		if (any != NULL && (e == NULL || any->order < e->order))
+			e = any;
+	}
 
-	if (NULL != res)
+	if (NULL != e)
 	{
+		res = &(e->data.recv);
 		*recv_begin = res->recv_begin;
 		*recv_end = res->recv_end;
 		*thread = res->thread;
 		*vthread = res->vthread;
-		NewQueue_delete (qreceive, res);
+		CommQueue_Delete (qreceive, e);
 	}
 	else
 	{
@@ -232,18 +484,16 @@ void CommunicationQueues_ExtractRecv (NewQueue_t *qreceive, int sender,
 *** INITIALIZATION 
 **********************************************************************/
 
-void CommunicationQueues_Init (NewQueue_t **send, NewQueue_t **receive)
+void CommunicationQueues_Init (CommunicationQueue_t **send, CommunicationQueue_t **receive)
 {
-	/* Initialize queues. Allocate 1024 entries by default. */
-	*send = NewQueue_create (sizeof(SendData_t), 1024);
-	*receive = NewQueue_create (sizeof(RecvData_t), 1024);
+	*send = CommQueue_Create ();
+	*receive = CommQueue_Create ();
 }
 
-void CommunicationQueues_Clear (NewQueue_t *queue)
+void CommunicationQueues_Clear (CommunicationQueue_t *queue)
 {
 	if (queue != NULL)
 	{
-		NewQueue_clear(queue);
+		CommQueue_Clear (queue);
 	}
 }
-
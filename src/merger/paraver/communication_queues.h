@@ -28,24 +28,26 @@
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
-#include "new-queue.h"
 #include "record.h"
 
-void CommunicationQueues_Init (NewQueue_t **fsend, NewQueue_t **freceive);
+/* Pending sends (or receives) of a task indexed by partner, tag and key */
+typedef struct CommunicationQueue_st CommunicationQueue_t;
 
-void CommunicationQueues_Clear (NewQueue_t *queue);
+void CommunicationQueues_Init (CommunicationQueue_t **fsend, CommunicationQueue_t **freceive);
 
-void CommunicationQueues_QueueSend (NewQueue_t *qsend, event_t *send_begin,
+void CommunicationQueues_Clear (CommunicationQueue_t *queue);
+
+void CommunicationQueues_QueueSend (CommunicationQueue_t *qsend, event_t *send_begin,
 	event_t *send_end, off_t send_position, unsigned thread,
 	unsigned vthread, unsigned partner, unsigned tag, long long key);
-void CommunicationQueues_QueueRecv (NewQueue_t *qreceive, event_t *recv_begin,
+void CommunicationQueues_QueueRecv (CommunicationQueue_t *qreceive, event_t *recv_begin,
 	event_t *recv_end, unsigned thread, unsigned vthread,
 	unsigned partner, unsigned tag, long long key);
 
-void CommunicationQueues_ExtractRecv (NewQueue_t *qreceive, int sender,
+void CommunicationQueues_ExtractRecv (CommunicationQueue_t *qreceive, int sender,
 	int tag, event_t **recv_begin, event_t **recv_end, unsigned *thread,
 	unsigned *vthread, long long key);
-void CommunicationQueues_ExtractSend (NewQueue_t *qsend, int receiver,
+void CommunicationQueues_ExtractSend (CommunicationQueue_t *qsend, int receiver,
 	int tag, event_t **send_begin, event_t **send_end,
 	off_t *send_position, unsigned *thread, unsigned *vthread, long long key);
 
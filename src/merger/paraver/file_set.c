@@ -51,6 +51,9 @@
 #ifdef HAVE_SYS_STAT_H
 # include <sys/stat.h>
 #endif
+#ifdef HAVE_SYS_TIME_H
+# include <sys/time.h>
+#endif
 #ifdef HAVE_STRINGS_H
 # include <strings.h>
 #endif
@@ -63,6 +66,9 @@
 #if defined(HAVE_SIONLIB)
 # include "sion.h"
 #endif
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+# include <pthread.h>
+#endif
 #include "labels.h"
 #include "utils.h"
 #include "semantics.h"
@@ -77,6 +83,9 @@
 #include "trace_to_prv.h"
 #include "communication_queues.h"
 #include "intercommunicators.h"
+#include "options.h"
+#include "mpit_header.h"
+#include "mpit_events.h"
 
 #define EVENTS_FOR_NUM_GLOBAL_OPS(x) \
      ((x) == MPI_BARRIER_EV  || (x) == MPI_BCAST_EV       || (x) == MPI_ALLREDUCE_EV       || \
@@ -89,6 +98,11 @@
 static int Is_FS_Rewound = TRUE;
 static int LimitOfEvents = 0;
 
+/* Bytes of consumed input that each mapped file may keep before giving
+   them back to the system (0 means leave it to the kernel) */
+static unsigned long InputWindow = 0;
+#define RELEASE_PERIOD 4096
+
 void setLimitOfEvents (int limit)
 {
 	LimitOfEvents = limit;
@@ -133,6 +147,38 @@ static int event_timing_sort (const void *e1, const void *e2)
 }
 #endif
 
+/******************************************************************************
+ ***  Sort_Handoff_Events
+ ***  The events that a thread emits into the buffer of another thread (e.g.
+ ***  the flush events of a flush on its behalf) keep their time, and may be
+ ***  written after events that happened later. Moves them back into place.
+ ***  As these events are few and close to their place, an insertion sort
+ ***  costs a single pass on the file, and keeps the order of the events
+ ***  with the same time.
+ ******************************************************************************/
+static void Sort_Handoff_Events (FileItem_t *fitem)
+{
+	event_t *ptr, *pos, *prev, tmp;
+
+	for (ptr = fitem->first + 1; ptr < fitem->last; ptr++)
+	{
+		prev = ptr - 1;
+		if (Get_EvTime(ptr) >= Get_EvTime(prev))
+			continue;
+
+		tmp = *ptr;
+		for (pos = ptr; pos > fitem->first; pos--)
+		{
+			prev = pos - 1;
+			if (Get_EvTime(prev) <= tmp.time)
+				break;
+			*pos = *prev;
+		}
+		*pos = tmp;
+		fitem->modified = TRUE;
+	}
+}
+
 int isTaskInMyGroup (FileSet_t *fset, int ptask, int task)
 {
 	unsigned i;
@@ -196,27 +242,206 @@ static int newTemporalFile (int taskid, int initial, int depth, char *filename)
 
 
 /******************************************************************************
- ***  AddFile_FS
+ ***  Map_MPIT_File
+ ***  Maps the events of the intermediate file into memory. Pages are loaded on
+ ***  demand and, as they are backed by the file, they can be reclaimed by the
+ ***  system or explicitly released by Release_FS once consumed. The mapping is
+ ***  private so that the events can still be changed in memory if needed.
  ******************************************************************************/
 
-static int AddFile_FS (FileItem_t * fitem, struct input_t *IFile, int taskid)
+static void Map_MPIT_File (FileItem_t *fitem, FILE *fd, long long size)
+{
+#if defined(HAVE_SYS_MMAN_H)
+	void *addr;
+
+	addr = mmap (NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fileno (fd), 0);
+	if (MAP_FAILED == addr)
+		return;
+# if defined(MADV_SEQUENTIAL)
+	madvise (addr, size, MADV_SEQUENTIAL);
+# endif
+	fitem->first = fitem->released = (event_t*) addr;
+	fitem->mapped = TRUE;
+#else
+	UNREFERENCED_PARAMETER(fitem);
+	UNREFERENCED_PARAMETER(fd);
+	UNREFERENCED_PARAMETER(size);
+#endif
+}
+
+/******************************************************************************
+ ***  Map_Decoded_File
+ ***  Events that cannot be mapped straight from the .mpit (compact files, or
+ ***  files merged with their samples) are decoded into an unlinked temporary
+ ***  file mapped into memory. Its pages can then be released by Release_FS and
+ ***  loaded again on demand, as for plain files. The mapping is shared so that
+ ***  the decoded events (and any later change to them) reach the file.
+ ******************************************************************************/
+
+static void Map_Decoded_File (FileItem_t *fitem, int taskid)
+{
+#if defined(HAVE_SYS_MMAN_H)
+	char tmp_name[PATH_MAX];
+	void *addr;
+	int fd;
+
+	fd = newTemporalFile (taskid, TRUE, 0, tmp_name);
+	unlink (tmp_name);
+
+	if (ftruncate (fd, fitem->size) == 0)
+	{
+		addr = mmap (NULL, fitem->size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+		if (MAP_FAILED != addr)
+		{
+# if defined(MADV_SEQUENTIAL)
+			madvise (addr, fitem->size, MADV_SEQUENTIAL);
+# endif
+			fitem->first = fitem->released = (event_t*) addr;
+			fitem->mapped = fitem->decoded = TRUE;
+		}
+	}
+	close (fd);
+#else
+	UNREFERENCED_PARAMETER(fitem);
+	UNREFERENCED_PARAMETER(taskid);
+#endif
+}
+
+/******************************************************************************
+ ***  Count_MPIT_Events
+ ***  Returns the number of events of an intermediate file given its version
+ ***  (see mpit_header.h). Compact files are scanned through the headers of
+ ***  their blocks, and a truncated block at the end of the file is ignored.
+ ******************************************************************************/
+
+static long long Count_MPIT_Events (int fd, int version, long long file_size,
+	char *file_name)
+{
+	MPIT_Block_t block;
+	long long num_events = 0;
+	off_t offset;
+
+	if (version == MPIT_VERSION_RAW)
+		return file_size / sizeof(event_t);
+
+	offset = sizeof(MPIT_Header_t);
+	while (offset + (off_t) sizeof(MPIT_Block_t) <= file_size)
+	{
+		if (pread (fd, &block, sizeof(MPIT_Block_t), offset) != sizeof(MPIT_Block_t))
+		{
+			fprintf (stderr, "mpi2prv: `pread` failed to read from file %s\n", file_name);
+			exit (1);
+		}
+		if (offset + (off_t) (sizeof(MPIT_Block_t) + block.Size) > file_size)
+			break;
+
+		num_events += block.NumEvents;
+		offset += sizeof(MPIT_Block_t) + block.Size;
+	}
+
+	if (offset != file_size)
+		fprintf (stderr, "mpi2prv: WARNING! File %s ends with an incomplete block of events (%lld bytes). Ignoring it.\n",
+			file_name, (long long) (file_size - offset));
+
+	return num_events;
+}
+
+/******************************************************************************
+ ***  Read_MPIT_Events
+ ***  Reads (and decodes, if needed) the given number of events from the
+ ***  beginning of an intermediate file.
+ ******************************************************************************/
+
+static void Read_MPIT_Events (int fd, int version, event_t *events,
+	long long num_events, char *file_name)
+{
+	MPIT_Block_t block;
+	unsigned char *data = NULL;
+	size_t data_size = 0;
+	size_t remaining;
+	char *ptr;
+	ssize_t res;
+
+	if (version == MPIT_VERSION_RAW)
+	{
+		ptr = (char *) events;
+		remaining = num_events * sizeof(event_t);
+		lseek (fd, 0, SEEK_SET);
+		while (remaining > 0)
+		{
+			res = read (fd, ptr, remaining);
+			if (res <= 0)
+			{
+				fprintf (stderr, "mpi2prv: `read` failed to read from file %s\n", file_name);
+				exit (1);
+			}
+			ptr += res;
+			remaining -= res;
+		}
+		return;
+	}
+
+	lseek (fd, sizeof(MPIT_Header_t), SEEK_SET);
+	while (num_events > 0)
+	{
+		if (read (fd, &block, sizeof(MPIT_Block_t)) != sizeof(MPIT_Block_t))
+		{
+			fprintf (stderr, "mpi2prv: `read` failed to read from file %s\n", file_name);
+			exit (1);
+		}
+		if (block.Size > data_size)
+		{
+			data_size = block.Size;
+			data = (unsigned char *) realloc (data, data_size);
+			if (data == NULL)
+			{
+				fprintf (stderr, "mpi2prv: `realloc` failed to allocate memory for file %s\n", file_name);
+				exit (1);
+			}
+		}
+		if (read (fd, data, block.Size) != (ssize_t) block.Size ||
+		    block.NumEvents > num_events ||
+		    MPIT_Events_Decode (&block, data, events) != 0)
+		{
+			fprintf (stderr, "mpi2prv: Error! Malformed block of events in file %s\n", file_name);
+			exit (1);
+		}
+		events += block.NumEvents;
+		num_events -= block.NumEvents;
+	}
+
+	if (data != NULL)
+		free (data);
+}
+
+/******************************************************************************
+ ***  LoadFile_FS
+ ***  Loads the events of the intermediate files of a thread into memory.
+ ***  It only touches the given FileItem_t, so several files can be loaded at
+ ***  the same time (see Load_FS).
+ ******************************************************************************/
+
+static int LoadFile_FS (FileItem_t * fitem, struct input_t *IFile, int taskid)
 {
-	int tmp_fd;
 	int ret;
 	FILE *fd_trace;
+#if defined(HAVE_SIONLIB)
 	ssize_t res;
+#endif
 	char *tmp;
-	char paraver_tmp[PATH_MAX];
 	char trace_file_name[PATH_MAX];
-	long long trace_file_size;
+	long long trace_file_size, trace_events;
+	int trace_version;
 #if defined(SAMPLING_SUPPORT)
 	char sample_file_name[PATH_MAX];
-	long long sample_file_size;
+	long long sample_file_size, sample_events = 0;
+	int sample_version = MPIT_VERSION_RAW;
 	FILE *fd_sample;
 #endif
 #if defined(HAVE_ONLINE)
 	char online_file_name[PATH_MAX];
-	long long online_file_size;
+	long long online_file_size, online_events = 0;
+	int online_version = MPIT_VERSION_RAW;
 	int fd_online;
 #endif
 #if defined(SAMPLING_SUPPORT) || defined(HAVE_ONLINE)
@@ -316,12 +541,72 @@ static int AddFile_FS (FileItem_t * fitem, struct input_t *IFile, int taskid)
 	online_file_size = (fd_online != -1)?lseek (fd_online, 0, SEEK_END):0;
 #endif
 
-	fitem->size = trace_file_size;
+	/* Files written by older tracers contain plain event_t, otherwise their
+	   header tells how the events are encoded */
+#if defined(HAVE_SIONLIB)
+	trace_version = MPIT_VERSION_RAW;
+#else
+	trace_version = MPIT_Header_Version (fileno (fd_trace));
+#endif
+#if defined(SAMPLING_SUPPORT)
+	if (NULL != fd_sample)
+		sample_version = MPIT_Header_Version (fileno (fd_sample));
+#endif
+#if defined(HAVE_ONLINE)
+	if (fd_online != -1)
+		online_version = MPIT_Header_Version (fd_online);
+#endif
+	if (trace_version == MPIT_VERSION_OTHER_ENDIANNESS
+#if defined(SAMPLING_SUPPORT)
+	    || sample_version == MPIT_VERSION_OTHER_ENDIANNESS
+#endif
+#if defined(HAVE_ONLINE)
+	    || online_version == MPIT_VERSION_OTHER_ENDIANNESS
+#endif
+	   )
+	{
+		fprintf (stderr, "mpi2prv: Error! Intermediate files for %s were written on a host of the opposite endianness. "
+			"Compact intermediate files of the opposite endianness are not supported, merge them on a host with the same byte order\n",
+			trace_file_name);
+		exit (1);
+	}
+	if (trace_version < 0
+#if defined(SAMPLING_SUPPORT)
+	    || sample_version < 0
+#endif
+#if defined(HAVE_ONLINE)
+	    || online_version < 0
+#endif
+	   )
+	{
+		fprintf (stderr, "mpi2prv: Error! Intermediate files for %s were written by an incompatible tracer\n",
+			trace_file_name);
+		exit (1);
+	}
+
+#if defined(HAVE_SIONLIB)
+	trace_events = trace_file_size / sizeof(event_t);
+#else
+	trace_events = Count_MPIT_Events (fileno (fd_trace), trace_version,
+		trace_file_size, trace_file_name);
+#endif
+#if defined(SAMPLING_SUPPORT)
+	if (NULL != fd_sample)
+		sample_events = Count_MPIT_Events (fileno (fd_sample), sample_version,
+			sample_file_size, sample_file_name);
+#endif
+#if defined(HAVE_ONLINE)
+	if (fd_online != -1)
+		online_events = Count_MPIT_Events (fd_online, online_version,
+			online_file_size, online_file_name);
+#endif
+
+	fitem->size = trace_events * sizeof(event_t);
 #if defined(SAMPLING_SUPPORT)
-	fitem->size += sample_file_size;
+	fitem->size += sample_events * sizeof(event_t);
 #endif
 #if defined(HAVE_ONLINE)
-	fitem->size += online_file_size;
+	fitem->size += online_events * sizeof(event_t);
 #endif
 
 #if 0
@@ -345,66 +630,78 @@ static int AddFile_FS (FileItem_t * fitem, struct input_t *IFile, int taskid)
 
 	{
 		int extra = (trace_file_size % sizeof (event_t));
-		if (extra != 0)
+		if (trace_version == MPIT_VERSION_RAW && extra != 0)
 			printf ("PANIC! Trace file %s is %d bytes too big!\n", trace_file_name, extra);
 
 #if defined(SAMPLING_SUPPORT)
 		extra = (sample_file_size % sizeof (event_t));
-		if (extra != 0)
+		if (sample_version == MPIT_VERSION_RAW && extra != 0)
 			printf ("PANIC! Sample file %s is %d bytes too big!\n", sample_file_name, extra);
 #endif
 #if defined(HAVE_ONLINE)
 		extra = (online_file_size % sizeof (event_t));
-		if (extra != 0)
+		if (online_version == MPIT_VERSION_RAW && extra != 0)
 			printf ("PANIC! Online file %s is %d bytes too big!\n", online_file_name, extra);
 #endif
 	}
 
-	fitem->first = (event_t*) malloc (fitem->size);
-	if (fitem->first == NULL)
-	{
-		fprintf (stderr, "mpi2prv: `malloc` failed to allocate memory for file %s\n",
-			IFile->name);
-		exit (1);
-	}
+	fitem->mapped = fitem->modified = fitem->decoded = FALSE;
+	fitem->released = NULL;
 
-	/* Read files */
-	res = fread (fitem->first, 1, trace_file_size, fd_trace);
-	if (res != trace_file_size)
-	{
-		fprintf (stderr, "mpi2prv: `fread` failed to read from file %s\n", trace_file_name);
-		fprintf (stderr, "mpi2prv:        returned %Zu (instead of %lld)\n", res, trace_file_size);
-		exit (1);
-	}
-	ptr_last = fitem->first + (trace_file_size/sizeof(event_t));
+#if !defined(HAVE_SIONLIB)
+	/* If there are no sample nor online events to merge, a .mpit with plain
+	   events can be used as is */
+	if (trace_version == MPIT_VERSION_RAW && trace_events > 0 &&
+	    (long long) fitem->size == trace_events * (long long) sizeof(event_t))
+		Map_MPIT_File (fitem, fd_trace, fitem->size);
+#endif
 
-#if defined(SAMPLING_SUPPORT)
-	if (NULL != fd_sample)
+	/* Otherwise, bound the memory of the decoded events if requested */
+	if (!fitem->mapped && fitem->size > 0 && get_option_merge_InputMaxMem() > 0)
+		Map_Decoded_File (fitem, taskid);
+
+	if (!fitem->mapped)
 	{
-		res = fread (ptr_last, 1, sample_file_size, fd_sample);
-		if (res != sample_file_size)
+		fitem->first = (event_t*) malloc (fitem->size);
+		if (fitem->first == NULL)
 		{
-			fprintf (stderr, "mpi2prv: `fread` failed to read from file %s\n", sample_file_name);
-			fprintf (stderr, "mpi2prv:        returned %Zu (instead of %lld)\n", res, sample_file_size);
+			fprintf (stderr, "mpi2prv: `malloc` failed to allocate memory for file %s\n",
+				IFile->name);
 			exit (1);
 		}
 	}
-	sort_needed = sample_file_size > 0;
-	ptr_last += (sample_file_size/sizeof(event_t));
-#endif
-#if defined(HAVE_ONLINE)
-	if (fd_online != -1)
+
+	if (!fitem->mapped || fitem->decoded)
 	{
-		res = read (fd_online, ptr_last, online_file_size);
-		if (res != online_file_size)
+		/* Read files */
+#if defined(HAVE_SIONLIB)
+		res = fread (fitem->first, 1, trace_file_size, fd_trace);
+		if (res != trace_file_size)
 		{
-			fprintf (stderr, "mpi2prv: `read` failed to read from file %s\n", online_file_name);
-			fprintf (stderr, "mpi2prv:        returned %Zu (instead of %lld)\n", res, online_file_size);
+			fprintf (stderr, "mpi2prv: `fread` failed to read from file %s\n", trace_file_name);
+			fprintf (stderr, "mpi2prv:        returned %Zu (instead of %lld)\n", res, trace_file_size);
 			exit (1);
 		}
+#else
+		Read_MPIT_Events (fileno (fd_trace), trace_version, fitem->first,
+			trace_events, trace_file_name);
+#endif
 	}
-	if (online_file_size > 0) sort_needed = TRUE;
-	ptr_last += (online_file_size/sizeof(event_t));	
+	ptr_last = fitem->first + trace_events;
+
+#if defined(SAMPLING_SUPPORT)
+	if (NULL != fd_sample)
+		Read_MPIT_Events (fileno (fd_sample), sample_version, ptr_last,
+			sample_events, sample_file_name);
+	sort_needed = sample_events > 0;
+	ptr_last += sample_events;
+#endif
+#if defined(HAVE_ONLINE)
+	if (fd_online != -1)
+		Read_MPIT_Events (fd_online, online_version, ptr_last,
+			online_events, online_file_name);
+	if (online_events > 0) sort_needed = TRUE;
+	ptr_last += online_events;
 #endif
 
 #if defined(SAMPLING_SUPPORT) || defined(HAVE_ONLINE)
@@ -429,6 +726,14 @@ static int AddFile_FS (FileItem_t * fitem, struct input_t *IFile, int taskid)
 	tmp = tmp + fitem->size;
 	fitem->last = (event_t *) tmp;
 
+#if !defined(HETEROGENEOUS_SUPPORT)
+	/* Files in the opposite byte order are sorted once they are corrected */
+# if defined(SAMPLING_SUPPORT) || defined(HAVE_ONLINE)
+	if (!sort_needed)
+# endif
+		Sort_Handoff_Events (fitem);
+#endif
+
 	fitem->first_glop = NULL;
 	fitem->current = fitem->next_cpu_burst = fitem->last_recv = fitem->first;
 
@@ -437,6 +742,114 @@ static int AddFile_FS (FileItem_t * fitem, struct input_t *IFile, int taskid)
 	fitem->thread = IFile->thread;
 	fitem->cpu = IFile->cpu;
 
+	return 0;
+}
+
+/******************************************************************************
+ ***  Load_FS
+ ***  Loads the intermediate files of the file set, on several threads if
+ ***  requested (-threads). Each thread takes the next file not taken yet, as
+ ***  the files can differ a lot in size.
+ ******************************************************************************/
+
+typedef struct
+{
+	FileSet_t *fset;
+	int taskid;
+	unsigned next;
+	int error;
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+	pthread_mutex_t lock;
+#endif
+} LoadQueue_t;
+
+static void * Load_FS_Worker (void *arg)
+{
+	LoadQueue_t *queue = (LoadQueue_t *) arg;
+	FileSet_t *fset = queue->fset;
+	unsigned i;
+	int error;
+
+	while (1)
+	{
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+		pthread_mutex_lock (&(queue->lock));
+#endif
+		i = queue->next++;
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+		pthread_mutex_unlock (&(queue->lock));
+#endif
+		if (i >= fset->nfiles)
+			break;
+
+		error = LoadFile_FS (&(fset->files[i]),
+		  &(fset->input_files[fset->files[i].mpit_id]), queue->taskid) != 0;
+
+		if (error)
+		{
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+			pthread_mutex_lock (&(queue->lock));
+#endif
+			queue->error = TRUE;
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+			pthread_mutex_unlock (&(queue->lock));
+#endif
+		}
+	}
+
+	return NULL;
+}
+
+static int Load_FS (FileSet_t *fset, int taskid)
+{
+	LoadQueue_t queue;
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+	pthread_t *threads = NULL;
+	unsigned i, nthreads = 0;
+#endif
+
+	queue.fset = fset;
+	queue.taskid = taskid;
+	queue.next = 0;
+	queue.error = FALSE;
+
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+	pthread_mutex_init (&(queue.lock), NULL);
+# if !defined(HAVE_SIONLIB) /* SIONlib containers are opened one at a time */
+	if (get_option_merge_NumThreads() > 1 && fset->nfiles > 1)
+	{
+		unsigned max = MIN((unsigned) get_option_merge_NumThreads(), fset->nfiles) - 1;
+
+		xmalloc (threads, max * sizeof(pthread_t));
+		for (nthreads = 0; nthreads < max; nthreads++)
+			if (pthread_create (&threads[nthreads], NULL, Load_FS_Worker, &queue) != 0)
+				break;
+	}
+# endif
+#endif
+
+	/* This thread also loads files, all of them if there are no more threads */
+	Load_FS_Worker (&queue);
+
+#if defined(MERGER_WITH_THREADS) && defined(HAVE_PTHREAD_H)
+	for (i = 0; i < nthreads; i++)
+		pthread_join (threads[i], NULL);
+	xfree (threads);
+	pthread_mutex_destroy (&(queue.lock));
+#endif
+
+	return queue.error ? -1 : 0;
+}
+
+/******************************************************************************
+ ***  AddFile_FS
+ ******************************************************************************/
+
+static int AddFile_FS (FileItem_t * fitem, struct input_t *IFile, int taskid)
+{
+	int tmp_fd;
+	char paraver_tmp[PATH_MAX];
+
 	(GET_THREAD_INFO(fitem->ptask,IFile->task,IFile->thread))->file = fitem;
 
 	/* Create a buffered file with 512 entries of paraver_rec_t */
@@ -458,6 +871,8 @@ FileSet_t *Create_FS (unsigned long nfiles, struct input_t * IFiles, int idtask,
 	unsigned long file;
 	FileSet_t *fset;
 	FileItem_t *fitem;
+	struct timeval time_begin, time_end;
+	long delta;
 
 	if ((fset = malloc (sizeof (FileSet_t))) == NULL)
 	{
@@ -469,6 +884,8 @@ FileSet_t *Create_FS (unsigned long nfiles, struct input_t * IFiles, int idtask,
 	fset->input_files = IFiles;
 	fset->num_input_files = nfiles;
 	fset->traceformat = trace_format;
+	Extrae_Heap_Init (&(fset->events));
+	Extrae_Heap_Init (&(fset->bursts));
 	xmalloc(fset->files, nTraces * sizeof(FileItem_t));
 	fset->nfiles = 0;
 	for (file = 0; file < nfiles; file++)
@@ -476,16 +893,51 @@ FileSet_t *Create_FS (unsigned long nfiles, struct input_t * IFiles, int idtask,
 		{
 			fitem = &(fset->files[fset->nfiles]);
 			fitem->mpit_id = file;
-			if (AddFile_FS (fitem, &(IFiles[file]), idtask) != 0)
-			{
-				perror ("AddFile_FS");
-				fprintf (stderr, "mpi2prv: Error creating file set\n");
-				free (fset);
-				return NULL;
-			}
+			fitem->wfb = NULL;
+			fitem->first = fitem->last = fitem->current = NULL;
+			fitem->mapped = fitem->modified = fitem->decoded = FALSE;
 			fset->nfiles++;
 		}
 
+	gettimeofday (&time_begin, NULL);
+
+	if (Load_FS (fset, idtask) != 0)
+	{
+		fprintf (stderr, "mpi2prv: Error! Processor %d could not load its intermediate files\n", idtask);
+		Free_FS (fset);
+		return NULL;
+	}
+
+	for (file = 0; file < fset->nfiles; file++)
+	{
+		fitem = &(fset->files[file]);
+		if (AddFile_FS (fitem, &(IFiles[fitem->mpit_id]), idtask) != 0)
+		{
+			fprintf (stderr, "mpi2prv: Error creating the temporary file for %s\n",
+				IFiles[fitem->mpit_id].name);
+			Free_FS (fset);
+			return NULL;
+		}
+	}
+
+	if (idtask == 0)
+	{
+		gettimeofday (&time_end, NULL);
+		delta = time_end.tv_sec - time_begin.tv_sec;
+		fprintf (stdout, "mpi2prv: Elapsed time loading intermediate files: %ld hours %ld minutes %ld seconds\n", delta / 3600, (delta % 3600)/60, (delta % 60));
+	}
+
+#if defined(HAVE_SYS_MMAN_H) && defined(MADV_DONTNEED)
+	/* Split the input memory budget among the files of this processor */
+	if (get_option_merge_InputMaxMem() > 0 && fset->nfiles > 0)
+	{
+		unsigned long pagesize = sysconf (_SC_PAGESIZE);
+
+		InputWindow = (1024UL*1024UL*get_option_merge_InputMaxMem()) / fset->nfiles;
+		InputWindow = MAX(pagesize, InputWindow - (InputWindow % pagesize));
+	}
+#endif
+
 	return fset;
 }
 
@@ -512,14 +964,35 @@ void Free_FS (FileSet_t *fset)
 		for (i = 0; i < fset->nfiles; i++)
 		{
 			fitem = &(fset->files[i]);
+#if defined(HAVE_SYS_MMAN_H)
+			if (fitem->mapped)
+				munmap (fitem->first, fitem->size);
+			else
+#endif
 			if (fitem->first != NULL)
 				free (fitem->first);
 			fitem->first = fitem->last = fitem->current = NULL;
 		}
+		Extrae_Heap_Destroy (&(fset->events));
+		Extrae_Heap_Destroy (&(fset->bursts));
+		xfree (fset->files);
 		free (fset);
 	}
 }
 
+/******************************************************************************
+ ***  Init_PRV_Decoder
+ ***  Records in the intermediate files are encoded (see paraver_records.h) and
+ ***  decoded into blocks of paraver_rec_t as they are read.
+ ******************************************************************************/
+
+static void Init_PRV_Decoder (PRVFileItem_t *file)
+{
+	file->encoded = NULL;
+	file->encoded_size = file->encoded_begin = file->encoded_end = 0;
+	ParaverRecord_InitContext (&(file->context));
+}
+
 #if defined(PARALLEL_MERGE)
 PRVFileSet_t * Map_Paraver_files (FileSet_t * fset, 
 	unsigned long long *num_of_events, int numtasks, int taskid, 
@@ -541,6 +1014,8 @@ PRVFileSet_t * Map_Paraver_files (FileSet_t * fset,
 	}
 
 	prvfset->fset = fset;
+	Extrae_Heap_Init (&(prvfset->heap));
+	prvfset->heap_ready = prvfset->heap_refill = FALSE;
 
         xmalloc(prvfset->files, nTraces * sizeof(PRVFileItem_t));
 	prvfset->nfiles = fset->nfiles;
@@ -567,16 +1042,14 @@ PRVFileSet_t * Map_Paraver_files (FileSet_t * fset,
 		prvfset->files[i].current_p =
 			prvfset->files[i].last_mapped_p =
 			prvfset->files[i].first_mapped_p = NULL;
-		prvfset->files[i].remaining_records = lseek (prvfset->files[i].source, 0, SEEK_END);
-		lseek (prvfset->files[i].source, 0, SEEK_SET);
-		if (-1 == prvfset->files[i].remaining_records)
+		Init_PRV_Decoder (&(prvfset->files[i]));
+		prvfset->files[i].remaining_records = WriteFileBuffer_getNumRecords (fset->files[i].wfb);
+		if (-1 == lseek (prvfset->files[i].source, 0, SEEK_SET))
 		{
-			fprintf (stderr, "mpi2prv: Failed to seek the end of a temporal file\n");
+			fprintf (stderr, "mpi2prv: Failed to seek the beginning of a temporal file\n");
 			fflush (stderr);
 			exit (0);
 		}
-		else
-			prvfset->files[i].remaining_records /= sizeof(paraver_rec_t);
 
 		total += prvfset->files[i].remaining_records;
 	}
@@ -595,6 +1068,7 @@ PRVFileSet_t * Map_Paraver_files (FileSet_t * fset,
 			prvfset->files[fset->nfiles+i-1].current_p =
 			prvfset->files[fset->nfiles+i-1].last_mapped_p =
 				prvfset->files[fset->nfiles+i-1].first_mapped_p = NULL;
+			Init_PRV_Decoder (&(prvfset->files[fset->nfiles+i-1]));
 
 			res = MPI_Recv (&(prvfset->files[fset->nfiles+i-1].remaining_records), 1, MPI_LONG_LONG, prvfset->files[fset->nfiles+i-1].source, REMAINING_TAG, MPI_COMM_WORLD, &s);
 			MPI_CHECK(res, MPI_Recv, "Cannot receive information of remaining records");
@@ -633,6 +1107,7 @@ PRVFileSet_t * ReMap_Paraver_files_binary (PRVFileSet_t * infset,
 	*num_of_events = total;
 
 	infset->records_per_block = records_per_block / tree_fan_out;
+	infset->heap_ready = infset->heap_refill = FALSE;
 
 	/* Master process will have its own files plus references to a single file of every other
 	   task (which represents a its set of assigned files) */
@@ -646,6 +1121,7 @@ PRVFileSet_t * ReMap_Paraver_files_binary (PRVFileSet_t * infset,
 			int fd;
 
 			infset->files[0].source = WriteFileBuffer_getFD(infset->files[0].destination);
+			infset->files[0].remaining_records = WriteFileBuffer_getNumRecords (infset->files[0].destination);
 
 			/* Create a temporal file */
 			fd = newTemporalFile (taskid, FALSE, 0, paraver_tmp);
@@ -659,16 +1135,13 @@ PRVFileSet_t * ReMap_Paraver_files_binary (PRVFileSet_t * infset,
 			infset->files[0].current_p =
 				infset->files[0].last_mapped_p =
 				infset->files[0].first_mapped_p = NULL;
-			infset->files[0].remaining_records = lseek (infset->files[0].source, 0, SEEK_END);
-			lseek (infset->files[0].source, 0, SEEK_SET);
-			if (-1 == infset->files[0].remaining_records)
+			Init_PRV_Decoder (&(infset->files[0]));
+			if (-1 == lseek (infset->files[0].source, 0, SEEK_SET))
 			{
-				fprintf (stderr, "mpi2prv: Failed to seek the end of a temporal file\n");
+				fprintf (stderr, "mpi2prv: Failed to seek the beginning of a temporal file\n");
 				fflush (stderr);
 				exit (0);
 			}
-			else
-				infset->files[0].remaining_records /= sizeof(paraver_rec_t);
 		
 			total += infset->files[0].remaining_records;
 
@@ -683,6 +1156,7 @@ PRVFileSet_t * ReMap_Paraver_files_binary (PRVFileSet_t * infset,
 				infset->files[i].current_p =
 					infset->files[i].last_mapped_p =
 					infset->files[i].first_mapped_p = NULL;
+				Init_PRV_Decoder (&(infset->files[i]));
 
 				res = MPI_Recv (&(infset->files[i].remaining_records), 1, MPI_LONG_LONG, infset->files[i].source, REMAINING_TAG, MPI_COMM_WORLD, &s);
 				MPI_CHECK(res, MPI_Recv, "Cannot receive information of remaining records");
@@ -708,6 +1182,7 @@ PRVFileSet_t * ReMap_Paraver_files_binary (PRVFileSet_t * infset,
 
 		infset->nfiles = 1;
 		infset->files[0].source = WriteFileBuffer_getFD(infset->files[0].destination);
+		infset->files[0].remaining_records = WriteFileBuffer_getNumRecords (infset->files[0].destination);
 		infset->files[0].destination = (WriteFileBuffer_t*) 0xdeadbeef;
 		infset->files[0].type = LOCAL;
 
@@ -716,18 +1191,14 @@ PRVFileSet_t * ReMap_Paraver_files_binary (PRVFileSet_t * infset,
 		infset->files[0].current_p =
 			infset->files[0].last_mapped_p =
 			infset->files[0].first_mapped_p = NULL;
+		Init_PRV_Decoder (&(infset->files[0]));
 
-		infset->files[0].remaining_records = lseek (infset->files[0].source, 0, SEEK_END);
-		lseek (infset->files[0].source, 0, SEEK_SET);
-
-		if (-1 == infset->files[0].remaining_records)
+		if (-1 == lseek (infset->files[0].source, 0, SEEK_SET))
 		{
-			fprintf (stderr, "mpi2prv: Failed to seek the end of a temporal file\n");
+			fprintf (stderr, "mpi2prv: Failed to seek the beginning of a temporal file\n");
 			fflush (stderr);
 			exit (0);
 		}
-		else
-			infset->files[0].remaining_records /= sizeof(paraver_rec_t);
 
 		total = infset->files[0].remaining_records;
 
@@ -749,7 +1220,10 @@ void Free_Map_Paraver_Files (PRVFileSet_t * infset)
 		{
 			xfree (infset->files[i].first_mapped_p)
 			infset->files[i].first_mapped_p = NULL;
+			xfree (infset->files[i].encoded);
 		}
+	Extrae_Heap_Destroy (&(infset->heap));
+	infset->heap_ready = infset->heap_refill = FALSE;
 }
 
 void Flush_Paraver_Files_binary (PRVFileSet_t *prvfset, int taskid, int depth,
@@ -779,6 +1253,8 @@ PRVFileSet_t * Map_Paraver_files (FileSet_t * fset,
 	}
 
 	prvfset->fset = fset;
+	Extrae_Heap_Init (&(prvfset->heap));
+	prvfset->heap_ready = prvfset->heap_refill = FALSE;
 
 	/* Master process will have its own files plus references to a single file of every other
 	   task (which represents a its set of assigned files) */
@@ -801,16 +1277,14 @@ PRVFileSet_t * Map_Paraver_files (FileSet_t * fset,
 		prvfset->files[i].current_p =
 			prvfset->files[i].last_mapped_p =
 			prvfset->files[i].first_mapped_p = NULL;
-		prvfset->files[i].remaining_records = lseek (prvfset->files[i].source, 0, SEEK_END);
-		lseek (prvfset->files[i].source, 0, SEEK_SET);
-		if (-1 == prvfset->files[i].remaining_records)
+		Init_PRV_Decoder (&(prvfset->files[i]));
+		prvfset->files[i].remaining_records = WriteFileBuffer_getNumRecords (fset->files[i].wfb);
+		if (-1 == lseek (prvfset->files[i].source, 0, SEEK_SET))
 		{
-			fprintf (stderr, "mpi2prv: Failed to seek the end of a temporal file\n");
+			fprintf (stderr, "mpi2prv: Failed to seek the beginning of a temporal file\n");
 			fflush (stderr);
 			exit (0);
 		}
-		else
-			prvfset->files[i].remaining_records /= sizeof(paraver_rec_t);
 			
 		total += prvfset->files[i].remaining_records;
 	}
@@ -824,10 +1298,9 @@ PRVFileSet_t * Map_Paraver_files (FileSet_t * fset,
 
 static void Read_PRV_LocalFile (PRVFileItem_t *file, unsigned records_per_block)
 {
-	size_t want_to_read;
+	size_t want_to_read, used;
 	ssize_t res;
-	char *tmp;
-	unsigned nrecords;
+	unsigned nrecords, n;
 
 	nrecords = MIN(records_per_block,file->remaining_records);
 	want_to_read = nrecords * sizeof(paraver_rec_t);
@@ -848,20 +1321,50 @@ static void Read_PRV_LocalFile (PRVFileItem_t *file, unsigned records_per_block)
 		fflush (stderr);
 		exit (0);
 	}
-	
-	res = read (file->source, file->first_mapped_p, want_to_read);
-	if (-1 == res)
+
+	/* The encoded records are read in chunks of at most the size of the
+	   decoded block */
+	if (file->encoded == NULL)
 	{
-		perror ("read");
-		fprintf (stderr, "mpi2prv: Failed to read %Zu bytes on local file (result = %Zu)\n", want_to_read, res);
-		fflush (stderr);
-		exit (0);
+		file->encoded_size = MAX(want_to_read, PRV_RECORD_MAX_SIZE);
+		xmalloc (file->encoded, file->encoded_size);
+		file->encoded_begin = file->encoded_end = 0;
+	}
+
+	n = 0;
+	while (n < nrecords)
+	{
+		used = ParaverRecord_Decode (&(file->context),
+		  &(file->encoded[file->encoded_begin]),
+		  file->encoded_end - file->encoded_begin, &(file->first_mapped_p[n]));
+
+		if (used > 0)
+		{
+			file->encoded_begin += used;
+			n++;
+			continue;
+		}
+
+		/* Keep the partial record and read what follows */
+		memmove (file->encoded, &(file->encoded[file->encoded_begin]),
+		  file->encoded_end - file->encoded_begin);
+		file->encoded_end -= file->encoded_begin;
+		file->encoded_begin = 0;
+
+		res = read (file->source, &(file->encoded[file->encoded_end]),
+		  file->encoded_size - file->encoded_end);
+		if (res <= 0)
+		{
+			perror ("read");
+			fprintf (stderr, "mpi2prv: Failed to read %Zu bytes on local file (result = %Zu)\n", file->encoded_size - file->encoded_end, res);
+			fflush (stderr);
+			exit (0);
+		}
+		file->encoded_end += res;
 	}
 
 	file->current_p = file->first_mapped_p;
-	tmp = (char *) file->first_mapped_p;
-	tmp = tmp + want_to_read;
-	file->last_mapped_p = (paraver_rec_t *) tmp;
+	file->last_mapped_p = file->first_mapped_p + nrecords;
 
 	file->remaining_records -= nrecords;
 }
@@ -871,15 +1374,17 @@ static void Read_PRV_LocalFile (PRVFileItem_t *file, unsigned records_per_block)
 static void Read_PRV_RemoteFile (PRVFileItem_t *file)
 {
 	int res;
-	unsigned int howmany;
+	unsigned int howmany, n;
+	unsigned int block[2]; /* number of events and bytes */
+	size_t offset, used;
 	MPI_Status s;
-	char *tmp;
 
 	res = MPI_Send (&res, 1, MPI_INT, file->source, ASK_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD); 
 	MPI_CHECK(res, MPI_Send, "Failed to ask to a remote task a block of merged events!");
 
-	res = MPI_Recv (&howmany, 1, MPI_UNSIGNED, file->source, HOWMANY_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD, &s);
+	res = MPI_Recv (block, 2, MPI_UNSIGNED, file->source, HOWMANY_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD, &s);
 	MPI_CHECK(res, MPI_Recv, "Failed to receive how many events are on the incoming buffer!");
+	howmany = block[0];
 
 	if (0 != howmany)
 	{
@@ -896,74 +1401,164 @@ static void Read_PRV_RemoteFile (PRVFileItem_t *file)
 		}
 
 		file->current_p = file->first_mapped_p;
-		tmp = (char *) file->first_mapped_p;
-		tmp += howmany*sizeof(paraver_rec_t);
-		file->last_mapped_p = (paraver_rec_t *) tmp;
+		file->last_mapped_p = file->first_mapped_p + howmany;
 		file->remaining_records -= howmany;
 
-		res = MPI_Recv (file->first_mapped_p, howmany*sizeof(paraver_rec_t), MPI_BYTE, file->source, BUFFER_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD, &s);
+		/* The block comes encoded (see Paraver_JoinFiles_Slave) */
+		if (file->encoded_size < block[1])
+		{
+			xfree (file->encoded);
+			xmalloc (file->encoded, block[1]);
+			file->encoded_size = block[1];
+		}
+
+		res = MPI_Recv (file->encoded, block[1], MPI_BYTE, file->source, BUFFER_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD, &s);
 		MPI_CHECK(res, MPI_Recv, "ERROR! Failed to receive how many events are on the incoming buffer!");
+
+		ParaverRecord_InitContext (&(file->context));
+		for (n = 0, offset = 0; n < howmany; n++, offset += used)
+		{
+			used = ParaverRecord_Decode (&(file->context), &(file->encoded[offset]),
+			  block[1] - offset, &(file->first_mapped_p[n]));
+			if (0 == used)
+			{
+				fprintf (stderr, "mpi2prv: Error! Malformed block of events received from task %u\n", file->source);
+				fflush (stderr);
+				exit (0);
+			}
+		}
 	}
 }
 #endif /* PARALLEL_MERGE */
 
 
-paraver_rec_t *GetNextParaver_Rec (PRVFileSet_t * fset)
+static void Reload_PRV_File (PRVFileSet_t * fset, unsigned i)
 {
-	paraver_rec_t *minimum = NULL, *current = NULL;
-	PRVFileItem_t *sfile;
-	unsigned int fminimum = 0, i;
-	
-	/* Check if we have to reload any files */
-	for (i = 0; i < fset->nfiles; i++)
-		if (fset->files[i].current_p == fset->files[i].last_mapped_p)
-			if (fset->files[i].remaining_records > 0)
-			{
 #if defined(PARALLEL_MERGE)
-				/* This can only happen for task = 0 and parallel merger */
-				if (fset->files[i].type == REMOTE)
-					Read_PRV_RemoteFile (&(fset->files[i]));
-				else
+	/* This can only happen for task = 0 and parallel merger */
+	if (fset->files[i].type == REMOTE)
+		Read_PRV_RemoteFile (&(fset->files[i]));
+	else
 #endif
-					Read_PRV_LocalFile (&(fset->files[i]), fset->records_per_block);
-			}
+		Read_PRV_LocalFile (&(fset->files[i]), fset->records_per_block);
+}
 
-	for (i = 0; i < fset->nfiles; i++)
-	{
-		sfile = &(fset->files[i]);
+/* Records are sorted by time and, on equal times, the one with greater type
+   comes first. Remaining ties go to the file with the lowest index. */
+#define PRV_HEAP_TIE(rec) (-((int)(rec)->type))
 
-		current = (sfile->current_p == sfile->last_mapped_p) ? NULL : sfile->current_p;
+paraver_rec_t *GetNextParaver_Rec (PRVFileSet_t * fset)
+{
+	paraver_rec_t *minimum;
+	PRVFileItem_t *sfile;
+	Extrae_Heap_Item_t *top;
+	unsigned int i;
 
-		if (!(minimum) && current)
-		{
-			minimum = current;
-			fminimum = i;
-		}
-		else if (minimum && current)
+	if (!fset->heap_ready)
+	{
+		/* Load the first block of every file and sort the files */
+		Extrae_Heap_Clear (&(fset->heap));
+		for (i = 0; i < fset->nfiles; i++)
 		{
-			if (minimum->time > current->time)
-			{
-				minimum = current;
-				fminimum = i;
-			}
-			else if (minimum->time == current->time)
-			{
-				if (minimum->type < current->type)
-				{
-					minimum = current;
-					fminimum = i;
-				}
-			}
+			sfile = &(fset->files[i]);
+			if (sfile->current_p == sfile->last_mapped_p && sfile->remaining_records > 0)
+				Reload_PRV_File (fset, i);
+			if (sfile->current_p != sfile->last_mapped_p)
+				Extrae_Heap_Push (&(fset->heap), sfile->current_p->time,
+				  PRV_HEAP_TIE(sfile->current_p), i);
 		}
+		fset->heap_ready = TRUE;
+		fset->heap_refill = FALSE;
+	}
+	else if (fset->heap_refill)
+	{
+		/* The block of the file returned last time has been consumed. It could
+		   not be reloaded then because the record returned lived in it */
+		top = Extrae_Heap_Top (&(fset->heap));
+		sfile = &(fset->files[top->id]);
+		Reload_PRV_File (fset, top->id);
+		if (sfile->current_p != sfile->last_mapped_p)
+			Extrae_Heap_UpdateTop (&(fset->heap), sfile->current_p->time,
+			  PRV_HEAP_TIE(sfile->current_p));
+		else
+			Extrae_Heap_Pop (&(fset->heap));
+		fset->heap_refill = FALSE;
 	}
 
-	sfile = &(fset->files[fminimum]);
+	top = Extrae_Heap_Top (&(fset->heap));
+	if (top == NULL)
+		return NULL;
+
+	sfile = &(fset->files[top->id]);
+	minimum = sfile->current_p;
+	sfile->current_p++;
+
 	if (sfile->current_p != sfile->last_mapped_p)
-		sfile->current_p++;
+		Extrae_Heap_UpdateTop (&(fset->heap), sfile->current_p->time,
+		  PRV_HEAP_TIE(sfile->current_p));
+	else if (sfile->remaining_records > 0)
+		fset->heap_refill = TRUE;
+	else
+		Extrae_Heap_Pop (&(fset->heap));
 
 	return minimum;
 }
 
+/******************************************************************************
+ ***  Next_CPU_Burst / Next_Event_prv
+ ***  Look forward in a file until the following CPU burst (or regular event)
+ ******************************************************************************/
+
+static event_t * Next_CPU_Burst (FileItem_t * fitem)
+{
+	while ((fitem->next_cpu_burst < fitem->last) &&
+	       (fitem->next_cpu_burst->event != CPU_BURST_EV) &&
+	       (fitem->next_cpu_burst->event != MPI_STATS_EV))
+		fitem->next_cpu_burst++;
+
+	return (fitem->next_cpu_burst < fitem->last) ? fitem->next_cpu_burst : NULL;
+}
+
+static event_t * Next_Event_prv (FileItem_t * fitem)
+{
+	event_t *current = Current_FS (fitem);
+
+	while ((current != NULL) && ((current->event == CPU_BURST_EV) || (current->event == MPI_STATS_EV)))
+	{
+		StepOne_FS (fitem);
+		current = Current_FS (fitem);
+	}
+	return current;
+}
+
+/******************************************************************************
+ ***  Rewind_Heaps_FS
+ ***  Sorts the files by the synchronized time of their following event and
+ ***  CPU burst. Ties go to the file with the lowest index.
+ ******************************************************************************/
+
+static void Rewind_Heaps_FS (FileSet_t * fset)
+{
+	unsigned int file;
+	event_t *current;
+
+	Extrae_Heap_Clear (&(fset->events));
+	Extrae_Heap_Clear (&(fset->bursts));
+
+	for (file = 0; file < fset->nfiles; file++)
+	{
+		FileItem_t *fitem = &(fset->files[file]);
+
+		if ((current = Next_Event_prv (fitem)) != NULL)
+			Extrae_Heap_Push (&(fset->events),
+			  TIMESYNC(fitem->ptask-1, fitem->task-1, current->time), 0, file);
+
+		if ((current = Next_CPU_Burst (fitem)) != NULL)
+			Extrae_Heap_Push (&(fset->bursts),
+			  TIMESYNC(fitem->ptask-1, fitem->task-1, current->time), 0, file);
+	}
+}
+
 /******************************************************************************
  ***  Search_CPU_Burst
  ******************************************************************************/
@@ -977,40 +1572,24 @@ static event_t * Search_CPU_Burst (
 	unsigned int *thread )
 {
 	event_t * minimum = NULL, * current = NULL;
-	unsigned int fminimum = 0;
-	unsigned int file;
+	Extrae_Heap_Item_t * top;
 	FileItem_t * sfile;
 
-	for (file = 0; file < fset->nfiles; file++)
-	{  
-		current = fset->files[file].next_cpu_burst;
-		/* Look forward until you find the next CPU burst (or end of file) */
-		while ((current < (fset->files[file].last)) && (current->event != CPU_BURST_EV) && (current->event != MPI_STATS_EV))
-		{
-			current = ++(fset->files[file].next_cpu_burst);
-		}
-		if (current < (fset->files[file].last)) 
-		{
-			if (minimum == NULL)
-			{
-				minimum = current;
-				fminimum = file;
-			}
-			else 
-			{ 
-				if (TIMESYNC(fset->files[fminimum].ptask-1, fset->files[fminimum].task-1, minimum->time) > TIMESYNC(fset->files[file].ptask-1, fset->files[file].task-1, current->time))
-				{
-					minimum = current;
-					fminimum = file;
-				}
-			}
-		}
-	}
+	top = Extrae_Heap_Top (&(fset->bursts));
+	if (top == NULL)
+		return NULL;
 
-	sfile = &(fset->files[fminimum]);
+	sfile = &(fset->files[top->id]);
+	minimum = sfile->next_cpu_burst;
 	CurrentObj_FS (sfile, *cpu, *ptask, *task, *thread);
 	sfile->next_cpu_burst ++; /* StepOne */
 
+	if ((current = Next_CPU_Burst (sfile)) != NULL)
+		Extrae_Heap_UpdateTop (&(fset->bursts),
+		  TIMESYNC(sfile->ptask-1, sfile->task-1, current->time), 0);
+	else
+		Extrae_Heap_Pop (&(fset->bursts));
+
 	return minimum;
 }
 
@@ -1022,35 +1601,24 @@ static event_t *GetNextEvent_FS_prv (FileSet_t * fset, unsigned int *cpu,
   unsigned int *ptask, unsigned int *task, unsigned int *thread)
 {
 	event_t *minimum = NULL, *current = NULL;
-	unsigned int fminimum = 0, file;
+	Extrae_Heap_Item_t *top;
 	FileItem_t *sfile;
 
-	for (file = 0; file < fset->nfiles; file++)
-	{
-		current = Current_FS (&(fset->files[file]));
-		while ((current != NULL) && ((current->event == CPU_BURST_EV) || (current->event == MPI_STATS_EV)))
-		{
-			StepOne_FS (&(fset->files[file]));
-			current = Current_FS (&(fset->files[file]));
-		}
-		if (minimum == NULL && current != NULL)
-		{
-			minimum = current;
-			fminimum = file;
-		}
-		else if (minimum != NULL && current != NULL)
-		{
-			if (TIMESYNC(fset->files[fminimum].ptask-1, fset->files[fminimum].task-1, minimum->time) > TIMESYNC(fset->files[file].ptask-1, fset->files[file].task-1, current->time))
-			{
-				minimum = current;
-				fminimum = file;
-			}
-		}
-	}
-	sfile = &(fset->files[fminimum]);
+	top = Extrae_Heap_Top (&(fset->events));
+	if (top == NULL)
+		return NULL;
+
+	sfile = &(fset->files[top->id]);
+	minimum = Current_FS (sfile);
 	CurrentObj_FS (sfile, *cpu, *ptask, *task, *thread);
 	StepOne_FS (sfile);
 
+	if ((current = Next_Event_prv (sfile)) != NULL)
+		Extrae_Heap_UpdateTop (&(fset->events),
+		  TIMESYNC(sfile->ptask-1, sfile->task-1, current->time), 0);
+	else
+		Extrae_Heap_Pop (&(fset->events));
+
 	return minimum;
 }
 
@@ -1073,6 +1641,45 @@ static event_t *GetNextEvent_FS_trf (FileSet_t * fset, unsigned int *cpu,
 	return current;
 }
 
+/******************************************************************************
+ ***  Release_FS
+ ***  Gives back to the system the mapped pages that lay behind the translation
+ ***  cursors of the file, once they exceed the per-file input window. They are
+ ***  loaded again from the file if visited later (e.g. by a search or after
+ ***  Rewind_FS).
+ ******************************************************************************/
+
+static void Release_FS (FileSet_t * fset)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(MADV_DONTNEED)
+	unsigned int file;
+
+	for (file = 0; file < fset->nfiles; file++)
+	{
+		FileItem_t *fitem = &(fset->files[file]);
+		event_t *low;
+		char *limit;
+
+		/* Pages changed in a private mapping cannot be reloaded from the file */
+		if (!fitem->mapped || (fitem->modified && !fitem->decoded))
+			continue;
+
+		low = MIN(fitem->current, fitem->next_cpu_burst);
+		low = MIN(low, fitem->last);
+
+		limit = (char*) low;
+		limit -= ((unsigned long) limit) % InputWindow;
+		if (limit > (char*) fitem->released)
+		{
+			madvise (fitem->released, limit - (char*) fitem->released, MADV_DONTNEED);
+			fitem->released = (event_t*) limit;
+		}
+	}
+#else
+	UNREFERENCED_PARAMETER(fset);
+#endif
+}
+
 event_t * GetNextEvent_FS (
 	FileSet_t * fset,
 	unsigned int *cpu, 
@@ -1084,12 +1691,17 @@ event_t * GetNextEvent_FS (
 	static event_t * min_event = NULL, * min_burst = NULL;
 	static unsigned int min_event_ptask = 0, min_event_task = 0, min_event_thread = 0, min_event_cpu = 0;
 	static unsigned int min_burst_ptask = 0, min_burst_task = 0, min_burst_thread = 0, min_burst_cpu = 0;
+	static unsigned int calls = 0;
+
+	if (InputWindow > 0 && (++calls % RELEASE_PERIOD) == 0)
+		Release_FS (fset);
 
 	if (PRV_SEMANTICS == fset->traceformat)
 	{
 		if (Is_FS_Rewound)
 		{
 			/* Select the first CPU burst event and the first normal event */
+			Rewind_Heaps_FS (fset);
 			min_event = GetNextEvent_FS_prv (fset, &min_event_cpu, &min_event_ptask, &min_event_task, &min_event_thread);
 			min_burst = Search_CPU_Burst (fset, &min_burst_cpu, &min_burst_ptask, &min_burst_task, &min_burst_thread);
 			Is_FS_Rewound = FALSE;
@@ -1200,6 +1812,10 @@ void Rewind_FS (FileSet_t * fs)
 			fs->files[i].next_cpu_burst = fs->files[i].first;
 			fs->files[i].last_recv = fs->files[i].first;
 		}
+
+		/* Released pages will be loaded again as they are visited */
+		if (fs->files[i].mapped)
+			fs->files[i].released = fs->files[i].first;
 	}
 	fs->active_file = 0;
 }
@@ -1416,6 +2032,7 @@ static void PerformEndianCorrection (FileItem_t *file)
 
 	/* Change the endianness in all the fields of event_t in all the records of
 	   the file! */	
+	file->modified = TRUE;
 	for (i = 0; i < file->num_of_events; i++)
 	{
 		file->first[i].event = bswap32 (file->first[i].event);
@@ -1582,6 +2199,9 @@ void EndianCorrection (FileSet_t *fset, int numtasks, int taskid)
 		}
 	}
 
+	for (file = 0; file < fset->nfiles; file++)
+		Sort_Handoff_Events (&(fset->files[file]));
+
 	if (0 == taskid)
 	{
 		fprintf (stdout, "done\n");
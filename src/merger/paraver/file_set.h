@@ -34,7 +34,9 @@
 #include "common.h"
 #include "queue.h"
 #include "mpi2out.h"
+#include "paraver_records.h"
 #include "write_file_buffer.h"
+#include "extrae_heap.h"
 
 enum
 {
@@ -42,39 +44,6 @@ enum
     CIRCULAR_SKIP_MATCHES
 };
 
-typedef enum
-{
-	LOGICAL_COMMUNICATION = 0,
-	PHYSICAL_COMMUNICATION,
-	NUM_COMMUNICATION_TYPE
-}
-CommunicationType;
-
-typedef enum {
-	UNFINISHED_STATE = -1,
-	STATE = 1,
-	EVENT = 2,
-	UNMATCHED_COMMUNICATION = -3,
-	COMMUNICATION = 3,
-	PENDING_COMMUNICATION = -4
-}
-RecordType;
-
-typedef struct
-{
-	unsigned long long receive[NUM_COMMUNICATION_TYPE];
-	                              /* both logical and physical recv times */
-	UINT64 value;                 /* state, value, tag or global_op_id */
-	unsigned long long time;      /* state ini_time or logical send time */
-	unsigned long long end_time;  /* state end_time or physical send time */
-	RecordType type;              /* Type of record */
-	int event;                    /* size, type or comm_id */
-	int cpu, ptask, task, thread; /* ID of this task */
-	int cpu_r, ptask_r, task_r, thread_r;
-	                              /* ID of the receiver task */
-}
-paraver_rec_t;
-
 typedef struct
 {
 	int fd;
@@ -90,6 +59,11 @@ typedef struct
 	event_t *first, *last, *first_glop;
 	event_t *last_recv;
 	event_t *tmp;
+
+	int mapped;                   /* Events are mmap'ed from the .mpit rather than read */
+	int modified;                 /* Mapped events have been changed in memory */
+	int decoded;                  /* Mapped events were decoded into a temporary file */
+	event_t *released;            /* Mapped pages before this have been given back */
 }
 FileItem_t;
 
@@ -102,6 +76,8 @@ typedef struct
 	FILE *output_file;              /* Dimemas output file */
 	struct input_t *input_files;    /* Input files */
 	unsigned int num_input_files;   /* Num of input files */
+	Extrae_Heap_t events;           /* Files sorted by their next event */
+	Extrae_Heap_t bursts;           /* Files sorted by their next CPU burst */
 }
 FileSet_t;
 
@@ -116,6 +92,9 @@ typedef struct
 {
 	paraver_rec_t *current_p, *first_mapped_p, *last_mapped_p;
 	WriteFileBuffer_t *destination;
+	unsigned char *encoded;         /* Encoded records read but not decoded */
+	size_t encoded_size, encoded_begin, encoded_end;
+	paraver_rec_context_t context;
 	long long remaining_records;
 	long long mapped_records;
 	unsigned source;
@@ -130,6 +109,9 @@ typedef struct
 	unsigned int nfiles;
 	FileSet_t *fset;
 	int SkipAsMasterOfSubtree;
+	Extrae_Heap_t heap;             /* Files sorted by their next record */
+	int heap_ready;                 /* Heap has been filled with the files */
+	int heap_refill;                /* Top file has to be reloaded */
 }
 PRVFileSet_t;
 
@@ -584,6 +584,59 @@ static void Write_MPI_Stats_Labels (FILE * pcf_fd)
    }
 }
 
+static void IO_Stats_Event_Label (int io_stats_evt, char *label, size_t size)
+{
+	static const char *io_stats_labels[IO_STATS_READ_HISTOGRAM_EV] = {
+		"Aggregated I/O descriptor",
+		"Aggregated I/O read calls",
+		"Aggregated I/O bytes read",
+		"Aggregated I/O time in read calls (ns)",
+		"Aggregated I/O write calls",
+		"Aggregated I/O bytes written",
+		"Aggregated I/O time in write calls (ns)" };
+	int bin;
+
+	if (io_stats_evt < IO_STATS_READ_HISTOGRAM_EV)
+	{
+		snprintf (label, size, "%s", io_stats_labels[io_stats_evt]);
+		return;
+	}
+
+	bin = (io_stats_evt < IO_STATS_WRITE_HISTOGRAM_EV) ?
+	  io_stats_evt - IO_STATS_READ_HISTOGRAM_EV :
+	  io_stats_evt - IO_STATS_WRITE_HISTOGRAM_EV;
+
+	if (bin == 0)
+		snprintf (label, size, "Aggregated I/O %s calls of 0-1 bytes",
+		  io_stats_evt < IO_STATS_WRITE_HISTOGRAM_EV ? "read" : "write");
+	else if (bin == IO_STATS_HISTOGRAM_BINS-1)
+		snprintf (label, size, "Aggregated I/O %s calls of %llu bytes or more",
+		  io_stats_evt < IO_STATS_WRITE_HISTOGRAM_EV ? "read" : "write", 1ULL << bin);
+	else
+		snprintf (label, size, "Aggregated I/O %s calls of %llu-%llu bytes",
+		  io_stats_evt < IO_STATS_WRITE_HISTOGRAM_EV ? "read" : "write",
+		  1ULL << bin, (1ULL << (bin+1)) - 1);
+}
+
+static void Write_IO_Stats_Labels (FILE * pcf_fd)
+{
+	char label[128];
+	int i;
+
+	if (IO_Stats_Events_Found)
+	{
+		fprintf (pcf_fd, "%s\n", TYPE_LABEL);
+
+		for (i=0; i<IO_STATS_EVENTS_COUNT; i++) {
+			if (IO_Stats_Labels_Used[i]) {
+				IO_Stats_Event_Label (i, label, sizeof(label));
+				fprintf(pcf_fd, "0    %d    %s\n", IO_STATS_BASE+i, label);
+			}
+		}
+		LET_SPACES (pcf_fd);
+	}
+}
+
 static void Write_Trace_Mode_Labels (FILE * pcf_fd)
 {
 	fprintf (pcf_fd, "%s\n", TYPE_LABEL);
@@ -1176,6 +1229,7 @@ int Labels_GeneratePCFfile (char *name, long long options)
 	Write_rusage_Labels (fd);
 	Write_memusage_Labels (fd);
 	Write_MPI_Stats_Labels (fd);
+	Write_IO_Stats_Labels (fd);
 	Write_Trace_Mode_Labels (fd);
 	Write_Clustering_Labels (fd);
 	Write_Spectral_Labels (fd);
@@ -534,10 +534,11 @@ void MISCEvent_WriteEnabledOperations (FILE * fd, long long options)
 void Share_MISC_Operations (void)
 {
 	int res, i, max;
-	int tmp2[4], tmp[4] = { Rusage_Events_Found, MPI_Stats_Events_Found, Memusage_Events_Found, Syscall_Events_Found };
+	int tmp2[5], tmp[5] = { Rusage_Events_Found, MPI_Stats_Events_Found, Memusage_Events_Found, Syscall_Events_Found, IO_Stats_Events_Found };
 	int tmp_in[RUSAGE_EVENTS_COUNT], tmp_out[RUSAGE_EVENTS_COUNT];
 	int tmp2_in[MPI_STATS_EVENTS_COUNT], tmp2_out[MPI_STATS_EVENTS_COUNT];
 	int tmp3_in[MEMUSAGE_EVENTS_COUNT], tmp3_out[MEMUSAGE_EVENTS_COUNT];
+	int tmp4_in[IO_STATS_EVENTS_COUNT], tmp4_out[IO_STATS_EVENTS_COUNT];
 	int tmp_misc[MAX_MISC_INDEX];
 
 	res = MPI_Reduce (inuse, tmp_misc, MAX_MISC_INDEX, MPI_INT, MPI_BOR, 0,
@@ -546,12 +547,13 @@ void Share_MISC_Operations (void)
 	for (i = 0; i < MAX_MISC_INDEX; i++)
 		inuse[i] = tmp_misc[i];
 
-	res = MPI_Reduce (tmp, tmp2, 4, MPI_INT, MPI_BOR, 0, MPI_COMM_WORLD);
+	res = MPI_Reduce (tmp, tmp2, 5, MPI_INT, MPI_BOR, 0, MPI_COMM_WORLD);
 	MPI_CHECK(res, MPI_Reduce, "Sharing MISC operations #2");
 	Rusage_Events_Found = tmp2[0];
 	MPI_Stats_Events_Found = tmp2[1];
 	Memusage_Events_Found = tmp2[2];
 	Syscall_Events_Found = tmp2[3];
+	IO_Stats_Events_Found = tmp2[4];
 
 	for (i = 0; i < RUSAGE_EVENTS_COUNT; i++)
 		tmp_in[i] = GetRusage_Labels_Used[i];
@@ -581,6 +583,13 @@ void Share_MISC_Operations (void)
   for (i = 0; i < SYSCALL_EVENTS_COUNT; i++)                                   
     Syscall_Labels_Used[i] = tmp3_out[i];                                      
 
+	for (i = 0; i < IO_STATS_EVENTS_COUNT; i++)
+		tmp4_in[i] = IO_Stats_Labels_Used[i];
+	res = MPI_Reduce (tmp4_in, tmp4_out, IO_STATS_EVENTS_COUNT, MPI_INT, MPI_BOR, 0, MPI_COMM_WORLD);
+	MPI_CHECK(res, MPI_Reduce, "Sharing MISC operations #9");
+	for (i = 0; i < IO_STATS_EVENTS_COUNT; i++)
+		IO_Stats_Labels_Used[i] = tmp4_out[i];
+
 	res = MPI_Reduce (&MaxClusterId, &max, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
 	MPI_CHECK(res, MPI_Reduce, "Sharing MISC operations #8");
 	MaxClusterId = max;
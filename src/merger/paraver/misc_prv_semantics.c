@@ -73,6 +73,8 @@ int Memusage_Events_Found = FALSE;
 int Memusage_Labels_Used[MEMUSAGE_EVENTS_COUNT];
 int MPI_Stats_Events_Found = FALSE;
 int MPI_Stats_Labels_Used[MPI_STATS_EVENTS_COUNT];
+int IO_Stats_Events_Found = FALSE;
+int IO_Stats_Labels_Used[IO_STATS_EVENTS_COUNT];
 int Syscall_Events_Found = FALSE;
 int Syscall_Labels_Used[SYSCALL_EVENTS_COUNT];
 
@@ -577,6 +579,46 @@ static int MPI_Stats_Event (
 }
 
 
+/******************************************************************************
+ ***  IO_Stats_Event
+ ******************************************************************************/
+static int IO_Stats_Event (
+   event_t * current_event,
+   unsigned long long current_time,
+   unsigned int cpu,
+   unsigned int ptask,
+   unsigned int task,
+   unsigned int thread,
+   FileSet_t *fset )
+{
+	int i;
+	unsigned int EvType;
+	unsigned long long EvValue;
+	UNREFERENCED_PARAMETER(fset);
+
+	EvType  = Get_EvValue (current_event);     /* Value is the event type.  */
+	EvValue = Get_EvMiscParam (current_event); /* Param is the event value. */
+
+	if (EvType >= IO_STATS_EVENTS_COUNT)
+		return 0;
+
+	trace_paraver_state (cpu, ptask, task, thread, current_time);
+	trace_paraver_event (cpu, ptask, task, thread, current_time, IO_STATS_BASE+EvType, EvValue);
+
+	if (!IO_Stats_Events_Found)
+	{
+		IO_Stats_Events_Found = TRUE;
+		for (i=0; i<IO_STATS_EVENTS_COUNT; i++)
+		{
+			IO_Stats_Labels_Used[i] = FALSE;
+		}
+	}
+	IO_Stats_Labels_Used[EvType] = TRUE;
+
+	return 0;
+}
+
+
 /******************************************************************************
  ***  InitTracing_Event
  ******************************************************************************/
@@ -1840,6 +1882,7 @@ SingleEv_Handler_t PRV_MISC_Event_Handlers[] = {
 	{ RUSAGE_EV, GetRusage_Event },
 	{ MEMUSAGE_EV, Memusage_Event },
 	{ MPI_STATS_EV, MPI_Stats_Event },
+	{ IO_STATS_EV, IO_Stats_Event },
 	{ USRFUNC_EV, USRFunction_Event },
 	{ TRACING_MODE_EV, Tracing_Mode_Event },
 	{ ONLINE_EV, Online_Event },
@@ -42,6 +42,8 @@ extern int Memusage_Labels_Used[MEMUSAGE_EVENTS_COUNT];
 
 extern int MPI_Stats_Events_Found;
 extern int MPI_Stats_Labels_Used[MPI_STATS_EVENTS_COUNT];
+extern int IO_Stats_Events_Found;
+extern int IO_Stats_Labels_Used[IO_STATS_EVENTS_COUNT];
 
 extern int Syscall_Events_Found;
 extern int Syscall_Labels_Used[SYSCALL_EVENTS_COUNT];
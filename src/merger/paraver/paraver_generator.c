@@ -231,12 +231,10 @@ void trace_paraver_state (
 #endif
 	if (!State_Excluded(current_state))
 	{
-		paraver_rec_t fake_record;
+		/* The slot is later rewritten with the end of the state, which is
+		   the only part of the record that can be changed in place */
+		paraver_rec_t fake_record = thread_info->incomplete_state_record;
 		fake_record.type   = UNFINISHED_STATE;
-		fake_record.ptask  = ptask;
-		fake_record.task   = task;
-		fake_record.thread = thread;
-		fake_record.time   = current_time;
 		thread_info->incomplete_state_offset = WriteFileBuffer_getPosition (wfb);
 		trace_paraver_record (wfb, &fake_record);
 	}
@@ -635,6 +633,12 @@ static UINT64 paraver_translate_bfd_event (unsigned ptask, unsigned task,
 	else if (eventtype == PTHREAD_FUNC_LINE_EV)
 		return Address2Info_Translate (ptask, task, 
 		  eventvalue, ADDR2OMP_LINE, get_option_merge_UniqueCallerID());
+	else if (eventtype == PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_CALLER_EV)
+		return Address2Info_Translate (ptask, task, 
+		  eventvalue, ADDR2OMP_FUNCTION, get_option_merge_UniqueCallerID());
+	else if (eventtype == PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_CALLER_LINE_EV)
+		return Address2Info_Translate (ptask, task, 
+		  eventvalue, ADDR2OMP_LINE, get_option_merge_UniqueCallerID());
 	else if (eventtype == CUDAFUNC_EV)
 		return Address2Info_Translate (ptask, task, 
 		  eventvalue, ADDR2CUDA_FUNCTION, get_option_merge_UniqueCallerID());
@@ -722,6 +726,8 @@ static int paraver_build_multi_event (struct fdz_fitxer fdz, paraver_rec_t ** cu
 				  cur->event == TASKFUNC_EV || cur->event == TASKFUNC_LINE_EV ||
 				  cur->event == TASKFUNC_INST_EV || cur->event == TASKFUNC_INST_LINE_EV ||
 				  cur->event == PTHREAD_FUNC_EV || cur->event == PTHREAD_FUNC_LINE_EV ||
+				  cur->event == PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_CALLER_EV ||
+				  cur->event == PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_CALLER_LINE_EV ||
 				  cur->event == CUDAFUNC_EV || cur->event == CUDAFUNC_LINE_EV)
 				{
 					values[nevents] = paraver_translate_bfd_event (cur->ptask,
@@ -762,6 +768,11 @@ static int paraver_build_multi_event (struct fdz_fitxer fdz, paraver_rec_t ** cu
 					// Set to 0 again after emitting the information
 					memset (CallerAddresses, 0, sizeof(CallerAddresses));
 				}
+				else if (cur->event == PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_OBJECT_EV)
+				{
+					values[nevents] = Address2Info_Translate_MemReference (cur->ptask,
+					  cur->task, cur->value, MEM_REFERENCE_STATIC, NULL);
+				}
 
 				if (Extrae_Vector_Count (&RegisteredCodeLocationTypes) > 0)
 				{
@@ -1186,45 +1197,50 @@ static void Paraver_JoinFiles_Slave (PRVFileSet_t *prvfset, int taskid, int tree
 {
 	/* Slave-side. Master will ask all slaves for their parts as needed */
 	paraver_rec_t *current;
-	paraver_rec_t *buffer;
+	paraver_rec_context_t context;
+	unsigned char *buffer;
 	MPI_Status s;
 	int res;
-	unsigned tmp, nevents;
+	unsigned tmp, block[2]; /* number of events and bytes */
 	int my_master = tree_myMaster (taskid, tree_fan_out, current_depth);
 
-	buffer = malloc (sizeof(paraver_rec_t)*prvfset->records_per_block);
+	buffer = malloc (PRV_RECORD_MAX_SIZE*prvfset->records_per_block);
 	if (buffer == NULL)
 	{
 		fprintf (stderr, "mpi2prv: ERROR! Slave %d was unable to allocate %llu bytes to hold records buffer\n", 
-			taskid, sizeof(paraver_rec_t)*prvfset->records_per_block);
+			taskid, PRV_RECORD_MAX_SIZE*prvfset->records_per_block);
 		fflush (stderr);
 		exit (0);
 	}
 
 	/* This loop will locally sort the files. Master will only have 
-	   to partially sort all the events*/
+	   to partially sort all the events. Blocks are sent encoded, and each
+	   one can be decoded on its own */
 
-	nevents = 0;
+	block[0] = block[1] = 0;
+	ParaverRecord_InitContext (&context);
 	current = GetNextParaver_Rec (prvfset);
 	do
 	{
 		if (current->type == PENDING_COMMUNICATION)
 			FixPendingCommunication (current, prvfset->fset);
 
-		bcopy (current, &(buffer[nevents++]), sizeof(paraver_rec_t));
+		block[1] += ParaverRecord_Encode (&context, current, &(buffer[block[1]]));
+		block[0]++;
 		
-		if (nevents == prvfset->records_per_block)
+		if (block[0] == prvfset->records_per_block)
 		{
 			res = MPI_Recv (&tmp, 1, MPI_INT, my_master, ASK_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD, &s);
 			MPI_CHECK(res, MPI_Recv, "Failed to receive remote request!");
 
-			res = MPI_Send (&nevents, 1, MPI_UNSIGNED, my_master, HOWMANY_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD); 
+			res = MPI_Send (block, 2, MPI_UNSIGNED, my_master, HOWMANY_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD); 
 			MPI_CHECK(res, MPI_Send, "Failed to send the number of events to the MASTER");
 
-			res = MPI_Send (buffer, nevents*sizeof(paraver_rec_t), MPI_BYTE, my_master, BUFFER_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD); 
+			res = MPI_Send (buffer, block[1], MPI_BYTE, my_master, BUFFER_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD); 
 			MPI_CHECK(res, MPI_Send, "Failed to send the buffer of events to the MASTER");
 
-			nevents = 0;
+			block[0] = block[1] = 0;
+			ParaverRecord_InitContext (&context);
 		}
 		current = GetNextParaver_Rec (prvfset);
 	}
@@ -1233,12 +1249,12 @@ static void Paraver_JoinFiles_Slave (PRVFileSet_t *prvfset, int taskid, int tree
 	res = MPI_Recv (&tmp, 1, MPI_INT, my_master, ASK_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD, &s);
 	MPI_CHECK(res, MPI_Recv, "Failed to receive remote request!");
 
-	res = MPI_Send (&nevents, 1, MPI_UNSIGNED, my_master, HOWMANY_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD); 
+	res = MPI_Send (block, 2, MPI_UNSIGNED, my_master, HOWMANY_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD); 
 	MPI_CHECK(res, MPI_Send, "Failed to send the number of events to the MASTER");
 
-	if (nevents != 0)
+	if (block[0] != 0)
 	{
-		res = MPI_Send (buffer, nevents*sizeof(paraver_rec_t), MPI_BYTE, my_master, BUFFER_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD); 
+		res = MPI_Send (buffer, block[1], MPI_BYTE, my_master, BUFFER_MERGE_REMOTE_BLOCK_TAG, MPI_COMM_WORLD); 
 		MPI_CHECK(res, MPI_Send, "Failed to send the buffer of events to the MASTER");
 	}
 
@@ -1279,11 +1295,56 @@ int Paraver_JoinFiles (unsigned num_appl, char *outName, FileSet_t * fset,
 #ifdef HAVE_ZLIB
 	prv_fd.handleGZ = NULL;
 #endif
+	prv_fd.handlePZ = NULL;
 
 	if (0 == taskid)
 	{
-#ifdef HAVE_ZLIB
+#ifndef HAVE_ZSTD
+		/* If the user requested .prv.zst but it is not supported, change into .prv */
+		if (strlen (outName) >= 8 &&
+		strncmp (&(outName[strlen (outName) - 8]), ".prv.zst", 8) == 0)
+			outName[strlen(outName)-4] = (char) 0;
+#endif
+#ifndef HAVE_ZLIB
+		/* If the user requested .prv.gz but it is not supported, change into .prv */
 		if (strlen (outName) >= 7 &&
+		strncmp (&(outName[strlen (outName) - 7]), ".prv.gz", 7) == 0)
+			outName[strlen(outName)-3] = (char) 0;
+#endif
+
+		if (strlen (outName) >= 8 &&
+		strncmp (&(outName[strlen (outName) - 8]), ".prv.zst", 8) == 0)
+		{
+			/*
+			* Zstd output is always written in seekable frames
+			*/
+			prv_fd.handlePZ = FDZ_Parallel_Open (outName, FDZ_CODEC_ZSTD,
+			  get_option_merge_CompressThreads());
+			if (prv_fd.handlePZ == NULL)
+			{
+				fprintf (stderr, "mpi2prv ERROR: creating ZSTD paraver tracefile : %s\n",
+					outName);
+				exit (-1);
+			}
+		}
+#ifdef HAVE_ZLIB
+		else if (strlen (outName) >= 7 &&
+		strncmp (&(outName[strlen (outName) - 7]), ".prv.gz", 7) == 0 &&
+		get_option_merge_CompressThreads() > 0)
+		{
+			/*
+			* Compress independent GZ members on several threads
+			*/
+			prv_fd.handlePZ = FDZ_Parallel_Open (outName, FDZ_CODEC_GZIP,
+			  get_option_merge_CompressThreads());
+			if (prv_fd.handlePZ == NULL)
+			{
+				fprintf (stderr, "mpi2prv ERROR: creating GZ paraver tracefile : %s\n",
+					outName);
+				exit (-1);
+			}
+		}
+		else if (strlen (outName) >= 7 &&
 		strncmp (&(outName[strlen (outName) - 7]), ".prv.gz", 7) == 0)
 		{
 			/*
@@ -1298,6 +1359,7 @@ int Paraver_JoinFiles (unsigned num_appl, char *outName, FileSet_t * fset,
 				exit (-1);
 			}
 		}
+#endif
 		else
 		{
 			/*
@@ -1308,7 +1370,6 @@ int Paraver_JoinFiles (unsigned num_appl, char *outName, FileSet_t * fset,
 #else
 			prv_fd.handle = fopen (outName, "w");
 #endif
-			prv_fd.handleGZ = NULL;
 			if (prv_fd.handle == NULL)
 			{
 				fprintf (stderr, "mpi2prv ERROR: Creating Paraver tracefile : %s\n",
@@ -1316,26 +1377,6 @@ int Paraver_JoinFiles (unsigned num_appl, char *outName, FileSet_t * fset,
 				exit (-1);
 			}
 		}
-#else
-
-		/* If the user requested .prv.gz but it is not supported, change into .prv */
-		if (strlen (outName) >= 7 &&
-		strncmp (&(outName[strlen (outName) - 7]), ".prv.gz", 7) == 0)
-			outName[strlen(outName)-3] = (char) 0;
-
-		/* Open normal handle for the file, and mark GZ handle as unused!  */
-#if HAVE_FOPEN64
-		prv_fd.handle = fopen64 (outName, "w");
-#else
-		prv_fd.handle = fopen (outName, "w");
-#endif
-		if (prv_fd.handle == NULL)
-		{
-			fprintf (stderr, "mpi2prv ERROR: Creating Paraver tracefile : %s\n",
-				outName);
-			exit (-1);
-		}
-#endif
 	} /* taskid == 0 */
 
 	error = Paraver_WriteHeader (fset, numtasks, taskid, num_appl, Ftime, prv_fd,
@@ -0,0 +1,273 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include "common.h"
+
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
+
+#include "paraver_records.h"
+
+/* The low bits of the tag tell the kind of record */
+#define TAG_EVENT          0
+#define TAG_STATE          1
+#define TAG_COMMUNICATION  2
+#define TAG_KIND_MASK      3
+#define TAG_SAME_OBJECT    4  /* Object is the one of the previous record */
+
+#define STATE_BODY_SIZE    (sizeof(signed char) + sizeof(unsigned long long))
+#define COMM_BODY_SIZE     (5*sizeof(unsigned long long) + 10*sizeof(int))
+
+#define ZIGZAG(x)    ((((UINT64)(x)) << 1) ^ ((UINT64)(((INT64)(x)) >> 63)))
+#define UNZIGZAG(x)  ((UINT64)(((x) >> 1) ^ (~((x) & 1) + 1)))
+
+#define PUT(p, v) \
+	do { memcpy ((p), &(v), sizeof(v)); (p) += sizeof(v); } while (0)
+#define GET(p, v) \
+	do { memcpy (&(v), (p), sizeof(v)); (p) += sizeof(v); } while (0)
+
+static unsigned char * put_varint (unsigned char *p, UINT64 v)
+{
+	while (v >= 0x80)
+	{
+		*p++ = (unsigned char) (v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (unsigned char) v;
+	return p;
+}
+
+static const unsigned char * get_varint (const unsigned char *p,
+	const unsigned char *end, UINT64 *v)
+{
+	UINT64 res = 0;
+	unsigned shift;
+
+	for (shift = 0; p < end && shift < 64; shift += 7)
+	{
+		unsigned char b = *p++;
+
+		res |= ((UINT64) (b & 0x7f)) << shift;
+		if (!(b & 0x80))
+		{
+			*v = res;
+			return p;
+		}
+	}
+	return NULL;
+}
+
+static unsigned char * put_body (const paraver_rec_t *r, unsigned char *p)
+{
+	if (r->type == STATE || r->type == UNFINISHED_STATE)
+	{
+		signed char type = r->type;
+
+		PUT(p, type);
+		PUT(p, r->end_time);
+	}
+	else
+	{
+		int type = r->type;
+
+		/* receive[] goes first, see PRV_RECORD_RECEIVE_OFFSET */
+		PUT(p, r->receive[LOGICAL_COMMUNICATION]);
+		PUT(p, r->receive[PHYSICAL_COMMUNICATION]);
+		PUT(p, r->time);
+		PUT(p, r->end_time);
+		PUT(p, r->value);
+		PUT(p, type);
+		PUT(p, r->event);
+		PUT(p, r->cpu);
+		PUT(p, r->ptask);
+		PUT(p, r->task);
+		PUT(p, r->thread);
+		PUT(p, r->cpu_r);
+		PUT(p, r->ptask_r);
+		PUT(p, r->task_r);
+		PUT(p, r->thread_r);
+	}
+	return p;
+}
+
+void ParaverRecord_InitContext (paraver_rec_context_t *ctx)
+{
+	ctx->time = 0;
+	ctx->cpu = ctx->ptask = ctx->task = ctx->thread = 0;
+}
+
+/******************************************************************************
+ ***  ParaverRecord_EncodePatch
+ ***  Encodes the fixed-size body of a state or communication. Writing it at
+ ***  PRV_RECORD_BODY_OFFSET bytes from where the record was encoded replaces
+ ***  it without changing its size.
+ ******************************************************************************/
+size_t ParaverRecord_EncodePatch (const paraver_rec_t *r, unsigned char *buffer)
+{
+	return put_body (r, buffer) - buffer;
+}
+
+/******************************************************************************
+ ***  ParaverRecord_Encode
+ ***  Encodes r into buffer (at least PRV_RECORD_MAX_SIZE bytes) and returns
+ ***  the number of bytes used.
+ ******************************************************************************/
+size_t ParaverRecord_Encode (paraver_rec_context_t *ctx, const paraver_rec_t *r,
+	unsigned char *buffer)
+{
+	unsigned char *p = buffer + PRV_RECORD_BODY_OFFSET;
+	unsigned char tag;
+
+	if (r->type == EVENT)
+		tag = TAG_EVENT;
+	else if (r->type == STATE || r->type == UNFINISHED_STATE)
+	{
+		tag = TAG_STATE;
+		p = put_body (r, p);
+	}
+	else
+	{
+		/* Communications are kept whole in their body and do not take part
+		   in the delta encoding, as any of their fields may change later */
+		buffer[0] = TAG_COMMUNICATION;
+		return put_body (r, p) - buffer;
+	}
+
+	if (r->cpu == ctx->cpu && r->ptask == ctx->ptask &&
+	    r->task == ctx->task && r->thread == ctx->thread)
+		tag |= TAG_SAME_OBJECT;
+	else
+	{
+		p = put_varint (p, (unsigned) r->cpu);
+		p = put_varint (p, (unsigned) r->ptask);
+		p = put_varint (p, (unsigned) r->task);
+		p = put_varint (p, (unsigned) r->thread);
+		ctx->cpu = r->cpu;
+		ctx->ptask = r->ptask;
+		ctx->task = r->task;
+		ctx->thread = r->thread;
+	}
+
+	p = put_varint (p, ZIGZAG(r->time - ctx->time));
+	ctx->time = r->time;
+
+	if ((tag & TAG_KIND_MASK) == TAG_EVENT)
+		p = put_varint (p, (unsigned) r->event);
+	p = put_varint (p, r->value);
+
+	buffer[0] = tag;
+	return p - buffer;
+}
+
+/******************************************************************************
+ ***  ParaverRecord_Decode
+ ***  Decodes the record at buffer into r and returns the number of bytes it
+ ***  takes, or 0 if it does not fit in size bytes (ctx is not changed then).
+ ******************************************************************************/
+size_t ParaverRecord_Decode (paraver_rec_context_t *ctx,
+	const unsigned char *buffer, size_t size, paraver_rec_t *r)
+{
+	const unsigned char *p = buffer + PRV_RECORD_BODY_OFFSET;
+	const unsigned char *end = buffer + size;
+	UINT64 cpu, ptask, task, thread, delta, event = 0, value;
+	unsigned char tag;
+
+	if (size < PRV_RECORD_BODY_OFFSET)
+		return 0;
+	tag = buffer[0];
+
+	switch (tag & TAG_KIND_MASK)
+	{
+		case TAG_COMMUNICATION:
+		{
+			int type;
+
+			if (size < PRV_RECORD_BODY_OFFSET + COMM_BODY_SIZE)
+				return 0;
+			GET(p, r->receive[LOGICAL_COMMUNICATION]);
+			GET(p, r->receive[PHYSICAL_COMMUNICATION]);
+			GET(p, r->time);
+			GET(p, r->end_time);
+			GET(p, r->value);
+			GET(p, type);
+			GET(p, r->event);
+			GET(p, r->cpu);
+			GET(p, r->ptask);
+			GET(p, r->task);
+			GET(p, r->thread);
+			GET(p, r->cpu_r);
+			GET(p, r->ptask_r);
+			GET(p, r->task_r);
+			GET(p, r->thread_r);
+			r->type = (RecordType) type;
+			return p - buffer;
+		}
+
+		case TAG_STATE:
+		{
+			signed char type;
+
+			if (size < PRV_RECORD_BODY_OFFSET + STATE_BODY_SIZE)
+				return 0;
+			GET(p, type);
+			GET(p, r->end_time);
+			r->type = (RecordType) type;
+			break;
+		}
+
+		default:
+			r->type = EVENT;
+			break;
+	}
+
+	if (tag & TAG_SAME_OBJECT)
+	{
+		cpu = ctx->cpu;
+		ptask = ctx->ptask;
+		task = ctx->task;
+		thread = ctx->thread;
+	}
+	else if ((p = get_varint (p, end, &cpu)) == NULL ||
+	         (p = get_varint (p, end, &ptask)) == NULL ||
+	         (p = get_varint (p, end, &task)) == NULL ||
+	         (p = get_varint (p, end, &thread)) == NULL)
+		return 0;
+
+	if ((p = get_varint (p, end, &delta)) == NULL)
+		return 0;
+	if ((tag & TAG_KIND_MASK) == TAG_EVENT && (p = get_varint (p, end, &event)) == NULL)
+		return 0;
+	if ((p = get_varint (p, end, &value)) == NULL)
+		return 0;
+
+	r->cpu = ctx->cpu = (int) cpu;
+	r->ptask = ctx->ptask = (int) ptask;
+	r->task = ctx->task = (int) task;
+	r->thread = ctx->thread = (int) thread;
+	r->time = ctx->time = ctx->time + UNZIGZAG(delta);
+	r->event = (int) event;
+	r->value = value;
+
+	return p - buffer;
+}
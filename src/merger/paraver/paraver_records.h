@@ -0,0 +1,99 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#ifndef _PARAVER_RECORDS_H
+#define _PARAVER_RECORDS_H
+
+#include <config.h>
+
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+
+#include "common.h"
+
+typedef enum
+{
+	LOGICAL_COMMUNICATION = 0,
+	PHYSICAL_COMMUNICATION,
+	NUM_COMMUNICATION_TYPE
+}
+CommunicationType;
+
+typedef enum {
+	UNFINISHED_STATE = -1,
+	STATE = 1,
+	EVENT = 2,
+	UNMATCHED_COMMUNICATION = -3,
+	COMMUNICATION = 3,
+	PENDING_COMMUNICATION = -4
+}
+RecordType;
+
+typedef struct
+{
+	unsigned long long receive[NUM_COMMUNICATION_TYPE];
+	                              /* both logical and physical recv times */
+	UINT64 value;                 /* state, value, tag or global_op_id */
+	unsigned long long time;      /* state ini_time or logical send time */
+	unsigned long long end_time;  /* state end_time or physical send time */
+	RecordType type;              /* Type of record */
+	int event;                    /* size, type or comm_id */
+	int cpu, ptask, task, thread; /* ID of this task */
+	int cpu_r, ptask_r, task_r, thread_r;
+	                              /* ID of the receiver task */
+}
+paraver_rec_t;
+
+/*
+ * Encoding of the paraver_rec_t in the intermediate files of the merger.
+ *
+ * Every record starts with a tag byte that tells its kind. Events store
+ * their time as a (zigzag) varint delta from the previous event or state,
+ * and their object only when it differs from the previous one. States and
+ * communications may be rewritten once they are in the file (when the
+ * state ends or the communication is matched), so the fields that change
+ * are kept in a fixed-size body right after the tag. See
+ * ParaverRecord_EncodePatch.
+ */
+
+#define PRV_RECORD_MAX_SIZE        96
+#define PRV_RECORD_BODY_OFFSET     1  /* Where the fixed-size body starts */
+#define PRV_RECORD_RECEIVE_OFFSET  PRV_RECORD_BODY_OFFSET
+                                      /* Where a communication keeps receive[] */
+
+typedef struct
+{
+	unsigned long long time;      /* Time of the last event or state */
+	int cpu, ptask, task, thread; /* Object of the last event or state */
+}
+paraver_rec_context_t;
+
+void ParaverRecord_InitContext (paraver_rec_context_t *ctx);
+size_t ParaverRecord_Encode (paraver_rec_context_t *ctx, const paraver_rec_t *r,
+	unsigned char *buffer);
+size_t ParaverRecord_EncodePatch (const paraver_rec_t *r, unsigned char *buffer);
+size_t ParaverRecord_Decode (paraver_rec_context_t *ctx,
+	const unsigned char *buffer, size_t size, paraver_rec_t *r);
+
+#endif /* _PARAVER_RECORDS_H */
@@ -96,6 +96,18 @@ void Enable_pthread_Operation (unsigned evttype)
 		}
 }
 
+static int pthread_Lock_Stats_Found = FALSE;
+static int pthread_Lock_Stats_Labels_Used[PTHREAD_LOCK_STATS_EVENTS_COUNT];
+
+void Enable_pthread_Lock_Stats (unsigned evttype)
+{
+	if (evttype < PTHREAD_LOCK_STATS_EVENTS_COUNT)
+	{
+		pthread_Lock_Stats_Found = TRUE;
+		pthread_Lock_Stats_Labels_Used[evttype] = TRUE;
+	}
+}
+
 #if defined(PARALLEL_MERGE)
 
 #include <mpi.h>
@@ -114,10 +126,67 @@ void Share_pthread_Operations (void)
 
 	for (i = 0; i < MAX_PTHREAD_TYPE_ENTRIES; i++)
 		pthread_event_presency_label[i].present = tmp_out[i];
+
+	res = MPI_Reduce (pthread_Lock_Stats_Labels_Used, tmp_out,
+	  PTHREAD_LOCK_STATS_EVENTS_COUNT, MPI_INT, MPI_BOR, 0, MPI_COMM_WORLD);
+	MPI_CHECK(res, MPI_Reduce, "While sharing pthread lock statistics");
+
+	pthread_Lock_Stats_Found = FALSE;
+	for (i = 0; i < PTHREAD_LOCK_STATS_EVENTS_COUNT; i++)
+	{
+		pthread_Lock_Stats_Labels_Used[i] = tmp_out[i];
+		pthread_Lock_Stats_Found = pthread_Lock_Stats_Found || tmp_out[i];
+	}
 }
 
 #endif
 
+static void Write_pthread_Lock_Stats_Labels (FILE * fd)
+{
+	static const char *labels[PTHREAD_LOCK_STATS_OBJECT_EV] =
+	{
+		"pthread lock address",
+		"pthread lock kind",
+		"pthread lock caller",
+		"pthread lock acquisitions",
+		"pthread lock contended acquisitions",
+		"pthread lock wait time (ns)",
+		"pthread lock hold time (ns)"
+	};
+	unsigned u;
+
+	fprintf (fd, "EVENT_TYPE\n");
+	for (u = 0; u < PTHREAD_LOCK_STATS_OBJECT_EV; u++)
+	{
+#if defined(HAVE_BFD)
+		/* The caller gets its own block below with the translated values */
+		if (u == PTHREAD_LOCK_STATS_CALLER_EV)
+			continue;
+#endif
+		if (pthread_Lock_Stats_Labels_Used[u])
+			fprintf (fd, "%d    %d    %s\n", 0, PTHREAD_LOCK_STATS_BASE+u, labels[u]);
+	}
+	if (pthread_Lock_Stats_Labels_Used[PTHREAD_LOCK_STATS_KIND_EV])
+	{
+		fprintf (fd, "VALUES\n");
+		fprintf (fd, "%d pthread_mutex\n", 1);
+		fprintf (fd, "%d pthread_rwlock (read)\n", 2);
+		fprintf (fd, "%d pthread_rwlock (write)\n", 3);
+	}
+	LET_SPACES(fd);
+
+#if defined(HAVE_BFD)
+	if (pthread_Lock_Stats_Labels_Used[PTHREAD_LOCK_STATS_CALLER_EV])
+		Address2Info_Write_OMP_Labels (fd,
+			PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_CALLER_EV, "pthread lock caller",
+			PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_CALLER_LINE_EV, "pthread lock caller line and file",
+			get_option_merge_UniqueCallerID());
+	if (pthread_Lock_Stats_Labels_Used[PTHREAD_LOCK_STATS_OBJECT_EV])
+		Address2Info_Write_MemReferenceObject_Labels (fd,
+			PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_OBJECT_EV, "pthread lock object");
+#endif
+}
+
 void WriteEnabled_pthread_Operations (FILE * fd)
 {
 	unsigned u;
@@ -157,5 +226,8 @@ void WriteEnabled_pthread_Operations (FILE * fd)
 			PTHREAD_FUNC_LINE_EV, "pthread function line and file",
 			get_option_merge_UniqueCallerID());
 #endif
+
+	if (pthread_Lock_Stats_Found)
+		Write_pthread_Lock_Stats_Labels (fd);
 }
 
@@ -38,6 +38,7 @@ int Translate_pthread_Operation (unsigned in_evttype,
 void Share_pthread_Operations (void);
 #endif
 void Enable_pthread_Operation (unsigned evttype);
+void Enable_pthread_Lock_Stats (unsigned evttype);
 void WriteEnabled_pthread_Operations (FILE * fd);
 
 #endif
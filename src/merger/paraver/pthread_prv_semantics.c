@@ -132,6 +132,63 @@ static int pthread_Function_Event (event_t * current_event,
 	return 0;
 }
 
+/******************************************************************************
+ ***  pthread_Lock_Stats_Event
+ ******************************************************************************/
+
+static int pthread_Lock_Stats_Event (event_t * current_event,
+	unsigned long long current_time, unsigned int cpu, unsigned int ptask,
+	unsigned int task, unsigned int thread, FileSet_t *fset )
+{
+	unsigned int EvType;
+	unsigned long long EvValue;
+	UNREFERENCED_PARAMETER(fset);
+
+	EvType  = Get_EvValue (current_event);     /* Value is the event type.  */
+	EvValue = Get_EvMiscParam (current_event); /* Param is the event value. */
+
+	if (EvType >= PTHREAD_LOCK_STATS_OBJECT_EV)
+		return 0;
+
+	trace_paraver_state (cpu, ptask, task, thread, current_time);
+
+	if (EvType == PTHREAD_LOCK_STATS_CALLER_EV)
+	{
+		/* The tracer records the return address, which points after the call */
+		if (EvValue > 0)
+			EvValue--;
+#if defined(HAVE_BFD)
+		if (get_option_merge_SortAddresses() && EvValue > 0)
+		{
+			AddressCollector_Add (&CollectedAddresses, ptask, task, EvValue, ADDR2OMP_FUNCTION);
+			AddressCollector_Add (&CollectedAddresses, ptask, task, EvValue, ADDR2OMP_LINE);
+		}
+#endif
+		trace_paraver_event (cpu, ptask, task, thread, current_time,
+		  PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_CALLER_EV, EvValue);
+		trace_paraver_event (cpu, ptask, task, thread, current_time,
+		  PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_CALLER_LINE_EV, EvValue);
+		Enable_pthread_Lock_Stats (PTHREAD_LOCK_STATS_CALLER_LINE_EV);
+	}
+	else
+	{
+		trace_paraver_event (cpu, ptask, task, thread, current_time,
+		  PTHREAD_LOCK_STATS_BASE+EvType, EvValue);
+#if defined(HAVE_BFD)
+		/* Locks living in static data can be named after their symbol */
+		if (EvType == PTHREAD_LOCK_STATS_ADDRESS_EV)
+		{
+			trace_paraver_event (cpu, ptask, task, thread, current_time,
+			  PTHREAD_LOCK_STATS_BASE+PTHREAD_LOCK_STATS_OBJECT_EV, EvValue);
+			Enable_pthread_Lock_Stats (PTHREAD_LOCK_STATS_OBJECT_EV);
+		}
+#endif
+	}
+	Enable_pthread_Lock_Stats (EvType);
+
+	return 0;
+}
+
 SingleEv_Handler_t PRV_pthread_Event_Handlers[] = {
 	{ PTHREAD_CREATE_EV, pthread_Call },
 	{ PTHREAD_EXIT_EV, pthread_Call },
@@ -147,6 +204,7 @@ SingleEv_Handler_t PRV_pthread_Event_Handlers[] = {
 	{ PTHREAD_COND_BROADCAST_EV, pthread_Call },
 	{ PTHREAD_COND_WAIT_EV, pthread_Call },
 	{ PTHREAD_BARRIER_WAIT_EV, pthread_Call },
+	{ PTHREAD_LOCK_STATS_EV, pthread_Lock_Stats_Event },
 	{ NULL_EV, NULL }
 };
 
@@ -223,6 +223,7 @@ int Paraver_ProcessTraceFiles (unsigned long nfiles,
 	event_t * current_event;
 	char envName[PATH_MAX], *tmp;
 	unsigned int Type, EvType;
+	Ev_Handler_t *handler;
 	unsigned long long current_time = 0;
 	unsigned long long num_of_events, parsed_events, tmp_nevents;
 	unsigned long long records_per_task;
@@ -302,6 +303,12 @@ int Paraver_ProcessTraceFiles (unsigned long nfiles,
 				sprintf (extra, ".%04d.prv.gz", lastid);
 				strncpy (&tmp[strlen(tmp)-strlen(".prv.gz")], extra, strlen(extra));
 			}
+			else if (strcmp (&tmp[strlen(tmp)-strlen(".prv.zst")], ".prv.zst") == 0)
+			{
+				char extra[1+4+1+3+1+3+1];
+				sprintf (extra, ".%04d.prv.zst", lastid);
+				strncpy (&tmp[strlen(tmp)-strlen(".prv.zst")], extra, strlen(extra));
+			}
 		} while (__Extrae_Utils_file_exists (tmp));
 		set_merge_OutputTraceName (tmp);
 		set_merge_GivenTraceName (TRUE);
@@ -442,7 +449,7 @@ int Paraver_ProcessTraceFiles (unsigned long nfiles,
 
 		EvType = Get_EvEvent (current_event);
 
-		if (getEventType (EvType, &Type))
+		if (Semantics_getEventDispatch (EvType, &Type, &handler))
 		{
 			current_time = TIMESYNC(ptask-1, task-1, Get_EvTime (current_event));
 
@@ -455,7 +462,6 @@ int Paraver_ProcessTraceFiles (unsigned long nfiles,
 			    Type == OPENSHMEM_TYPE || Type == JAVA_TYPE)
 			{
 				task_t *task_info = GET_TASK_INFO(ptask, task);
-				Ev_Handler_t *handler = Semantics_getEventHandler (EvType);
 				if (handler != NULL)
 				{
 					handler (current_event, current_time, cpu, ptask, task, thread, fset);
@@ -636,6 +642,11 @@ int Paraver_ProcessTraceFiles (unsigned long nfiles,
 			unsigned *buffer_ptasks = AddressCollector_GetAllPtasks (&CollectedAddresses);
 			unsigned *buffer_tasks = AddressCollector_GetAllTasks (&CollectedAddresses);
 
+			/* Resolve all the distinct addresses at once before assigning
+			   them their identifiers */
+			Address2Info_ResolveBatch (AddressCollector_Count(&CollectedAddresses),
+			  buffer_ptasks, buffer_tasks, buffer_addresses, buffer_types);
+
 			for (i = 0; i < AddressCollector_Count(&CollectedAddresses); i++)
 				Address2Info_Translate (buffer_ptasks[i], buffer_tasks[i],
 				  buffer_addresses[i], buffer_types[i], get_option_merge_UniqueCallerID());
@@ -689,12 +700,17 @@ int Paraver_ProcessTraceFiles (unsigned long nfiles,
 		tmp = &(envName[strlen (envName) - 7]);
 	}
 	else
+#endif
+#ifdef HAVE_ZSTD
+	if (strlen (envName) >= 8 && strncmp (&(envName[strlen (envName) - 8]), ".prv.zst", 8) == 0)
 	{
-		tmp = &(envName[strlen (envName) - 4]);
+		tmp = &(envName[strlen (envName) - 8]);
 	}
-#else
-	tmp = &(envName[strlen (envName) - 4]);
+	else
 #endif
+	{
+		tmp = &(envName[strlen (envName) - 4]);
+	}
 
 	if (0 == taskid)
 	{
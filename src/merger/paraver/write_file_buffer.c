@@ -60,8 +60,9 @@ WriteFileBuffer_t * WriteFileBuffer_new (int FD, char *filename, int maxElements
 		exit (-1);
 	}
 
-	res->maxElements = maxElements;
-	res->sizeElement = sizeElement;
+	/* Records are encoded (see paraver_records.h), so the buffer holds at
+	   least maxElements records of sizeElement bytes */
+	res->sizeBuffer = MAX(maxElements*sizeElement, PRV_RECORD_MAX_SIZE);
 	res->FD = FD;
 	res->filename = strdup(filename);
 	if (res->filename == NULL)
@@ -69,9 +70,12 @@ WriteFileBuffer_t * WriteFileBuffer_new (int FD, char *filename, int maxElements
 		fprintf (stderr, "mpi2prv: Error! cannot duplicate string for WriteFileBuffer\n");
 		exit (-1);
 	}
-	res->numElements = 0;
+	res->usedBuffer = res->sizeLast = 0;
+	res->numRecords = 0;
+	ParaverRecord_InitContext (&(res->context));
+	res->contextLast = res->context;
 	res->lastWrittenLocation = 0;
-	res->Buffer = (void*) malloc (res->maxElements*sizeElement);
+	res->Buffer = (void*) malloc (res->sizeBuffer);
 	if (NULL == res->Buffer)
 	{
 		fprintf (stderr, "mpi2prv: Cannot allocate memory for %d elements in WriteFileBuffer\n", maxElements);
@@ -132,16 +136,16 @@ void WriteFileBuffer_flush (WriteFileBuffer_t *wfb)
 	fprintf (stderr, "WriteFileBuffer_flush (%p)\n", wfb);
 #endif
 
-	res_write = write (wfb->FD, wfb->Buffer, wfb->numElements*wfb->sizeElement);
+	res_write = write (wfb->FD, wfb->Buffer, wfb->usedBuffer);
 	if (-1 == res_write)
 	{
 		fprintf (stderr, "mpi2prv: Error! Cannot write WriteFileBuffer for flushing!\n");
 		exit (-1);
 	}
-	else if (wfb->numElements*wfb->sizeElement != res_write)
+	else if (wfb->usedBuffer != res_write)
 	{
 		fprintf (stderr, "mpi2prv: Error! Could not write %Zu bytes to disk\n"
-		                 "mpi2prv: Error! Check your quota or set TMPDIR to a free disk zone\n", wfb->numElements*wfb->sizeElement);
+		                 "mpi2prv: Error! Check your quota or set TMPDIR to a free disk zone\n", wfb->usedBuffer);
 		exit (-1);
 	}
 
@@ -151,7 +155,7 @@ void WriteFileBuffer_flush (WriteFileBuffer_t *wfb)
 		fprintf (stderr, "mpi2prv: Error! Cannot retrieve last written location for WriteFileBuffer\n");
 		exit (-1);
 	}
-	wfb->numElements = 0;
+	wfb->usedBuffer = 0;
 }
 
 off_t WriteFileBuffer_getPosition (WriteFileBuffer_t *wfb)
@@ -159,31 +163,46 @@ off_t WriteFileBuffer_getPosition (WriteFileBuffer_t *wfb)
 #if defined(DEBUG)
 	fprintf (stderr, "WriteFileBuffer_getPosition (%p)\n", wfb);
 #endif
-	return wfb->lastWrittenLocation+wfb->numElements*wfb->sizeElement;
+	return wfb->lastWrittenLocation+wfb->usedBuffer;
 }
 
-void WriteFileBuffer_write (WriteFileBuffer_t *wfb, const void* data)
+unsigned long long WriteFileBuffer_getNumRecords (WriteFileBuffer_t *wfb)
 {
-	size_t offset;
+	return wfb->numRecords;
+}
+
+void WriteFileBuffer_write (WriteFileBuffer_t *wfb, const paraver_rec_t *record)
+{
+	paraver_rec_context_t context = wfb->context;
 
 #if defined(DEBUG)
-	fprintf (stderr, "WriteFileBuffer_write (%p, %p)\n", wfb, data);
+	fprintf (stderr, "WriteFileBuffer_write (%p, %p)\n", wfb, record);
 #endif
 
-	offset = wfb->numElements*wfb->sizeElement;
-	memcpy ((((char*)wfb->Buffer)+offset), data, wfb->sizeElement);
-	wfb->numElements++;
-
-	if (wfb->numElements == wfb->maxElements)
+	if (wfb->usedBuffer + PRV_RECORD_MAX_SIZE > wfb->sizeBuffer)
 		WriteFileBuffer_flush (wfb);
+
+	wfb->sizeLast = ParaverRecord_Encode (&(wfb->context), record,
+	  ((unsigned char*)wfb->Buffer)+wfb->usedBuffer);
+	wfb->contextLast = context;
+	wfb->usedBuffer += wfb->sizeLast;
+	wfb->numRecords++;
 }
 
-void WriteFileBuffer_writeAt (WriteFileBuffer_t *wfb, const void* data, off_t position)
+void WriteFileBuffer_writeAt (WriteFileBuffer_t *wfb, const paraver_rec_t *record, off_t position)
 {
+	unsigned char patch[PRV_RECORD_MAX_SIZE];
+	size_t size;
+
 #if defined(DEBUG)
-	fprintf (stderr, "WriteFileBuffer_writeAt (%p, %p, %ld)\n", wfb, data, position);
+	fprintf (stderr, "WriteFileBuffer_writeAt (%p, %p, %ld)\n", wfb, record, position);
 #endif
 
+	/* Records are never split between the file and the buffer, and only
+	   their fixed-size body is rewritten */
+	size = ParaverRecord_EncodePatch (record, patch);
+	position += PRV_RECORD_BODY_OFFSET;
+
 	if (position < wfb->lastWrittenLocation)
 	{
 		/* this is outside and before the buffer */
@@ -196,7 +215,7 @@ void WriteFileBuffer_writeAt (WriteFileBuffer_t *wfb, const void* data, off_t po
 			fprintf (stderr, "mpi2prv: Error! Cannot lseek when performing WriteFileBuffer_writeAt\n");
 			exit (-1);
 		}
-		write_res = write (wfb->FD, data, wfb->sizeElement);
+		write_res = write (wfb->FD, patch, size);
 		if (-1 == write_res)
 		{
 			fprintf (stderr, "mpi2prv: Error! Cannot write when performing write_WriteFileBufferAt\n");
@@ -211,22 +230,21 @@ void WriteFileBuffer_writeAt (WriteFileBuffer_t *wfb, const void* data, off_t po
 	}
 	else
 	{
-		if (position+wfb->sizeElement >
-		    wfb->lastWrittenLocation+wfb->sizeElement*wfb->numElements)
+		if (position+size > wfb->lastWrittenLocation+wfb->usedBuffer)
 		{
 			/* the write is beyond the limit of the file, abort it */
 			fprintf (stderr, "mpi2prv: Error! Cannot perform WriteFileBuffer_writeAt. Given position is out ouf bounds.\n");
-			fprintf (stderr, "mpi2prv: Position = %ld, limit = %ld (numelements = %d)\n",
-			         position+wfb->sizeElement,
-			         wfb->lastWrittenLocation+wfb->sizeElement*wfb->numElements,
-			         wfb->numElements);
+			fprintf (stderr, "mpi2prv: Position = %ld, limit = %ld (used = %Zu)\n",
+			         (long) (position+size),
+			         (long) (wfb->lastWrittenLocation+wfb->usedBuffer),
+			         wfb->usedBuffer);
 			exit (-1);
 		}
 		else
 		{
 			/* the write is inside the limit of the file, AND, inside the buffer */
 			size_t offset = position - wfb->lastWrittenLocation;
-			memcpy ((((char*)wfb->Buffer)+offset), data, wfb->sizeElement);
+			memcpy ((((char*)wfb->Buffer)+offset), patch, size);
 		}
 	}
 }
@@ -237,23 +255,32 @@ void WriteFileBuffer_removeLast (WriteFileBuffer_t *wfb)
   fprintf (stderr, "WriteFileBuffer_removeLast (%p)\n", wfb);
 #endif
 
-	if (wfb->numElements > 0)
+	if (wfb->numRecords == 0 || wfb->sizeLast == 0)
+		return;
+
+	if (wfb->usedBuffer > 0)
 	{
 		/* if exists in the buffer, just remove its accounting */
-		wfb->numElements--;
+		wfb->usedBuffer -= wfb->sizeLast;
 	}
-	else if (wfb->numElements == 0)
+	else
 	{
 		/* The buffer was just flushed. Now if it has contents, truncate it */
-		if (wfb->lastWrittenLocation >= wfb->sizeElement)
+		if (wfb->lastWrittenLocation >= (off_t) wfb->sizeLast)
 		{
-			int res = ftruncate (wfb->FD, wfb->lastWrittenLocation-wfb->sizeElement);
+			int res = ftruncate (wfb->FD, wfb->lastWrittenLocation-wfb->sizeLast);
 			if (-1 == res)
 			{
 				fprintf (stderr, "mpi2prv: Error! Could not truncate the file pointed by the WriteFileBuffer\n");
 				exit (-1);
 			}
+			wfb->lastWrittenLocation -= wfb->sizeLast;
+			lseek (wfb->FD, wfb->lastWrittenLocation, SEEK_SET);
 		}
 	}
-}
 
+	/* Only the last record can be removed */
+	wfb->context = wfb->contextLast;
+	wfb->sizeLast = 0;
+	wfb->numRecords--;
+}
@@ -26,13 +26,18 @@
 
 #include <config.h>
 
+#include "paraver_records.h"
+
 typedef struct 
 {
 	void *Buffer;
 	off_t lastWrittenLocation;
-	size_t sizeElement;
-	int maxElements;
-	int numElements;
+	size_t sizeBuffer;
+	size_t usedBuffer;
+	size_t sizeLast;                      /* Encoded size of the last record */
+	unsigned long long numRecords;
+	paraver_rec_context_t context;        /* Encoding state after the last record */
+	paraver_rec_context_t contextLast;    /* and before it (see removeLast) */
 	int FD;
 	char *filename;
 }
@@ -44,8 +49,9 @@ void WriteFileBuffer_deleteall (void);
 int WriteFileBuffer_getFD (WriteFileBuffer_t *wfb);
 void WriteFileBuffer_flush (WriteFileBuffer_t *wfb);
 off_t WriteFileBuffer_getPosition (WriteFileBuffer_t *wfb);
-void WriteFileBuffer_write (WriteFileBuffer_t *wfb, const void* data);
-void WriteFileBuffer_writeAt (WriteFileBuffer_t *wfb, const void* data, off_t position);
+unsigned long long WriteFileBuffer_getNumRecords (WriteFileBuffer_t *wfb);
+void WriteFileBuffer_write (WriteFileBuffer_t *wfb, const paraver_rec_t *record);
+void WriteFileBuffer_writeAt (WriteFileBuffer_t *wfb, const paraver_rec_t *record, off_t position);
 void WriteFileBuffer_removeLast (WriteFileBuffer_t *wfb);
 
 #endif
@@ -35,8 +35,13 @@
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
 
 #include "record.h"
+#include "mpit_header.h"
+#include "mpit_events.h"
 
 #define MAX_MPIT_FILES 8192
 
@@ -77,11 +82,61 @@ void AddFileOfFiles (char *file)
 	fclose (fd);
 }
 
+/* Returns the size that keeps the first numofevents events of the file. The
+   compact files (see mpit_events.h) can only be cut between blocks, so the
+   whole block that holds the last event is kept */
+off_t SizeOfEvents (char *file, int numofevents)
+{
+	MPIT_Header_t header;
+	MPIT_Block_t block;
+	off_t size, offset;
+	long long events = 0;
+	int fd;
+
+	fd = open (file, O_RDONLY);
+	if (fd < 0)
+	{
+		perror ("open failed. Reported error:\n");
+		exit (-1);
+	}
+
+	size = lseek (fd, 0, SEEK_END);
+	if (pread (fd, &header, sizeof(header), 0) != sizeof(header) ||
+	    (header.Signature != MPIT_SIGNATURE && header.Signature != MPIT_SIGNATURE_SWAPPED))
+	{
+		/* Files from older tracers have no header and are plain events */
+		close (fd);
+		return (off_t) numofevents * sizeof(event_t);
+	}
+	if (header.Signature == MPIT_SIGNATURE_SWAPPED || header.Version != MPIT_VERSION_COMPACT)
+	{
+		fprintf (stderr, "reducempit: %s was written by an incompatible tracer or on a host of the opposite endianness\n", file);
+		exit (-1);
+	}
+
+	offset = sizeof(header);
+	while (events < numofevents && offset + (off_t) sizeof(block) <= size)
+	{
+		if (pread (fd, &block, sizeof(block), offset) != sizeof(block))
+		{
+			perror ("pread failed. Reported error:\n");
+			exit (-1);
+		}
+		events += block.NumEvents;
+		offset += sizeof(block) + block.Size;
+	}
+	close (fd);
+
+	/* A block cut short at the end of the file is kept as is */
+	return (offset < size) ? offset : size;
+}
+
 void ReduceFileTo (char *file, int numofevents)
 {
+	off_t size = SizeOfEvents (file, numofevents);
 	int res;
 
-	res = truncate (file, numofevents * sizeof(event_t));
+	res = truncate (file, size);
 	if (res < 0)
 	{
 		perror ("truncate failed. Reported error:\n");
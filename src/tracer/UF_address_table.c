@@ -0,0 +1,151 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include "common.h"
+
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
+
+#include "utils.h"
+#include "UF_address_table.h"
+
+#define UF_MIN_SIZE_l2    (4)
+#define UF_MAX_KICKS      (512)
+#define UF_BLOOM_KEYS_l2  (2)  /* 64 bits / 4 keys = 16 bits per address */
+
+/* Places address in the cuckoo table, evicting the occupants of its slots to
+   their alternate slots if needed. Returns FALSE if the evictions do not
+   settle, in which case the table has to be rebuilt with another seed or
+   size (some address has been dropped from the table) */
+static int UF_address_table_insert (UF_address_table_t *t, void *address)
+{
+	uint64_t h = UF_address_table_hash (t->seed, address);
+	unsigned long pos;
+	int kicks;
+
+	if (t->addresses[UF_SLOT0(t,h)] == address || t->addresses[UF_SLOT1(t,h)] == address)
+		return TRUE;
+
+	if (t->addresses[UF_SLOT0(t,h)] == NULL)
+	{
+		t->addresses[UF_SLOT0(t,h)] = address;
+		t->count++;
+		return TRUE;
+	}
+	if (t->addresses[UF_SLOT1(t,h)] == NULL)
+	{
+		t->addresses[UF_SLOT1(t,h)] = address;
+		t->count++;
+		return TRUE;
+	}
+
+	pos = UF_SLOT0(t,h);
+	for (kicks = 0; kicks < UF_MAX_KICKS; kicks++)
+	{
+		void *victim = t->addresses[pos];
+
+		t->addresses[pos] = address;
+		if (victim == NULL)
+		{
+			t->count++;
+			return TRUE;
+		}
+
+		/* Move the evicted address to its other slot */
+		address = victim;
+		h = UF_address_table_hash (t->seed, address);
+		pos = (pos < t->size) ? UF_SLOT1(t,h) : UF_SLOT0(t,h);
+	}
+	return FALSE;
+}
+
+/* Builds the cuckoo table and the Bloom filter for the n addresses in list.
+   Each half of the table gets at least as many slots as addresses (load
+   factor <= 50%); if the insertions do not settle the table is rebuilt with
+   a new seed, and its size doubles every few attempts */
+UF_address_table_t * UF_address_table_new (void *const *list, unsigned int n)
+{
+	UF_address_table_t *t;
+	unsigned int size_l2 = UF_MIN_SIZE_l2, bloom_l2;
+	unsigned int i, attempt = 0;
+
+	while ((1UL << size_l2) < n)
+		size_l2++;
+
+	xmalloc (t, sizeof(UF_address_table_t));
+	t->addresses = NULL;
+	t->rebuilds = 0;
+
+	bloom_l2 = (size_l2 > UF_BLOOM_KEYS_l2) ? size_l2 - UF_BLOOM_KEYS_l2 : 1;
+	xmalloc (t->bloom, (1UL << bloom_l2) * sizeof(uint64_t));
+	t->bloom_shift = 64 - bloom_l2;
+
+	do
+	{
+		int ok = TRUE;
+
+		t->seed = UF_ADDRESS_TABLE_SEED(attempt);
+		t->size = 1UL << size_l2;
+		t->mask = t->size - 1;
+		t->count = 0;
+
+		xfree (t->addresses);
+		xmalloc (t->addresses, 2 * t->size * sizeof(void *));
+		memset (t->addresses, 0, 2 * t->size * sizeof(void *));
+
+		for (i = 0; i < n && ok; i++)
+			ok = UF_address_table_insert (t, list[i]);
+
+		if (ok)
+			break;
+
+		t->rebuilds++;
+		attempt++;
+		if ((attempt % 4) == 0)
+			size_l2++;
+	} while (TRUE);
+
+	/* The filter depends on the seed, so it is filled once the table settled */
+	memset (t->bloom, 0, (1UL << bloom_l2) * sizeof(uint64_t));
+	for (i = 0; i < n; i++)
+	{
+		uint64_t g = UF_BLOOM_MIX(UF_address_table_hash (t->seed, list[i]));
+		t->bloom[UF_BLOOM_WORD(t,g)] |= UF_BLOOM_BITS(g);
+	}
+
+	return t;
+}
+
+void UF_address_table_free (UF_address_table_t *table)
+{
+	if (table != NULL)
+	{
+		xfree (table->addresses);
+		xfree (table->bloom);
+		xfree (table);
+	}
+}
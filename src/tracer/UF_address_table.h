@@ -0,0 +1,107 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#if !defined(UF_ADDRESS_TABLE_H_INCLUDED)
+#define UF_ADDRESS_TABLE_H_INCLUDED
+
+#ifdef HAVE_STDINT_H
+# include <stdint.h>
+#endif
+
+/* The list of user functions is fully known before the application starts,
+   so it is compiled into a cuckoo table: every address may only live in one
+   of two slots (one per half of addresses), and a query never looks anywhere
+   else. In front of the table there is a blocked Bloom filter (one 64-bit
+   word per query) that rejects most of the routines that are not in the
+   list -- by far the most frequent case -- without touching the table.
+   Both structures are sized after the number of addresses in the list, so
+   there is no capacity limit. A table is never changed once built. */
+
+typedef struct
+{
+	void **addresses;             /* 2 * size slots */
+	unsigned long size, mask;
+	uint64_t *bloom;
+	unsigned int bloom_shift;
+	uint64_t seed;
+	unsigned int count;           /* Distinct addresses in the table */
+	unsigned int rebuilds;        /* Seeds tried before the table settled */
+} UF_address_table_t;
+
+/* Seed of the hash on the given attempt to build a table */
+#define UF_ADDRESS_TABLE_SEED(attempt) (0x9e3779b97f4a7c15ULL * ((attempt) + 1))
+
+static inline uint64_t UF_address_table_hash (uint64_t seed, const void *address)
+{
+	uint64_t h = (uint64_t) (uintptr_t) address ^ seed;
+
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+#define UF_SLOT0(t,h)  ((unsigned long) (h) & (t)->mask)
+#define UF_SLOT1(t,h)  ((t)->size + ((unsigned long) ((h) >> 32) & (t)->mask))
+
+/* The Bloom word and its two bits come from a cheap remix of the hash so they
+   are not correlated with the table slots */
+#define UF_BLOOM_MIX(h)     ((h) * 0x9e3779b97f4a7c15ULL)
+#define UF_BLOOM_WORD(t,g)  ((g) >> (t)->bloom_shift)
+#define UF_BLOOM_BITS(g)    ((1ULL << ((g) & 63)) | (1ULL << (((g) >> 6) & 63)))
+
+static inline int UF_address_table_lookup (const UF_address_table_t *table,
+	const void *address)
+{
+	uint64_t h, g, bits;
+
+	if (table == NULL)
+		return 0;
+
+	h = UF_address_table_hash (table->seed, address);
+	g = UF_BLOOM_MIX(h);
+	bits = UF_BLOOM_BITS(g);
+
+	if ((table->bloom[UF_BLOOM_WORD(table,g)] & bits) != bits)
+		return 0;
+
+	return table->addresses[UF_SLOT0(table,h)] == address ||
+	       table->addresses[UF_SLOT1(table,h)] == address;
+}
+
+/* Only checks the Bloom filter (no false negatives, some false positives) */
+static inline int UF_address_table_maybe (const UF_address_table_t *table,
+	const void *address)
+{
+	uint64_t g = UF_BLOOM_MIX(UF_address_table_hash (table->seed, address));
+	uint64_t bits = UF_BLOOM_BITS(g);
+
+	return (table->bloom[UF_BLOOM_WORD(table,g)] & bits) == bits;
+}
+
+UF_address_table_t * UF_address_table_new (void *const *list, unsigned int n);
+void UF_address_table_free (UF_address_table_t *table);
+
+#endif /* UF_ADDRESS_TABLE_H_INCLUDED */
@@ -33,34 +33,27 @@
 # include <stdint.h>
 #endif
 
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
+
 #include <dlfcn.h>
 
 #include "wrapper.h"
+#include "utils.h"
 #include "UF_gcc_instrument.h"
+#include "UF_address_table.h"
 
 /* #define DEBUG */
 
-/* Configure the hash so it uses up to 1 Mbyte */
-#if SIZEOF_VOIDP == 8
-# define MAX_UFs_l2  (17)
-#elif SIZEOF_VOIDP == 4
-# define MAX_UFs_l2  (18)
-#else
-# error "Error! Unknown SIZEOF_VOIDP value!"
-#endif
-
-#define MAX_UFs      (1<<MAX_UFs_l2)
-#define MAX_UFs_mask ((1<<MAX_UFs_l2)-1)
-#define UF_lookahead (64)
-
-static void *UF_addresses[MAX_UFs];
-static unsigned int UF_collisions, UF_count, UF_distance;
-
-#if SIZEOF_VOIDP == 8
-# define HASH(address) ((address>>3) & MAX_UFs_mask)
-#elif SIZEOF_VOIDP == 4
-# define HASH(address) ((address>>2) & MAX_UFs_mask)
-#endif
+/* Table of the user functions to trace (see UF_address_table.h). It is only
+   replaced when the list is loaded again, and the tables replaced (or left
+   at the end) are never freed, as instrumented threads may still be looking
+   an address up in them. */
+static UF_address_table_t *UF_table = NULL;
 
 static int UF_tracing_enabled = FALSE;
 static int LookForUFaddress (void *address);
@@ -123,58 +116,15 @@ void __cyg_profile_func_exit (void *this_fn, void *call_site)
 	}
 }
 
-static void AddUFtoInstrument (void *address)
-{
-	int i = HASH((long)address);
-
-	if (UF_addresses[i] == NULL)
-	{
-		UF_addresses[i] = address;
-		UF_count++;
-	}
-	else
-	{
-		int count = 1;
-		while (UF_addresses[(i+count)%MAX_UFs] != NULL && count < UF_lookahead)
-			count++;
-
-		if (UF_addresses[(i+count)%MAX_UFs] == NULL)
-		{
-			UF_addresses[(i+count)%MAX_UFs] = address;
-			UF_collisions++;
-			UF_count++;
-			UF_distance += count;
-		}
-		else
-			fprintf (stderr, PACKAGE_NAME": Cannot add UF %p\n", address);
-	}
-}
-
 static int LookForUFaddress (void *address)
 {
-	int i = HASH((long)address);
-	int count = 0;
-
-	while (UF_addresses[(i+count)%MAX_UFs] != address && 
-		UF_addresses[(i+count)%MAX_UFs] != NULL &&
-		count < UF_lookahead)
-	{
-		count++;
-	}
-
-	return UF_addresses[(i+count)%MAX_UFs] == address;
-}
-
-static void ResetUFtoInstrument (void)
-{
-	int i;
-	for (i = 0; i < MAX_UFs; i++)
-		UF_addresses[i] = NULL;
-	UF_distance = UF_count = UF_collisions = 0;
+	return UF_address_table_lookup (UF_table, address);
 }
 
 void InstrumentUFroutines_GCC_CleanUp (void)
 {
+	/* The table is left allocated, see UF_table */
+	UF_tracing_enabled = FALSE;
 }
 
 void InstrumentUFroutines_GCC (int rank, char *filename)
@@ -184,26 +134,46 @@ void InstrumentUFroutines_GCC (int rank, char *filename)
 	{
 		char buffer[1024], fname[1024];
 		unsigned long address;
+		void **list = NULL;
+		unsigned int list_count = 0, list_allocated = 0;
+		UF_address_table_t *table;
 
-		ResetUFtoInstrument ();
+		UF_tracing_enabled = FALSE;
 
 		if (fgets (buffer, sizeof(buffer), f) != NULL)
 			while (!feof(f))
 			{
-				if (sscanf (buffer, "%lx # %s", &address, fname) == 2)
-					AddUFtoInstrument ((void*) address);
+				if (sscanf (buffer, "%lx # %s", &address, fname) == 2 && address != 0)
+				{
+					if (list_count == list_allocated)
+					{
+						list_allocated = (list_allocated > 0) ? 2 * list_allocated : 1024;
+						xrealloc (list, list, list_allocated * sizeof(void *));
+					}
+					list[list_count++] = (void*) address;
+				}
 				if (fgets (buffer, sizeof(buffer), f) == NULL)
 					break;
 			}
 		fclose (f);
 
+		table = (list_count > 0) ? UF_address_table_new (list, list_count) : NULL;
+		xfree (list);
+
+		/* The table must be complete before other threads can see it */
+#if defined(HAVE__SYNC_FETCH_AND_ADD)
+		__sync_synchronize ();
+#endif
+		UF_table = table;
+
 		if (rank == 0)
 		{
-			if (UF_collisions > 0)
-				fprintf (stdout, PACKAGE_NAME": Number of user functions traced (GCC runtime): %u (collisions: %u, avg distance = %u)\n",
-    	    UF_count, UF_collisions, UF_distance/UF_collisions);
+			if (table != NULL && table->rebuilds > 0)
+				fprintf (stdout, PACKAGE_NAME": Number of user functions traced (GCC runtime): %u (table slots: %lu, rebuilds: %u)\n",
+				  table->count, 2 * table->size, table->rebuilds);
 			else
-				fprintf (stdout, PACKAGE_NAME": Number of user functions traced (GCC runtime): %u\n", UF_count);
+				fprintf (stdout, PACKAGE_NAME": Number of user functions traced (GCC runtime): %u\n",
+				  (table != NULL) ? table->count : 0);
 		}
 	}
 	else
@@ -212,7 +182,7 @@ void InstrumentUFroutines_GCC (int rank, char *filename)
 			fprintf (stderr, PACKAGE_NAME": Warning! Cannot open %s file\n", filename);
 	}
 
-	if (UF_count > 0)
+	if (UF_table != NULL && UF_table->count > 0)
 		UF_tracing_enabled = TRUE;
 }
 
@@ -31,6 +31,7 @@
 #include <string.h>
 
 #include "utils.h"
+#include "cache_line.h"
 
 #include "clock.h"
 
@@ -60,6 +61,7 @@
 # include <ia32_clock.h>
 # define  GET_CLOCK    ia32_getTime
 # define  INIT_CLOCK   ia32_Initialize
+# define  CHECK_CLOCK  ia32_isReliable
 #elif defined(OS_LINUX) && defined(ARCH_IA64)
 # include <ia64_clock.h>
 # define  GET_CLOCK    ia64_getTime
@@ -72,7 +74,16 @@
 # error "Unhandled clock type"
 #endif
 
-static UINT64 *_extrae_last_read_clock = NULL;
+/* Last time read by every thread, one cache line per thread as every event
+   updates it */
+typedef union
+{
+	UINT64 time;
+	char pad[EXTRAE_CACHE_LINE_ROUNDUP(sizeof(UINT64))];
+} Clock_LastRead_t;
+
+static Clock_LastRead_t *_extrae_last_read_clock = NULL;
+static unsigned _extrae_last_read_clock_threads = 0;
 static unsigned ClockType = REAL_CLOCK;
 iotimer_t (*get_clock)();
 
@@ -89,7 +100,7 @@ unsigned Clock_getType (void)
 /* We obtain the last read time */
 UINT64 Clock_getLastReadTime (unsigned thread)
 {
-	return _extrae_last_read_clock[thread];
+	return _extrae_last_read_clock[thread].time;
 }
 
 /* We obtain the current time, but we don't store it in the last read time */
@@ -103,24 +114,23 @@ UINT64 Clock_getCurrentTime_nstore (void)
 UINT64 Clock_getCurrentTime (unsigned thread)
 {
 	UINT64 tmp = Clock_getCurrentTime_nstore ();
-	_extrae_last_read_clock[thread] = tmp;
+	_extrae_last_read_clock[thread].time = tmp;
 	return tmp;
 }
 
 void Clock_AllocateThreads (unsigned numthreads)
 {
-	_extrae_last_read_clock = (UINT64*) realloc (_extrae_last_read_clock,
-		sizeof(UINT64)*numthreads);
-	if (_extrae_last_read_clock == NULL)
-	{
-		fprintf (stderr, PACKAGE_NAME": Cannot allocate timing memory for %u threads\n", numthreads);
-		exit (-1);
-	}
+	_extrae_last_read_clock = (Clock_LastRead_t*) Extrae_CacheLine_Realloc (
+	  _extrae_last_read_clock,
+	  sizeof(Clock_LastRead_t)*_extrae_last_read_clock_threads,
+	  sizeof(Clock_LastRead_t)*numthreads);
+	_extrae_last_read_clock_threads = numthreads;
 }
 
 void Clock_CleanUp (void)
 {
 	xfree (_extrae_last_read_clock);
+	_extrae_last_read_clock_threads = 0;
 }
 
 void Clock_Initialize (unsigned numthreads)
@@ -159,4 +169,15 @@ void Clock_Initialize (unsigned numthreads)
 	}
 
 	init_clock();
+
+#if defined(CHECK_CLOCK)
+	/* The native clock may turn out to be unusable on this machine (e.g. a
+	   time-stamp counter that is not invariant), use the POSIX clock then */
+	if (get_clock == GET_CLOCK && !CHECK_CLOCK())
+	{
+		fprintf (stderr, PACKAGE_NAME": Warning! The native clock is not reliable on this machine, using the POSIX clock instead.\n");
+		posix_Initialize();
+		get_clock = posix_getTime;
+	}
+#endif
 }
@@ -32,6 +32,9 @@
 # ifdef HAVE_STRING_H
 #  include <string.h>
 # endif
+# ifdef HAVE_TIME_H
+#  include <time.h>
+# endif
 #elif defined(OS_FREEBSD) || defined(OS_DARWIN)
 # ifdef HAVE_SYS_TYPES_H
 #  include <sys/types.h>
@@ -50,9 +53,14 @@
 
 #include "ia32_clock.h"
 
-static unsigned long long proc_timebase_MHz;
-
 #if defined(OS_FREEBSD) || defined (OS_LINUX) || defined (OS_DARWIN)
+/* Time-stamp counter to nanoseconds conversion, computed as
+   ns = (cycles * ia32_mult) >> ia32_shift, so that the hot path does not need
+   any division */
+static unsigned long long ia32_mult;
+static unsigned ia32_shift;
+static int ia32_reliable = FALSE;
+
 static __inline unsigned long long ia32_cputime (void)
 {
 #if defined(ARCH_IA32_x64)
@@ -87,31 +95,118 @@ static __inline unsigned long long ia32_cputime (void)
 #endif
 }
 
-void ia32_Initialize (void)
+/* Precomputes the multiply-shift factor for a time-stamp counter ticking at
+   the given frequency (in Hz). The shift is chosen as large as possible while
+   keeping the factor below 2^32, which is what ia32_getTime relies on when no
+   128-bit arithmetic is available. A null frequency (e.g. a failed
+   calibration) leaves the clock marked as unreliable. */
+static void ia32_SetFrequency (unsigned long long tsc_hz)
 {
+	ia32_reliable = FALSE;
+	if (tsc_hz == 0)
+		return;
+
+	ia32_shift = 32;
+	do
+	{
+		ia32_mult = ((1000000000ULL << ia32_shift) + tsc_hz / 2) / tsc_hz;
+	} while (ia32_mult >= (1ULL << 32) && --ia32_shift > 0);
+
+	ia32_reliable = (ia32_mult > 0);
+}
+
 #if defined(OS_LINUX)
-  FILE *fp;
-  char buffer[ 32768 ];
-  size_t bytes_read;
-  char* match;
-  double temp;
-  int res;
 
-  fp = fopen( "/proc/cpuinfo", "r" );
-  bytes_read = fread( buffer, 1, sizeof(buffer) - sizeof(char), fp );
-  fclose( fp );
+# if defined(CLOCK_MONOTONIC_RAW)
+#  define IA32_CALIBRATION_CLOCK CLOCK_MONOTONIC_RAW
+# else
+#  define IA32_CALIBRATION_CLOCK CLOCK_MONOTONIC
+# endif
 
-  if (bytes_read == 0)
-    return;
+/* Length of the calibration window (in ns) */
+# define IA32_CALIBRATION_WINDOW 20000000ULL
 
-  buffer[bytes_read] = '\0';
-  match = strstr( buffer, "cpu MHz" );
-  if (match == NULL)
-    return;
+static unsigned long long ia32_calibration_ns (void)
+{
+	struct timespec ts;
 
-  res = sscanf (match, "cpu MHz    : %lf", &temp );
+	clock_gettime (IA32_CALIBRATION_CLOCK, &ts);
+	return ((unsigned long long) ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+/* The conversion is only meaningful if the counter ticks at a constant rate
+   and keeps ticking in deep C-states (i.e. it is invariant). The kernel
+   reports both properties in the flags of /proc/cpuinfo. */
+static int ia32_TSC_isInvariant (void)
+{
+	FILE *fp;
+	char line[8192];
+	int constant = FALSE, nonstop = FALSE;
+
+	fp = fopen ("/proc/cpuinfo", "r");
+	if (fp == NULL)
+		return FALSE;
+
+	while (fgets (line, sizeof(line), fp) != NULL)
+		if (strncmp (line, "flags", strlen("flags")) == 0)
+		{
+			constant = strstr (line, " constant_tsc") != NULL;
+			nonstop = strstr (line, " nonstop_tsc") != NULL;
+			break;
+		}
+	fclose (fp);
 
-  proc_timebase_MHz = (res == 1) ? temp : 0;
+	return constant && nonstop;
+}
+
+/* Reads the time-stamp counter bracketed by two reads of the reference clock.
+   The narrowest bracket out of a few tries is kept, which filters out the
+   samples where the thread was preempted between the reads. */
+static void ia32_TSC_Sample (unsigned long long *ns, unsigned long long *cycles)
+{
+	unsigned long long before, after, c, best = ~0ULL;
+	int i;
+
+	for (i = 0; i < 8; i++)
+	{
+		before = ia32_calibration_ns();
+		c = ia32_cputime();
+		after = ia32_calibration_ns();
+		if (after - before < best)
+		{
+			best = after - before;
+			*ns = before + best / 2;
+			*cycles = c;
+		}
+	}
+}
+
+/* Measures the frequency of the time-stamp counter against the raw monotonic
+   clock over a short window */
+static unsigned long long ia32_TSC_Calibrate (void)
+{
+	unsigned long long ns_begin, ns_end, cycles_begin, cycles_end;
+
+	ia32_TSC_Sample (&ns_begin, &cycles_begin);
+	while (ia32_calibration_ns() - ns_begin < IA32_CALIBRATION_WINDOW)
+		;
+	ia32_TSC_Sample (&ns_end, &cycles_end);
+
+	if (ns_end <= ns_begin || cycles_end <= cycles_begin)
+		return 0;
+
+	return (unsigned long long) (((double) (cycles_end - cycles_begin) * 1000000000.0) / (ns_end - ns_begin));
+}
+#endif /* OS_LINUX */
+
+void ia32_Initialize (void)
+{
+#if defined(OS_LINUX)
+	ia32_reliable = FALSE;
+	if (!ia32_TSC_isInvariant())
+		return;
+
+	ia32_SetFrequency (ia32_TSC_Calibrate());
 #elif defined(OS_FREEBSD) || defined(OS_DARWIN)
 	int mib[3];
 	int result;
@@ -137,7 +232,7 @@ void ia32_Initialize (void)
     exit (-1);
   }
 
-  proc_timebase_MHz = (unsigned long long) (tsc_value / 1000000);
+  ia32_SetFrequency (tsc_value);
 #endif
 }
 #endif /* OS_FREEBSD || OS_LINUX || OS_DARWIN */
@@ -145,10 +240,26 @@ void ia32_Initialize (void)
 iotimer_t ia32_getTime (void)
 {
 #if defined(OS_FREEBSD) || defined(OS_LINUX) || defined(OS_DARWIN)
-  return (ia32_cputime() * 1000) / proc_timebase_MHz; 
+# if defined(__SIZEOF_INT128__)
+  return (iotimer_t) (((unsigned __int128) ia32_cputime() * ia32_mult) >> ia32_shift);
+# else
+  unsigned long long cycles = ia32_cputime();
+
+  return (((cycles >> 32) * ia32_mult) << (32 - ia32_shift)) +
+    (((cycles & 0xFFFFFFFFULL) * ia32_mult) >> ia32_shift);
+# endif
 #elif defined (OS_SOLARIS)
   return gethrtime();
 #endif
 }
 
+int ia32_isReliable (void)
+{
+#if defined(OS_FREEBSD) || defined(OS_LINUX) || defined(OS_DARWIN)
+  return ia32_reliable;
+#elif defined (OS_SOLARIS)
+  return TRUE;
+#endif
+}
+
 #endif
@@ -27,5 +27,6 @@
 
 iotimer_t ia32_getTime (void);
 void ia32_Initialize (void);
+int ia32_isReliable (void);
 
 #endif
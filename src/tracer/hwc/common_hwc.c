@@ -63,12 +63,10 @@ int Reset_After_Read = FALSE;
 /* XXX: This variable should be defined at the Extrae core level */
 int Trace_HWC_Enabled = TRUE;     /* Global variable that allows the gathering of HWC information */
 
-int *HWC_Thread_Initialized;
-
-/* XXX: These buffers should probably be external to this module, 
+/* XXX: The accumulation buffers should probably be external to this module,
    and HWC_Accum should receive the buffer as an I/O parameter. */
-long long **Accumulated_HWC;
-int *Accumulated_HWC_Valid; /* Marks whether Accumulated_HWC has valid values */
+HWC_Thread_Slot_t *HWC_Thread_State = NULL;
+static unsigned HWC_Thread_State_size = 0;
 
 HWC_Set_Count_t *CommonHWCs = NULL; /* To keep track in how many sets each counter appears */
 int              AllHWCs    = 0;    /* Count of all the different counters from all sets   */
@@ -81,12 +79,9 @@ int              AllHWCs    = 0;    /* Count of all the different counters from
 
 struct HWC_Set_t *HWC_sets = NULL;
 unsigned long long HWC_current_changeat = 0;
-unsigned long long * HWC_current_timebegin;
-unsigned long long * HWC_current_glopsbegin;
 enum ChangeType_t HWC_current_changetype = CHANGE_NEVER;
 enum ChangeTo_t HWC_current_changeto = CHANGE_SEQUENTIAL;
 int HWC_num_sets = 0;
-int * HWC_current_set;
 
 /**
  * Checks whether the module has been started and the HWC are counting
@@ -103,7 +98,7 @@ int HWC_IsEnabled()
  */
 int HWC_Get_Current_Set (int threadid)
 {
-	return HWC_current_set[threadid];
+	return HWC_THREAD(threadid).current_set;
 }
 
 /*
@@ -196,7 +191,7 @@ void HWC_Stop_Current_Set (UINT64 time, int thread_id)
 		Extrae_counters_at_Time_Wrapper(time);
 
 		/* Actually stop the counters */
-		HWCBE_STOP_SET (time, HWC_current_set[thread_id], thread_id);
+		HWCBE_STOP_SET (time, HWC_THREAD(thread_id).current_set, thread_id);
 	}
 }
 
@@ -210,7 +205,7 @@ void HWC_Start_Current_Set (UINT64 countglops, UINT64 time, int thread_id)
 	if (HWC_num_sets > 0)
 	{
 		/* Actually start the counters */
-		HWCBE_START_SET (countglops, time, HWC_current_set[thread_id], thread_id);
+		HWCBE_START_SET (countglops, time, HWC_THREAD(thread_id).current_set, thread_id);
 	}
 }
 
@@ -228,9 +223,9 @@ void HWC_Start_Next_Set (UINT64 countglops, UINT64 time, int thread_id)
 		
 		/* Move to the next set */
 		if (HWC_current_changeto == CHANGE_SEQUENTIAL)
-			HWC_current_set[thread_id] = (HWC_current_set[thread_id] + 1) % HWC_num_sets;
+			HWC_THREAD(thread_id).current_set = (HWC_THREAD(thread_id).current_set + 1) % HWC_num_sets;
 		else if (HWC_current_changeto == CHANGE_RANDOM)
-			HWC_current_set[thread_id] = random()%HWC_num_sets;
+			HWC_THREAD(thread_id).current_set = random()%HWC_num_sets;
 
 		HWC_Start_Current_Set (countglops, time, thread_id);
 	}
@@ -249,9 +244,9 @@ void HWC_Start_Previous_Set (UINT64 countglops, UINT64 time, int thread_id)
 
 		/* Move to the previous set */
 		if (HWC_current_changeto == CHANGE_SEQUENTIAL)
-			HWC_current_set[thread_id] = ((HWC_current_set[thread_id] - 1) < 0) ? (HWC_num_sets - 1) : (HWC_current_set[thread_id] - 1) ;
+			HWC_THREAD(thread_id).current_set = ((HWC_THREAD(thread_id).current_set - 1) < 0) ? (HWC_num_sets - 1) : (HWC_THREAD(thread_id).current_set - 1) ;
 		else if (HWC_current_changeto == CHANGE_RANDOM)
-			HWC_current_set[thread_id] = random()%HWC_num_sets;
+			HWC_THREAD(thread_id).current_set = random()%HWC_num_sets;
 
 		HWC_Start_Current_Set (countglops, time, thread_id);
 	}
@@ -271,7 +266,7 @@ static inline int CheckForHWCSetChange_GLOPS (UINT64 countglops, UINT64 time, in
 
 	if (HWC_current_changeat != 0)
 	{
-		if (HWC_current_glopsbegin[threadid] + HWC_current_changeat <= countglops)
+		if (HWC_THREAD(threadid).current_glopsbegin + HWC_current_changeat <= countglops)
 		{
 			HWC_Start_Next_Set (countglops, time, threadid);
 			ret = 1;
@@ -290,9 +285,9 @@ static inline int CheckForHWCSetChange_TIME (UINT64 countglops, UINT64 time, int
 {
 	int ret = 0;
 
-//	fprintf (stderr, "HWC_current_timebegin[%d]=%llu HWC_current_changeat=%llu time = %llu\n", THREADID, HWC_current_timebegin[threadid], HWC_current_changeat, time);
+//	fprintf (stderr, "HWC_THREAD(%d).current_timebegin=%llu HWC_current_changeat=%llu time = %llu\n", THREADID, HWC_THREAD(threadid).current_timebegin, HWC_current_changeat, time);
 
-	if (HWC_current_timebegin[threadid] + HWC_current_changeat < time)
+	if (HWC_THREAD(threadid).current_timebegin + HWC_current_changeat < time)
 	{
 		HWC_Start_Next_Set (countglops, time, threadid);
 		ret = 1;
@@ -317,6 +312,22 @@ int HWC_Check_Pending_Set_Change (UINT64 countglops, UINT64 time, int thread_id)
 		return 0;
 }
 
+/**
+ * Grows the per-thread state up to the given number of threads. The state of
+ * the new threads is zeroed (i.e. uninitialized and using the first set).
+ * \param num_threads Total number of threads.
+ */
+static void HWC_Reallocate_Thread_State (unsigned num_threads)
+{
+	if (num_threads > HWC_Thread_State_size)
+	{
+		HWC_Thread_State = (HWC_Thread_Slot_t *) Extrae_CacheLine_Realloc (
+		  HWC_Thread_State, sizeof(HWC_Thread_Slot_t) * HWC_Thread_State_size,
+		  sizeof(HWC_Thread_Slot_t) * num_threads);
+		HWC_Thread_State_size = num_threads;
+	}
+}
+
 /** 
  * Initializes the hardware counters module.
  * \param options Configuration options.
@@ -325,15 +336,7 @@ void HWC_Initialize (int options)
 {
 	int num_threads = Backend_getMaximumOfThreads();
 
-	HWC_current_set = (int *)malloc(sizeof(int) * num_threads);
-	ASSERT(HWC_current_set != NULL, "Cannot allocate memory for HWC_current_set");
-	memset (HWC_current_set, 0, sizeof(int) * num_threads);
-
-	HWC_current_timebegin = (unsigned long long *)malloc(sizeof(unsigned long long) * num_threads);
-	ASSERT(HWC_current_timebegin != NULL, "Cannot allocate memory for HWC_current_timebegin");
-
-	HWC_current_glopsbegin = (unsigned long long *)malloc(sizeof(unsigned long long) * num_threads);
-	ASSERT(HWC_current_glopsbegin != NULL, "Cannot allocate memory for HWC_current_glopsbegin");
+	HWC_Reallocate_Thread_State (num_threads);
 
 	HWCBE_INITIALIZE(options);
 }
@@ -343,22 +346,12 @@ void HWC_Initialize (int options)
  */
 void HWC_CleanUp (unsigned nthreads)
 {
-	unsigned u;
-
 	if (HWC_num_sets > 0)
 	{
 		HWCBE_CLEANUP_COUNTERS_THREAD(nthreads);
 
-		xfree (HWC_current_set);
-		xfree (HWC_current_timebegin);
-		xfree (HWC_current_glopsbegin);
-		xfree (HWC_Thread_Initialized);
-		xfree (Accumulated_HWC_Valid);
-		for (u = 0; u < nthreads; u++)
-		{
-			xfree (Accumulated_HWC[u]);
-		}
-		xfree (Accumulated_HWC);
+		xfree (HWC_Thread_State);
+		HWC_Thread_State_size = 0;
 	}
 }
 
@@ -373,23 +366,12 @@ void HWC_Start_Counters (int num_threads, UINT64 time, int forked)
 	/* Allocate memory if this process has not been forked */
 	if (!forked)
 	{
-		HWC_Thread_Initialized = (int *) malloc (sizeof(int) * num_threads);
-		ASSERT(HWC_Thread_Initialized!=NULL, "Cannot allocate memory for HWC_Thread_Initialized!");
+		HWC_Reallocate_Thread_State (num_threads);
 
 		/* Mark all the threads as uninitialized */
-		for (i = 0; i < num_threads; i++)
-			HWC_Thread_Initialized[i] = FALSE;
-
-		Accumulated_HWC_Valid = (int *)malloc(sizeof(int) * num_threads);
-		ASSERT(Accumulated_HWC_Valid!=NULL, "Cannot allocate memory for Accumulated_HWC_Valid");
-
-		Accumulated_HWC = (long long **)malloc(sizeof(long long *) * num_threads);
-		ASSERT(Accumulated_HWC!=NULL, "Cannot allocate memory for Accumulated_HWC");
-
 		for (i = 0; i < num_threads; i++)
 		{
-			Accumulated_HWC[i] = (long long *)malloc(sizeof(long long) * MAX_HWC);
-			ASSERT(Accumulated_HWC[i]!=NULL, "Cannot allocate memory for Accumulated_HWC");
+			HWC_THREAD(i).Initialized = FALSE;
 			HWC_Accum_Reset(i);
 		}
 
@@ -409,10 +391,10 @@ void HWC_Start_Counters (int num_threads, UINT64 time, int forked)
  * XXX This used to be uncommented. Sets the same counter set to all the threads
  * of a task. Commented to allow every thread to have a different set.
 
-		HWC_current_set[i] = HWC_current_set[0];
+		HWC_THREAD(i).current_set = HWC_THREAD(0).current_set;
 */
-		HWC_current_timebegin[i] = HWC_current_timebegin[0];
-		HWC_current_glopsbegin[i] = HWC_current_glopsbegin[0];
+		HWC_THREAD(i).current_timebegin = HWC_THREAD(0).current_timebegin;
+		HWC_THREAD(i).current_glopsbegin = HWC_THREAD(0).current_glopsbegin;
 	}
 }
 
@@ -423,48 +405,18 @@ void HWC_Start_Counters (int num_threads, UINT64 time, int forked)
  */
 void HWC_Restart_Counters (int old_num_threads, int new_num_threads)
 {
+#if defined(PAPI_COUNTERS)
 	int i;
 
-#if defined(PAPI_COUNTERS)
 	for (i = 0; i < HWC_num_sets; i++)
 		HWCBE_PAPI_Allocate_eventsets_per_thread (i, old_num_threads, new_num_threads);
+#else
+	UNREFERENCED_PARAMETER(old_num_threads);
 #endif
 
-	HWC_Thread_Initialized = (int *) realloc (HWC_Thread_Initialized, sizeof(int) * new_num_threads);
-	ASSERT(HWC_Thread_Initialized!=NULL, "Cannot reallocate memory for HWC_Thread_Initialized!");
-
-	/* Mark all the threads as uninitialized */
-	for (i = old_num_threads; i < new_num_threads; i++)
-		HWC_Thread_Initialized[i] = FALSE;
-
-	Accumulated_HWC_Valid = (int *) realloc (Accumulated_HWC_Valid, sizeof(int) * new_num_threads);
-	ASSERT(Accumulated_HWC_Valid!=NULL, "Cannot reallocate memory for Accumulated_HWC_Valid");
-
-	Accumulated_HWC = (long long **) realloc (Accumulated_HWC, sizeof(long long *) * new_num_threads);
-	ASSERT(Accumulated_HWC!=NULL, "Cannot reallocate memory for Accumulated_HWC");
-
-	for (i = old_num_threads; i < new_num_threads; i++)
-	{
-		Accumulated_HWC[i] = (long long *)malloc(sizeof(long long) * MAX_HWC);
-		ASSERT(Accumulated_HWC[i]!=NULL, "Cannot reallocate memory for Accumulated_HWC");
-		HWC_Accum_Reset(i);
-	}
-
-	HWC_current_set = (int *) realloc (HWC_current_set, sizeof(int) * new_num_threads);
-	ASSERT(HWC_current_set!=NULL, "Cannot reallocate memory for HWC_current_set");
-
-	HWC_current_timebegin = (unsigned long long *) realloc (HWC_current_timebegin, sizeof(unsigned long long) * new_num_threads);
-	ASSERT(HWC_current_timebegin!=NULL, "Cannot reallocate memory for HWC_current_timebegin");
-
-	HWC_current_glopsbegin = (unsigned long long *) realloc (HWC_current_glopsbegin, sizeof(unsigned long long) * new_num_threads);
-	ASSERT(HWC_current_glopsbegin!=NULL, "Cannot reallocate memory for HWC_current_glopsbegin");
-
-	for (i = old_num_threads; i < new_num_threads; i++)
-	{
-		HWC_current_set[i] = 0;
-		HWC_current_timebegin[i] = 0;
-		HWC_current_glopsbegin[i] = 0;
-	}
+	/* New threads start uninitialized, in the first set and with no
+	   accumulated values */
+	HWC_Reallocate_Thread_State (new_num_threads);
 }
 
 /**
@@ -496,7 +448,7 @@ HWC_Parse_XML_Config (int task_id, int num_tasks, char *distribution)
 			HWC_current_changeto = CHANGE_RANDOM;
 
 			for(threadid=0; threadid<Backend_getMaximumOfThreads(); threadid++) 
-				HWC_current_set[threadid] = rset;
+				HWC_THREAD(threadid).current_set = rset;
 
 			if (task_id == 0)
 				fprintf (stdout, PACKAGE_NAME": Starting distribution hardware counters set is established to 'random'\n");
@@ -506,7 +458,7 @@ HWC_Parse_XML_Config (int task_id, int num_tasks, char *distribution)
 			/* Sets are distributed among tasks like:
 			0 1 2 3 .. n-1 0 1 2 3 .. n-1  0 1 2 3 ... */
 			for(threadid=0; threadid<Backend_getMaximumOfThreads(); threadid++) 
-				HWC_current_set[threadid] = task_id % HWC_num_sets;
+				HWC_THREAD(threadid).current_set = task_id % HWC_num_sets;
 
 			if (task_id == 0)
 				fprintf (stdout, PACKAGE_NAME": Starting distribution hardware counters set is established to 'cyclic'\n");
@@ -519,7 +471,7 @@ HWC_Parse_XML_Config (int task_id, int num_tasks, char *distribution)
 			maxThreads = Backend_getMaximumOfThreads();
 			for(threadid=0; threadid<maxThreads; threadid++)
 			{
-				HWC_current_set[threadid] = (maxThreads * task_id + threadid) % HWC_num_sets;
+				HWC_THREAD(threadid).current_set = (maxThreads * task_id + threadid) % HWC_num_sets;
 			}
 
 			if (task_id == 0)
@@ -536,9 +488,9 @@ HWC_Parse_XML_Config (int task_id, int num_tasks, char *distribution)
 			for(threadid=0; threadid<Backend_getMaximumOfThreads(); threadid++) 
 			{
 				if (BlockDivisor > 0)
-					HWC_current_set[threadid] = task_id / BlockDivisor;
+					HWC_THREAD(threadid).current_set = task_id / BlockDivisor;
 				else
-					HWC_current_set[threadid] = 0;
+					HWC_THREAD(threadid).current_set = 0;
 			}
 
 			if (task_id == 0)
@@ -553,11 +505,11 @@ HWC_Parse_XML_Config (int task_id, int num_tasks, char *distribution)
 				if (task_id == 0)
 					fprintf (stderr, PACKAGE_NAME": Warning! Cannot identify '%s' as a valid starting distribution set on the CPU counters. Setting to the first one.\n", distribution);
 				for(threadid=0; threadid<Backend_getMaximumOfThreads(); threadid++)
-					HWC_current_set[threadid] = 0;
+					HWC_THREAD(threadid).current_set = 0;
 			}
 			else
 				for(threadid=0; threadid<Backend_getMaximumOfThreads(); threadid++)
-					HWC_current_set[threadid] = (HWC_num_sets<value-1)?HWC_num_sets:value-1;
+					HWC_THREAD(threadid).current_set = (HWC_num_sets<value-1)?HWC_num_sets:value-1;
 		}
 	}
 }
@@ -588,7 +540,7 @@ int HWC_Read (unsigned int tid, UINT64 time, long long *store_buffer)
 
 	if (HWCEnabled)
 	{
-		if (!HWC_Thread_Initialized[tid])
+		if (!HWC_THREAD(tid).Initialized)
 			HWCBE_START_COUNTERS_THREAD(time, tid, FALSE);
 		TOUCH_LASTFIELD( store_buffer );
 
@@ -629,19 +581,19 @@ int HWC_Accum (unsigned int tid, UINT64 time)
 
 	if (HWCEnabled)
 	{
-		if (!HWC_Thread_Initialized[tid])
+		if (!HWC_THREAD(tid).Initialized)
 			HWCBE_START_COUNTERS_THREAD(time, tid, FALSE);
-		TOUCH_LASTFIELD( Accumulated_HWC[tid] );
+		TOUCH_LASTFIELD( HWC_THREAD(tid).Accumulated );
 
 #if defined(SAMPLING_SUPPORT)
 		/* If sampling is enabled, the counters are always in "accumulate" mode
 		   because PAPI_reset is not called */
-		accum_ok = HWCBE_READ (tid, Accumulated_HWC[tid]);
+		accum_ok = HWCBE_READ (tid, HWC_THREAD(tid).Accumulated);
 #else
-		accum_ok = HWCBE_ACCUM (tid, Accumulated_HWC[tid]);
+		accum_ok = HWCBE_ACCUM (tid, HWC_THREAD(tid).Accumulated);
 #endif
 
-		Accumulated_HWC_Valid[tid] = TRUE;
+		HWC_THREAD(tid).Accumulated_Valid = TRUE;
 	}
 	return (HWCEnabled && accum_ok);
 }
@@ -655,8 +607,8 @@ int HWC_Accum_Reset (unsigned int tid)
 {
 	if (HWCEnabled)
 	{
-		Accumulated_HWC_Valid[tid] = FALSE;
-		memset(Accumulated_HWC[tid], 0, MAX_HWC * sizeof(long long));
+		HWC_THREAD(tid).Accumulated_Valid = FALSE;
+		memset(HWC_THREAD(tid).Accumulated, 0, MAX_HWC * sizeof(long long));
 		return 1;
 	}
 	else return 0;
@@ -665,7 +617,7 @@ int HWC_Accum_Reset (unsigned int tid)
 /** Returns whether Accumulated_HWC contains valid values or not */
 int HWC_Accum_Valid_Values (unsigned int tid) 
 {
-	return ( HWCEnabled ? Accumulated_HWC_Valid[tid] : 0 );
+	return ( HWCEnabled ? HWC_THREAD(tid).Accumulated_Valid : 0 );
 }
 
 /** 
@@ -677,7 +629,7 @@ int HWC_Accum_Copy_Here (unsigned int tid, long long *store_buffer)
 {
 	if (HWCEnabled)
 	{
-		memcpy(store_buffer, Accumulated_HWC[tid], MAX_HWC * sizeof(long long));
+		memcpy(store_buffer, HWC_THREAD(tid).Accumulated, MAX_HWC * sizeof(long long));
 		return 1;
 	}
 	else return 0;
@@ -695,7 +647,7 @@ int HWC_Accum_Add_Here (unsigned int tid, long long *store_buffer)
 	{
 		for (i=0; i<MAX_HWC; i++)
 		{
-			store_buffer[i] += 	Accumulated_HWC[tid][i];
+			store_buffer[i] += 	HWC_THREAD(tid).Accumulated[i];
 		}
 		return 1;
 	}
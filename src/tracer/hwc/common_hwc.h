@@ -30,6 +30,7 @@
 #include "num_hwc.h"
 #include "hwc_version.h"
 #include "hwc.h"
+#include "cache_line.h"
 
 /*------------------------------------------------ Structures ---------------*/
 
@@ -53,6 +54,26 @@ struct HWC_Set_t
 #endif
 };
 
+/* Per-thread state of the module. Each thread owns a whole number of cache
+   lines, as the counters of a thread are accumulated on every event */
+typedef struct
+{
+    int Initialized;                       /* Counters started for the thread */
+    int current_set;                       /* Active set (0 .. n-1) */
+    unsigned long long current_timebegin;  /* When the active set started */
+    unsigned long long current_glopsbegin; /* At which global op it started */
+    int Accumulated_Valid;                 /* Accumulated has valid values */
+    long long Accumulated[MAX_HWC];
+} HWC_Thread_State_t;
+
+typedef union
+{
+    HWC_Thread_State_t s;
+    char pad[EXTRAE_CACHE_LINE_ROUNDUP(sizeof(HWC_Thread_State_t))];
+} HWC_Thread_Slot_t;
+
+#define HWC_THREAD(tid) (HWC_Thread_State[tid].s)
+
 #define MAX_HWC_DESCRIPTION_LENGTH  256
 
 typedef struct HWC_Definition_st
@@ -70,14 +91,11 @@ typedef struct
 
 /*------------------------------------------------ Global Variables  --------*/
 
-extern int *HWC_Thread_Initialized;
+extern HWC_Thread_Slot_t *HWC_Thread_State;
 extern struct HWC_Set_t *HWC_sets;
 extern int HWC_num_sets;
 extern unsigned long long HWC_current_changeat;
-extern unsigned long long * HWC_current_timebegin;
-extern unsigned long long * HWC_current_glopsbegin;
 extern enum ChangeType_t HWC_current_changetype;
-extern int * HWC_current_set;
 
 /*------------------------------------------------ Useful macros ------------*/
 
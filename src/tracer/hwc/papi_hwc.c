@@ -409,8 +409,8 @@ int HWCBE_PAPI_Start_Set (UINT64 countglops, UINT64 time, int numset, int thread
 
 	HWC_current_changeat = HWC_sets[numset].change_at;
 	HWC_current_changetype = HWC_sets[numset].change_type;
-	HWC_current_timebegin[threadid] = time;
-	HWC_current_glopsbegin[threadid] = countglops;
+	HWC_THREAD(threadid).current_timebegin = time;
+	HWC_THREAD(threadid).current_glopsbegin = countglops;
 
 	/* Mark this counter set as the current set */
 	HWCEVTSET(threadid) = HWC_sets[numset].eventsets[threadid];
@@ -655,13 +655,13 @@ int HWCBE_PAPI_Init_Thread (UINT64 time, int threadid, int forked)
 		}
 	} /* forked */ 
 
-	HWC_Thread_Initialized[threadid] = HWCBE_PAPI_Start_Set (0, time, HWC_current_set[threadid], threadid);
+	HWC_THREAD(threadid).Initialized = HWCBE_PAPI_Start_Set (0, time, HWC_THREAD(threadid).current_set, threadid);
 
 #if defined(ENABLE_PEBS_SAMPLING)                                               
 	    Extrae_IntelPEBS_startSampling();                                              
 #endif                                                                          
 
-	return HWC_Thread_Initialized[threadid];
+	return HWC_THREAD(threadid).Initialized;
 }
 
 #if defined(IS_BG_MACHINE)
@@ -262,8 +262,8 @@ int HWCBE_PMAPI_Start_Set (UINT64 countglops, UINT64 time, int numset, int threa
 
 	HWC_current_changeat = HWC_sets[numset].change_at;
 	HWC_current_changetype = HWC_sets[numset].change_type;
-	HWC_current_timebegin[threadid] = time;
-	HWC_current_glopsbegin[threadid] = countglops;
+	HWC_THREAD(threadid).current_timebegin = time;
+	HWC_THREAD(threadid).current_glopsbegin = countglops;
 
 	rc = pm_set_program_mythread (&(HWC_sets[numset].pmprog));
 	if (rc != 0)
@@ -347,8 +347,8 @@ int HWCBE_PMAPI_Init_Thread (UINT64 time, int threadid, int forked)
 {
 	UNREFERENCED_PARAMETER(forked);
 
-	HWC_Thread_Initialized[threadid] = HWCBE_PMAPI_Start_Set (0, time, HWC_current_set[threadid], threadid);
-	return HWC_Thread_Initialized[threadid];
+	HWC_THREAD(threadid).Initialized = HWCBE_PMAPI_Start_Set (0, time, HWC_THREAD(threadid).current_set, threadid);
+	return HWC_THREAD(threadid).Initialized;
 }
 
 int HWCBE_PMAPI_Read (unsigned int tid, long long *store_buffer)
@@ -182,6 +182,8 @@ void Bursts::EmitPhase(unsigned long long from, unsigned long long to, bool init
   if (initialize)
     Phase->DumpZeros( from );
   Phase->DumpToTrace( to, dump_hwcs );
+
+  delete Phase;
 }
 
 void Bursts::EmitBursts(unsigned long long local_from, unsigned long long local_to, unsigned long long threshold)
@@ -47,6 +47,7 @@ BurstsExtractor::BurstsExtractor(unsigned long long min_duration, bool sync_time
 BurstsExtractor::~BurstsExtractor()
 {
   delete ExtractedBursts;
+  delete CurrentPhase;
 }
 
 /**
@@ -21,6 +21,7 @@
  *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
 \*****************************************************************************/
 
+#include <pthread.h>
 #include "PhaseStats.h"
 #include "taskid.h"
 #include "utils.h"
@@ -34,6 +35,50 @@
 
 using std::make_pair;
 
+#define PHASE_STATS_POOL_MAX 64
+
+static void *PhaseStatsPool[PHASE_STATS_POOL_MAX];
+static int PhaseStatsPoolSize = 0;
+static pthread_mutex_t PhaseStatsPoolMtx = PTHREAD_MUTEX_INITIALIZER;
+
+void * PhaseStats::operator new(size_t size)
+{
+  void *ptr = NULL;
+
+  if (size == sizeof(PhaseStats))
+  {
+    pthread_mutex_lock(&PhaseStatsPoolMtx);
+    if (PhaseStatsPoolSize > 0)
+    {
+      ptr = PhaseStatsPool[--PhaseStatsPoolSize];
+    }
+    pthread_mutex_unlock(&PhaseStatsPoolMtx);
+  }
+  if (ptr == NULL)
+  {
+    ptr = ::operator new(size);
+  }
+  return ptr;
+}
+
+void PhaseStats::operator delete(void *ptr)
+{
+  if (ptr == NULL) return;
+
+  pthread_mutex_lock(&PhaseStatsPoolMtx);
+  if (PhaseStatsPoolSize < PHASE_STATS_POOL_MAX)
+  {
+    PhaseStatsPool[PhaseStatsPoolSize++] = ptr;
+    ptr = NULL;
+  }
+  pthread_mutex_unlock(&PhaseStatsPoolMtx);
+
+  if (ptr != NULL)
+  {
+    ::operator delete(ptr);
+  }
+}
+
 PhaseStats::PhaseStats(int num_tasks)
 {
   MPI_Stats = mpi_stats_init( num_tasks );
@@ -499,8 +544,8 @@ void PhaseStats::DumpToTrace( unsigned long long timestamp, bool dump_hwcs )
   TRACE_ONLINE_EVENT( timestamp, MPI_STATS_TIME_IN_MPI_EV, MPI_Stats->Elapsed_Time_In_MPI );
   TRACE_ONLINE_EVENT( timestamp, MPI_STATS_P2P_INCOMING_COUNT_EV, MPI_Stats->P2P_Communications_In );
   TRACE_ONLINE_EVENT( timestamp, MPI_STATS_P2P_OUTGOING_COUNT_EV, MPI_Stats->P2P_Communications_Out );
-  TRACE_ONLINE_EVENT( timestamp, MPI_STATS_P2P_INCOMING_PARTNERS_COUNT_EV, mpi_stats_get_num_partners(MPI_Stats, MPI_Stats->P2P_Partner_In) );
-  TRACE_ONLINE_EVENT( timestamp, MPI_STATS_P2P_OUTGOING_PARTNERS_COUNT_EV, mpi_stats_get_num_partners(MPI_Stats, MPI_Stats->P2P_Partner_Out) );
+  TRACE_ONLINE_EVENT( timestamp, MPI_STATS_P2P_INCOMING_PARTNERS_COUNT_EV, mpi_stats_get_num_partners_in(MPI_Stats) );
+  TRACE_ONLINE_EVENT( timestamp, MPI_STATS_P2P_OUTGOING_PARTNERS_COUNT_EV, mpi_stats_get_num_partners_out(MPI_Stats) );
   TRACE_ONLINE_EVENT( timestamp, MPI_STATS_TIME_IN_OTHER_EV, MPI_Stats->Elapsed_Time_In_MPI - MPI_Stats->Elapsed_Time_In_P2P_MPI - MPI_Stats->Elapsed_Time_In_COLLECTIVE_MPI );
   TRACE_ONLINE_EVENT( timestamp, MPI_STATS_TIME_IN_P2P_EV, MPI_Stats->Elapsed_Time_In_P2P_MPI );
   TRACE_ONLINE_EVENT( timestamp, MPI_STATS_TIME_IN_GLOBAL_EV, MPI_Stats->Elapsed_Time_In_COLLECTIVE_MPI );
@@ -24,6 +24,7 @@
 #ifndef __PHASE_STATS_H__
 #define __PHASE_STATS_H__
 
+#include <cstddef>
 #include <map>
 #include <vector>
 #include "mpi_stats.h"
@@ -40,6 +41,10 @@ class PhaseStats
     PhaseStats(int num_tasks);
     ~PhaseStats();
 
+    /* A phase is created per burst, released objects are recycled */
+    static void * operator new(size_t size);
+    static void operator delete(void *ptr);
+
     void UpdateMPI(event_t *MPIBeginEv, event_t *MPIEndEv);
     void UpdateMPI(event_t *SingleMPIEv);
     void Reset();
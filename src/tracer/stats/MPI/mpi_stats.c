@@ -27,36 +27,156 @@
 #ifndef HAVE_STDIO_H
 # include <stdio.h>
 #endif
+#if HAVE_STRING_H
+# include <string.h>
+#endif
+#if HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
 
 #include <mpi.h>
 
+/* Initial number of partners tracked, the index keeps at least twice as many slots */
+#define MPI_STATS_PARTNERS_INITIAL 16
+
+/* Released objects kept for reuse, the online analysis creates one per burst */
+#define MPI_STATS_POOL_MAX 64
+
 mpi_stats_t *global_mpi_stats = NULL;
 
-mpi_stats_t * mpi_stats_init(int num_tasks)
+static mpi_stats_t *mpi_stats_pool = NULL;
+static int mpi_stats_pool_size = 0;
+static pthread_mutex_t mpi_stats_pool_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned mpi_stats_partner_hash(int task, int mask)
 {
-    mpi_stats_t *mpi_stats = NULL;
+    return ((unsigned)task * 2654435761u) & (unsigned)mask;
+}
 
-    mpi_stats = (mpi_stats_t *)malloc(sizeof(mpi_stats_t));
-    if (mpi_stats == NULL)
-    { 
-        fprintf (stderr, PACKAGE_NAME": Error! Unable to get memory for MPI Stats");
-        exit(-1);
+/**
+ * Rebuilds the partners index with twice as many slots.
+ */
+static void mpi_stats_grow_index(mpi_stats_t * mpi_stats)
+{
+    int i, num_slots = 2 * (mpi_stats->P2P_Partners_Index_Mask + 1);
+
+    xfree(mpi_stats->P2P_Partners_Index);
+    xmalloc(mpi_stats->P2P_Partners_Index, num_slots * sizeof(int));
+    memset(mpi_stats->P2P_Partners_Index, 0, num_slots * sizeof(int));
+    mpi_stats->P2P_Partners_Index_Mask = num_slots - 1;
+
+    for (i = 0; i < mpi_stats->P2P_Partners_Count; i++)
+    {
+        unsigned slot = mpi_stats_partner_hash(mpi_stats->P2P_Partners[i].task,
+          mpi_stats->P2P_Partners_Index_Mask);
+
+        while (mpi_stats->P2P_Partners_Index[slot] != 0)
+            slot = (slot + 1) & mpi_stats->P2P_Partners_Index_Mask;
+        mpi_stats->P2P_Partners_Index[slot] = i + 1;
     }
-    mpi_stats->ntasks = num_tasks;
+}
 
-    mpi_stats->P2P_Partner_In = (int *) malloc (mpi_stats->ntasks * sizeof(int));
-    if (mpi_stats->P2P_Partner_In == NULL)
+/**
+ * Returns the counters for the given partner, adding them if the partner was
+ * not touched since the last reset.
+ */
+static mpi_stats_partner_t * mpi_stats_get_partner(mpi_stats_t * mpi_stats, int task)
+{
+    mpi_stats_partner_t *partner = NULL;
+    unsigned slot;
+
+    if (mpi_stats->P2P_Partners_Index == NULL)
+    {
+        mpi_stats->P2P_Partners_Size = MPI_STATS_PARTNERS_INITIAL;
+        xmalloc(mpi_stats->P2P_Partners,
+          mpi_stats->P2P_Partners_Size * sizeof(mpi_stats_partner_t));
+        mpi_stats->P2P_Partners_Index_Mask = MPI_STATS_PARTNERS_INITIAL - 1;
+        mpi_stats_grow_index(mpi_stats);
+    }
+
+    slot = mpi_stats_partner_hash(task, mpi_stats->P2P_Partners_Index_Mask);
+    while (mpi_stats->P2P_Partners_Index[slot] != 0)
     {
-        fprintf (stderr, PACKAGE_NAME": Error! Unable to get memory for MPI Stats");
-        exit(-1);
+        partner = &(mpi_stats->P2P_Partners[mpi_stats->P2P_Partners_Index[slot] - 1]);
+        if (partner->task == task)
+            return partner;
+        slot = (slot + 1) & mpi_stats->P2P_Partners_Index_Mask;
     }
-    mpi_stats->P2P_Partner_Out = (int *) malloc (mpi_stats->ntasks * sizeof(int));
-    if (mpi_stats->P2P_Partner_Out == NULL)
+
+    /* Keep the index at most half full */
+    if (2 * (mpi_stats->P2P_Partners_Count + 1) > mpi_stats->P2P_Partners_Index_Mask + 1)
+    {
+        mpi_stats_grow_index(mpi_stats);
+        slot = mpi_stats_partner_hash(task, mpi_stats->P2P_Partners_Index_Mask);
+        while (mpi_stats->P2P_Partners_Index[slot] != 0)
+            slot = (slot + 1) & mpi_stats->P2P_Partners_Index_Mask;
+    }
+    if (mpi_stats->P2P_Partners_Count == mpi_stats->P2P_Partners_Size)
     {
-        fprintf (stderr, PACKAGE_NAME": Error! Unable to get memory for MPI Stats");
-        exit(-1);
+        mpi_stats->P2P_Partners_Size *= 2;
+        xrealloc(mpi_stats->P2P_Partners, mpi_stats->P2P_Partners,
+          mpi_stats->P2P_Partners_Size * sizeof(mpi_stats_partner_t));
     }
 
+    partner = &(mpi_stats->P2P_Partners[mpi_stats->P2P_Partners_Count]);
+    partner->task = task;
+    partner->in = 0;
+    partner->out = 0;
+    mpi_stats->P2P_Partners_Count ++;
+    mpi_stats->P2P_Partners_Index[slot] = mpi_stats->P2P_Partners_Count;
+
+    return partner;
+}
+
+static void mpi_stats_add_partner(mpi_stats_t * mpi_stats, int task,
+  unsigned long long in, unsigned long long out)
+{
+    mpi_stats_partner_t *partner = mpi_stats_get_partner(mpi_stats, task);
+
+    if (in > 0)
+    {
+        if (partner->in == 0)
+            mpi_stats->P2P_Partners_In ++;
+        partner->in += in;
+    }
+    if (out > 0)
+    {
+        if (partner->out == 0)
+            mpi_stats->P2P_Partners_Out ++;
+        partner->out += out;
+    }
+}
+
+mpi_stats_t * mpi_stats_init(int num_tasks)
+{
+    mpi_stats_t *mpi_stats = NULL;
+
+    pthread_mutex_lock(&mpi_stats_pool_mtx);
+    if (mpi_stats_pool != NULL)
+    {
+        mpi_stats = mpi_stats_pool;
+        mpi_stats_pool = mpi_stats->next_free;
+        mpi_stats_pool_size --;
+    }
+    pthread_mutex_unlock(&mpi_stats_pool_mtx);
+
+    if (mpi_stats == NULL)
+    {
+        mpi_stats = (mpi_stats_t *)malloc(sizeof(mpi_stats_t));
+        if (mpi_stats == NULL)
+        { 
+            fprintf (stderr, PACKAGE_NAME": Error! Unable to get memory for MPI Stats");
+            exit(-1);
+        }
+        mpi_stats->P2P_Partners = NULL;
+        mpi_stats->P2P_Partners_Count = 0;
+        mpi_stats->P2P_Partners_Size = 0;
+        mpi_stats->P2P_Partners_Index = NULL;
+        mpi_stats->P2P_Partners_Index_Mask = 0;
+    }
+    mpi_stats->ntasks = num_tasks;
+    mpi_stats->next_free = NULL;
+
     mpi_stats_reset(mpi_stats);
 
     return mpi_stats;
@@ -83,19 +203,43 @@ void mpi_stats_reset(mpi_stats_t * mpi_stats)
       mpi_stats->Elapsed_Time_In_P2P_MPI = 0;
       mpi_stats->Elapsed_Time_In_COLLECTIVE_MPI = 0;
 
-      for (i = 0; i < mpi_stats->ntasks; i++)
+      /* Only clear the index slots of the touched partners */
+      for (i = 0; i < mpi_stats->P2P_Partners_Count; i++)
       {
-         mpi_stats->P2P_Partner_In[i] = 0;
-         mpi_stats->P2P_Partner_Out[i] = 0;
+         unsigned slot = mpi_stats_partner_hash(mpi_stats->P2P_Partners[i].task,
+           mpi_stats->P2P_Partners_Index_Mask);
+
+         while (mpi_stats->P2P_Partners_Index[slot] != i + 1)
+            slot = (slot + 1) & mpi_stats->P2P_Partners_Index_Mask;
+         mpi_stats->P2P_Partners_Index[slot] = 0;
       }
+      mpi_stats->P2P_Partners_Count = 0;
+      mpi_stats->P2P_Partners_In = 0;
+      mpi_stats->P2P_Partners_Out = 0;
    }
 }
 
 void mpi_stats_free(mpi_stats_t * mpi_stats)
 {
-  xfree(mpi_stats->P2P_Partner_In);
-  xfree(mpi_stats->P2P_Partner_Out);
-  xfree(mpi_stats);
+  if (mpi_stats == NULL)
+    return;
+
+  pthread_mutex_lock(&mpi_stats_pool_mtx);
+  if (mpi_stats_pool_size < MPI_STATS_POOL_MAX)
+  {
+    mpi_stats->next_free = mpi_stats_pool;
+    mpi_stats_pool = mpi_stats;
+    mpi_stats_pool_size ++;
+    mpi_stats = NULL;
+  }
+  pthread_mutex_unlock(&mpi_stats_pool_mtx);
+
+  if (mpi_stats != NULL)
+  {
+    xfree(mpi_stats->P2P_Partners);
+    xfree(mpi_stats->P2P_Partners_Index);
+    xfree(mpi_stats);
+  }
 }
 
 void mpi_stats_sum(mpi_stats_t * base, mpi_stats_t * extra)
@@ -116,10 +260,10 @@ void mpi_stats_sum(mpi_stats_t * base, mpi_stats_t * extra)
     base->P2P_Communications_Out         += extra->P2P_Communications_Out;
     base->Elapsed_Time_In_P2P_MPI        += extra->Elapsed_Time_In_P2P_MPI;
     base->Elapsed_Time_In_COLLECTIVE_MPI += extra->Elapsed_Time_In_COLLECTIVE_MPI;
-    for (i = 0; i < base->ntasks; i++)
+    for (i = 0; i < extra->P2P_Partners_Count; i++)
     {
-      base->P2P_Partner_In[i]  += extra->P2P_Partner_In[i];
-      base->P2P_Partner_Out[i] += extra->P2P_Partner_Out[i];
+      mpi_stats_add_partner(base, extra->P2P_Partners[i].task,
+        extra->P2P_Partners[i].in, extra->P2P_Partners[i].out);
     }
   }
 }
@@ -129,35 +273,32 @@ void updateStats_P2P(mpi_stats_t * mpi_stats, int partner, int inputSize, int ou
    /* Weird cases: MPI_Sendrecv_Fortran_Wrapper */
    if (mpi_stats != NULL)
    {
+      int valid_partner = (partner != MPI_PROC_NULL && partner != MPI_ANY_SOURCE &&
+                           partner != MPI_UNDEFINED);
+
+      if (valid_partner && (partner < 0 || partner >= mpi_stats->ntasks))
+      {
+          fprintf(stderr, "[DEBUG] OUT_OF_RANGE partner=%d/%d\n",
+            partner, mpi_stats->ntasks);
+          valid_partner = FALSE;
+      }
+
       mpi_stats->P2P_Communications ++;
       if (inputSize)
       {    
           mpi_stats->P2P_Bytes_Recv += inputSize;
           mpi_stats->P2P_Communications_In ++;
-          if (partner != MPI_PROC_NULL && partner != MPI_ANY_SOURCE && 
-              partner != MPI_UNDEFINED)
-          {
-              if (partner < mpi_stats->ntasks)
-                  mpi_stats->P2P_Partner_In[partner] ++;
-              else
-                  fprintf(stderr, "[DEBUG] OUT_OF_RANGE partner=%d/%d\n",
-                    partner, mpi_stats->ntasks);
-          }
       }    
       if (outputSize)
       {    
           mpi_stats->P2P_Bytes_Sent += outputSize;
           mpi_stats->P2P_Communications_Out ++;
-          if (partner != MPI_PROC_NULL && partner != MPI_ANY_SOURCE && 
-              partner != MPI_UNDEFINED)
-          {
-              if (partner < mpi_stats->ntasks)
-                  mpi_stats->P2P_Partner_Out[partner] ++;
-              else
-                  fprintf(stderr, "[DEBUG] OUT_OF_RANGE partner=%d/%d\n",
-                    partner, mpi_stats->ntasks);
-          }
       }    
+      if (valid_partner && (inputSize || outputSize))
+      {
+          mpi_stats_add_partner(mpi_stats, partner,
+            (inputSize ? 1 : 0), (outputSize ? 1 : 0));
+      }
    }
 }
 
@@ -179,14 +320,14 @@ void updateStats_OTHER(mpi_stats_t * mpi_stats)
     mpi_stats->MPI_Others_count++;
 }
 
-int mpi_stats_get_num_partners(mpi_stats_t * mpi_stats, int * partners_vector)
+int mpi_stats_get_num_partners_in(mpi_stats_t * mpi_stats)
 {
-    int i, num_partners = 0;
-    for (i = 0; i < mpi_stats->ntasks; i++)
-    {
-        if (partners_vector[i] > 0) num_partners++;
-    }
-    return num_partners;
+    return mpi_stats->P2P_Partners_In;
+}
+
+int mpi_stats_get_num_partners_out(mpi_stats_t * mpi_stats)
+{
+    return mpi_stats->P2P_Partners_Out;
 }
 
 void mpi_stats_update_elapsed_time(mpi_stats_t * mpi_stats, unsigned EvtType, unsigned long long elapsedTime)
@@ -32,25 +32,43 @@
 extern "C" {
 #endif
 
+/* Counters of the point to point communications exchanged with one partner */
+typedef struct mpi_stats_partner_t
+{
+    int task;                      /* Partner rank */
+    unsigned long long in;         /* Communications received from the partner */
+    unsigned long long out;        /* Communications sent to the partner */
+} mpi_stats_partner_t;
+
 typedef struct mpi_stats_t
 {
 /* MPI Stats */
-    int ntasks;             /* Just to create vectors with the proper size */
-    int P2P_Bytes_Sent;      /* Sent bytes by point to point MPI operations */
-    int P2P_Bytes_Recv;      /* Recv bytes by point to point MPI operations */
-    int COLLECTIVE_Bytes_Sent;      /* Sent "bytes" by MPI global operations */
-    int COLLECTIVE_Bytes_Recv;      /* Recv "bytes" by MPI global operations */
-    int P2P_Communications;      /* Number of point to point communications */
-    int COLLECTIVE_Communications;      /* Number of global operations */
-    int MPI_Others_count;      /* Number of global operations */
+    int ntasks;             /* Upper bound for the valid partners */
+    unsigned long long P2P_Bytes_Sent;      /* Sent bytes by point to point MPI operations */
+    unsigned long long P2P_Bytes_Recv;      /* Recv bytes by point to point MPI operations */
+    unsigned long long COLLECTIVE_Bytes_Sent;      /* Sent "bytes" by MPI global operations */
+    unsigned long long COLLECTIVE_Bytes_Recv;      /* Recv "bytes" by MPI global operations */
+    unsigned long long P2P_Communications;      /* Number of point to point communications */
+    unsigned long long COLLECTIVE_Communications;      /* Number of global operations */
+    unsigned long long MPI_Others_count;      /* Number of global operations */
     unsigned long long Elapsed_Time_In_MPI;     /* Elapsed time in MPI */
 
-    int P2P_Communications_In;      /* Number of input communication by point to point MPI operations */
-    int P2P_Communications_Out; /* Number of output communication by point to point MPI operations */
-    int * P2P_Partner_In;              /* Number of partners in */
-    int * P2P_Partner_Out;             /* Nuber of partners out */
+    unsigned long long P2P_Communications_In;      /* Number of input communication by point to point MPI operations */
+    unsigned long long P2P_Communications_Out; /* Number of output communication by point to point MPI operations */
     unsigned long long Elapsed_Time_In_P2P_MPI; /* Time inside P2P MPI calls */
     unsigned long long Elapsed_Time_In_COLLECTIVE_MPI; /* Time inside global MPI calls */
+
+    /* Only the partners actually communicated with are stored, so that the
+     * cost of the statistics does not depend on the number of tasks */
+    mpi_stats_partner_t * P2P_Partners;  /* Touched partners, in order of appearance */
+    int P2P_Partners_Count;              /* Number of touched partners */
+    int P2P_Partners_Size;               /* Allocated entries in P2P_Partners */
+    int * P2P_Partners_Index;            /* Open-addressed partner -> P2P_Partners position + 1 (0 is empty) */
+    int P2P_Partners_Index_Mask;         /* Number of slots in P2P_Partners_Index minus 1 */
+    int P2P_Partners_In;                 /* Number of partners in */
+    int P2P_Partners_Out;                /* Number of partners out */
+
+    struct mpi_stats_t * next_free;      /* Link in the pool of released objects */
 } mpi_stats_t;
 
 extern mpi_stats_t *global_mpi_stats;
@@ -62,7 +80,8 @@ void mpi_stats_sum(mpi_stats_t * base, mpi_stats_t * extra);
 void updateStats_P2P(mpi_stats_t * mpi_stats, int partner, int inputSize, int outputSize);
 void updateStats_COLLECTIVE(mpi_stats_t * mpi_stats, int inputSize, int outputSize);
 void updateStats_OTHER(mpi_stats_t * mpi_stats);
-int mpi_stats_get_num_partners(mpi_stats_t * mpi_stats, int * partners_vector);
+int mpi_stats_get_num_partners_in(mpi_stats_t * mpi_stats);
+int mpi_stats_get_num_partners_out(mpi_stats_t * mpi_stats);
 void mpi_stats_update_elapsed_time(mpi_stats_t * mpi_stats, unsigned EvtType, unsigned long long elapsedTime);
 
 
@@ -52,18 +52,44 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_ERRNO_H
+# include <errno.h>
+#endif
 
 #include "buffers.h"
+#include "mpit_header.h"
+#include "mpit_events.h"
+
+/* Asynchronous flushes write one half of the buffer through POSIX AIO while
+   the owner keeps inserting into the other half. The on-line analysis needs
+   to filter the events through the masks at flush time, so it keeps the
+   synchronous flushes. */
+#if defined(HAVE_AIO_H) && defined(HAVE_LIO_LISTIO) && defined(LOCKLESS_INSERT) && !defined(HAVE_ONLINE)
+# define ASYNC_FLUSH 1
+# include <aio.h>
+#endif
 #include "utils.h"
 
 #define EVENT_INDEX(buffer, event) (event - Buffer_GetFirst(buffer))
 #define ALL_BITS_SET 0xFFFFFFFF
 
+/* FillCount is the only field shared between the owner (producer) and
+   whoever is draining the buffer (consumer). The atomic builtins act as full
+   barriers, so the event contents are published before the count grows. */
+#if defined(LOCKLESS_INSERT)
+# define FILLCOUNT_ADD(buffer,n) __sync_fetch_and_add (&((buffer)->FillCount), (n))
+# define FILLCOUNT_SUB(buffer,n) __sync_fetch_and_sub (&((buffer)->FillCount), (n))
+#else
+# define FILLCOUNT_ADD(buffer,n) ((buffer)->FillCount += (n))
+# define FILLCOUNT_SUB(buffer,n) ((buffer)->FillCount -= (n))
+#endif
+
 /* Forward declarations */
 static void Mask_ChangeRegion (Buffer_t *buffer, event_t *start, event_t *end, int mask_id, int set);
 static int Mask_Get (Buffer_t *buffer, event_t *event, int mask_id);
 
 static void dump_buffer (int fd, int n_blocks, struct iovec *blocks);
+static void dump_events (Buffer_t *buffer, int n_blocks, struct iovec *blocks);
 
 static DataBlocks_t * new_DataBlocks (Buffer_t *buffer);
 #if !defined(ARCH_SPARC64)
@@ -72,7 +98,46 @@ static void DataBlocks_Add (DataBlocks_t *blocks, void *ini_address, void *end_a
 #endif
 static void DataBlocks_Free (DataBlocks_t *blocks);
 
+static void Buffer_AcquireToken (Buffer_t *buffer);
+static void Buffer_ReleaseToken (Buffer_t *buffer);
+static void Buffer_InsertOwned (Buffer_t *buffer, event_t *new_event);
+static void Buffer_DumpHandoff (Buffer_t *buffer);
+#if defined(LOCKLESS_INSERT)
+static void Buffer_BeginInsert (Buffer_t *buffer);
+static void Buffer_EndInsert (Buffer_t *buffer);
+static void Buffer_AttendRequests (Buffer_t *buffer, event_t *new_event);
+#endif
+#if defined(ASYNC_FLUSH)
+static void Buffer_AsyncProgress (Buffer_t *buffer);
+#endif
+static void Buffer_AsyncComplete (Buffer_t *buffer);
+static void Buffer_AsyncFree (Buffer_t *buffer);
+static void TimeIndex_Insert (Buffer_t *buffer, event_t *event);
+static void TimeIndex_Free (Buffer_t *buffer);
+static Buffer_t * Buffer_New (int n_events, char *file, int enable_cache);
+
+/* Events are encoded and written in blocks of this many events */
+#define ENCODE_CHUNK 1024
+
 Buffer_t * new_Buffer (int n_events, char *file, int enable_cache)
+{
+	Buffer_t *buffer = Buffer_New (n_events, file, enable_cache);
+
+	/* Once the cache has opened (and truncated) the same file, tell the
+	   merger how the events are encoded */
+	if (buffer->fd != -1)
+	{
+		MPIT_Header_t header;
+
+		MPIT_Header_Init (&header);
+		MPIT_Header_Write (buffer->fd, &header);
+		lseek (buffer->fd, 0, SEEK_END);
+	}
+
+	return buffer;
+}
+
+static Buffer_t * Buffer_New (int n_events, char *file, int enable_cache)
 {
 	Buffer_t *buffer = NULL;
 #if defined(HAVE_ONLINE)
@@ -141,6 +206,11 @@ Buffer_t * new_Buffer (int n_events, char *file, int enable_cache)
 #endif
 #endif
 
+	buffer->Paused = FALSE;
+	buffer->Inserting = FALSE;
+	buffer->ExclusiveToken = 0;
+	buffer->NumHandoffEvents = 0;
+
 	xmalloc(buffer->Masks, n_events * sizeof(Mask_t));
 	Mask_Wipe(buffer);
 
@@ -150,9 +220,12 @@ Buffer_t * new_Buffer (int n_events, char *file, int enable_cache)
 	buffer->NumberOfCachedEvents = 0;
 	buffer->CachedEvents         = NULL;
 	buffer->VictimCache          = NULL;
+	buffer->Async                = NULL;
+	buffer->Encoded              = NULL;
+	buffer->Index                = NULL;
 	if (enable_cache)
 	{
-		buffer->VictimCache = new_Buffer(BUFFER_CACHE_SIZE, file, 0);
+		buffer->VictimCache = Buffer_New(BUFFER_CACHE_SIZE, file, 0);
 	}
 
 	return buffer;
@@ -169,6 +242,11 @@ void Buffer_Free (Buffer_t *buffer)
 		xfree (buffer->Masks);
 
                 xfree (buffer->CachedEvents);
+                /* Do not wait for pending requests here, after a fork they
+                   belong to the parent process */
+                Buffer_AsyncFree (buffer);
+                xfree (buffer->Encoded);
+                TimeIndex_Free (buffer);
                 if (buffer->VictimCache != NULL)
 		{
 			Buffer_Free(buffer->VictimCache);
@@ -274,6 +352,11 @@ void Buffer_Close (Buffer_t *buffer)
 {
 	if (buffer->fd != -1)
 	{
+		Buffer_AcquireToken (buffer);
+		Buffer_AsyncComplete (buffer);
+		Buffer_DumpHandoff (buffer);
+		Buffer_ReleaseToken (buffer);
+
 		Buffer_FlushCache(buffer);
 		close(buffer->fd);
 	}
@@ -357,6 +440,15 @@ void Buffer_Lock (Buffer_t *buffer)
 {
 #if defined(HAVE_ONLINE)
 	pthread_mutex_lock(&(buffer->Lock));
+# if defined(LOCKLESS_INSERT)
+	/* Make the owner leave the lock-free path and block on the mutex, and
+	   wait until it is done with the insertion in flight (if any) */
+	__sync_lock_test_and_set (&(buffer->Paused), TRUE);
+	__sync_synchronize();
+	while (buffer->Inserting);
+# else
+	buffer->Paused = TRUE;
+# endif
 #else
 	UNREFERENCED_PARAMETER(buffer);
 #endif
@@ -365,12 +457,50 @@ void Buffer_Lock (Buffer_t *buffer)
 void Buffer_Unlock (Buffer_t *buffer)
 {
 #if defined(HAVE_ONLINE)
+	buffer->Paused = FALSE;
 	pthread_mutex_unlock(&(buffer->Lock));
 #else
 	UNREFERENCED_PARAMETER(buffer);
 #endif
 }
 
+/**
+ * Grants exclusive access to the parts of the buffer that are not owned by
+ * the producer (HeadEvt and the handoff area). The owner thread only needs
+ * the token when the buffer is full or when it has pending requests.
+ */
+static void Buffer_AcquireToken (Buffer_t *buffer)
+{
+#if defined(LOCKLESS_INSERT)
+	while (!__sync_bool_compare_and_swap (&(buffer->ExclusiveToken), 0, 1))
+		while (buffer->ExclusiveToken);
+#else
+	UNREFERENCED_PARAMETER(buffer);
+#endif
+}
+
+static void Buffer_ReleaseToken (Buffer_t *buffer)
+{
+#if defined(LOCKLESS_INSERT)
+	__sync_lock_release (&(buffer->ExclusiveToken));
+#else
+	UNREFERENCED_PARAMETER(buffer);
+#endif
+}
+
+/**
+ * Number of events ready to be consumed. Events counted here are guaranteed
+ * to be completely written by the owner thread.
+ */
+static int Buffer_GetPublishedCount (Buffer_t *buffer)
+{
+	int count = buffer->FillCount;
+#if defined(LOCKLESS_INSERT)
+	__sync_synchronize();
+#endif
+	return count;
+}
+
 /*
 	writev_wrapper
 	writev can be interrupted in BG systems. We build this wrapper to emulate the
@@ -389,7 +519,7 @@ static ssize_t writev_wrapper (int fd, const struct iovec *iov, int iovcnt)
 		while (tmp < iov->iov_len)
 		{
 			written = write (fd,
-				(const void *)((int *)(iov->iov_base) + tmp), iov->iov_len - tmp);
+				(const void *)((char *)(iov->iov_base) + tmp), iov->iov_len - tmp);
 
 			if (written < 0)  
 				return written;
@@ -435,6 +565,40 @@ static void dump_buffer (int fd, int n_blocks, struct iovec *blocks)
 #endif
 }
 
+/**
+ * Encodes the events of the given blocks (see mpit_events.h) and appends
+ * them to the file of the buffer.
+ * \param buffer The buffer the events belong to
+ * \param n_blocks Number of blocks
+ * \param blocks Blocks of contiguous events
+ */
+static void dump_events (Buffer_t *buffer, int n_blocks, struct iovec *blocks)
+{
+	struct iovec encoded;
+	int i;
+
+	if (buffer->Encoded == NULL)
+		xmalloc (buffer->Encoded, MPIT_BLOCK_MAX_SIZE(ENCODE_CHUNK));
+
+	for (i = 0; i < n_blocks; i++)
+	{
+		event_t *events = (event_t *) blocks[i].iov_base;
+		unsigned remaining = blocks[i].iov_len / sizeof(event_t);
+
+		while (remaining > 0)
+		{
+			unsigned n = MIN(remaining, ENCODE_CHUNK);
+
+			encoded.iov_base = buffer->Encoded;
+			encoded.iov_len  = MPIT_Events_Encode (events, n, buffer->Encoded);
+			dump_buffer (buffer->fd, 1, &encoded);
+
+			events += n;
+			remaining -= n;
+		}
+	}
+}
+
 void Buffer_InsertMultiple(Buffer_t *buffer, event_t *events_list, int num_events)
 {
 	int i, retry = num_events;
@@ -458,29 +622,177 @@ void Buffer_InsertMultiple(Buffer_t *buffer, event_t *events_list, int num_event
 	}
 }
 
+/**
+ * Inserts an event from the thread that owns the buffer. No lock is taken
+ * unless the buffer fills up or another thread requested our attention.
+ * \param buffer The buffer owned by the calling thread
+ * \param new_event The event to be copied into the buffer
+ */
 void Buffer_InsertSingle(Buffer_t *buffer, event_t *new_event)
 {
 #if defined(LOCK_AT_INSERT)
 	Buffer_Lock (buffer);
+	Buffer_InsertOwned (buffer, new_event);
+	Buffer_Unlock (buffer);
+#elif defined(LOCKLESS_INSERT)
+	/* Events emitted while flushing within the insertion in flight */
+	if (buffer->Inserting)
+	{
+		Buffer_InsertOwned (buffer, new_event);
+		return;
+	}
+
+	Buffer_BeginInsert (buffer);
+	if (buffer->NumHandoffEvents > 0)
+		Buffer_AttendRequests (buffer, new_event);
+	else
+		Buffer_InsertOwned (buffer, new_event);
+	Buffer_EndInsert (buffer);
 #endif
+}
 
+static void Buffer_InsertOwned (Buffer_t *buffer, event_t *new_event)
+{
 	if (Buffer_IsFull (buffer))
 	{
 		int rc;
 		rc = Buffer_ExecuteFlushCallback (buffer);
-		if (rc == 0) return;
+		if ((rc == 0) || (Buffer_IsFull (buffer))) return;
 	}
 
 	/* Insert new event */
 	memcpy(buffer->CurEvt, new_event, sizeof(event_t));
 	Mask_UnsetAll (buffer, buffer->CurEvt);
+	if (buffer->Index != NULL)
+		TimeIndex_Insert (buffer, buffer->CurEvt);
 
-	/* Move tail forwards */
+	/* Move tail forwards and publish the event */
 	buffer->CurEvt = Buffer_GetNext(buffer, buffer->CurEvt);
-	buffer->FillCount ++;
+	FILLCOUNT_ADD(buffer, 1);
 
-#if defined(LOCK_AT_INSERT)
-	Buffer_Unlock (buffer);
+#if defined(ASYNC_FLUSH)
+	if (buffer->Async != NULL)
+		Buffer_AsyncProgress (buffer);
+#endif
+}
+
+#if defined(LOCKLESS_INSERT)
+/**
+ * Announces that the owner thread is inserting, so that Buffer_Lock waits
+ * for the insertion to end. While the on-line analysis keeps the application
+ * paused, the owner withdraws the announcement and waits on the mutex.
+ * \param buffer The buffer owned by the calling thread
+ */
+static void Buffer_BeginInsert (Buffer_t *buffer)
+{
+# if defined(HAVE_ONLINE)
+	buffer->Inserting = TRUE;
+	__sync_synchronize();
+	while (buffer->Paused)
+	{
+		buffer->Inserting = FALSE;
+		pthread_mutex_lock (&(buffer->Lock));
+		pthread_mutex_unlock (&(buffer->Lock));
+		buffer->Inserting = TRUE;
+		__sync_synchronize();
+	}
+# else
+	UNREFERENCED_PARAMETER(buffer);
+# endif
+}
+
+static void Buffer_EndInsert (Buffer_t *buffer)
+{
+# if defined(HAVE_ONLINE)
+	__sync_lock_release (&(buffer->Inserting));
+# else
+	UNREFERENCED_PARAMETER(buffer);
+# endif
+}
+
+/**
+ * Slow path of the owner thread. Moves the events other threads handed off
+ * to us into the buffer, the ones that happened earlier before the new event.
+ * They keep their time, so they may be older than the last events inserted;
+ * the merger puts them back in order.
+ * \param buffer The buffer owned by the calling thread
+ * \param new_event The event the owner is inserting
+ */
+static void Buffer_AttendRequests (Buffer_t *buffer, event_t *new_event)
+{
+	event_t pending[BUFFER_HANDOFF_SIZE];
+	int i, num_pending;
+
+	/* Copy them out first, inserting may trigger a flush that needs the token */
+	Buffer_AcquireToken (buffer);
+	num_pending = buffer->NumHandoffEvents;
+	memcpy (pending, buffer->HandoffEvents, num_pending * sizeof(event_t));
+	buffer->NumHandoffEvents = 0;
+	Buffer_ReleaseToken (buffer);
+
+	for (i = 0; i < num_pending && pending[i].time <= Get_EvTime(new_event); i++)
+		Buffer_InsertOwned (buffer, &pending[i]);
+
+	Buffer_InsertOwned (buffer, new_event);
+
+	for (; i < num_pending; i++)
+		Buffer_InsertOwned (buffer, &pending[i]);
+}
+#endif
+
+/**
+ * Writes the events handed off by other threads straight to the file, after
+ * the events already written. Must be called with the exclusive token held.
+ */
+static void Buffer_DumpHandoff (Buffer_t *buffer)
+{
+	struct iovec block;
+
+	if ((buffer->NumHandoffEvents > 0) && (!Buffer_IsClosed(buffer)))
+	{
+		/* The end of the file is only known once the write in flight is done */
+		Buffer_AsyncComplete (buffer);
+
+		block.iov_base = buffer->HandoffEvents;
+		block.iov_len  = buffer->NumHandoffEvents * sizeof(event_t);
+
+		lseek (buffer->fd, 0, SEEK_END);
+		dump_events (buffer, 1, &block);
+	}
+	buffer->NumHandoffEvents = 0;
+}
+
+/**
+ * Inserts an event into a buffer owned by a different thread (e.g. the
+ * flush events emitted when flushing on behalf of another thread). The event
+ * is parked in the handoff area and the owner moves it into the buffer on
+ * its next insertion. If the owner never shows up again, the events are
+ * written when the handoff area fills up or when the buffer is closed.
+ * \param buffer A buffer owned by another thread
+ * \param new_event The event to be handed off
+ */
+void Buffer_HandoffSingle(Buffer_t *buffer, event_t *new_event)
+{
+#if defined(LOCKLESS_INSERT)
+	Buffer_AcquireToken (buffer);
+
+	if (buffer->NumHandoffEvents == BUFFER_HANDOFF_SIZE)
+	{
+		/* Write the events of the owner first, so that the ones handed off
+		   go after them in the file */
+		Buffer_ReleaseToken (buffer);
+		Buffer_Flush (buffer);
+		Buffer_AcquireToken (buffer);
+		if (buffer->NumHandoffEvents == BUFFER_HANDOFF_SIZE)
+			Buffer_DumpHandoff (buffer);
+	}
+
+	memcpy (&(buffer->HandoffEvents[buffer->NumHandoffEvents]), new_event, sizeof(event_t));
+	__sync_fetch_and_add (&(buffer->NumHandoffEvents), 1);
+
+	Buffer_ReleaseToken (buffer);
+#else
+	Buffer_InsertSingle (buffer, new_event);
 #endif
 }
 
@@ -490,17 +802,25 @@ int Buffer_Flush(Buffer_t *buffer)
 	event_t *head = NULL, *tail = NULL;
 	int num_flushed, overflow;
 #if defined(ARCH_SPARC64)
-	ssize_t r;
+	struct iovec block;
 #endif
 
+	Buffer_AcquireToken (buffer);
+
+	/* Both halves are full (or somebody explicitly asked for a flush), wait
+	   for the asynchronous write and dump the rest synchronously */
+	Buffer_AsyncComplete (buffer);
+
 	if ((Buffer_IsEmpty(buffer)) || (Buffer_IsClosed(buffer))) 
 	{
+		Buffer_ReleaseToken (buffer);
+		DataBlocks_Free (db);
 		return 0;
 	}
 
 	head = Buffer_GetHead(buffer);
 	tail = head;
-	num_flushed = Buffer_GetFillCount(buffer);
+	num_flushed = Buffer_GetPublishedCount(buffer);
 	CIRCULAR_STEP (tail, num_flushed, buffer->FirstEvt, buffer->LastEvt, &overflow);
 
 #if !defined(ARCH_SPARC64)
@@ -519,23 +839,26 @@ int Buffer_Flush(Buffer_t *buffer)
         lseek(buffer->fd, 0, SEEK_END);
 
 	/* Write to disk */
-	dump_buffer (buffer->fd, db->NumBlocks, db->BlocksList);
+	dump_events (buffer, db->NumBlocks, db->BlocksList);
 
 	/* Free resources */
 	DataBlocks_Free(db);
 
 #else /* ARCH_SPARC64 */
 
-	r = write (buffer->fd, head, buffer->FillCount*sizeof(event_t));
-	if (r != buffer->FillCount*sizeof(event_t))
-		fprintf (stderr, "ERROR! Wrote %ld bytes instead of %ld bytes\n", r, buffer->FillCount*sizeof(event_t));
+	block.iov_base = head;
+	block.iov_len  = buffer->FillCount*sizeof(event_t);
+	dump_events (buffer, 1, &block);
 
 #endif
 
 	//Do not call DiscardAll. This allows one thread to flush another thread's buffer that is not locked.
 	//Buffer_DiscardAll(buffer);
-    buffer->FillCount -= num_flushed;
-    buffer->HeadEvt = tail;
+	/* Only release the slots once the head has moved */
+	buffer->HeadEvt = tail;
+	FILLCOUNT_SUB(buffer, num_flushed);
+
+	Buffer_ReleaseToken (buffer);
 
 	return 1;
 }
@@ -544,6 +867,11 @@ int Buffer_FlushCache(Buffer_t *buffer)
 {
   if ((buffer != NULL) && (buffer->VictimCache != NULL))
   {
+    /* The cache appends to the same file, wait for our write in flight */
+    Buffer_AcquireToken (buffer);
+    Buffer_AsyncComplete (buffer);
+    Buffer_ReleaseToken (buffer);
+
     return Buffer_Flush(buffer->VictimCache);
   }
   return 0;
@@ -589,12 +917,16 @@ int Buffer_DiscardOldest (Buffer_t *buffer)
 {
     event_t *old_head = NULL, *new_head = NULL;
 
+    Buffer_AcquireToken (buffer);
+
     old_head = buffer->HeadEvt;
     Buffer_CacheEvent(buffer, old_head);
 
     new_head = Buffer_GetNext(buffer, buffer->HeadEvt);
-    buffer->FillCount --;
     buffer->HeadEvt = new_head;
+    FILLCOUNT_SUB(buffer, 1);
+
+    Buffer_ReleaseToken (buffer);
 
     return 1;
 }
@@ -604,6 +936,8 @@ int Buffer_Discard10Pct (Buffer_t *buffer)
     event_t *head = NULL, *last = NULL;
     int pct10 = buffer->MaxEvents * 0.1;
 
+    Buffer_AcquireToken (buffer);
+
     head = buffer->HeadEvt;
     last = buffer->LastEvt;
 
@@ -613,18 +947,438 @@ int Buffer_Discard10Pct (Buffer_t *buffer)
         head = buffer->FirstEvt + (head - last);
     }
 
-    buffer->FillCount -= pct10;
     buffer->HeadEvt = head;
+    FILLCOUNT_SUB(buffer, pct10);
+
+    Buffer_ReleaseToken (buffer);
 
 	return 1;
 }
 
 int Buffer_DiscardAll (Buffer_t *buffer)
 {
-	buffer->FillCount = 0;
-	buffer->HeadEvt = buffer->CurEvt;
+	int num_discarded, overflow;
+
+	Buffer_AcquireToken (buffer);
+
+	/* CurEvt may be moving if the owner is still inserting */
+	num_discarded = Buffer_GetPublishedCount (buffer);
+	CIRCULAR_STEP (buffer->HeadEvt, num_discarded, buffer->FirstEvt, buffer->LastEvt, &overflow);
+	FILLCOUNT_SUB(buffer, num_discarded);
+
+	Buffer_ReleaseToken (buffer);
+
+	return 1;
+}
+
+/***************************************************************************/
+/***************************************************************************/
+/*********************    A S Y N C   F L U S H E S    *********************/
+/***************************************************************************/
+/***************************************************************************/
+
+#if defined(ASYNC_FLUSH)
+struct AsyncFlush
+{
+	int InFlight;
+	int NumRequests;
+	struct aiocb Requests[1];  /* Both ends of a wrapped half go in one request */
+	event_t *NewHead;          /* Head of the buffer once the requests complete */
+	int NumEvents;             /* Slots released once the requests complete */
+	unsigned char *Encoded;    /* Encoded events being written */
+	size_t EncodedSize;
+};
+
+/**
+ * Starts writing asynchronously all the events published in the buffer.
+ * Must be called with the exclusive token held.
+ */
+static void Buffer_AsyncStart (Buffer_t *buffer)
+{
+	struct AsyncFlush *async = buffer->Async;
+	struct aiocb *list[1];
+	event_t *head, *tail;
+	off_t offset;
+	size_t needed;
+	int num_events, overflow;
+
+	num_events = Buffer_GetPublishedCount (buffer);
+	if ((num_events == 0) || (Buffer_IsClosed(buffer)))
+		return;
+
+	head = Buffer_GetHead (buffer);
+	tail = head;
+	CIRCULAR_STEP (tail, num_events, buffer->FirstEvt, buffer->LastEvt, &overflow);
 
+	/* The events are encoded (in one block, or two if they wrap around the
+	   end of the buffer) and written in a single request */
+	needed = MPIT_BLOCK_MAX_SIZE(num_events) + sizeof(MPIT_Block_t);
+	if (async->EncodedSize < needed)
+	{
+		xrealloc (async->Encoded, async->Encoded, needed);
+		async->EncodedSize = needed;
+	}
+
+	memset (async->Requests, 0, sizeof(async->Requests));
+	if (head < tail)
+	{
+		async->Requests[0].aio_nbytes = MPIT_Events_Encode (head, tail - head,
+		  async->Encoded);
+	}
+	else
+	{
+		async->Requests[0].aio_nbytes = MPIT_Events_Encode (head,
+		  buffer->LastEvt - head, async->Encoded);
+		async->Requests[0].aio_nbytes += MPIT_Events_Encode (buffer->FirstEvt,
+		  tail - buffer->FirstEvt, async->Encoded + async->Requests[0].aio_nbytes);
+	}
+	async->NumRequests = 1;
+
+	/* Only one request is in flight at a time, and every synchronous write
+	   to this file (flushes, handed off events, the cache) completes it
+	   first, so the end of the file is where these events go */
+	offset = lseek (buffer->fd, 0, SEEK_END);
+	async->Requests[0].aio_buf    = async->Encoded;
+	async->Requests[0].aio_fildes = buffer->fd;
+	async->Requests[0].aio_offset = offset;
+	async->Requests[0].aio_lio_opcode = LIO_WRITE;
+	async->Requests[0].aio_sigevent.sigev_notify = SIGEV_NONE;
+	list[0] = &(async->Requests[0]);
+
+	/* If the request cannot be queued, the next synchronous flush will
+	   write (and encode again) these events */
+	if (lio_listio (LIO_NOWAIT, list, async->NumRequests, NULL) == 0)
+	{
+		async->NewHead   = tail;
+		async->NumEvents = num_events;
+		async->InFlight  = TRUE;
+	}
+	else
+	{
+		/* The request may have been queued anyway, let it finish */
+		while (aio_error (list[0]) == EINPROGRESS)
+			aio_suspend ((const struct aiocb * const *) &list[0], 1, NULL);
+	}
+}
+
+static int Buffer_AsyncDone (struct AsyncFlush *async)
+{
+	int i;
+
+	for (i = 0; i < async->NumRequests; i++)
+		if (aio_error (&(async->Requests[i])) == EINPROGRESS)
+			return FALSE;
+	return TRUE;
+}
+
+/**
+ * Called by the owner after every insertion. Releases the half that has been
+ * written, and starts writing the current half once it fills up.
+ */
+static void Buffer_AsyncProgress (Buffer_t *buffer)
+{
+	struct AsyncFlush *async = buffer->Async;
+
+	if (async->InFlight)
+	{
+		if (Buffer_AsyncDone (async))
+		{
+			Buffer_AcquireToken (buffer);
+			Buffer_AsyncComplete (buffer);
+			Buffer_ReleaseToken (buffer);
+		}
+	}
+	else if (buffer->FillCount >= buffer->MaxEvents / 2)
+	{
+		Buffer_AcquireToken (buffer);
+		if (!async->InFlight)
+			Buffer_AsyncStart (buffer);
+		Buffer_ReleaseToken (buffer);
+	}
+}
+#endif /* ASYNC_FLUSH */
+
+/**
+ * Waits for the asynchronous write in flight (if any) and releases the
+ * events it contained. Must be called with the exclusive token held.
+ */
+static void Buffer_AsyncComplete (Buffer_t *buffer)
+{
+#if defined(ASYNC_FLUSH)
+	struct AsyncFlush *async = buffer->Async;
+	int i;
+
+	if ((async == NULL) || (!async->InFlight))
+		return;
+
+	for (i = 0; i < async->NumRequests; i++)
+	{
+		struct aiocb *req = &(async->Requests[i]);
+		ssize_t written;
+
+		while (aio_error (req) == EINPROGRESS)
+			aio_suspend ((const struct aiocb * const *) &req, 1, NULL);
+
+		written = aio_return (req);
+		if (written < 0)
+		{
+			fprintf(stderr, "Buffer_AsyncComplete: Error writing to disk.\n");
+			perror("aio_write");
+			exit(1);
+		}
+		else if ((size_t) written < req->aio_nbytes)
+		{
+			/* Short write, complete it synchronously */
+			struct iovec rest;
+
+			rest.iov_base = (char *) req->aio_buf + written;
+			rest.iov_len  = req->aio_nbytes - written;
+			lseek (buffer->fd, req->aio_offset + written, SEEK_SET);
+			dump_buffer (buffer->fd, 1, &rest);
+		}
+	}
+
+	buffer->HeadEvt = async->NewHead;
+	FILLCOUNT_SUB(buffer, async->NumEvents);
+	async->InFlight = FALSE;
+#else
+	UNREFERENCED_PARAMETER(buffer);
+#endif
+}
+
+/**
+ * Releases the asynchronous flush state of the buffer. Requests in flight
+ * are not waited for, after a fork they belong to the parent process.
+ */
+static void Buffer_AsyncFree (Buffer_t *buffer)
+{
+#if defined(ASYNC_FLUSH)
+	if (buffer->Async != NULL)
+	{
+		xfree (buffer->Async->Encoded);
+	}
+#endif
+	xfree (buffer->Async);
+}
+
+/**
+ * Makes the buffer write each half asynchronously as soon as it fills up,
+ * so that the owner only blocks in a flush when both halves are full.
+ * \param buffer The buffer
+ * \return 1 if asynchronous flushes are supported, 0 otherwise
+ */
+int Buffer_EnableAsyncFlush (Buffer_t *buffer)
+{
+#if defined(ASYNC_FLUSH)
+	if (buffer->Async == NULL)
+	{
+		xmalloc (buffer->Async, sizeof(struct AsyncFlush));
+		memset (buffer->Async, 0, sizeof(struct AsyncFlush));
+		buffer->Async->InFlight = FALSE;
+	}
 	return 1;
+#else
+	UNREFERENCED_PARAMETER(buffer);
+	return 0;
+#endif
+}
+
+/***************************************************************************/
+/***************************************************************************/
+/*********************     T I M E   I N D E X     *************************/
+/***************************************************************************/
+/***************************************************************************/
+
+/* One checkpoint every TIME_INDEX_STRIDE slots of the buffer (power of 2) */
+#define TIME_INDEX_STRIDE 256
+
+/* The events of a buffer are mostly, but not strictly, sorted by time (e.g.
+   events handed off by other threads, or emitted with an earlier timestamp).
+   Instead of the time of the event in the slot, every checkpoint keeps two
+   bounds that stay monotonic along the insertion order, so that the binary
+   searches give the same bounds as the linear scans. */
+struct TimeIndex
+{
+	int NumCheckpoints;
+	int Newest;                /* Checkpoint of the latest event inserted */
+	UINT64 MaxTime;            /* Latest time inserted so far */
+	UINT64 *Before;            /* Latest time inserted before the checkpoint slot */
+	UINT64 *After;             /* Earliest time inserted from the checkpoint slot on */
+};
+
+/**
+ * Updates the checkpoints with an event just copied into the buffer. Called
+ * by the owner with every insertion once the index is enabled.
+ * \param buffer The buffer
+ * \param event The slot of the new event
+ */
+static void TimeIndex_Insert (Buffer_t *buffer, event_t *event)
+{
+	struct TimeIndex *index = buffer->Index;
+	int slot = EVENT_INDEX(buffer, event);
+	UINT64 time = Get_EvTime(event);
+	int i, n;
+
+	if ((slot & (TIME_INDEX_STRIDE-1)) == 0)
+	{
+		index->Newest = slot / TIME_INDEX_STRIDE;
+		index->Before[index->Newest] = index->MaxTime;
+		index->After[index->Newest] = time;
+	}
+
+	/* Lower the checkpoints that did not expect such an early event. Usually
+	   none, the loop stops at the first checkpoint that is already earlier */
+	for (i = index->Newest, n = 0;
+	     n < index->NumCheckpoints && index->After[i] > time;
+	     i = (i == 0 ? index->NumCheckpoints : i) - 1, n++)
+		index->After[i] = time;
+
+	if (time > index->MaxTime)
+		index->MaxTime = time;
+}
+
+static void TimeIndex_Free (Buffer_t *buffer)
+{
+	if (buffer->Index != NULL)
+	{
+		xfree (buffer->Index->Before);
+		xfree (buffer->Index->After);
+	}
+	xfree (buffer->Index);
+}
+
+/**
+ * Makes the buffer keep a checkpoint every TIME_INDEX_STRIDE events, so that
+ * range iterators are created with a binary search instead of walking the
+ * buffer. The events already in the buffer are indexed too.
+ * \param buffer The buffer
+ */
+void Buffer_EnableTimeIndex (Buffer_t *buffer)
+{
+	struct TimeIndex *index;
+	event_t *current;
+	int i, count;
+
+	if (buffer->Index != NULL)
+		return;
+
+	xmalloc (index, sizeof(struct TimeIndex));
+	index->NumCheckpoints = (buffer->MaxEvents + TIME_INDEX_STRIDE - 1) / TIME_INDEX_STRIDE;
+	index->Newest = 0;
+	index->MaxTime = 0;
+	xmalloc (index->Before, index->NumCheckpoints * sizeof(UINT64));
+	xmalloc (index->After, index->NumCheckpoints * sizeof(UINT64));
+	memset (index->Before, 0, index->NumCheckpoints * sizeof(UINT64));
+	memset (index->After, 0, index->NumCheckpoints * sizeof(UINT64));
+	buffer->Index = index;
+
+	Buffer_AcquireToken (buffer);
+	current = Buffer_GetHead (buffer);
+	count = Buffer_GetPublishedCount (buffer);
+	for (i = 0; i < count; i++)
+	{
+		TimeIndex_Insert (buffer, current);
+		current = Buffer_GetNext (buffer, current);
+	}
+	Buffer_ReleaseToken (buffer);
+}
+
+/**
+ * Returns the event 'pos' events after the head of the buffer
+ */
+static event_t * TimeIndex_EventAt (Buffer_t *buffer, int head, int pos)
+{
+	return buffer->FirstEvt + (head + pos) % buffer->MaxEvents;
+}
+
+/**
+ * Returns how many events after the head of the buffer the slot of the i-th
+ * checkpoint (counting from the first one after the head) lies
+ */
+static int TimeIndex_CheckpointPos (Buffer_t *buffer, int first, int head, int i)
+{
+	int slot = ((first + i) % buffer->Index->NumCheckpoints) * TIME_INDEX_STRIDE;
+	return (slot - head + buffer->MaxEvents) % buffer->MaxEvents;
+}
+
+/**
+ * Finds the first event at or after start_time, and the last event at or
+ * before end_time, with a binary search over the checkpoints within the
+ * events in the buffer. The result is the same as walking the buffer from
+ * both ends.
+ * \return TRUE if both bounds were found
+ */
+static int TimeIndex_FindRange (Buffer_t *buffer, unsigned long long start_time,
+	unsigned long long end_time, event_t **start_bound, event_t **end_bound)
+{
+	struct TimeIndex *index = buffer->Index;
+	int head = EVENT_INDEX(buffer, Buffer_GetHead(buffer));
+	int count = EVENT_INDEX(buffer, Buffer_GetTail(buffer)) - head;
+	int first, num_live, pos, lo, hi, mid;
+	int found_start_bound = FALSE, found_end_bound = FALSE;
+
+	if (count < 0 || (count == 0 && !Buffer_IsEmpty(buffer)))
+		count += buffer->MaxEvents;
+
+	/* Checkpoints are ordered from the first one after the head, and those
+	   before the tail are the ones that describe the events in the buffer */
+	first = ((head + TIME_INDEX_STRIDE - 1) / TIME_INDEX_STRIDE) % index->NumCheckpoints;
+	lo = 0; hi = index->NumCheckpoints;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (TimeIndex_CheckpointPos (buffer, first, head, mid) < count)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	num_live = lo;
+
+	/* Start from the last checkpoint with all the events before it earlier
+	   than start_time */
+	lo = 0; hi = num_live;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (index->Before[(first + mid) % index->NumCheckpoints] < start_time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	pos = (lo > 0 ? TimeIndex_CheckpointPos (buffer, first, head, lo - 1) : 0);
+	for (; pos < count && !found_start_bound; pos++)
+	{
+		event_t *cur = TimeIndex_EventAt (buffer, head, pos);
+		if (Get_EvTime(cur) >= start_time)
+		{
+			found_start_bound = TRUE;
+			*start_bound = cur;
+		}
+	}
+
+	/* End right before the first checkpoint with all the events from it on
+	   later than end_time */
+	lo = 0; hi = num_live;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (index->After[(first + mid) % index->NumCheckpoints] <= end_time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	pos = (lo < num_live ? TimeIndex_CheckpointPos (buffer, first, head, lo) : count) - 1;
+	for (; pos >= 0 && !found_end_bound; pos--)
+	{
+		event_t *cur = TimeIndex_EventAt (buffer, head, pos);
+		if (Get_EvTime(cur) <= end_time)
+		{
+			found_end_bound = TRUE;
+			*end_bound = cur;
+		}
+	}
+
+	return (found_start_bound && found_end_bound);
 }
 
 /***************************************************************************/
@@ -776,14 +1530,29 @@ BufferIterator_t * BufferIterator_NewBackward (Buffer_t *buffer)
 	return it;
 }
 
+/**
+ * Creates a new iterator over the events between start_time and end_time
+ * \param buffer The buffer to create an iterator for
+ * \param start_time The iterator starts at the first event at or after this time
+ * \param end_time The iterator ends at the last event at or before this time
+ * \return The new iterator, out of bounds if there are no such events
+ */
 BufferIterator_t * BufferIterator_NewRange (Buffer_t *buffer, unsigned long long start_time, unsigned long long end_time)
 {
 	BufferIterator_t *itf, *itb, *itrange;
 	int found_start_bound = FALSE, found_end_bound = FALSE;
-	int count1 = 0, count2 = 0;
 	
 	itrange = new_Iterator(buffer);
 	ASSERT_VALID_ITERATOR(itrange);
+
+	if ((buffer->Index != NULL) && (!Buffer_IsEmpty(buffer)))
+	{
+		itrange->OutOfBounds = !TimeIndex_FindRange (buffer, start_time,
+		  end_time, &(itrange->StartBound), &(itrange->EndBound));
+		itrange->CurrentElement = itrange->StartBound;
+		return itrange;
+	}
+
 	itf = BIT_NewForward(buffer);
 	itb = BIT_NewBackward(buffer);
 
@@ -796,7 +1565,6 @@ BufferIterator_t * BufferIterator_NewRange (Buffer_t *buffer, unsigned long long
 			found_start_bound = TRUE;
 			itrange->StartBound = cur;
 		}
-		count1++;
 		BIT_Next(itf);
 	}
 
@@ -809,10 +1577,12 @@ BufferIterator_t * BufferIterator_NewRange (Buffer_t *buffer, unsigned long long
 			found_end_bound = TRUE;
 			itrange->EndBound = cur;
 		}
-		count2++;
 		BIT_Prev(itb);
 	}
 
+	BIT_Free(itf);
+	BIT_Free(itb);
+
 	itrange->CurrentElement = itrange->StartBound;
 	itrange->OutOfBounds = !(found_start_bound && found_end_bound);
 	return itrange;
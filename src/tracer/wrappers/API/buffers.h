@@ -38,9 +38,25 @@
 
 #include "record.h"
 
-#define LOCK_AT_INSERT 1
+/* The thread that owns a buffer inserts without taking any lock. Any other
+   thread that needs to touch the buffer (flushing on behalf of the owner,
+   pausing it from the on-line analysis, or emitting events into it) goes
+   through the ExclusiveToken / Paused / Handoff handshake instead.
+   Events handed off keep their time: the owner inserts them right before the
+   event that made it attend them if they happened earlier, so they may be
+   older than the last events of the buffer and the merger sorts them back. */
+#if defined(HAVE__SYNC_FETCH_AND_ADD)
+# define LOCKLESS_INSERT 1
+#else
+# define LOCK_AT_INSERT 1
+#endif
 //#define LOCK_AT_FLUSH 1
 
+#define BUFFER_HANDOFF_SIZE 16
+
+struct AsyncFlush;
+struct TimeIndex;
+
 typedef int Mask_t; 
 
 typedef struct Buffer Buffer_t;
@@ -48,17 +64,23 @@ typedef struct Buffer Buffer_t;
 struct Buffer
 {
   int MaxEvents;
-  int FillCount;
+  volatile int FillCount;
   event_t *FirstEvt;
   event_t *LastEvt;
-  event_t *HeadEvt;
-  event_t *CurEvt;
+  event_t *HeadEvt;        /* Only moved by the holder of ExclusiveToken */
+  event_t *CurEvt;         /* Only moved by the owner thread */
 
   int fd;
 
 #if defined(HAVE_ONLINE) 
   pthread_mutex_t Lock;
 #endif
+  volatile int Paused;
+  volatile int Inserting;  /* The owner is inserting (Buffer_Lock waits for it) */
+  volatile int ExclusiveToken;
+  volatile int NumHandoffEvents;
+  event_t HandoffEvents[BUFFER_HANDOFF_SIZE];
+
   Mask_t *Masks;
 
   int (*FlushCallback)(struct Buffer *);
@@ -66,6 +88,10 @@ struct Buffer
   int       NumberOfCachedEvents;
   INT32    *CachedEvents;
   Buffer_t *VictimCache;
+
+  struct AsyncFlush *Async;
+  unsigned char *Encoded;  /* Staging area to encode the events flushed */
+  struct TimeIndex *Index; /* Checkpoints to look up the events by time */
 };
 
 typedef struct
@@ -118,6 +144,8 @@ void Buffer_AddCachedEvent(Buffer_t *buffer, INT32 event_type);
 int  Buffer_IsEventCached(Buffer_t *buffer, INT32 event_type);
 unsigned long long Buffer_GetFileSize (Buffer_t *buffer);
 void Buffer_SetFlushCallback (Buffer_t *buffer, int (*callback)(struct Buffer *));
+int  Buffer_EnableAsyncFlush (Buffer_t *buffer);
+void Buffer_EnableTimeIndex (Buffer_t *buffer);
 int  Buffer_ExecuteFlushCallback (Buffer_t *buffer);
 void Buffer_Close (Buffer_t *buffer);
 int  Buffer_IsClosed (Buffer_t *buffer);
@@ -135,6 +163,7 @@ void Buffer_Lock (Buffer_t *buffer);
 void Buffer_Unlock (Buffer_t *buffer);
 void Buffer_InsertSingle(Buffer_t *buffer, event_t *new_event);
 void Buffer_InsertMultiple(Buffer_t *buffer, event_t *events_list, int num_events);
+void Buffer_HandoffSingle(Buffer_t *buffer, event_t *new_event);
 int  Buffer_Flush(Buffer_t *buffer);
 int  Buffer_FlushCache(Buffer_t *buffer);
 void Filter_Buffer(Buffer_t *buffer, event_t *first_event, event_t *last_event, DataBlocks_t *io_db);
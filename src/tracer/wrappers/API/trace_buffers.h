@@ -50,6 +50,15 @@ int Extrae_Flush_Wrapper (Buffer_t *buffer);
 	Signals_ExecuteDeferred();                              \
 }
 	
+/* Used when the buffer belongs to a different thread than tid */
+#define BUFFER_HANDOFF(tid, buffer, event)                  \
+{                                                           \
+	Signals_Inhibit();                                      \
+	Buffer_HandoffSingle (buffer, &event);                  \
+	Signals_Desinhibit();                                   \
+	Signals_ExecuteDeferred();                              \
+}
+
 #define BUFFER_INSERT_N(tid, buffer, events_list, num_events)            \
 {                                                                        \
 	if (num_events > 0)                                                  \
@@ -100,6 +100,7 @@
 #include "hwc.h"
 #include "signals.h"
 #include "utils.h"
+#include "cache_line.h"
 #include "calltrace.h"
 #include "xml-parse.h"
 #include "UF_gcc_instrument.h"
@@ -144,6 +145,7 @@
 #include "threadinfo.h"
 #if defined(PTHREAD_SUPPORT)
 # include "pthread_probe.h"
+# include "pthread_lock_stats.h"
 #endif
 
 #include "malloc_probe.h"
@@ -276,8 +278,28 @@ int hasMinimumTracingTime = FALSE;
 /* CPU events emission frequency */
 unsigned long long MinimumCPUEventTime = 0;
 unsigned short AlwaysEmitCPUEvent = 0;
-iotimer_t *LastCPUEmissionTime = NULL;
-int *LastCPUEvent = NULL;
+
+/* Per-thread state of the backend that is updated on every event. Every
+   thread owns its own cache line so that threads do not invalidate each other
+   when they update it */
+typedef struct
+{
+	iotimer_t LastCPUEmissionTime;
+	int LastCPUEvent;
+	int inInstrumentation;
+	int inSampling;
+} Backend_ThreadState_t;
+
+typedef union
+{
+	Backend_ThreadState_t s;
+	char pad[EXTRAE_CACHE_LINE_ROUNDUP(sizeof(Backend_ThreadState_t))];
+} Backend_ThreadSlot_t;
+
+static Backend_ThreadSlot_t *ThreadState = NULL;
+static unsigned ThreadState_size = 0;
+
+#define THREAD_STATE(thread) (ThreadState[thread].s)
 
 unsigned long long WantedCheckControlPeriod = 0;
 
@@ -316,8 +338,8 @@ char tmp_dir[TMP_DIR_LEN];
 int
 PENDING_TRACE_CPU_EVENT(int thread_id, iotimer_t current_time)
 {
-	if ((LastCPUEmissionTime[thread_id] == 0) || (((current_time - LastCPUEmissionTime[thread_id]) >  MinimumCPUEventTime) && MinimumCPUEventTime > 0)) {
-		LastCPUEmissionTime[thread_id] = current_time;
+	if ((THREAD_STATE(thread_id).LastCPUEmissionTime == 0) || (((current_time - THREAD_STATE(thread_id).LastCPUEmissionTime) >  MinimumCPUEventTime) && MinimumCPUEventTime > 0)) {
+		THREAD_STATE(thread_id).LastCPUEmissionTime = current_time;
 		return 1;
 	}
 
@@ -399,6 +421,7 @@ void Extrae_setCheckForGlobalOpsTracingIntervals (int b)
 
 int circular_buffering = 0;
 event_t *circular_HEAD;
+int async_flushing = 0;
 
 static void Extrae_getExecutableInfo (void);
 
@@ -487,9 +510,9 @@ void Extrae_AnnotateCPU (UINT64 timestamp)
 #if defined(HAVE_SCHED_GETCPU)
     int cpu = sched_getcpu();
 
-    if (cpu != LastCPUEvent[THREADID] || AlwaysEmitCPUEvent)
+    if (cpu != THREAD_STATE(THREADID).LastCPUEvent || AlwaysEmitCPUEvent)
     {
-        LastCPUEvent[THREADID] = cpu;
+        THREAD_STATE(THREADID).LastCPUEvent = cpu;
         TRACE_EVENT (timestamp, GETCPU_EV, cpu);
     }
 #else
@@ -859,6 +882,15 @@ static int read_environment_variables (int me)
 			fprintf (stdout, PACKAGE_NAME": Circular buffer enabled!\n");
 	}
 
+	/* Check if the buffers have to be written in the background */
+	str = getenv ("EXTRAE_ASYNC_FLUSH");
+	if (str != NULL && (strcmp (str, "1") == 0))
+	{
+		async_flushing = TRUE;
+		if (me == 0)
+			fprintf (stdout, PACKAGE_NAME": Asynchronous buffer flush enabled!\n");
+	}
+
 	/* Get the program name if available. It will be used to form the MPIT filenames */
 	str = getenv ("EXTRAE_PROGRAM_NAME");
 	if (!str)
@@ -996,6 +1028,15 @@ static int read_environment_variables (int me)
 	/* Will we trace openmp-locks ? */
 	str = getenv ("EXTRAE_PTHREAD_LOCKS");
 	Extrae_pthread_instrument_locks ((str != NULL && (strcmp (str, "1"))));
+
+	/* Only the contended pthread locks are traced? */
+	str = getenv ("EXTRAE_PTHREAD_LOCKS_CONTENTION");
+	if (str != NULL && (strcmp (str, "1") == 0))
+	{
+		if (me == 0)
+			fprintf (stdout, PACKAGE_NAME": Only contended pthread locks are traced.\n");
+		Extrae_pthread_instrument_locks_contention (TRUE);
+	}
 #endif
 
 	/* Should we configure a signal handler ? */
@@ -1354,14 +1395,18 @@ static int Allocate_buffer_and_file (int thread_id, int forked)
 	if (forked)
 		Buffer_Free (TracingBuffer[thread_id]);
 
-	LastCPUEmissionTime[thread_id] = 0;
-	LastCPUEvent[thread_id] = 0;
+	THREAD_STATE(thread_id).LastCPUEmissionTime = 0;
+	THREAD_STATE(thread_id).LastCPUEvent = 0;
 	TracingBuffer[thread_id] = new_Buffer (buffer_size, tmp_file, TRUE);
 	if (TracingBuffer[thread_id] == NULL)
 	{
 		fprintf (stderr, PACKAGE_NAME": Error allocating tracing buffer for thread %d\n", thread_id);
 		return 0;
 	}
+#if defined(HAVE_ONLINE)
+	/* The on-line analysis looks up time ranges in the buffers */
+	Buffer_EnableTimeIndex (TracingBuffer[thread_id]);
+#endif
 	if (circular_buffering)
 	{
 		Buffer_AddCachedEvent (TracingBuffer[thread_id], MPI_INIT_EV);
@@ -1373,6 +1418,17 @@ static int Allocate_buffer_and_file (int thread_id, int forked)
 	else
 	{
 		Buffer_SetFlushCallback (TracingBuffer[thread_id], Extrae_Flush_Wrapper);
+
+		/* The file size limit is checked on synchronous flushes only */
+		if (async_flushing && file_size == 0)
+		{
+			if (!Buffer_EnableAsyncFlush (TracingBuffer[thread_id]))
+			{
+				if (TASKID == 0 && thread_id == 0)
+					fprintf (stderr, PACKAGE_NAME": Asynchronous buffer flush is not supported in this installation. Flushing synchronously.\n");
+				async_flushing = FALSE;
+			}
+		}
 	}
 
 #if defined(SAMPLING_SUPPORT)
@@ -1425,8 +1481,6 @@ static int Allocate_buffers_and_files (int world_size, int num_threads, int fork
 	if (!forked)
 	{
 		xmalloc(TracingBuffer, num_threads * sizeof(Buffer_t *));
-		xmalloc(LastCPUEmissionTime, num_threads * sizeof(iotimer_t));
-		xmalloc(LastCPUEvent, num_threads * sizeof(int));
 #if defined(SAMPLING_SUPPORT)
 		xmalloc(SamplingBuffer, num_threads * sizeof(Buffer_t *));
 #endif
@@ -1448,10 +1502,13 @@ static int Reallocate_buffers_and_files (int new_num_threads)
 	int i;
 
 	xrealloc(TracingBuffer, TracingBuffer, new_num_threads * sizeof(Buffer_t *));
-	xrealloc(LastCPUEmissionTime, LastCPUEmissionTime, new_num_threads * sizeof(iotimer_t));
-	xrealloc(LastCPUEvent, LastCPUEvent, new_num_threads * sizeof(int));
 #if defined(SAMPLING_SUPPORT)
+	// Protects race condition with the sampling flusher thread
+	pthread_mutex_lock(&pthreadFreeBuffer_mtx);
 	xrealloc(SamplingBuffer, SamplingBuffer, new_num_threads * sizeof(Buffer_t *));
+	for (i = get_maximum_NumOfThreads(); i < new_num_threads; i++)
+		SamplingBuffer[i] = NULL;
+	pthread_mutex_unlock(&pthreadFreeBuffer_mtx);
 #endif
 
 	for (i = get_maximum_NumOfThreads(); i < new_num_threads; i++)
@@ -1460,6 +1517,148 @@ static int Reallocate_buffers_and_files (int new_num_threads)
 	return TRUE;
 }
 
+#if defined(SAMPLING_SUPPORT)
+/******************************************************************************
+ **      Function name : Sampling_BufferNeedsFlush
+ **      Description : Tells whether the given sampling buffer is, at least,
+ **        half full. Flushing at this threshold leaves room for the samples
+ **        that the signal handler keeps appending while the flush runs.
+ *****************************************************************************/
+static int Sampling_BufferNeedsFlush (Buffer_t *buffer)
+{
+	return Buffer_GetFillCount (buffer) >= Buffer_RemainingEvents (buffer);
+}
+
+# if defined(HAVE_PTHREAD_H)
+
+/* Period (in ms) in which the flusher thread checks the sampling buffers */
+#  define SAMPLING_FLUSHER_PERIOD_MS 100
+
+static pthread_t Sampling_Flusher;
+static int Sampling_Flusher_Running = FALSE;
+static pthread_mutex_t Sampling_Flusher_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Sampling_Flusher_cond = PTHREAD_COND_INITIALIZER;
+
+/******************************************************************************
+ **      Function name : Sampling_Flusher_Body
+ **      Description : Periodically dumps the sampling buffers that are half
+ **        full, so that the samples do not pile up until the end of the
+ **        execution. Signal handlers only append to the buffers; the writes
+ **        to disk happen here, outside signal context.
+ *****************************************************************************/
+static void * Sampling_Flusher_Body (void *arg)
+{
+	UNREFERENCED_PARAMETER(arg);
+
+	pthread_mutex_lock (&Sampling_Flusher_mtx);
+	while (Sampling_Flusher_Running)
+	{
+		struct timespec deadline;
+		unsigned thread;
+
+		clock_gettime (CLOCK_REALTIME, &deadline);
+		deadline.tv_nsec += SAMPLING_FLUSHER_PERIOD_MS * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+		pthread_cond_timedwait (&Sampling_Flusher_cond, &Sampling_Flusher_mtx,
+		  &deadline);
+		if (!Sampling_Flusher_Running)
+			break;
+		pthread_mutex_unlock (&Sampling_Flusher_mtx);
+
+		// Protects race condition with Backend_Flush_pThread and Backend_Finalize
+		pthread_mutex_lock (&pthreadFreeBuffer_mtx);
+		if (SamplingBuffer != NULL)
+			for (thread = 0; thread < get_maximum_NumOfThreads(); thread++)
+			{
+				Buffer_t *buffer = SAMPLING_BUFFER(thread);
+
+				if (buffer != NULL && !Buffer_IsClosed (buffer) &&
+				    Sampling_BufferNeedsFlush (buffer))
+					Buffer_Flush (buffer);
+			}
+		pthread_mutex_unlock (&pthreadFreeBuffer_mtx);
+
+		pthread_mutex_lock (&Sampling_Flusher_mtx);
+	}
+	pthread_mutex_unlock (&Sampling_Flusher_mtx);
+
+	return NULL;
+}
+
+/******************************************************************************
+ **      Function name : Sampling_Flusher_Start
+ **      Description : Launches the sampling flusher thread. The thread is
+ **        created with all signals blocked (so that sampling signals are never
+ **        delivered to it) and with the pthread instrumentation disabled (so
+ **        that it does not get a tracing buffer of its own). The thread is
+ **        only used with the lock-free buffers.
+ *****************************************************************************/
+static void Sampling_Flusher_Start (int forked)
+{
+#  if defined(LOCKLESS_INSERT)
+	sigset_t all_signals, prev_signals;
+	int prev_pthread_tracing;
+
+	/* The flusher of the parent process does not survive the fork */
+	if (forked)
+	{
+		Sampling_Flusher_Running = FALSE;
+		pthread_mutex_init (&Sampling_Flusher_mtx, NULL);
+		pthread_cond_init (&Sampling_Flusher_cond, NULL);
+	}
+
+	if (Sampling_Flusher_Running)
+		return;
+
+	Sampling_Flusher_Running = TRUE;
+
+	sigfillset (&all_signals);
+	pthread_sigmask (SIG_SETMASK, &all_signals, &prev_signals);
+	prev_pthread_tracing = Extrae_get_pthread_tracing();
+	Extrae_set_pthread_tracing (FALSE);
+
+	if (pthread_create (&Sampling_Flusher, NULL, Sampling_Flusher_Body, NULL) != 0)
+	{
+		fprintf (stderr, PACKAGE_NAME": Warning! Cannot create the sampling flusher thread. Sampling buffers will be flushed at instrumentation points only.\n");
+		Sampling_Flusher_Running = FALSE;
+	}
+
+	Extrae_set_pthread_tracing (prev_pthread_tracing);
+	pthread_sigmask (SIG_SETMASK, &prev_signals, NULL);
+#  else
+	/* Concurrent flushes of a buffer are only excluded by the token of the
+	   lock-free buffers (see buffers.h). Without it, the flusher would dump a
+	   buffer while its owner flushes it too, so the sampling buffers are
+	   flushed at instrumentation points only */
+	UNREFERENCED_PARAMETER(forked);
+#  endif
+}
+
+/******************************************************************************
+ **      Function name : Sampling_Flusher_Stop
+ **      Description : Stops and joins the sampling flusher thread, if any.
+ *****************************************************************************/
+static void Sampling_Flusher_Stop (void)
+{
+	int running;
+
+	pthread_mutex_lock (&Sampling_Flusher_mtx);
+	running = Sampling_Flusher_Running;
+	Sampling_Flusher_Running = FALSE;
+	pthread_cond_signal (&Sampling_Flusher_cond);
+	pthread_mutex_unlock (&Sampling_Flusher_mtx);
+
+	if (running)
+		pthread_join (Sampling_Flusher, NULL);
+}
+
+# endif /* HAVE_PTHREAD_H */
+#endif /* SAMPLING_SUPPORT */
+
 /******************************************************************************
  **      Function name : Extrae_Allocate_Task_Bitmap
  **      Author : HSG
@@ -1825,7 +2024,7 @@ int Backend_preInitialize (int me, int world_size, const char *config_file, int
 			unlink (trace_sym);
 	}
 
-	Backend_ChangeNumberOfThreads_InInstrumentation (get_maximum_NumOfThreads());
+	Backend_ChangeNumberOfThreads_ThreadState (get_maximum_NumOfThreads());
 
 	/* Remove the locals .sym file */
 	for (u = 0; u < get_maximum_NumOfThreads(); u++)
@@ -1853,6 +2052,12 @@ int Backend_preInitialize (int me, int world_size, const char *config_file, int
 	/* Allocate the buffers and trace files */
 	Allocate_buffers_and_files (world_size, get_maximum_NumOfThreads(), forked);
 
+#if defined(SAMPLING_SUPPORT) && defined(HAVE_PTHREAD_H)
+	/* Dump the sampling buffers periodically rather than only at the end */
+	if (Extrae_get_DumpBuffersAtInstrumentation())
+		Sampling_Flusher_Start (forked);
+#endif
+
 #if defined(CUDA_SUPPORT)
 	/* Allocate thread info for CUDA execs */
 	Extrae_reallocate_CUDA_info (get_maximum_NumOfThreads());
@@ -1972,8 +2177,8 @@ int Backend_ChangeNumberOfThreads (unsigned numberofthreads)
 			Extrae_IntelPEBS_pauseSampling();
 #endif
 	
-			/* Reallocate InInstrumentation structures */
-			Backend_ChangeNumberOfThreads_InInstrumentation (new_num_threads);
+			/* Reallocate the per-thread state (InInstrumentation, last CPU...) */
+			Backend_ChangeNumberOfThreads_ThreadState (new_num_threads);
 			/* We leave... so, we're no longer in instrumentatin from this point */
 			for (u = get_maximum_NumOfThreads(); u < new_num_threads; u++)
 			{
@@ -2355,15 +2560,39 @@ int Extrae_Flush_Wrapper (Buffer_t *buffer)
 		FlushEv_End.value = EVT_END;
 		HARDWARE_COUNTERS_READ (THREADID, FlushEv_End, Extrae_Flush_Wrapper_getCounters());
 
-		BUFFER_INSERT (THREADID, buffer, FlushEv_Begin);
+		if (buffer == TRACING_BUFFER(THREADID))
+		{
+			BUFFER_INSERT (THREADID, buffer, FlushEv_Begin);
+		}
+		else
+		{
+			/* Flushing on behalf of another thread, do not race with its insertions */
+			BUFFER_HANDOFF (THREADID, buffer, FlushEv_Begin);
+		}
 #if !defined(IS_BG_MACHINE)
 		Extrae_AnnotateTopology (TRUE, FlushEv_Begin.time);
 #endif
-		BUFFER_INSERT (THREADID, buffer, FlushEv_End);
+		if (buffer == TRACING_BUFFER(THREADID))
+		{
+			BUFFER_INSERT (THREADID, buffer, FlushEv_End);
+		}
+		else
+		{
+			BUFFER_HANDOFF (THREADID, buffer, FlushEv_End);
+		}
 #if !defined(IS_BG_MACHINE)
 		Extrae_AnnotateTopology (TRUE, FlushEv_End.time);
 #endif
 
+		/* Summarize the aggregated I/O calls and locks of this thread after every flush */
+		if (buffer == TRACING_BUFFER(THREADID))
+		{
+			IO_Stats_Emit (THREADID, FlushEv_End.time);
+#if defined(PTHREAD_SUPPORT)
+			Lock_Stats_Emit (THREADID, FlushEv_End.time);
+#endif
+		}
+
 		check_size = !hasMinimumTracingTime || (hasMinimumTracingTime && (TIME > MinimumTracingTime+initTracingTime));
 		if (file_size > 0 && check_size)
 		{
@@ -2426,6 +2655,9 @@ void Backend_Finalize (void)
 		/* Stop sampling right now */
 		Extrae_setSamplingEnabled (FALSE);
 		unsetTimeSampling ();
+#if defined(SAMPLING_SUPPORT) && defined(HAVE_PTHREAD_H)
+		Sampling_Flusher_Stop ();
+#endif
 
 		if (THREADID == 0) 
 		{
@@ -2472,6 +2704,10 @@ void Backend_Finalize (void)
 
 			if (TRACING_BUFFER(thread) != NULL)
 			{
+				IO_Stats_Emit (thread, TIME);
+#if defined(PTHREAD_SUPPORT)
+				Lock_Stats_Emit (thread, TIME);
+#endif
 				TRACE_EVENT (TIME, APPL_EV, EVT_END);
 				Buffer_ExecuteFlushCallback (TRACING_BUFFER(thread));
 				Backend_Finalize_close_mpits (getpid(), thread, FALSE);
@@ -2506,8 +2742,6 @@ void Backend_Finalize (void)
 #endif
 				pthread_mutex_unlock(&pthreadFreeBuffer_mtx);
 			}
-			xfree(LastCPUEmissionTime);
-			xfree(LastCPUEvent);
 			xfree(TracingBuffer);
 #if defined(SAMPLING_SUPPORT)
 			xfree(SamplingBuffer);
@@ -2519,6 +2753,10 @@ void Backend_Finalize (void)
 			Clock_CleanUp();
 			InstrumentUFroutines_GCC_CleanUp();
 			InstrumentUFroutines_XL_CleanUp();
+			IO_Stats_CleanUp();
+#if defined(PTHREAD_SUPPORT)
+			Lock_Stats_CleanUp();
+#endif
 #if USE_HARDWARE_COUNTERS
 			HWC_CleanUp (get_maximum_NumOfThreads());
 #endif
@@ -2585,45 +2823,34 @@ void Backend_Finalize (void)
 	}
 }
 
-//static int Extrae_inInstrumentation = FALSE;
-static int *Extrae_inInstrumentation = NULL;
-static int *Extrae_inSampling = NULL;
-
 int Backend_inInstrumentation (unsigned thread)
 {
-	if ((Extrae_inInstrumentation != NULL) && (Extrae_inSampling != NULL))
-		return (Extrae_inInstrumentation[thread] || Extrae_inSampling[thread]);
+	if (ThreadState != NULL)
+		return (THREAD_STATE(thread).inInstrumentation || THREAD_STATE(thread).inSampling);
 	else
 		return FALSE;
 }
 
-void Backend_setInSampling (unsigned thread, int insampling)      
-{                                                                               
-	  if (Extrae_inSampling != NULL)                                         
-			    Extrae_inSampling[thread] = insampling;                       
-}                                                                               
+void Backend_setInSampling (unsigned thread, int insampling)
+{
+	if (ThreadState != NULL)
+		THREAD_STATE(thread).inSampling = insampling;
+}
 
 void Backend_setInInstrumentation (unsigned thread, int ininstrumentation)
 {
-	if (Extrae_inInstrumentation != NULL)
-		Extrae_inInstrumentation[thread] = ininstrumentation;
+	if (ThreadState != NULL)
+		THREAD_STATE(thread).inInstrumentation = ininstrumentation;
 }
 
-void Backend_ChangeNumberOfThreads_InInstrumentation (unsigned nthreads)
+void Backend_ChangeNumberOfThreads_ThreadState (unsigned nthreads)
 {
-	Extrae_inInstrumentation = (int*) realloc (Extrae_inInstrumentation, sizeof(int)*nthreads);
-	if (Extrae_inInstrumentation == NULL)
-	{
-		fprintf (stderr, PACKAGE_NAME
-		  ": Failed to allocate memory for inInstrumentation structure\n");
-		exit (-1);
-	}
-	Extrae_inSampling = (int*) realloc (Extrae_inSampling, sizeof(int)*nthreads);
-	if (Extrae_inSampling == NULL)
+	if (nthreads > ThreadState_size)
 	{
-		fprintf (stderr, PACKAGE_NAME
-		  ": Failed to allocate memory for inSampling structure\n");
-		exit (-1);
+		ThreadState = (Backend_ThreadSlot_t*) Extrae_CacheLine_Realloc (
+		  ThreadState, sizeof(Backend_ThreadSlot_t)*ThreadState_size,
+		  sizeof(Backend_ThreadSlot_t)*nthreads);
+		ThreadState_size = nthreads;
 	}
 }
 
@@ -2640,13 +2867,14 @@ void Backend_Enter_Instrumentation ()
 	/* Check if we have to fill the sampling buffer */
 #if defined(SAMPLING_SUPPORT)
 	if (Extrae_get_DumpBuffersAtInstrumentation())
-		if (Buffer_IsFull (SAMPLING_BUFFER(THREADID)))
+		if (Sampling_BufferNeedsFlush (SAMPLING_BUFFER(THREADID)))
 		{
 			event_t FlushEv_Begin, FlushEv_End;
 
-			/* Disable sampling first, and then reestablish whether it was set */
-			int prev = Extrae_isSamplingEnabled();
-			Extrae_setSamplingEnabled (FALSE);
+			/* No need to disable sampling here: the signal handler already
+			   discards the samples of this thread while it is inside
+			   instrumentation, and the rest of threads keep sampling into
+			   their own buffers */
 
 			/* Get time now, to mark in the instrumentation buffer the begin of the flush */
 			FlushEv_Begin.time = TIME;
@@ -2668,9 +2896,6 @@ void Backend_Enter_Instrumentation ()
 			/* Add events into instrumentation buffer */
 			BUFFER_INSERT (THREADID, TRACING_BUFFER(THREADID), FlushEv_Begin);
 			BUFFER_INSERT (THREADID, TRACING_BUFFER(THREADID), FlushEv_End);
-
-			/* Reestablish sampling */
-			Extrae_setSamplingEnabled (prev);
 		}
 #endif
 
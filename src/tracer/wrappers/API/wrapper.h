@@ -237,7 +237,7 @@ void Backend_Leave_Instrumentation (void);
 int Backend_inInstrumentation (unsigned thread);
 void Backend_setInInstrumentation (unsigned thread, int ininstrumentation);
 void Backend_setInSampling (unsigned thread, int insampling);
-void Backend_ChangeNumberOfThreads_InInstrumentation (unsigned nthreads);
+void Backend_ChangeNumberOfThreads_ThreadState (unsigned nthreads);
 void Backend_createExtraeDirectory (int taskid, int Temporal);
 void Backend_syncOnExtraeDirectory (int taskid, int Temporal);
 int Extrae_Get_FinalDir_BlockSize(void);
@@ -247,6 +247,7 @@ char *Extrae_Get_TemporalDirNoTask (void);
 
 void advance_current(int);
 extern int circular_buffering, circular_OVERFLOW;
+extern int async_flushing;
 extern event_t *circular_HEAD;
 
 void Parse_Callers (int, char *, int);
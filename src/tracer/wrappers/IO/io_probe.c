@@ -40,6 +40,7 @@
 #include "wrapper.h"
 #include "trace_macros.h"
 #include "io_probe.h"
+#include "io_stats.h"
 
 /***********************************************************************************************\
  * This file contains the probes to record the begin/end events for instrumented I/O routines. *
@@ -211,6 +212,11 @@ void Probe_IO_read_Entry (int fd, ssize_t size)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Entry (IO_STATS_READ, fd, size);
+      return;
+    }
     unsigned type = Extrae_get_descriptor_type (fd);
     TRACE_MISCEVENTANDCOUNTERS(LAST_READ_TIME, READ_EV, EVT_BEGIN, fd);
     TRACE_MISCEVENT(LAST_READ_TIME, READ_EV, EVT_BEGIN+1, size);
@@ -227,6 +233,11 @@ void Probe_IO_read_Exit (void)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Exit ();
+      return;
+    }
     TRACE_MISCEVENTANDCOUNTERS(TIME, READ_EV, EVT_END, EMPTY);
   }
 }
@@ -242,6 +253,11 @@ void Probe_IO_write_Entry (int fd, ssize_t size)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Entry (IO_STATS_WRITE, fd, size);
+      return;
+    }
     unsigned type = Extrae_get_descriptor_type (fd);
     TRACE_MISCEVENTANDCOUNTERS(LAST_READ_TIME, WRITE_EV, EVT_BEGIN, fd);
     TRACE_MISCEVENT(LAST_READ_TIME, WRITE_EV, EVT_BEGIN+1, size);
@@ -258,6 +274,11 @@ void Probe_IO_write_Exit (void)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Exit ();
+      return;
+    }
     TRACE_MISCEVENTANDCOUNTERS(TIME, WRITE_EV, EVT_END, EMPTY);
   }
 }
@@ -273,6 +294,11 @@ void Probe_IO_fread_Entry (int fd, size_t size)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Entry (IO_STATS_READ, fd, size);
+      return;
+    }
     unsigned type = Extrae_get_descriptor_type (fd);
     TRACE_MISCEVENTANDCOUNTERS(LAST_READ_TIME, FREAD_EV, EVT_BEGIN, fd);
     TRACE_MISCEVENT(LAST_READ_TIME, FREAD_EV, EVT_BEGIN+1, size);
@@ -289,6 +315,11 @@ void Probe_IO_fread_Exit (void)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Exit ();
+      return;
+    }
     TRACE_MISCEVENTANDCOUNTERS(TIME, FREAD_EV, EVT_END, EMPTY);
   }
 }
@@ -304,6 +335,11 @@ void Probe_IO_fwrite_Entry (int fd, size_t size)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Entry (IO_STATS_WRITE, fd, size);
+      return;
+    }
     unsigned type = Extrae_get_descriptor_type (fd);
     TRACE_MISCEVENTANDCOUNTERS(LAST_READ_TIME, FWRITE_EV, EVT_BEGIN, fd);
     TRACE_MISCEVENT(LAST_READ_TIME, FWRITE_EV, EVT_BEGIN+1, size);
@@ -320,6 +356,11 @@ void Probe_IO_fwrite_Exit (void)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Exit ();
+      return;
+    }
     TRACE_MISCEVENTANDCOUNTERS(TIME, FWRITE_EV, EVT_END, EMPTY);
   }
 }
@@ -335,6 +376,11 @@ void Probe_IO_pread_Entry (int fd, ssize_t size)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Entry (IO_STATS_READ, fd, size);
+      return;
+    }
     unsigned type = Extrae_get_descriptor_type (fd);
     TRACE_MISCEVENTANDCOUNTERS(LAST_READ_TIME, PREAD_EV, EVT_BEGIN, fd);
     TRACE_MISCEVENT(LAST_READ_TIME, PREAD_EV, EVT_BEGIN+1, size);
@@ -351,6 +397,11 @@ void Probe_IO_pread_Exit (void)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Exit ();
+      return;
+    }
     TRACE_MISCEVENTANDCOUNTERS(TIME, PREAD_EV, EVT_END, EMPTY);
   }
 }
@@ -366,6 +417,11 @@ void Probe_IO_pwrite_Entry (int fd, ssize_t size)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Entry (IO_STATS_WRITE, fd, size);
+      return;
+    }
     unsigned type = Extrae_get_descriptor_type (fd);
     TRACE_MISCEVENTANDCOUNTERS(LAST_READ_TIME, PWRITE_EV, EVT_BEGIN, fd);
     TRACE_MISCEVENT(LAST_READ_TIME, PWRITE_EV, EVT_BEGIN+1, size);
@@ -382,6 +438,11 @@ void Probe_IO_pwrite_Exit (void)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Exit ();
+      return;
+    }
     TRACE_MISCEVENTANDCOUNTERS(TIME, PWRITE_EV, EVT_END, EMPTY);
   }
 }
@@ -397,6 +458,11 @@ void Probe_IO_readv_Entry (int fd, ssize_t size)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Entry (IO_STATS_READ, fd, size);
+      return;
+    }
     unsigned type = Extrae_get_descriptor_type (fd);
     TRACE_MISCEVENTANDCOUNTERS(LAST_READ_TIME, READV_EV, EVT_BEGIN, fd);
     TRACE_MISCEVENT(LAST_READ_TIME, READV_EV, EVT_BEGIN+1, size);
@@ -413,6 +479,11 @@ void Probe_IO_readv_Exit (void)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Exit ();
+      return;
+    }
     TRACE_MISCEVENTANDCOUNTERS(TIME, READV_EV, EVT_END, EMPTY);
   }
 }
@@ -428,6 +499,11 @@ void Probe_IO_writev_Entry (int fd, ssize_t size)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Entry (IO_STATS_WRITE, fd, size);
+      return;
+    }
     unsigned type = Extrae_get_descriptor_type (fd);
     TRACE_MISCEVENTANDCOUNTERS(LAST_READ_TIME, WRITEV_EV, EVT_BEGIN, fd);
     TRACE_MISCEVENT(LAST_READ_TIME, WRITEV_EV, EVT_BEGIN+1, size);
@@ -444,6 +520,11 @@ void Probe_IO_writev_Exit (void)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Exit ();
+      return;
+    }
     TRACE_MISCEVENTANDCOUNTERS(TIME, WRITEV_EV, EVT_END, EMPTY);
   }
 }
@@ -459,6 +540,11 @@ void Probe_IO_preadv_Entry (int fd, ssize_t size)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Entry (IO_STATS_READ, fd, size);
+      return;
+    }
     unsigned type = Extrae_get_descriptor_type (fd);
     TRACE_MISCEVENTANDCOUNTERS(LAST_READ_TIME, PREAD_EV, EVT_BEGIN, fd);
     TRACE_MISCEVENT(LAST_READ_TIME, PREAD_EV, EVT_BEGIN+1, size);
@@ -475,6 +561,11 @@ void Probe_IO_preadv_Exit (void)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Exit ();
+      return;
+    }
     TRACE_MISCEVENTANDCOUNTERS(TIME, PREAD_EV, EVT_END, EMPTY);
   }
 }
@@ -490,6 +581,11 @@ void Probe_IO_pwritev_Entry (int fd, ssize_t size)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Entry (IO_STATS_WRITE, fd, size);
+      return;
+    }
     unsigned type = Extrae_get_descriptor_type (fd);
     TRACE_MISCEVENTANDCOUNTERS(LAST_READ_TIME, PWRITEV_EV, EVT_BEGIN, fd);
     TRACE_MISCEVENT(LAST_READ_TIME, PWRITEV_EV, EVT_BEGIN+1, size);
@@ -506,6 +602,11 @@ void Probe_IO_pwritev_Exit (void)
 {
   if (mpitrace_on && trace_io_enabled)
   {
+    if (Extrae_get_trace_io_aggregate())
+    {
+      IO_Stats_Exit ();
+      return;
+    }
     TRACE_MISCEVENTANDCOUNTERS(TIME, PWRITEV_EV, EVT_END, EMPTY);
   }
 }
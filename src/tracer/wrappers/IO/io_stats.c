@@ -0,0 +1,385 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include "common.h"
+
+#if HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#if HAVE_STRING_H
+# include <string.h>
+#endif
+#if HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
+#include "threadid.h"
+#include "wrapper.h"
+#include "trace_macros.h"
+#include "utils.h"
+#include "io_stats.h"
+
+/**********************************************************************************************\
+ * This file contains the aggregated mode for the I/O instrumentation. Instead of emitting    *
+ * entry/exit events for every read/write-like call, each thread accumulates per descriptor   *
+ * the number of calls, the bytes requested, the time spent and a log2 histogram of the call  *
+ * sizes. These statistics are emitted as IO_STATS_EV events (one group per descriptor that   *
+ * has seen activity) after every flush of the thread buffer, at every time quantum (if set)  *
+ * and when the tracing finalizes, and then reset.                                            *
+\**********************************************************************************************/
+
+typedef struct
+{
+  unsigned long long calls;
+  unsigned long long bytes;
+  unsigned long long time;
+  unsigned long long histogram[IO_STATS_HISTOGRAM_BINS];
+} io_stats_op_t;
+
+typedef struct
+{
+  int fd;
+  int dirty;
+  io_stats_op_t op[IO_STATS_NUM_OPS];
+} io_stats_fd_t;
+
+typedef struct
+{
+  int *slot_of_fd;      /* Maps a descriptor into its position in fds, -1 if unused */
+  int slot_of_fd_size;
+  io_stats_fd_t *fds;
+  int *dirty;           /* Positions in fds with activity since the last summary */
+  int num_fds, num_dirty, max_fds;
+
+  unsigned long long last_emit;
+  unsigned long long entry_time;
+  size_t entry_size;
+  int entry_op, entry_fd;
+  int emitting;
+} io_stats_thread_t;
+
+static int io_aggregate_enabled = FALSE;
+static unsigned long long io_aggregate_quantum = 0;
+
+/* Every thread's statistics by thread id, so that the summaries of all threads
+ * can be emitted when the tracing finalizes. Each OS thread caches the entry of
+ * the thread id it last ran as, together with the generation in which it was
+ * looked up, so that a change of thread id or a cleanup invalidates the cache.
+ * The entries are never freed because other threads may still be using them. */
+static io_stats_thread_t **io_stats_threads = NULL;
+static unsigned io_stats_num_threads = 0;
+static volatile unsigned io_stats_generation = 1;
+static pthread_mutex_t io_stats_threads_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread io_stats_thread_t *io_stats_self = NULL;
+static __thread unsigned io_stats_self_thread = 0;
+static __thread unsigned io_stats_self_generation = 0;
+
+/**
+ * Extrae_set_trace_io_aggregate
+ *
+ * \param enable Aggregate the read/write I/O calls into per-descriptor statistics.
+ */
+void Extrae_set_trace_io_aggregate (int enable)
+{
+  io_aggregate_enabled = enable;
+}
+
+/**
+ * Extrae_get_trace_io_aggregate
+ *
+ * \return true if the read/write I/O calls are aggregated; false otherwise.
+ */
+int Extrae_get_trace_io_aggregate (void)
+{
+  return io_aggregate_enabled;
+}
+
+/**
+ * Extrae_set_trace_io_quantum
+ *
+ * \param quantum Time (in ns) after which each thread emits its summary, 0 to
+ * emit the summaries only after the buffer flushes and at the end.
+ */
+void Extrae_set_trace_io_quantum (unsigned long long quantum)
+{
+  io_aggregate_quantum = quantum;
+}
+
+static io_stats_thread_t * IO_Stats_Thread (unsigned thread)
+{
+  io_stats_thread_t *stats = NULL;
+
+  pthread_mutex_lock (&io_stats_threads_mtx);
+  if (thread >= io_stats_num_threads)
+  {
+    unsigned i, n = thread + 1;
+
+    xrealloc (io_stats_threads, io_stats_threads, n * sizeof(io_stats_thread_t *));
+    for (i = io_stats_num_threads; i < n; i++)
+      io_stats_threads[i] = NULL;
+    io_stats_num_threads = n;
+  }
+
+  /* OS threads that share a thread id (e.g. after the runtime recycles it)
+   * share its statistics, as they share its buffer */
+  stats = io_stats_threads[thread];
+  if (stats == NULL)
+  {
+    xmalloc (stats, sizeof(io_stats_thread_t));
+    memset (stats, 0, sizeof(io_stats_thread_t));
+    stats->last_emit = LAST_READ_TIME;
+    stats->entry_fd = -1;
+    io_stats_threads[thread] = stats;
+  }
+  pthread_mutex_unlock (&io_stats_threads_mtx);
+
+  return stats;
+}
+
+static io_stats_thread_t * IO_Stats_Self (void)
+{
+  unsigned thread = THREADID;
+
+  if (io_stats_self == NULL || io_stats_self_thread != thread ||
+      io_stats_self_generation != io_stats_generation)
+  {
+    io_stats_self_generation = io_stats_generation;
+    io_stats_self_thread = thread;
+    io_stats_self = IO_Stats_Thread (thread);
+  }
+  return io_stats_self;
+}
+
+static io_stats_fd_t * IO_Stats_Descriptor (io_stats_thread_t *stats, int fd)
+{
+  io_stats_fd_t *entry;
+  int slot;
+
+  if (fd >= stats->slot_of_fd_size)
+  {
+    int i, n = (fd + 1 > 2 * stats->slot_of_fd_size) ? fd + 1 : 2 * stats->slot_of_fd_size;
+
+    xrealloc (stats->slot_of_fd, stats->slot_of_fd, n * sizeof(int));
+    for (i = stats->slot_of_fd_size; i < n; i++)
+      stats->slot_of_fd[i] = -1;
+    stats->slot_of_fd_size = n;
+  }
+
+  slot = stats->slot_of_fd[fd];
+  if (slot < 0)
+  {
+    if (stats->num_fds == stats->max_fds)
+    {
+      stats->max_fds = (stats->max_fds > 0) ? 2 * stats->max_fds : 16;
+      xrealloc (stats->fds, stats->fds, stats->max_fds * sizeof(io_stats_fd_t));
+      xrealloc (stats->dirty, stats->dirty, stats->max_fds * sizeof(int));
+    }
+    slot = stats->slot_of_fd[fd] = stats->num_fds++;
+    memset (&stats->fds[slot], 0, sizeof(io_stats_fd_t));
+    stats->fds[slot].fd = fd;
+  }
+
+  entry = &stats->fds[slot];
+  if (!entry->dirty)
+  {
+    entry->dirty = TRUE;
+    stats->dirty[stats->num_dirty++] = slot;
+  }
+  return entry;
+}
+
+static inline int IO_Stats_Bin (size_t size)
+{
+  int bin = 0;
+
+  while (size > 1 && bin < IO_STATS_HISTOGRAM_BINS-1)
+  {
+    size >>= 1;
+    bin ++;
+  }
+  return bin;
+}
+
+static void IO_Stats_Insert (unsigned thread, unsigned long long time,
+  unsigned type, unsigned long long value)
+{
+  event_t evt;
+
+  evt.time = time;
+  evt.event = IO_STATS_EV;
+  evt.value = type;
+  evt.param.misc_param.param = value;
+  HARDWARE_COUNTERS_READ (thread, evt, FALSE);
+  BUFFER_INSERT (thread, TRACING_BUFFER(thread), evt);
+}
+
+static void IO_Stats_Emit_Thread (io_stats_thread_t *stats, unsigned thread,
+  unsigned long long time)
+{
+  static const unsigned first_ev[IO_STATS_NUM_OPS] =
+    { IO_STATS_READ_CALLS_EV, IO_STATS_WRITE_CALLS_EV };
+  static const unsigned histogram_ev[IO_STATS_NUM_OPS] =
+    { IO_STATS_READ_HISTOGRAM_EV, IO_STATS_WRITE_HISTOGRAM_EV };
+  int i, op, bin;
+
+  /* Inserting the summary may trigger a flush that would emit it again */
+  if (stats->emitting || TRACING_BUFFER(thread) == NULL)
+    return;
+  stats->emitting = TRUE;
+
+  if (tracejant && TracingBitmap[TASKID])
+  {
+    for (i = 0; i < stats->num_dirty; i++)
+    {
+      io_stats_fd_t *entry = &stats->fds[stats->dirty[i]];
+
+      IO_Stats_Insert (thread, time, IO_STATS_DESCRIPTOR_EV, entry->fd);
+      for (op = 0; op < IO_STATS_NUM_OPS; op++)
+      {
+        io_stats_op_t *s = &entry->op[op];
+
+        if (s->calls == 0)
+          continue;
+
+        /* The calls, bytes and time events are consecutive for every operation */
+        IO_Stats_Insert (thread, time, first_ev[op],   s->calls);
+        IO_Stats_Insert (thread, time, first_ev[op]+1, s->bytes);
+        IO_Stats_Insert (thread, time, first_ev[op]+2, s->time);
+        for (bin = 0; bin < IO_STATS_HISTOGRAM_BINS; bin++)
+          if (s->histogram[bin] > 0)
+            IO_Stats_Insert (thread, time, histogram_ev[op]+bin, s->histogram[bin]);
+      }
+    }
+  }
+
+  for (i = 0; i < stats->num_dirty; i++)
+  {
+    io_stats_fd_t *entry = &stats->fds[stats->dirty[i]];
+
+    entry->dirty = FALSE;
+    memset (entry->op, 0, sizeof(entry->op));
+  }
+  stats->num_dirty = 0;
+  stats->last_emit = time;
+  stats->emitting = FALSE;
+}
+
+/**
+ * IO_Stats_Entry
+ *
+ * Replaces the entry probe of a read/write-like call in aggregated mode.
+ * \param op Whether the call reads or writes (IO_STATS_READ/IO_STATS_WRITE)
+ * \param fd A file descriptor
+ * \param size The number of bytes requested
+ */
+void IO_Stats_Entry (int op, int fd, size_t size)
+{
+  io_stats_thread_t *stats = IO_Stats_Self ();
+
+  stats->entry_time = LAST_READ_TIME;
+  stats->entry_op = op;
+  stats->entry_fd = fd;
+  stats->entry_size = size;
+}
+
+/**
+ * IO_Stats_Exit
+ *
+ * Replaces the exit probe of a read/write-like call in aggregated mode.
+ * Accumulates the call and emits the summary if the time quantum expired.
+ */
+void IO_Stats_Exit (void)
+{
+  io_stats_thread_t *stats = IO_Stats_Self ();
+  unsigned long long now = TIME;
+  io_stats_op_t *s;
+
+  if (stats->entry_fd < 0)
+    return;
+
+  s = &(IO_Stats_Descriptor (stats, stats->entry_fd)->op[stats->entry_op]);
+  s->calls ++;
+  s->bytes += stats->entry_size;
+  s->time += now - stats->entry_time;
+  s->histogram[IO_Stats_Bin (stats->entry_size)] ++;
+  stats->entry_fd = -1;
+
+  if (io_aggregate_quantum > 0 && now - stats->last_emit >= io_aggregate_quantum)
+    IO_Stats_Emit_Thread (stats, io_stats_self_thread, now);
+}
+
+/**
+ * IO_Stats_Emit
+ *
+ * Emits (and resets) the summary accumulated by the given thread.
+ * \param thread The thread whose statistics are emitted into its buffer
+ * \param time Timestamp of the summary events
+ */
+void IO_Stats_Emit (unsigned thread, unsigned long long time)
+{
+  io_stats_thread_t *stats = NULL;
+
+  if (!io_aggregate_enabled)
+    return;
+
+  pthread_mutex_lock (&io_stats_threads_mtx);
+  if (thread < io_stats_num_threads)
+    stats = io_stats_threads[thread];
+  pthread_mutex_unlock (&io_stats_threads_mtx);
+
+  if (stats != NULL && stats->num_dirty > 0)
+    IO_Stats_Emit_Thread (stats, thread, time);
+}
+
+/**
+ * IO_Stats_CleanUp
+ *
+ * Discards the statistics not emitted yet and invalidates the entry cached by
+ * every thread. The entries are kept because other threads may be in the middle
+ * of an I/O call.
+ */
+void IO_Stats_CleanUp (void)
+{
+  unsigned i;
+  int j;
+
+  pthread_mutex_lock (&io_stats_threads_mtx);
+  io_stats_generation ++;
+  for (i = 0; i < io_stats_num_threads; i++)
+  {
+    io_stats_thread_t *stats = io_stats_threads[i];
+
+    if (stats != NULL)
+    {
+      for (j = 0; j < stats->num_dirty; j++)
+      {
+        stats->fds[stats->dirty[j]].dirty = FALSE;
+        memset (stats->fds[stats->dirty[j]].op, 0, sizeof(stats->fds[stats->dirty[j]].op));
+      }
+      stats->num_dirty = 0;
+      stats->entry_fd = -1;
+    }
+  }
+  pthread_mutex_unlock (&io_stats_threads_mtx);
+}
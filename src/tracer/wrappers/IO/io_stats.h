@@ -0,0 +1,47 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#ifndef __IO_STATS_H__
+#define __IO_STATS_H__
+
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+
+enum
+{
+  IO_STATS_READ = 0,
+  IO_STATS_WRITE,
+  IO_STATS_NUM_OPS
+};
+
+void Extrae_set_trace_io_aggregate (int enable);
+int  Extrae_get_trace_io_aggregate (void);
+void Extrae_set_trace_io_quantum (unsigned long long quantum);
+
+void IO_Stats_Entry (int op, int fd, size_t size);
+void IO_Stats_Exit  (void);
+void IO_Stats_Emit  (unsigned thread, unsigned long long time);
+void IO_Stats_CleanUp (void);
+
+#endif /* __IO_STATS_H__ */
@@ -624,7 +624,7 @@ ssize_t read (int fd, void *buf, size_t count)
     /* Instrumentation is enabled, emit events and invoke the real call */
     IO_Enter_Instrumentation ();
     Probe_IO_read_Entry (fd, count);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
@@ -705,7 +705,7 @@ ssize_t write (int fd, const void *buf, size_t count)
     /* Instrumentation is enabled, emit events and invoke the real call */
     IO_Enter_Instrumentation ();
     Probe_IO_write_Entry (fd, count);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
@@ -786,7 +786,7 @@ size_t fread(void *ptr, size_t size, size_t nmemb, FILE *stream)
     /* Instrumentation is enabled, emit events and invoke the real call */
     IO_Enter_Instrumentation ();
     Probe_IO_fread_Entry (fileno(stream), size * nmemb);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
@@ -866,7 +866,7 @@ size_t fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream)
     /* Instrumentation is enabled, emit events and invoke the real call */
     IO_Enter_Instrumentation ();
     Probe_IO_fwrite_Entry (fileno(stream), size * nmemb);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
@@ -947,7 +947,7 @@ ssize_t pread(int fd, void *buf, size_t count, off_t offset)
     /* Instrumentation is enabled, emit events and invoke the real call */
     IO_Enter_Instrumentation ();
     Probe_IO_pread_Entry (fd, count);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
@@ -1028,7 +1028,7 @@ ssize_t pwrite(int fd, const void *buf, size_t count, off_t offset)
     /* Instrumentation is enabled, emit events and invoke the real call */
     IO_Enter_Instrumentation ();
     Probe_IO_pwrite_Entry (fd, count);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
@@ -1118,7 +1118,7 @@ ssize_t readv (int fd, const struct iovec *iov, int iovcnt)
     }
 
     Probe_IO_readv_Entry (fd, size);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
@@ -1208,7 +1208,7 @@ ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
     }
 
     Probe_IO_writev_Entry (fd, size);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
     errno = errno_real;
 #endif
@@ -1298,7 +1298,7 @@ ssize_t preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset)
     }
 
     Probe_IO_preadv_Entry (fd, size);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
@@ -1388,7 +1388,7 @@ ssize_t preadv64(int fd, const struct iovec *iov, int iovcnt, __off64_t offset)
     }
 
     Probe_IO_preadv_Entry (fd, size);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
@@ -1478,7 +1478,7 @@ ssize_t pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset)
     }
 
     Probe_IO_pwritev_Entry (fd, size);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
@@ -1568,7 +1568,7 @@ ssize_t pwritev64(int fd, const struct iovec *iov, int iovcnt, __off64_t offset)
     }
 
     Probe_IO_pwritev_Entry (fd, size);
-    TRACE_IO_CALLER(LAST_READ_TIME, 3);
+    TRACE_IO_RW_CALLER(LAST_READ_TIME, 3);
 #ifdef HAVE_ERRNO_H
 		errno = errno_real;
 #endif
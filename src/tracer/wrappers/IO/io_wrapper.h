@@ -25,6 +25,7 @@
 #define __IO_WRAPPER_H__
 
 #include "calltrace.h"
+#include "io_stats.h"
 
 #define TRACE_IO_CALLER_IS_ENABLED (Trace_Caller_Enabled[CALLER_IO])
 
@@ -34,6 +35,13 @@
     Extrae_trace_callers (evttime, offset, CALLER_IO); \
 }
 
+/* The read/write calls folded into the aggregated statistics record no callers */
+#define TRACE_IO_RW_CALLER(evttime,offset)             \
+{                                                      \
+  if (!Extrae_get_trace_io_aggregate())                \
+    TRACE_IO_CALLER(evttime,offset);                   \
+}
+
 void xtr_IO_enable_internals();
 
 #endif /* __IO_WRAPPER_H__ */
@@ -0,0 +1,234 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include "common.h"
+
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
+#ifdef HAVE_ASSERT_H
+# include <assert.h>
+#endif
+
+#include "malloc_registry.h"
+
+/* Initial number of entries of a shard (must be a power of 2) */
+#define MALLOC_REGISTRY_INITIAL_CAPACITY 1024
+
+static __inline unsigned long long MallocRegistry_Hash (const void *p)
+{
+	/* Finalizer of MurmurHash3, spreads the (aligned) addresses evenly */
+	unsigned long long h = (unsigned long long) (size_t) p;
+
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static __inline Extrae_MallocRegistry_Shard_t * MallocRegistry_Shard (
+	Extrae_MallocRegistry_t *r, unsigned long long h)
+{
+	return &(r->shards[h & (MALLOC_REGISTRY_NSHARDS-1)].s);
+}
+
+/* Position where the search of the address with hash h starts. The bits used
+   to choose the shard are skipped, as they are the same within a shard */
+static __inline unsigned MallocRegistry_Home (Extrae_MallocRegistry_Shard_t *s,
+	unsigned long long h)
+{
+	return (unsigned) (h >> 32) & (s->capacity - 1);
+}
+
+/* Returns the position of p in the shard, or -1 if it is not there */
+static int MallocRegistry_Find (Extrae_MallocRegistry_Shard_t *s,
+	const void *p, unsigned long long h)
+{
+	unsigned i;
+
+	if (s->count == 0)
+		return -1;
+
+	for (i = MallocRegistry_Home (s, h); s->entries[i].ptr != NULL;
+	     i = (i + 1) & (s->capacity - 1))
+		if (s->entries[i].ptr == p)
+			return i;
+
+	return -1;
+}
+
+static void MallocRegistry_Insert (Extrae_MallocRegistry_Shard_t *s,
+	const void *p, unsigned long long h, size_t size)
+{
+	unsigned i = MallocRegistry_Home (s, h);
+
+	while (s->entries[i].ptr != NULL && s->entries[i].ptr != p)
+		i = (i + 1) & (s->capacity - 1);
+
+	if (s->entries[i].ptr == NULL)
+		s->count++;
+	s->entries[i].ptr = p;
+	s->entries[i].size = size;
+}
+
+/* Doubles the capacity of the shard and rehashes its entries */
+static void MallocRegistry_Grow (Extrae_MallocRegistry_t *r,
+	Extrae_MallocRegistry_Shard_t *s)
+{
+	Extrae_MallocRegistry_Entry_t *old_entries = s->entries;
+	unsigned u, old_capacity = s->capacity;
+
+	s->capacity = (old_capacity > 0) ? old_capacity * 2 :
+	  MALLOC_REGISTRY_INITIAL_CAPACITY;
+	s->entries = r->alloc (s->capacity * sizeof(Extrae_MallocRegistry_Entry_t));
+	assert (s->entries != NULL);
+	memset (s->entries, 0, s->capacity * sizeof(Extrae_MallocRegistry_Entry_t));
+	s->count = 0;
+
+	for (u = 0; u < old_capacity; u++)
+		if (old_entries[u].ptr != NULL)
+			MallocRegistry_Insert (s, old_entries[u].ptr,
+			  MallocRegistry_Hash (old_entries[u].ptr), old_entries[u].size);
+
+	if (old_entries != NULL)
+		r->dealloc (old_entries);
+}
+
+/* Removes the entry at position i. The entries that follow in the same probe
+   sequence are shifted back, so that no tombstones are needed */
+static void MallocRegistry_Delete (Extrae_MallocRegistry_Shard_t *s, unsigned i)
+{
+	unsigned mask = s->capacity - 1;
+	unsigned j = i;
+
+	while (1)
+	{
+		unsigned k;
+
+		j = (j + 1) & mask;
+		if (s->entries[j].ptr == NULL)
+			break;
+
+		/* The entry at j can fill the hole at i unless its home lies
+		   cyclically within (i, j] */
+		k = MallocRegistry_Home (s, MallocRegistry_Hash (s->entries[j].ptr));
+		if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+
+		s->entries[i] = s->entries[j];
+		i = j;
+	}
+
+	s->entries[i].ptr = NULL;
+	s->entries[i].size = 0;
+	s->count--;
+}
+
+void Extrae_MallocRegistry_Init (Extrae_MallocRegistry_t *r,
+	void *(*alloc)(size_t), void (*dealloc)(void *))
+{
+	unsigned u;
+
+	r->alloc = alloc;
+	r->dealloc = dealloc;
+	for (u = 0; u < MALLOC_REGISTRY_NSHARDS; u++)
+	{
+		Extrae_MallocRegistry_Shard_t *s = &(r->shards[u].s);
+
+		pthread_mutex_init (&s->lock, NULL);
+		s->entries = NULL;
+		s->capacity = s->count = 0;
+	}
+}
+
+void Extrae_MallocRegistry_Destroy (Extrae_MallocRegistry_t *r)
+{
+	unsigned u;
+
+	for (u = 0; u < MALLOC_REGISTRY_NSHARDS; u++)
+	{
+		Extrae_MallocRegistry_Shard_t *s = &(r->shards[u].s);
+
+		if (s->entries != NULL)
+			r->dealloc (s->entries);
+		s->entries = NULL;
+		s->capacity = s->count = 0;
+		pthread_mutex_destroy (&s->lock);
+	}
+}
+
+void Extrae_MallocRegistry_Add (Extrae_MallocRegistry_t *r, const void *p,
+	size_t size)
+{
+	unsigned long long h = MallocRegistry_Hash (p);
+	Extrae_MallocRegistry_Shard_t *s = MallocRegistry_Shard (r, h);
+
+	pthread_mutex_lock (&s->lock);
+
+	/* Keep the load factor below 1/2 to keep the probe sequences short */
+	if ((s->count + 1) * 2 > s->capacity)
+		MallocRegistry_Grow (r, s);
+	MallocRegistry_Insert (s, p, h, size);
+
+	pthread_mutex_unlock (&s->lock);
+}
+
+int Extrae_MallocRegistry_Remove (Extrae_MallocRegistry_t *r, const void *p,
+	size_t *size)
+{
+	unsigned long long h = MallocRegistry_Hash (p);
+	Extrae_MallocRegistry_Shard_t *s = MallocRegistry_Shard (r, h);
+	int i;
+
+	pthread_mutex_lock (&s->lock);
+
+	i = MallocRegistry_Find (s, p, h);
+	if (i >= 0)
+	{
+		if (size != NULL)
+			*size = s->entries[i].size;
+		MallocRegistry_Delete (s, i);
+	}
+
+	pthread_mutex_unlock (&s->lock);
+
+	return i >= 0;
+}
+
+unsigned Extrae_MallocRegistry_Count (Extrae_MallocRegistry_t *r)
+{
+	unsigned u, count = 0;
+
+	for (u = 0; u < MALLOC_REGISTRY_NSHARDS; u++)
+	{
+		Extrae_MallocRegistry_Shard_t *s = &(r->shards[u].s);
+
+		pthread_mutex_lock (&s->lock);
+		count += s->count;
+		pthread_mutex_unlock (&s->lock);
+	}
+
+	return count;
+}
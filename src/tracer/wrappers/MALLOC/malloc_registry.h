@@ -0,0 +1,90 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#ifndef _MALLOC_REGISTRY_H_
+#define _MALLOC_REGISTRY_H_
+
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#include <pthread.h>
+
+#include "cache_line.h"
+
+/* Registry of the allocations tracked by the dynamic memory instrumentation,
+   mapping every address to its size. The addresses are spread on several
+   shards, each protected by its own lock, and every shard is an open
+   addressing hash table with linear probing. Adding, looking up and removing
+   an address costs O(1) and threads only contend when they hit the same
+   shard. The tables are allocated through the given allocator, so that the
+   registry can be used from within the malloc wrappers. */
+
+#define MALLOC_REGISTRY_NSHARDS 64   /* Must be a power of 2 */
+
+typedef struct
+{
+	const void *ptr;  /* NULL if the entry is free */
+	size_t size;
+} Extrae_MallocRegistry_Entry_t;
+
+typedef struct
+{
+	pthread_mutex_t lock;
+	Extrae_MallocRegistry_Entry_t *entries;
+	unsigned capacity;  /* Power of 2, or 0 if not allocated yet */
+	unsigned count;
+} Extrae_MallocRegistry_Shard_t;
+
+typedef union
+{
+	Extrae_MallocRegistry_Shard_t s;
+	char pad[EXTRAE_CACHE_LINE_ROUNDUP(sizeof(Extrae_MallocRegistry_Shard_t))];
+} Extrae_MallocRegistry_Slot_t;
+
+typedef struct
+{
+	void *(*alloc)(size_t);
+	void (*dealloc)(void *);
+	Extrae_MallocRegistry_Slot_t shards[MALLOC_REGISTRY_NSHARDS];
+} Extrae_MallocRegistry_t;
+
+/* Initialize the registry, tables are allocated/freed through alloc/dealloc */
+void Extrae_MallocRegistry_Init (Extrae_MallocRegistry_t *r,
+	void *(*alloc)(size_t), void (*dealloc)(void *));
+
+/* Free the memory used by the registry */
+void Extrae_MallocRegistry_Destroy (Extrae_MallocRegistry_t *r);
+
+/* Track the given address (updates its size if it was already tracked) */
+void Extrae_MallocRegistry_Add (Extrae_MallocRegistry_t *r, const void *p,
+	size_t size);
+
+/* Stop tracking the given address. Returns whether it was tracked, and its
+   size in *size (if size is not NULL) */
+int Extrae_MallocRegistry_Remove (Extrae_MallocRegistry_t *r, const void *p,
+	size_t *size);
+
+/* Get the number of tracked addresses */
+unsigned Extrae_MallocRegistry_Count (Extrae_MallocRegistry_t *r);
+
+#endif /* _MALLOC_REGISTRY_H_ */
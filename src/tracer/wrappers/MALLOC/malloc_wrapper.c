@@ -44,6 +44,7 @@
 #include "wrapper.h"
 #include "trace_macros.h"
 #include "malloc_probe.h"
+#include "malloc_registry.h"
 
 // #define DEBUG
 
@@ -79,134 +80,83 @@ static void (*real_kmpc_free)(void *) = NULL;
 /* Note on the implementation!
    We will only instrument those malloc(), realloc() that are larger than
    a given threshold. Therefore, we will only instrument the free() associated to
-   those allocations. To this end, we store in malloc entries a vector of pointers
-   returned by malloc/realloc that surpass the threshold and that may need later
-   instrumentation of their respective free. */
-static void ** mallocentries = NULL;
-/* Capture also the size of the allocations */
-static size_t * mallocentries_sz = NULL;
-static unsigned nmallocentries_allocated = 0;
-static unsigned nmallocentries = 0;
-#define NMALLOCENTRIES_MALLOC 16*1024
+   those allocations. To this end, we store in malloc entries the pointers
+   returned by malloc/realloc that surpass the threshold (and their sizes) and
+   that may need later instrumentation of their respective free. As every
+   free() looks for its pointer, they are kept in a hash registry. */
+static Extrae_MallocRegistry_t mallocentries;
+static pthread_once_t mallocentries_once = PTHREAD_ONCE_INIT;
+
+extern int __in_free;
+
+/* The registry tables are allocated through the real allocator, so that
+   they are never tracked themselves. The real symbols are looked up before
+   taking any lock of the registry, as dlsym may allocate or free memory */
+static void Extrae_malloctrace_resolve (void)
+{
+	if (real_malloc == NULL)
+		real_malloc = EXTRAE_DL_INIT ("malloc");
+	if (real_free == NULL && !__in_free)
+	{
+		__in_free = TRUE;
+		real_free = EXTRAE_DL_INIT ("free");
+		__in_free = FALSE;
+	}
+}
+
+static void * Extrae_malloctrace_alloc (size_t s)
+{
+	assert (real_malloc != NULL);
+	return real_malloc (s);
+}
+
+static void Extrae_malloctrace_dealloc (void *p)
+{
+	assert (real_free != NULL);
+	real_free (p);
+}
+
+static void Extrae_malloctrace_init (void)
+{
+	Extrae_MallocRegistry_Init (&mallocentries, Extrae_malloctrace_alloc,
+	  Extrae_malloctrace_dealloc);
+}
 
 /* Registers a new address to be tracked for future free() calls */
-static pthread_mutex_t mutex_allocations = PTHREAD_MUTEX_INITIALIZER;
 static void Extrae_malloctrace_add (void *p, size_t s)
 {
 	if (p != NULL)
 	{
-		unsigned u;
-		assert (real_realloc != NULL);
-
-		pthread_mutex_lock (&mutex_allocations);
-	
-		if (nmallocentries == nmallocentries_allocated)
-		{
-			mallocentries = real_realloc (mallocentries,
-			  (nmallocentries_allocated+NMALLOCENTRIES_MALLOC) * sizeof(void*));
-			assert (mallocentries != NULL);
-			mallocentries_sz = (size_t*) real_realloc (mallocentries_sz,
-			  (nmallocentries_allocated+NMALLOCENTRIES_MALLOC) * sizeof(size_t));
-			assert (mallocentries != NULL);
-			for (u = nmallocentries_allocated;
-			     u < nmallocentries_allocated+NMALLOCENTRIES_MALLOC;
-			     u++)
-				mallocentries[u] = NULL;
-			nmallocentries_allocated += NMALLOCENTRIES_MALLOC;
-		}
-	
-		for (u = 0; u < nmallocentries_allocated; u++)
-			if (mallocentries[u] == NULL)
-			{
-				mallocentries[u]    = p;
-				mallocentries_sz[u] = s;
-				nmallocentries++;
-				break;
-			}
-
-		pthread_mutex_unlock (&mutex_allocations);
+		Extrae_malloctrace_resolve ();
+		pthread_once (&mallocentries_once, Extrae_malloctrace_init);
+		Extrae_MallocRegistry_Add (&mallocentries, p, s);
 	}
 }
 
 /* Removes an entry from the list of registered addresses */
 static int Extrae_malloctrace_remove (const void *p)
 {
-	unsigned found = FALSE;
 	if (p != NULL)
 	{
-		unsigned u;
-
-		pthread_mutex_lock (&mutex_allocations);
-
-		for (u = 0; u < nmallocentries_allocated; u++)
-			if (mallocentries[u] == p)
-			{
-				mallocentries[u]    = NULL;
-				mallocentries_sz[u] = 0;
-				nmallocentries--;
-				found = TRUE;
-				break;
-			}
-
-		pthread_mutex_unlock (&mutex_allocations);
+		pthread_once (&mallocentries_once, Extrae_malloctrace_init);
+		return Extrae_MallocRegistry_Remove (&mallocentries, p, NULL);
 	}
-	return found;
+	return FALSE;
 }
 
 static size_t Extrae_malloctrace_replace (const void *p1, void *p2, size_t s)
 {
 	size_t prev_sz = 0;
 
-	pthread_mutex_lock (&mutex_allocations);
-
-	int replaced = FALSE;
-	if (p1)
-	{
-		unsigned u;
-		for (u = 0; u < nmallocentries_allocated; u++)
-			if (mallocentries[u] == p1)
-			{
-				prev_sz = mallocentries_sz[u];
-				mallocentries[u]    = p2;
-				mallocentries_sz[u] = s;
-				replaced = TRUE;
-				break;
-			}
-	}
-
-	// If we didn't find the pointer, we probably omitted its creation (because of
-	// threshold, e.g.). Need to create an entry for this new allocation if it is
-	// above the threshold.
-	if (!replaced)
-	{
-		unsigned u;
-
-		if (nmallocentries == nmallocentries_allocated)
-		{
-			mallocentries = real_realloc (mallocentries,
-			  (nmallocentries_allocated+NMALLOCENTRIES_MALLOC) * sizeof(void*));
-			assert (mallocentries != NULL);
-			mallocentries_sz = (size_t*) real_realloc (mallocentries_sz,
-			  (nmallocentries_allocated+NMALLOCENTRIES_MALLOC) * sizeof(size_t));
-			assert (mallocentries != NULL);
-			for (u = nmallocentries_allocated;
-			     u < nmallocentries_allocated+NMALLOCENTRIES_MALLOC;
-			     u++)
-				mallocentries[u] = NULL;
-			nmallocentries_allocated += NMALLOCENTRIES_MALLOC;
-		}
-	
-		for (u = 0; u < nmallocentries_allocated; u++)
-			if (mallocentries[u] == NULL)
-			{
-				mallocentries[u]    = p2;
-				mallocentries_sz[u] = s;
-				nmallocentries++;
-				break;
-			}
-	}
+	Extrae_malloctrace_resolve ();
+	pthread_once (&mallocentries_once, Extrae_malloctrace_init);
 
-	pthread_mutex_unlock (&mutex_allocations);
+	// If we don't find the pointer, we probably omitted its creation (because of
+	// threshold, e.g.). Need to create an entry for this new allocation anyway.
+	if (p1 != NULL)
+		Extrae_MallocRegistry_Remove (&mallocentries, p1, &prev_sz);
+	if (p2 != NULL)
+		Extrae_MallocRegistry_Add (&mallocentries, p2, s);
 
 	return prev_sz;
 }
@@ -176,7 +176,14 @@ int xtr_hash_add (xtr_hash_t *hash, uintptr_t key, void *data)
 	{
 		// There was a previous key stored, get a free collision cell to fill
 		cell_to_add = hash->next_free_collision_cell;
-		if (cell_to_add == XTR_HASH_FULL) return 0;
+		if (cell_to_add == XTR_HASH_FULL)
+		{
+			if (hash->flags & XTR_HASH_LOCK)
+			{
+				pthread_rwlock_unlock(&hash->lock);
+			}
+			return 0;
+		}
 		hash->next_free_collision_cell = cell_to_add->next;
 		// Mark the hash cell with 1+ collisions
 		XTR_KEY_HASHED_WITH_COLLISION(cell, cell_to_add);
@@ -259,6 +266,7 @@ static int xtr_hash_search (xtr_hash_t *hash, uintptr_t key, xtr_hash_cell_t **p
  */
 int xtr_hash_query (xtr_hash_t *hash, uintptr_t key, void *data)
 {
+	int found = 0;
 	xtr_hash_cell_t *previous = NULL, *cell = NULL;
 
         if (hash->flags & XTR_HASH_LOCK)
@@ -278,7 +286,7 @@ int xtr_hash_query (xtr_hash_t *hash, uintptr_t key, void *data)
 		{
 			memcpy(data, cell->data, hash->data_size);
 		}
-		return 1;
+		found = 1;
 	}
 
         if (hash->flags & XTR_HASH_LOCK)
@@ -286,7 +294,7 @@ int xtr_hash_query (xtr_hash_t *hash, uintptr_t key, void *data)
                 pthread_rwlock_unlock(&hash->lock);
         }
 
-	return 0;
+	return found;
 }
 
 
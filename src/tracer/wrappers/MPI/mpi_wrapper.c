@@ -165,6 +165,7 @@ char *Extrae_core_get_mpits_file_name (void)
 
 xtr_hash_t *hash_requests = NULL; // MPI_Request stored in a hash in order to search them fast
 xtr_hash_t *hash_messages = NULL; // MPI_Message stored in a hash in order to search them fast
+xtr_hash_t *hash_comm_ranks = NULL; // Rank translation tables of the communicators, built on first use
 
 PR_Queue_t PR_queue;              // Persistent requests queue
 static int *ranks_global;         // Global ranks vector (from 1 to NProcs)
@@ -208,94 +209,151 @@ int getMsgSizeFromCountAndDatatype(int count, MPI_Datatype datatype)
 }
 
 /******************************************************************************
- ***  translateLocalToGlobalRank
+ ***  BuildCommRanks
+ ***  Computes the table that translates the local ranks of 'comm' (the remote
+ ***  ones for intercommunicators) into MPI_COMM_WORLD ranks.
  ******************************************************************************/
 
-void translateLocalToGlobalRank (MPI_Comm comm, MPI_Group group, int partner_local, int *partner_world, int send_or_recv)
+static void BuildCommRanks (MPI_Comm comm, xtr_hash_data_comm_ranks_t *ranks)
 {
-	int inter = 0;
+	MPI_Group group = MPI_GROUP_NULL;
+	int inter = 0, i, *local_ranks;
 
-	/* If rank in MPI_COMM_WORLD or if partner_local is PROC_NULL or any source,
-	   return value directly */
-	if (comm == MPI_COMM_WORLD || comm == MPI_COMM_NULL || partner_local == MPI_PROC_NULL || partner_local == MPI_ANY_SOURCE)
-	{
-		*partner_world = partner_local;
-	}
-	else
-	{
-		PMPI_Comm_test_inter (comm, &inter);	
+	ranks->size = 0;
+	ranks->world_ranks = NULL;
 
-		if (inter)
-		{
-			// The communicator is an intercommunicator
+	PMPI_Comm_test_inter (comm, &inter);
+
+	if (inter)
+	{
+		// The communicator is an intercommunicator
 
 #if defined(MPI_SUPPORTS_MPI_COMM_SPAWN)
-			// The intercommunicator was created through MPI_Comm_spawn => each process has its own MPI_COMM_WORLD
-			
-			int *was_spawned, flag_spawned = FALSE;
-			PMPI_Comm_get_attr(comm, XTR_SPAWNED_INTERCOMM, &was_spawned, &flag_spawned);
+		// The intercommunicator was created through MPI_Comm_spawn => each process has its own MPI_COMM_WORLD
 
-			MPI_Comm parent;
-			PMPI_Comm_get_parent(&parent);
+		int *was_spawned, flag_spawned = FALSE;
+		PMPI_Comm_get_attr(comm, XTR_SPAWNED_INTERCOMM, &was_spawned, &flag_spawned);
 
-			if (flag_spawned && *was_spawned)
-			{
-				// Parent process sends/recvs to/from children -- When interacting with an specific child, there's no need to translate ranks
-				*partner_world = partner_local;
-			}
-			else if ((comm == parent) && (parent != MPI_COMM_NULL))
+		MPI_Comm parent;
+		PMPI_Comm_get_parent(&parent);
+
+		if (flag_spawned && *was_spawned)
+		{
+			// Parent process sends/recvs to/from children -- When interacting with an specific child, there's no need to translate ranks
+			return;
+		}
+		else if ((comm == parent) && (parent != MPI_COMM_NULL))
+		{
+			// Child process sends/recvs to/from parent -- Translate the local parent rank into its MPI_COMM_WORLD rank
+			if (ParentWorldRanks != NULL)
 			{
-				// Child process sends/recvs to/from parent -- Translate the local parent rank into its MPI_COMM_WORLD rank
-				if (ParentWorldRanks != NULL)
-					*partner_world = ParentWorldRanks[partner_local];
-				else
-					*partner_world = partner_local; // Should never happen
+				PMPI_Comm_remote_size (comm, &ranks->size);
+				xmalloc (ranks->world_ranks, sizeof(int) * ranks->size);
+				memcpy (ranks->world_ranks, ParentWorldRanks, sizeof(int) * ranks->size);
 			}
-			else
+			return;
+		}
 #endif
-			{
-				// The intercommunicator was created through MPI_Intercomm_create => there's only 1 MPI_COMM_WORLD 
+		// The intercommunicator was created through MPI_Intercomm_create => there's only 1 MPI_COMM_WORLD 
+		PMPI_Comm_remote_group (comm, &group);
+	}
+	else
+	{
+		// The communicator is an intracommunicator
+		PMPI_Comm_group (comm, &group);
+	}
 
-				MPI_Group remote_group;
-				int remote_group_size;
-				int *local_ranks, *world_ranks;
+	if ((group != MPI_GROUP_NULL) && (group != MPI_GROUP_EMPTY))
+	{
+		PMPI_Group_size (group, &ranks->size);
 
-				PMPI_Comm_remote_group(comm, &remote_group);
-				PMPI_Group_size(remote_group, &remote_group_size);
-				local_ranks = (int *)malloc(sizeof(int) * remote_group_size);
-				world_ranks = (int *)malloc(sizeof(int) * remote_group_size);
-				for (int i = 0; i < remote_group_size; i++) local_ranks[i] = i;
+		xmalloc (local_ranks, sizeof(int) * ranks->size);
+		xmalloc (ranks->world_ranks, sizeof(int) * ranks->size);
+		for (i = 0; i < ranks->size; i++)
+			local_ranks[i] = i;
 
-				PMPI_Group_translate_ranks (remote_group, remote_group_size, local_ranks, CommWorldRanks, world_ranks); 
+		PMPI_Group_translate_ranks (group, ranks->size, local_ranks, CommWorldRanks, ranks->world_ranks);
 
-				*partner_world = world_ranks[partner_local];
+		for (i = 0; i < ranks->size; i++)
+			if (ranks->world_ranks[i] == MPI_UNDEFINED)
+				ranks->world_ranks[i] = i;
 
-				free(local_ranks);
-				free(world_ranks);
-			}
-		}
-		else
-		{
-			// The communicator is an intracommunicator
+		xfree (local_ranks);
+		PMPI_Group_free (&group);
+	}
+}
 
-			// Get the communicator group if not provided
-			if (group == MPI_GROUP_NULL)
-			{
-				PMPI_Comm_group (comm, &group);
-			}
+/******************************************************************************
+ ***  GetCommRanks
+ ***  Returns the rank translation table of 'comm', building it on first use.
+ ***  Returns FALSE if the table could not be cached and the caller owns it.
+ ******************************************************************************/
 
-			if ((group != MPI_GROUP_NULL) && (group != MPI_GROUP_EMPTY))
-			{
-				// Translate the rank 
-				PMPI_Group_translate_ranks (group, 1, &partner_local, CommWorldRanks, partner_world); 
-				if (*partner_world == MPI_UNDEFINED) *partner_world = partner_local;
-				PMPI_Group_free (&group);
-			}
-			else
-			{
-				*partner_world = partner_local;
-			}
-		}
+static int GetCommRanks (MPI_Comm comm, xtr_hash_data_comm_ranks_t *ranks)
+{
+	static pthread_mutex_t build_mtx = PTHREAD_MUTEX_INITIALIZER;
+	int cached = TRUE;
+
+	if (xtr_hash_query (hash_comm_ranks, MPI_COMM_TO_HASH_KEY(comm), ranks))
+		return TRUE;
+
+	/* Serialize the misses so that concurrent threads do not insert the
+	   same communicator twice */
+	pthread_mutex_lock (&build_mtx);
+	if (!xtr_hash_query (hash_comm_ranks, MPI_COMM_TO_HASH_KEY(comm), ranks))
+	{
+		BuildCommRanks (comm, ranks);
+		cached = xtr_hash_add (hash_comm_ranks, MPI_COMM_TO_HASH_KEY(comm), ranks);
+	}
+	pthread_mutex_unlock (&build_mtx);
+
+	return cached;
+}
+
+/******************************************************************************
+ ***  InvalidateCommRanks
+ ***  Drops the cached rank translation table of 'comm'. Must be called when
+ ***  the communicator is freed, as its handle may be reused afterwards.
+ ******************************************************************************/
+
+void InvalidateCommRanks (MPI_Comm comm)
+{
+	xtr_hash_data_comm_ranks_t ranks;
+
+	if (hash_comm_ranks == NULL || comm == MPI_COMM_WORLD || comm == MPI_COMM_NULL)
+		return;
+
+	if (xtr_hash_fetch (hash_comm_ranks, MPI_COMM_TO_HASH_KEY(comm), &ranks))
+		xfree (ranks.world_ranks);
+}
+
+/******************************************************************************
+ ***  translateLocalToGlobalRank
+ ******************************************************************************/
+
+void translateLocalToGlobalRank (MPI_Comm comm, int partner_local, int *partner_world, int send_or_recv)
+{
+	xtr_hash_data_comm_ranks_t ranks;
+
+	UNREFERENCED_PARAMETER(send_or_recv);
+
+	/* If rank in MPI_COMM_WORLD or if partner_local is PROC_NULL or any source,
+	   return value directly */
+	if (comm == MPI_COMM_WORLD || comm == MPI_COMM_NULL || partner_local == MPI_PROC_NULL || partner_local == MPI_ANY_SOURCE)
+	{
+		*partner_world = partner_local;
+	}
+	else
+	{
+		int cached = GetCommRanks (comm, &ranks);
+
+		if (ranks.world_ranks != NULL && partner_local >= 0 && partner_local < ranks.size)
+			*partner_world = ranks.world_ranks[partner_local];
+		else
+			*partner_world = partner_local;
+
+		if (!cached)
+			xfree (ranks.world_ranks);
 	}
 }
 
@@ -326,7 +384,7 @@ static void Traceja_Persistent_Request (MPI_Request* reqid, iotimer_t temps)
 
 	send_or_recv = (p_request->tipus == MPI_IRECV_EV ? OP_TYPE_RECV : OP_TYPE_SEND );
 
-	translateLocalToGlobalRank (p_request->comm, MPI_GROUP_NULL, p_request->task, &src_world, send_or_recv);
+	translateLocalToGlobalRank (p_request->comm, p_request->task, &src_world, send_or_recv);
 
 	if (p_request->tipus == MPI_IRECV_EV)
 	{
@@ -987,6 +1045,7 @@ void PMPI_Init_Wrapper (MPI_Fint *ierror)
 
 	hash_requests = xtr_hash_new(XTR_HASH_SIZE_MEDIUM, sizeof(xtr_hash_data_request_t), XTR_HASH_NONE);
 	hash_messages = xtr_hash_new(XTR_HASH_SIZE_TINY, sizeof(xtr_hash_data_message_t), XTR_HASH_NONE);
+	hash_comm_ranks = xtr_hash_new(XTR_HASH_SIZE_TINY, sizeof(xtr_hash_data_comm_ranks_t), XTR_HASH_NONE);
 
 	PR_queue_init (&PR_queue);
 
@@ -1107,6 +1166,7 @@ void PMPI_Init_thread_Wrapper (MPI_Fint *required, MPI_Fint *provided, MPI_Fint
 
         hash_requests = xtr_hash_new(XTR_HASH_SIZE_MEDIUM, sizeof(xtr_hash_data_request_t), XTR_HASH_LOCK);
         hash_messages = xtr_hash_new(XTR_HASH_SIZE_TINY, sizeof(xtr_hash_data_message_t), XTR_HASH_LOCK);
+        hash_comm_ranks = xtr_hash_new(XTR_HASH_SIZE_TINY, sizeof(xtr_hash_data_comm_ranks_t), XTR_HASH_LOCK);
 
 	PR_queue_init (&PR_queue);
 
@@ -1443,11 +1503,11 @@ void PMPI_Comm_Create_Wrapper (MPI_Fint *comm, MPI_Fint *group,
 
 void PMPI_Comm_Free_Wrapper (MPI_Fint *comm, MPI_Fint *ierror)
 {
-	UNREFERENCED_PARAMETER(comm);
-
 	TRACE_MPIEVENT (LAST_READ_TIME, MPI_COMM_FREE_EV, EVT_BEGIN, EMPTY, EMPTY,
 		EMPTY, EMPTY, EMPTY);
 
+	InvalidateCommRanks (PMPI_Comm_f2c (*comm));
+
 	*ierror = MPI_SUCCESS;
 
 	TRACE_MPIEVENT (TIME, MPI_COMM_FREE_EV, EVT_END, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY);
@@ -1880,6 +1940,7 @@ int MPI_Init_C_Wrapper (int *argc, char ***argv)
 
 	hash_requests = xtr_hash_new(XTR_HASH_SIZE_MEDIUM, sizeof(xtr_hash_data_request_t), XTR_HASH_NONE);
 	hash_messages = xtr_hash_new(XTR_HASH_SIZE_TINY, sizeof(xtr_hash_data_message_t), XTR_HASH_NONE);
+	hash_comm_ranks = xtr_hash_new(XTR_HASH_SIZE_TINY, sizeof(xtr_hash_data_comm_ranks_t), XTR_HASH_NONE);
 
 	PR_queue_init (&PR_queue);
 
@@ -1998,6 +2059,7 @@ int MPI_Init_thread_C_Wrapper (int *argc, char ***argv, int required, int *provi
 
 	hash_requests = xtr_hash_new(XTR_HASH_SIZE_MEDIUM, sizeof(xtr_hash_data_request_t), XTR_HASH_LOCK);
 	hash_messages = xtr_hash_new(XTR_HASH_SIZE_TINY, sizeof(xtr_hash_data_message_t), XTR_HASH_LOCK);
+	hash_comm_ranks = xtr_hash_new(XTR_HASH_SIZE_TINY, sizeof(xtr_hash_data_comm_ranks_t), XTR_HASH_LOCK);
 	
 	PR_queue_init (&PR_queue);
 
@@ -2345,11 +2407,11 @@ int MPI_Comm_create_C_Wrapper (MPI_Comm comm, MPI_Group group, MPI_Comm *newcomm
 
 int MPI_Comm_free_C_Wrapper (MPI_Comm *comm)
 {
-	UNREFERENCED_PARAMETER(comm);
-
 	TRACE_MPIEVENT (LAST_READ_TIME, MPI_COMM_FREE_EV, EVT_BEGIN, EMPTY, EMPTY,
 		EMPTY, EMPTY, EMPTY);
 
+	InvalidateCommRanks (*comm);
+
 	TRACE_MPIEVENT (TIME, MPI_COMM_CREATE_EV, EVT_END, EMPTY, EMPTY, EMPTY, EMPTY,
 	  EMPTY);
 
@@ -2749,7 +2811,7 @@ void Extrae_MPI_stats_Wrapper (iotimer_t timestamp)
     MPI_STATS_OTHER_COUNT_EV
   };
 
-  unsigned int vec_params[MPI_STATS_EVENTS_COUNT] = {
+  unsigned long long vec_params[MPI_STATS_EVENTS_COUNT] = {
     global_mpi_stats->P2P_Communications, 
     global_mpi_stats->P2P_Bytes_Sent,
     global_mpi_stats->P2P_Bytes_Recv, 
@@ -2759,8 +2821,8 @@ void Extrae_MPI_stats_Wrapper (iotimer_t timestamp)
     global_mpi_stats->Elapsed_Time_In_MPI, 
     global_mpi_stats->P2P_Communications_In,
     global_mpi_stats->P2P_Communications_Out,
-    mpi_stats_get_num_partners(global_mpi_stats, global_mpi_stats->P2P_Partner_In),
-    mpi_stats_get_num_partners(global_mpi_stats, global_mpi_stats->P2P_Partner_Out),
+    mpi_stats_get_num_partners_in(global_mpi_stats),
+    mpi_stats_get_num_partners_out(global_mpi_stats),
     (global_mpi_stats->Elapsed_Time_In_MPI - global_mpi_stats->Elapsed_Time_In_P2P_MPI - global_mpi_stats->Elapsed_Time_In_COLLECTIVE_MPI),
     global_mpi_stats->Elapsed_Time_In_P2P_MPI,
     global_mpi_stats->Elapsed_Time_In_COLLECTIVE_MPI,
@@ -3040,33 +3102,7 @@ void Extrae_MPI_prepareDirectoryStructures (int me, int world_size)
 	}
 }
 
-void getCommunicatorGroup(MPI_Comm comm, MPI_Group *group)
-{
-	int ret, inter;
-
-        if (comm == MPI_COMM_WORLD)
-        {
-                *group = MPI_GROUP_NULL;
-        }
-        else
-        {
-                ret = PMPI_Comm_test_inter (comm, &inter);
-                MPI_CHECK(ret, PMPI_Comm_test_inter);
-
-                if (inter)
-                {
-                        ret = PMPI_Comm_remote_group (comm, group);
-                        MPI_CHECK(ret, PMPI_Comm_remote_group);
-                }
-                else
-                {
-                        ret = PMPI_Comm_group (comm, group);
-                        MPI_CHECK(ret, PMPI_Comm_group);
-                }
-        }
-}
-
-void getCommDataFromStatus (MPI_Status *status, MPI_Datatype datatype, MPI_Comm comm, MPI_Group group, int *size, int *tag, int *global_source)
+void getCommDataFromStatus (MPI_Status *status, MPI_Datatype datatype, MPI_Comm comm, int *size, int *tag, int *global_source)
 {
   int recved_count;
   int local_source;
@@ -3086,7 +3122,7 @@ void getCommDataFromStatus (MPI_Status *status, MPI_Datatype datatype, MPI_Comm
   local_source = status->MPI_SOURCE;
 
   // Transform local rank into MPI_COMM_WORLD rank
-  translateLocalToGlobalRank (comm, group, local_source, global_source, OP_TYPE_RECV);
+  translateLocalToGlobalRank (comm, local_source, global_source, OP_TYPE_RECV);
 }
 
 void SaveRequest(MPI_Request request, MPI_Comm comm)
@@ -3096,7 +3132,6 @@ void SaveRequest(MPI_Request request, MPI_Comm comm)
 		xtr_hash_data_request_t request_data;
 
 		request_data.commid = comm;
-		getCommunicatorGroup(comm, &request_data.group);
 
 		xtr_hash_add (hash_requests, MPI_REQUEST_TO_HASH_KEY(request), &request_data);
 	}
@@ -3132,7 +3167,7 @@ void ProcessRequest(iotimer_t ts, MPI_Request request, MPI_Status *status)
 				With the source rank and the communicator, we translate the local rank into the global rank.
 				*/
 
-				getCommDataFromStatus(status, MPI_BYTE, request_data.commid, request_data.group, &size, &tag, &src_world);
+				getCommDataFromStatus(status, MPI_BYTE, request_data.commid, &size, &tag, &src_world);
 
 				updateStats_P2P(global_mpi_stats, src_world, size, 0);
   
@@ -3168,7 +3203,6 @@ void SaveMessage(MPI_Message message, MPI_Comm comm)
 		xtr_hash_data_message_t message_data;
 
 		message_data.commid = comm;
-		getCommunicatorGroup(comm, &message_data.group);
 
 		xtr_hash_add (hash_messages, MPI_MESSAGE_TO_HASH_KEY(message), &message_data);
 	}
@@ -3190,7 +3224,6 @@ MPI_Comm ProcessMessage(MPI_Message message, MPI_Request *request)
 	
 				// Fill request communicator data
 				request_data.commid = message_data.commid;
-				request_data.group  = message_data.group;
 
 				// Save the request in the hash with the message's comm data
 				xtr_hash_add(hash_requests, MPI_REQUEST_TO_HASH_KEY(*request), &request_data);
@@ -80,11 +80,13 @@ void Extrae_MPI_prepareDirectoryStructures (int me, int world_size);
 
 void Extrae_MPI_stats_Wrapper (iotimer_t timestamp);
 
-void getCommDataFromStatus (MPI_Status *status, MPI_Datatype datatype, MPI_Comm comm, MPI_Group group, int *size, int *tag, int *global_source);
-void translateLocalToGlobalRank (MPI_Comm comm, MPI_Group group, int dest, int *receiver, int send_or_recv);
+void getCommDataFromStatus (MPI_Status *status, MPI_Datatype datatype, MPI_Comm comm, int *size, int *tag, int *global_source);
+void translateLocalToGlobalRank (MPI_Comm comm, int dest, int *receiver, int send_or_recv);
+void InvalidateCommRanks (MPI_Comm comm);
 
 #define MPI_REQUEST_TO_HASH_KEY(r) ((uintptr_t)r)
 #define MPI_MESSAGE_TO_HASH_KEY(m) ((uintptr_t)m)
+#define MPI_COMM_TO_HASH_KEY(c)    ((uintptr_t)c)
 
 /** 
  * xtr_hash_data_request_t
@@ -94,7 +96,6 @@ void translateLocalToGlobalRank (MPI_Comm comm, MPI_Group group, int dest, int *
 typedef struct xtr_hash_data_request_t
 {
 	MPI_Comm  commid;
-	MPI_Group group;
 } xtr_hash_data_request_t;
 
 /** 
@@ -105,11 +106,24 @@ typedef struct xtr_hash_data_request_t
 typedef struct xtr_hash_data_message_t
 {
 	MPI_Comm  commid;
-	MPI_Group group;
 } xtr_hash_data_message_t;
 
+/** 
+ * xtr_hash_data_comm_ranks_t
+ * 
+ * This structure holds the local to MPI_COMM_WORLD rank translation table of a
+ * communicator. For intercommunicators the table refers to the remote group.
+ * A NULL 'world_ranks' means that local ranks are already world ranks.
+ */
+typedef struct xtr_hash_data_comm_ranks_t
+{
+	int  size;
+	int *world_ranks;
+} xtr_hash_data_comm_ranks_t;
+
 extern xtr_hash_t *hash_requests;     /* MPI_Request stored in a hash in order to search them fast */
 extern xtr_hash_t *hash_messages;     /* MPI_Message stored in a hash in order to search them fast */
+extern xtr_hash_t *hash_comm_ranks;   /* Rank translation tables of the communicators */
 extern PR_Queue_t PR_queue;     /* Persistent requests queue */
 
 /* Fortran Wrappers */
@@ -96,7 +96,7 @@ int MPI_Bsend_C_Wrapper (void *buf, int count, MPI_Datatype datatype, int dest,
 
 	size = getMsgSizeFromCountAndDatatype (count, datatype);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, dest, &receiver, OP_TYPE_SEND);
+	translateLocalToGlobalRank (comm, dest, &receiver, OP_TYPE_SEND);
 
 	/*
 	 *   event  : BSEND_EV                     value  : EVT_BEGIN
@@ -134,7 +134,7 @@ int MPI_Ssend_C_Wrapper (void *buf, int count, MPI_Datatype datatype, int dest,
 
 	size = getMsgSizeFromCountAndDatatype (count, datatype);        
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, dest, &receiver, OP_TYPE_SEND);
+	translateLocalToGlobalRank (comm, dest, &receiver, OP_TYPE_SEND);
 
 	/*
 	 *   event  : SSEND_EV                     value  : EVT_BEGIN
@@ -173,7 +173,7 @@ int MPI_Rsend_C_Wrapper (void *buf, int count, MPI_Datatype datatype, int dest,
 
 	size = getMsgSizeFromCountAndDatatype (count, datatype);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, dest, &receiver, OP_TYPE_SEND);
+	translateLocalToGlobalRank (comm, dest, &receiver, OP_TYPE_SEND);
 
 	/*
 	 *   event  : RSEND_EV                     value  : EVT_BEGIN
@@ -212,7 +212,7 @@ int MPI_Send_C_Wrapper (void *buf, int count, MPI_Datatype datatype, int dest,
 
 	size = getMsgSizeFromCountAndDatatype (count, datatype);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, dest, &receiver, OP_TYPE_SEND);
+	translateLocalToGlobalRank (comm, dest, &receiver, OP_TYPE_SEND);
 
 	/*
 	 *   event  : SEND_EV                      value  : EVT_BEGIN
@@ -251,7 +251,7 @@ int MPI_Ibsend_C_Wrapper (void *buf, int count, MPI_Datatype datatype, int dest,
 
 	size = getMsgSizeFromCountAndDatatype (count, datatype);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, dest, &receiver, OP_TYPE_SEND);
+	translateLocalToGlobalRank (comm, dest, &receiver, OP_TYPE_SEND);
 
 	/*
 	 *   event  : IBSEND_EV                    value  : EVT_BEGIN
@@ -290,7 +290,7 @@ int MPI_Isend_C_Wrapper (void *buf, int count, MPI_Datatype datatype, int dest,
 
 	size = getMsgSizeFromCountAndDatatype (count, datatype);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, dest, &receiver, OP_TYPE_SEND);
+	translateLocalToGlobalRank (comm, dest, &receiver, OP_TYPE_SEND);
 
 	/*
 	 *   event  : ISEND_EV                     value  : EVT_BEGIN
@@ -329,7 +329,7 @@ int MPI_Issend_C_Wrapper (void *buf, int count, MPI_Datatype datatype, int dest,
 
 	size = getMsgSizeFromCountAndDatatype (count, datatype);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, dest, &receiver, OP_TYPE_SEND);
+	translateLocalToGlobalRank (comm, dest, &receiver, OP_TYPE_SEND);
 
 	/*
 	 *   event  : ISSEND_EV                    value  : EVT_BEGIN
@@ -368,7 +368,7 @@ int MPI_Irsend_C_Wrapper (void *buf, int count, MPI_Datatype datatype, int dest,
 
 	size = getMsgSizeFromCountAndDatatype (count, datatype);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, dest, &receiver, OP_TYPE_SEND);
+	translateLocalToGlobalRank (comm, dest, &receiver, OP_TYPE_SEND);
 
 	/*
 	 *   event  : IRSEND_EV                    value  : EVT_BEGIN
@@ -408,7 +408,7 @@ int MPI_Recv_C_Wrapper (void *buf, int count, MPI_Datatype datatype, int source,
 
 	size = getMsgSizeFromCountAndDatatype (count, datatype);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, source, &src_world, OP_TYPE_RECV);
+	translateLocalToGlobalRank (comm, source, &src_world, OP_TYPE_RECV);
 
 	/*
 	 *   event  : RECV_EV                      value  : EVT_BEGIN    
@@ -422,7 +422,7 @@ int MPI_Recv_C_Wrapper (void *buf, int count, MPI_Datatype datatype, int source,
  
 	ierror = PMPI_Recv (buf, count, datatype, source, tag, comm, ptr_status);
 
-	getCommDataFromStatus (ptr_status, datatype, comm, MPI_GROUP_NULL, &size, &sender_tag, &src_world);
+	getCommDataFromStatus (ptr_status, datatype, comm, &size, &sender_tag, &src_world);
 
 	/*
 	 *   event  : RECV_EV                      value  : EVT_END
@@ -451,7 +451,7 @@ int MPI_Irecv_C_Wrapper (void *buf, int count, MPI_Datatype datatype,
 
 	size = getMsgSizeFromCountAndDatatype (count, datatype);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, source, &src_world, OP_TYPE_RECV);
+	translateLocalToGlobalRank (comm, source, &src_world, OP_TYPE_RECV);
 
 	/*
 	 *   event  : IRECV_EV                     value  : EVT_BEGIN
@@ -507,7 +507,7 @@ int MPI_Mrecv_C_Wrapper (void *buf, int count, MPI_Datatype datatype,
 
 	comm = ProcessMessage (save_message, NULL);
 
-	getCommDataFromStatus (ptr_status, datatype, comm, MPI_GROUP_NULL, &size, &sender_tag, &src_world);
+	getCommDataFromStatus (ptr_status, datatype, comm, &size, &sender_tag, &src_world);
 
 	/*
 	 *   event  : MRECV_EV                          value  : EVT_END
@@ -1601,7 +1601,7 @@ int MPI_Sendrecv_C_Wrapper (void *sendbuf, int sendcount, MPI_Datatype sendtype,
 
 	SentSize = getMsgSizeFromCountAndDatatype (sendcount, sendtype);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, dest, &ReceiverRank, OP_TYPE_SEND);
+	translateLocalToGlobalRank (comm, dest, &ReceiverRank, OP_TYPE_SEND);
 
 	/*
 	 *   event  : SENDRECV_EV                value  : EVT_BEGIN
@@ -1617,7 +1617,7 @@ int MPI_Sendrecv_C_Wrapper (void *sendbuf, int sendcount, MPI_Datatype sendtype,
 	                        recvbuf, recvcount, recvtype, source, recvtag, 
 	                        comm,    ptr_status);
 
-	getCommDataFromStatus (ptr_status, recvtype, comm, MPI_GROUP_NULL, &ReceivedSize, &Tag, &SenderRank);
+	getCommDataFromStatus (ptr_status, recvtype, comm, &ReceivedSize, &Tag, &SenderRank);
 
 	/*
 	 *   event  : SENDRECV_EV                value  : EVT_END
@@ -1648,7 +1648,7 @@ int MPI_Sendrecv_replace_C_Wrapper (void *buf, int count, MPI_Datatype type,
 
 	SentSize = getMsgSizeFromCountAndDatatype (count, type);
 
-	translateLocalToGlobalRank (comm, MPI_GROUP_NULL, dest, &ReceiverRank, OP_TYPE_SEND);
+	translateLocalToGlobalRank (comm, dest, &ReceiverRank, OP_TYPE_SEND);
 	
 	/*
 	 *   event  : SENDRECV_REPLACE_EV        value  : EVT_BEGIN
@@ -1662,7 +1662,7 @@ int MPI_Sendrecv_replace_C_Wrapper (void *buf, int count, MPI_Datatype type,
 
 	ierror = PMPI_Sendrecv_replace (buf, count, type, dest, sendtag, source, recvtag, comm, ptr_status);
 
-	getCommDataFromStatus (ptr_status, type, comm, MPI_GROUP_NULL, &ReceivedSize, &Tag, &SenderRank);
+	getCommDataFromStatus (ptr_status, type, comm, &ReceivedSize, &Tag, &SenderRank);
 
 	/*
 	 *   event  : SENDRECV_REPLACE_EV        value  : EVT_END
@@ -108,7 +108,7 @@ void PMPI_BSend_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 
 	size = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *dest, &receiver_world, OP_TYPE_SEND);
+	translateLocalToGlobalRank (c_comm, *dest, &receiver_world, OP_TYPE_SEND);
 
 	/*
 	 *   event  : BSEND_EV                          value  : EVT_BEGIN
@@ -148,7 +148,7 @@ void PMPI_SSend_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 
 	size = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *dest, &receiver_world, OP_TYPE_SEND);
+	translateLocalToGlobalRank (c_comm, *dest, &receiver_world, OP_TYPE_SEND);
 
 	/*
 	 *   event  : SSEND_EV                          value  : EVT_BEGIN
@@ -187,7 +187,7 @@ void PMPI_RSend_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 
 	size = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *dest, &receiver_world, OP_TYPE_SEND);
+	translateLocalToGlobalRank (c_comm, *dest, &receiver_world, OP_TYPE_SEND);
 
 	/*
 	 *   event  : RSEND_EV                   value  : EVT_BEGIN
@@ -226,7 +226,7 @@ void PMPI_Send_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 
 	size = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *dest, &receiver_world, OP_TYPE_SEND);
+	translateLocalToGlobalRank (c_comm, *dest, &receiver_world, OP_TYPE_SEND);
 
 	/*
 	 *   event  : SEND_EV                           value  : EVT_BEGIN
@@ -267,7 +267,7 @@ void PMPI_IBSend_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 
 	size = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *dest, &receiver_world, OP_TYPE_SEND);
+	translateLocalToGlobalRank (c_comm, *dest, &receiver_world, OP_TYPE_SEND);
 
 	/*
 	 *   event  : IBSEND_EV                         value  : EVT_BEGIN
@@ -308,7 +308,7 @@ void PMPI_ISend_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 
 	size = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *dest, &receiver_world, OP_TYPE_SEND);
+	translateLocalToGlobalRank (c_comm, *dest, &receiver_world, OP_TYPE_SEND);
 
 	/*
 	 *   event  : ISEND_EV                          value  : EVT_BEGIN
@@ -349,7 +349,7 @@ void PMPI_ISSend_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 
 	size = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *dest, &receiver_world, OP_TYPE_SEND);
+	translateLocalToGlobalRank (c_comm, *dest, &receiver_world, OP_TYPE_SEND);
 
 	/*
 	 *   event : ISSEND_EV                     value : EVT_BEGIN
@@ -390,7 +390,7 @@ void PMPI_IRSend_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 
 	size = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *dest, &receiver_world, OP_TYPE_SEND);
+	translateLocalToGlobalRank (c_comm, *dest, &receiver_world, OP_TYPE_SEND);
 
 	/*
 	 *   event  : IRSEND_EV                         value  : EVT_BEGIN
@@ -435,7 +435,7 @@ void PMPI_Recv_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 
 	size = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *source, &source_world, OP_TYPE_RECV);
+	translateLocalToGlobalRank (c_comm, *source, &source_world, OP_TYPE_RECV);
 
 	/*
 	 *   event  : RECV_EV                           value  : EVT_BEGIN    
@@ -450,7 +450,7 @@ void PMPI_Recv_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 	CtoF77 (pmpi_recv) (buf, count, datatype, source, tag, comm, f_status_ptr, ierror);
 
 	PMPI_Status_f2c (f_status_ptr, &c_status);
-	getCommDataFromStatus (&c_status, c_type, c_comm, MPI_GROUP_NULL, &size, &source_tag, &source_world);
+	getCommDataFromStatus (&c_status, c_type, c_comm, &size, &source_tag, &source_world);
 
 	/*
 	 *   event  : RECV_EV                           value  : EVT_END
@@ -482,7 +482,7 @@ void PMPI_IRecv_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 
 	size = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *source, &source_world, OP_TYPE_RECV);
+	translateLocalToGlobalRank (c_comm, *source, &source_world, OP_TYPE_RECV);
 
 	/*
 	 *   event  : IRECV_EV                          value  : EVT_BEGIN
@@ -543,7 +543,7 @@ void PMPI_Mrecv_Wrapper (void *buf, MPI_Fint *count, MPI_Fint *datatype,
 	c_comm = ProcessMessage (c_save_message, NULL);
 
 	PMPI_Status_f2c (f_status_ptr, &c_status);
-	getCommDataFromStatus (&c_status, c_type, c_comm, MPI_GROUP_NULL, &size, &source_tag, &source_world);
+	getCommDataFromStatus (&c_status, c_type, c_comm, &size, &source_tag, &source_world);
 
 	/*
 	 *   event  : MRECV_EV                          value  : EVT_END
@@ -1571,7 +1571,7 @@ void MPI_Sendrecv_Fortran_Wrapper (void *sendbuf, MPI_Fint *sendcount,
 
 	SentSize = getMsgSizeFromCountAndDatatype (*sendcount, c_sendtype);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *dest, &ReceiverRank, OP_TYPE_SEND);
+	translateLocalToGlobalRank (c_comm, *dest, &ReceiverRank, OP_TYPE_SEND);
 
 	/*
 	 *   event  : SENDRECV_REPLACE_EV        value  : EVT_BEGIN
@@ -1588,7 +1588,7 @@ void MPI_Sendrecv_Fortran_Wrapper (void *sendbuf, MPI_Fint *sendcount,
 	                       comm, f_status_ptr, ierr);
 
 	PMPI_Status_f2c (f_status_ptr, &c_status);
-	getCommDataFromStatus (&c_status, c_recvtype, c_comm, MPI_GROUP_NULL, &ReceivedSize, &Tag, &SenderRank);
+	getCommDataFromStatus (&c_status, c_recvtype, c_comm, &ReceivedSize, &Tag, &SenderRank);
 
 	/*
 	 *   event  : SENDRECV_REPLACE_EV        value  : EVT_END
@@ -1616,7 +1616,7 @@ void MPI_Sendrecv_replace_Fortran_Wrapper (void *buf, MPI_Fint *count, MPI_Fint
 
 	SentSize = getMsgSizeFromCountAndDatatype (*count, c_type);
 
-	translateLocalToGlobalRank (c_comm, MPI_GROUP_NULL, *dest, &ReceiverRank, OP_TYPE_SEND);
+	translateLocalToGlobalRank (c_comm, *dest, &ReceiverRank, OP_TYPE_SEND);
 
 	/*
 	 *   event  : SENDRECV_REPLACE_EV        value  : EVT_BEGIN
@@ -1631,7 +1631,7 @@ void MPI_Sendrecv_replace_Fortran_Wrapper (void *buf, MPI_Fint *count, MPI_Fint
 	CtoF77(pmpi_sendrecv_replace) (buf, count, type, dest, sendtag, source, recvtag, comm, f_status_ptr, ierr);
 
 	PMPI_Status_f2c (f_status_ptr, &c_status);
-	getCommDataFromStatus (&c_status, c_type, c_comm, MPI_GROUP_NULL, &ReceivedSize, &Tag, &SenderRank);
+	getCommDataFromStatus (&c_status, c_type, c_comm, &ReceivedSize, &Tag, &SenderRank);
 
 	/*
 	 *   event  : SENDRECV_REPLACE_EV        value  : EVT_END
@@ -0,0 +1,294 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include "common.h"
+
+#if HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#if HAVE_STRING_H
+# include <string.h>
+#endif
+#if HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
+#include "threadid.h"
+#include "wrapper.h"
+#include "trace_macros.h"
+#include "utils.h"
+#include "pthread_lock_stats.h"
+#include "pthread_lock_table.h"
+
+/**********************************************************************************************\
+ * This file contains the contention-only mode for the pthread locks instrumentation. The    *
+ * wrappers first try to take the lock and only trace the acquisitions that had to wait.     *
+ * Besides, each thread accumulates per lock address the number of acquisitions, how many    *
+ * of them were contended, the time waiting and the time holding the lock. These statistics  *
+ * are emitted as PTHREAD_LOCK_STATS_EV events (one group per lock used since the previous   *
+ * summary) after every flush of the thread buffer and when the tracing finalizes.           *
+\**********************************************************************************************/
+
+static int lock_contention_enabled = FALSE;
+
+/* Every thread's statistics by thread id, so that the summaries of all threads
+ * can be emitted when the tracing finalizes. Each OS thread caches the table of
+ * the thread id it last ran as, together with the generation in which it was
+ * looked up, so that a change of thread id or a cleanup invalidates the cache.
+ * The tables are never freed because other threads may still be using them. */
+static lock_stats_thread_t **lock_stats_threads = NULL;
+static unsigned lock_stats_num_threads = 0;
+static volatile unsigned lock_stats_generation = 1;
+static pthread_mutex_t lock_stats_threads_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread lock_stats_thread_t *lock_stats_self = NULL;
+static __thread unsigned lock_stats_self_thread = 0;
+static __thread unsigned lock_stats_self_generation = 0;
+
+/* Whether the running thread is updating or emitting statistics */
+static __thread int lock_stats_busy = FALSE;
+
+/**
+ * Extrae_pthread_instrument_locks_contention
+ *
+ * \param value Only trace the contended lock acquisitions and aggregate the
+ * rest into per-lock statistics.
+ */
+void Extrae_pthread_instrument_locks_contention (int value)
+{
+  lock_contention_enabled = value;
+}
+
+/**
+ * Extrae_get_pthread_instrument_locks_contention
+ *
+ * \return true if only the contended lock acquisitions are traced; false otherwise.
+ */
+int Extrae_get_pthread_instrument_locks_contention (void)
+{
+  return lock_contention_enabled;
+}
+
+/**
+ * Lock_Stats_Busy
+ *
+ * \return true while the running thread is updating or emitting statistics.
+ * The locks taken meanwhile (e.g. the registry mutex) must not be accounted.
+ */
+int Lock_Stats_Busy (void)
+{
+  return lock_stats_busy;
+}
+
+/* Returns the statistics of the running thread id, creating them if asked to */
+static lock_stats_thread_t * Lock_Stats_Self (int create)
+{
+  unsigned thread = THREADID;
+  lock_stats_thread_t *stats = NULL;
+
+  if (lock_stats_self != NULL && lock_stats_self_thread == thread &&
+      lock_stats_self_generation == lock_stats_generation)
+    return lock_stats_self;
+
+  /* Looking up the thread locks the registry mutex, which is wrapped too */
+  lock_stats_busy = TRUE;
+  lock_stats_self_generation = lock_stats_generation;
+
+  pthread_mutex_lock (&lock_stats_threads_mtx);
+  if (thread < lock_stats_num_threads)
+    stats = lock_stats_threads[thread];
+  if (stats == NULL && create)
+  {
+    if (thread >= lock_stats_num_threads)
+    {
+      unsigned i, n = thread + 1;
+
+      xrealloc (lock_stats_threads, lock_stats_threads, n * sizeof(lock_stats_thread_t *));
+      for (i = lock_stats_num_threads; i < n; i++)
+        lock_stats_threads[i] = NULL;
+      lock_stats_num_threads = n;
+    }
+
+    /* OS threads that share a thread id (e.g. after the runtime recycles it)
+     * share its statistics, as they share its buffer */
+    xmalloc (stats, sizeof(lock_stats_thread_t));
+    memset (stats, 0, sizeof(lock_stats_thread_t));
+    lock_stats_threads[thread] = stats;
+  }
+  pthread_mutex_unlock (&lock_stats_threads_mtx);
+
+  lock_stats_self_thread = thread;
+  lock_stats_self = stats;
+  lock_stats_busy = FALSE;
+  return stats;
+}
+
+/**
+ * Lock_Stats_Acquired
+ *
+ * Accounts an acquisition of a lock by the running thread.
+ * \param lock The mutex or rwlock
+ * \param kind LOCK_STATS_MUTEX, LOCK_STATS_RWLOCK_RD or LOCK_STATS_RWLOCK_WR
+ * \param caller Return address of the wrapper, to locate the call site
+ * \param contended Whether the lock was busy and the thread had to wait
+ * \param wait_begin Time when the thread started waiting, if contended
+ */
+void Lock_Stats_Acquired (void *lock, int kind, void *caller, int contended,
+  unsigned long long wait_begin)
+{
+  lock_stats_thread_t *stats = Lock_Stats_Self (TRUE);
+  unsigned long long now = TIME;
+
+  lock_stats_busy = TRUE;
+  Lock_Table_Acquired (stats, lock, kind, caller, contended, wait_begin, now);
+  lock_stats_busy = FALSE;
+}
+
+/**
+ * Lock_Stats_Released
+ *
+ * Accounts the release of a lock by the running thread, adding the time it was
+ * held once the outermost acquisition is released.
+ * \param lock The mutex or rwlock
+ */
+void Lock_Stats_Released (void *lock)
+{
+  lock_stats_thread_t *stats = Lock_Stats_Self (FALSE);
+
+  /* Locks taken before enabling the instrumentation or in other threads are not tracked */
+  if (stats != NULL)
+    Lock_Table_Released (stats, lock, TIME);
+}
+
+/**
+ * Lock_Stats_Resumed
+ *
+ * The mutex released by a condition wait was taken again, restart the time it
+ * is held without accounting a new acquisition.
+ * \param lock The mutex
+ */
+void Lock_Stats_Resumed (void *lock)
+{
+  lock_stats_thread_t *stats = Lock_Stats_Self (FALSE);
+
+  if (stats != NULL)
+    Lock_Table_Resumed (stats, lock, TIME);
+}
+
+static void Lock_Stats_Insert_Event (unsigned thread, unsigned long long time,
+  unsigned type, unsigned long long value)
+{
+  event_t evt;
+
+  evt.time = time;
+  evt.event = PTHREAD_LOCK_STATS_EV;
+  evt.value = type;
+  evt.param.misc_param.param = value;
+  HARDWARE_COUNTERS_READ (thread, evt, FALSE);
+  BUFFER_INSERT (thread, TRACING_BUFFER(thread), evt);
+}
+
+static void Lock_Stats_Emit_Thread (lock_stats_thread_t *stats, unsigned thread,
+  unsigned long long time)
+{
+  int i;
+
+  int busy = lock_stats_busy;
+
+  /* Inserting the summary may trigger a flush that would emit it again */
+  if (stats->emitting || TRACING_BUFFER(thread) == NULL)
+    return;
+  stats->emitting = TRUE;
+  lock_stats_busy = TRUE;
+
+  if (tracejant && TracingBitmap[TASKID])
+  {
+    for (i = 0; i < stats->num_dirty; i++)
+    {
+      lock_stats_entry_t *entry = &stats->locks[stats->dirty[i]];
+
+      Lock_Stats_Insert_Event (thread, time, PTHREAD_LOCK_STATS_ADDRESS_EV, (UINT64) entry->lock);
+      Lock_Stats_Insert_Event (thread, time, PTHREAD_LOCK_STATS_KIND_EV, entry->kind);
+      Lock_Stats_Insert_Event (thread, time, PTHREAD_LOCK_STATS_CALLER_EV, (UINT64) entry->caller);
+      Lock_Stats_Insert_Event (thread, time, PTHREAD_LOCK_STATS_ACQUISITIONS_EV, entry->acquisitions);
+      Lock_Stats_Insert_Event (thread, time, PTHREAD_LOCK_STATS_CONTENDED_EV, entry->contended);
+      Lock_Stats_Insert_Event (thread, time, PTHREAD_LOCK_STATS_WAIT_TIME_EV, entry->wait_time);
+      Lock_Stats_Insert_Event (thread, time, PTHREAD_LOCK_STATS_HOLD_TIME_EV, entry->hold_time);
+    }
+  }
+
+  Lock_Table_Reset (stats);
+  lock_stats_busy = busy;
+  stats->emitting = FALSE;
+}
+
+/**
+ * Lock_Stats_Emit
+ *
+ * Emits (and resets) the summary accumulated by the given thread.
+ * \param thread The thread whose statistics are emitted into its buffer
+ * \param time Timestamp of the summary events
+ */
+void Lock_Stats_Emit (unsigned thread, unsigned long long time)
+{
+  lock_stats_thread_t *stats = NULL;
+  int busy = lock_stats_busy;
+
+  if (!lock_contention_enabled)
+    return;
+
+  /* Do not account the registry mutex into the running thread statistics */
+  lock_stats_busy = TRUE;
+  pthread_mutex_lock (&lock_stats_threads_mtx);
+  if (thread < lock_stats_num_threads)
+    stats = lock_stats_threads[thread];
+  pthread_mutex_unlock (&lock_stats_threads_mtx);
+  lock_stats_busy = busy;
+
+  if (stats != NULL && stats->num_dirty > 0)
+    Lock_Stats_Emit_Thread (stats, thread, time);
+}
+
+/**
+ * Lock_Stats_CleanUp
+ *
+ * Disables the contention-only mode, discards the statistics not emitted yet
+ * and invalidates the table cached by every thread. The tables are kept
+ * because other threads may be in the middle of a lock call.
+ */
+void Lock_Stats_CleanUp (void)
+{
+  unsigned i;
+  int busy = lock_stats_busy;
+
+  lock_contention_enabled = FALSE;
+
+  lock_stats_busy = TRUE;
+  pthread_mutex_lock (&lock_stats_threads_mtx);
+  lock_stats_generation ++;
+  for (i = 0; i < lock_stats_num_threads; i++)
+    if (lock_stats_threads[i] != NULL)
+      Lock_Table_Reset (lock_stats_threads[i]);
+  pthread_mutex_unlock (&lock_stats_threads_mtx);
+  lock_stats_busy = busy;
+}
@@ -0,0 +1,45 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#ifndef __PTHREAD_LOCK_STATS_H__
+#define __PTHREAD_LOCK_STATS_H__
+
+enum
+{
+  LOCK_STATS_MUTEX = 1,
+  LOCK_STATS_RWLOCK_RD,
+  LOCK_STATS_RWLOCK_WR
+};
+
+void Extrae_pthread_instrument_locks_contention (int value);
+int  Extrae_get_pthread_instrument_locks_contention (void);
+
+int  Lock_Stats_Busy (void);
+void Lock_Stats_Acquired (void *lock, int kind, void *caller, int contended,
+  unsigned long long wait_begin);
+void Lock_Stats_Released (void *lock);
+void Lock_Stats_Resumed (void *lock);
+void Lock_Stats_Emit (unsigned thread, unsigned long long time);
+void Lock_Stats_CleanUp (void);
+
+#endif /* __PTHREAD_LOCK_STATS_H__ */
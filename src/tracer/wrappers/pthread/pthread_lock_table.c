@@ -0,0 +1,220 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include "common.h"
+
+#if HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#if HAVE_STRING_H
+# include <string.h>
+#endif
+
+#include "utils.h"
+#include "pthread_lock_table.h"
+
+static unsigned Lock_Table_Hash (void *lock, int mask)
+{
+  unsigned long long k = (unsigned long long) lock;
+
+  /* Locks are aligned, mix the upper bits into the lower ones */
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  return (unsigned) k & (unsigned) mask;
+}
+
+static void Lock_Table_Grow_Index (lock_stats_thread_t *stats)
+{
+  int i, num_slots = (stats->index_mask > 0) ? 2 * (stats->index_mask + 1) : 32;
+
+  xfree (stats->index);
+  xmalloc (stats->index, num_slots * sizeof(int));
+  memset (stats->index, 0, num_slots * sizeof(int));
+  stats->index_mask = num_slots - 1;
+
+  for (i = 0; i < stats->num_locks; i++)
+  {
+    unsigned slot = Lock_Table_Hash (stats->locks[i].lock, stats->index_mask);
+
+    while (stats->index[slot] != 0)
+      slot = (slot + 1) & stats->index_mask;
+    stats->index[slot] = i + 1;
+  }
+}
+
+lock_stats_entry_t * Lock_Table_Lookup (lock_stats_thread_t *stats, void *lock)
+{
+  lock_stats_entry_t *entry;
+  unsigned slot;
+
+  if (stats->index != NULL)
+  {
+    slot = Lock_Table_Hash (lock, stats->index_mask);
+    while (stats->index[slot] != 0)
+    {
+      entry = &stats->locks[stats->index[slot] - 1];
+      if (entry->lock == lock)
+        return entry;
+      slot = (slot + 1) & stats->index_mask;
+    }
+  }
+  return NULL;
+}
+
+static lock_stats_entry_t * Lock_Table_Insert (lock_stats_thread_t *stats, void *lock)
+{
+  lock_stats_entry_t *entry;
+  unsigned slot;
+  int pos;
+
+  /* Keep the index at most half full */
+  if (stats->index == NULL || 2 * (stats->num_locks + 1) > stats->index_mask + 1)
+    Lock_Table_Grow_Index (stats);
+
+  if (stats->num_locks == stats->max_locks)
+  {
+    stats->max_locks = (stats->max_locks > 0) ? 2 * stats->max_locks : 16;
+    xrealloc (stats->locks, stats->locks, stats->max_locks * sizeof(lock_stats_entry_t));
+    xrealloc (stats->dirty, stats->dirty, stats->max_locks * sizeof(int));
+  }
+
+  pos = stats->num_locks++;
+  entry = &stats->locks[pos];
+  memset (entry, 0, sizeof(lock_stats_entry_t));
+  entry->lock = lock;
+
+  slot = Lock_Table_Hash (lock, stats->index_mask);
+  while (stats->index[slot] != 0)
+    slot = (slot + 1) & stats->index_mask;
+  stats->index[slot] = pos + 1;
+
+  return entry;
+}
+
+static void Lock_Table_Touch (lock_stats_thread_t *stats, lock_stats_entry_t *entry)
+{
+  if (!entry->dirty)
+  {
+    entry->dirty = TRUE;
+    stats->dirty[stats->num_dirty++] = entry - stats->locks;
+  }
+}
+
+/**
+ * Lock_Table_Acquired
+ *
+ * Accounts an acquisition of a lock, and starts the time it is held unless
+ * it was already held (recursive mutexes and read locks).
+ * \param contended Whether the lock was busy and the thread had to wait
+ * \param wait_begin Time when the thread started waiting, if contended
+ * \param now Time when the lock was acquired
+ */
+void Lock_Table_Acquired (lock_stats_thread_t *stats, void *lock, int kind,
+  void *caller, int contended, unsigned long long wait_begin,
+  unsigned long long now)
+{
+  lock_stats_entry_t *entry;
+
+  entry = Lock_Table_Lookup (stats, lock);
+  if (entry == NULL)
+    entry = Lock_Table_Insert (stats, lock);
+  Lock_Table_Touch (stats, entry);
+
+  entry->kind = kind;
+  entry->acquisitions ++;
+  if (contended)
+  {
+    if (entry->contended == 0)
+      entry->caller = caller;
+    entry->contended ++;
+    entry->wait_time += now - wait_begin;
+  }
+  else if (entry->caller == NULL)
+    entry->caller = caller;
+
+  if (entry->depth++ == 0)
+    entry->acquired_at = now;
+}
+
+/**
+ * Lock_Table_Released
+ *
+ * Accounts the release of a lock, adding the time it was held once the
+ * outermost acquisition is released. Locks not acquired through the table
+ * are ignored.
+ */
+void Lock_Table_Released (lock_stats_thread_t *stats, void *lock,
+  unsigned long long now)
+{
+  lock_stats_entry_t *entry = Lock_Table_Lookup (stats, lock);
+
+  if (entry == NULL || entry->depth == 0)
+    return;
+
+  if (--entry->depth == 0)
+  {
+    Lock_Table_Touch (stats, entry);
+    entry->hold_time += now - entry->acquired_at;
+  }
+}
+
+/**
+ * Lock_Table_Resumed
+ *
+ * The mutex released by a condition wait was taken again, restart the time it
+ * is held without accounting a new acquisition.
+ */
+void Lock_Table_Resumed (lock_stats_thread_t *stats, void *lock,
+  unsigned long long now)
+{
+  lock_stats_entry_t *entry = Lock_Table_Lookup (stats, lock);
+
+  if (entry == NULL)
+    return;
+
+  if (entry->depth++ == 0)
+    entry->acquired_at = now;
+}
+
+/**
+ * Lock_Table_Reset
+ *
+ * Clears the statistics of the locks used since the last summary. The locks
+ * currently held keep their depth and acquisition time for the next summary.
+ */
+void Lock_Table_Reset (lock_stats_thread_t *stats)
+{
+  int i;
+
+  for (i = 0; i < stats->num_dirty; i++)
+  {
+    lock_stats_entry_t *entry = &stats->locks[stats->dirty[i]];
+
+    entry->dirty = FALSE;
+    entry->caller = NULL;
+    entry->acquisitions = entry->contended = 0;
+    entry->wait_time = entry->hold_time = 0;
+  }
+  stats->num_dirty = 0;
+}
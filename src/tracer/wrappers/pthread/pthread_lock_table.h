@@ -0,0 +1,68 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#ifndef __PTHREAD_LOCK_TABLE_H__
+#define __PTHREAD_LOCK_TABLE_H__
+
+/* Per-thread table of the locks used in the contention-only mode. Every lock
+   address has an entry with the number of acquisitions, how many of them were
+   contended, the time waiting and the time holding the lock, and the entries
+   used since the last summary are kept in a dirty list. The table is only
+   updated by the thread that owns it, and the times are given by the caller. */
+
+typedef struct
+{
+  void *lock;
+  void *caller;         /* Call site of the first contended (or else the first) acquisition */
+  int kind;
+  int depth;            /* Nested acquisitions of recursive mutexes and read locks */
+  int dirty;
+  unsigned long long acquisitions;
+  unsigned long long contended;
+  unsigned long long wait_time;
+  unsigned long long hold_time;
+  unsigned long long acquired_at;
+} lock_stats_entry_t;
+
+typedef struct
+{
+  lock_stats_entry_t *locks;
+  int num_locks, max_locks;
+  int *index;           /* Open-addressed lock -> position in locks + 1 (0 is empty) */
+  int index_mask;
+  int *dirty;           /* Positions in locks used since the last summary */
+  int num_dirty;
+  int emitting;
+} lock_stats_thread_t;
+
+lock_stats_entry_t * Lock_Table_Lookup (lock_stats_thread_t *stats, void *lock);
+void Lock_Table_Acquired (lock_stats_thread_t *stats, void *lock, int kind,
+  void *caller, int contended, unsigned long long wait_begin,
+  unsigned long long now);
+void Lock_Table_Released (lock_stats_thread_t *stats, void *lock,
+  unsigned long long now);
+void Lock_Table_Resumed (lock_stats_thread_t *stats, void *lock,
+  unsigned long long now);
+void Lock_Table_Reset (lock_stats_thread_t *stats);
+
+#endif /* __PTHREAD_LOCK_TABLE_H__ */
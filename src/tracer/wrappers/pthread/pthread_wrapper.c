@@ -40,14 +40,60 @@
 #ifdef HAVE_TIME_H
 # include <time.h>
 #endif
+#ifdef HAVE_ERRNO_H
+# include <errno.h>
+#endif
 
 #include "wrapper.h"
 #include "trace_macros.h"
 #include "pthread_probe.h"
+#include "pthread_lock_stats.h"
 
 //#define DEBUG
 //#define DEBUG_MUTEX
 
+/* Contention-only mode: take the lock with its try variant first, and only
+   trace the acquisition if the lock was busy and the thread had to wait.
+   Locks taken by the statistics module itself are not accounted, and the
+   accounting runs inside the instrumentation so that the memory it allocates
+   is not attributed to the application. */
+#define TRACE_CONTENDED_LOCK(lock,kind,trylock_call,lock_call,probe_entry,probe_exit) \
+{ \
+	void *caller = __builtin_return_address(0); \
+	if (Lock_Stats_Busy()) \
+	{ \
+		res = lock_call; \
+	} \
+	else if ((res = trylock_call) == EBUSY) \
+	{ \
+		unsigned long long wait_begin = TIME; \
+		Backend_Enter_Instrumentation (); \
+		probe_entry (lock); \
+		res = lock_call; \
+		probe_exit (lock); \
+		if (res == 0) \
+			Lock_Stats_Acquired (lock, kind, caller, TRUE, wait_begin); \
+		Backend_Leave_Instrumentation (); \
+	} \
+	else if (res == 0) \
+	{ \
+		Backend_Enter_Instrumentation (); \
+		Lock_Stats_Acquired (lock, kind, caller, FALSE, 0); \
+		Backend_Leave_Instrumentation (); \
+	} \
+}
+
+#define TRACE_UNCONTENDED_TRYLOCK(lock,kind,trylock_call) \
+{ \
+	res = trylock_call; \
+	if (res == 0 && !Lock_Stats_Busy()) \
+	{ \
+		Backend_Enter_Instrumentation (); \
+		Lock_Stats_Acquired (lock, kind, __builtin_return_address(0), FALSE, 0); \
+		Backend_Leave_Instrumentation (); \
+	} \
+}
+
 #if defined(PIC)
 
 static int (*pthread_create_real)(pthread_t*,const pthread_attr_t*,void *(*) (void *),void*) = NULL;
@@ -459,11 +505,20 @@ int pthread_mutex_lock (pthread_mutex_t *m)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_mutex_lock_Entry (m);
-			res = pthread_mutex_lock_real (m);
-			Probe_pthread_mutex_lock_Exit (m);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				TRACE_CONTENDED_LOCK(m, LOCK_STATS_MUTEX, pthread_mutex_trylock_real (m),
+				  pthread_mutex_lock_real (m), Probe_pthread_mutex_lock_Entry,
+				  Probe_pthread_mutex_lock_Exit);
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_mutex_lock_Entry (m);
+				res = pthread_mutex_lock_real (m);
+				Probe_pthread_mutex_lock_Exit (m);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_mutex_lock_real != NULL)
@@ -495,11 +550,18 @@ int pthread_mutex_trylock (pthread_mutex_t *m)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_mutex_lock_Entry (m);
-			res = pthread_mutex_trylock_real (m);
-			Probe_pthread_mutex_lock_Exit (m);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				TRACE_UNCONTENDED_TRYLOCK(m, LOCK_STATS_MUTEX, pthread_mutex_trylock_real (m));
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_mutex_lock_Entry (m);
+				res = pthread_mutex_trylock_real (m);
+				Probe_pthread_mutex_lock_Exit (m);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_mutex_trylock_real != NULL)
@@ -532,11 +594,20 @@ int pthread_mutex_timedlock(pthread_mutex_t *m, const struct timespec *t)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_mutex_lock_Entry (m);
-			res = pthread_mutex_timedlock_real (m, t);
-			Probe_pthread_mutex_lock_Exit (m);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				TRACE_CONTENDED_LOCK(m, LOCK_STATS_MUTEX, pthread_mutex_trylock_real (m),
+				  pthread_mutex_timedlock_real (m, t), Probe_pthread_mutex_lock_Entry,
+				  Probe_pthread_mutex_lock_Exit);
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_mutex_lock_Entry (m);
+				res = pthread_mutex_timedlock_real (m, t);
+				Probe_pthread_mutex_lock_Exit (m);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_mutex_timedlock_real != NULL)
@@ -570,11 +641,19 @@ int pthread_mutex_unlock (pthread_mutex_t *m)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_mutex_unlock_Entry (m);
-			res = pthread_mutex_unlock_real (m);
-			Probe_pthread_mutex_unlock_Exit (m);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				Lock_Stats_Released (m);
+				res = pthread_mutex_unlock_real (m);
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_mutex_unlock_Entry (m);
+				res = pthread_mutex_unlock_real (m);
+				Probe_pthread_mutex_unlock_Exit (m);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_mutex_unlock_real != NULL)
@@ -607,11 +686,18 @@ int pthread_cond_signal (pthread_cond_t *c)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_cond_signal_Entry (c);
-			res = pthread_cond_signal_real (c);
-			Probe_pthread_cond_signal_Exit (c);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				res = pthread_cond_signal_real (c);
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_cond_signal_Entry (c);
+				res = pthread_cond_signal_real (c);
+				Probe_pthread_cond_signal_Exit (c);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_cond_signal_real != NULL)
@@ -644,11 +730,18 @@ int pthread_cond_broadcast (pthread_cond_t *c)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_cond_broadcast_Entry (c);
-			res = pthread_cond_broadcast_real (c);
-			Probe_pthread_cond_broadcast_Exit (c);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				res = pthread_cond_broadcast_real (c);
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_cond_broadcast_Entry (c);
+				res = pthread_cond_broadcast_real (c);
+				Probe_pthread_cond_broadcast_Exit (c);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_cond_broadcast_real != NULL)
@@ -680,11 +773,15 @@ int pthread_cond_wait (pthread_cond_t *c, pthread_mutex_t *m)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
+			if (Extrae_get_pthread_instrument_locks_contention())
+				Lock_Stats_Released (m);
 			Backend_Enter_Instrumentation ();
 			Probe_pthread_cond_wait_Entry (c);
 			res = pthread_cond_wait_real (c, m);
 			Probe_pthread_cond_wait_Exit (c);
 			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+				Lock_Stats_Resumed (m);
 		}
 	}
 	else if (pthread_cond_wait_real != NULL)
@@ -716,11 +813,15 @@ int pthread_cond_timedwait (pthread_cond_t *c, pthread_mutex_t *m, const struct
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
+			if (Extrae_get_pthread_instrument_locks_contention())
+				Lock_Stats_Released (m);
 			Backend_Enter_Instrumentation ();
 			Probe_pthread_cond_wait_Entry (c);
 			res = pthread_cond_timedwait_real (c,m,t);
 			Probe_pthread_cond_wait_Exit (c);
 			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+				Lock_Stats_Resumed (m);
 		}
 	}
 	else if (pthread_cond_timedwait_real != NULL)
@@ -753,11 +854,20 @@ int pthread_rwlock_rdlock (pthread_rwlock_t *l)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_rwlock_lockrd_Entry (l);
-			res = pthread_rwlock_rdlock_real (l);
-			Probe_pthread_rwlock_lockrd_Exit (l);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				TRACE_CONTENDED_LOCK(l, LOCK_STATS_RWLOCK_RD, pthread_rwlock_tryrdlock_real (l),
+				  pthread_rwlock_rdlock_real (l), Probe_pthread_rwlock_lockrd_Entry,
+				  Probe_pthread_rwlock_lockrd_Exit);
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_rwlock_lockrd_Entry (l);
+				res = pthread_rwlock_rdlock_real (l);
+				Probe_pthread_rwlock_lockrd_Exit (l);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_rwlock_rdlock_real != NULL)
@@ -790,11 +900,18 @@ int pthread_rwlock_tryrdlock(pthread_rwlock_t *l)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_rwlock_lockrd_Entry (l);
-			res = pthread_rwlock_tryrdlock_real (l);
-			Probe_pthread_rwlock_lockrd_Exit (l);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				TRACE_UNCONTENDED_TRYLOCK(l, LOCK_STATS_RWLOCK_RD, pthread_rwlock_tryrdlock_real (l));
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_rwlock_lockrd_Entry (l);
+				res = pthread_rwlock_tryrdlock_real (l);
+				Probe_pthread_rwlock_lockrd_Exit (l);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_rwlock_tryrdlock_real != NULL)
@@ -827,11 +944,20 @@ int pthread_rwlock_timedrdlock(pthread_rwlock_t *l, const struct timespec *t)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_rwlock_lockrd_Entry (l);
-			res = pthread_rwlock_timedrdlock_real (l, t);
-			Probe_pthread_rwlock_lockrd_Exit (l);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				TRACE_CONTENDED_LOCK(l, LOCK_STATS_RWLOCK_RD, pthread_rwlock_tryrdlock_real (l),
+				  pthread_rwlock_timedrdlock_real (l, t), Probe_pthread_rwlock_lockrd_Entry,
+				  Probe_pthread_rwlock_lockrd_Exit);
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_rwlock_lockrd_Entry (l);
+				res = pthread_rwlock_timedrdlock_real (l, t);
+				Probe_pthread_rwlock_lockrd_Exit (l);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_rwlock_timedrdlock_real != NULL)
@@ -864,11 +990,20 @@ int pthread_rwlock_wrlock(pthread_rwlock_t *l)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_rwlock_lockwr_Entry (l);
-			res = pthread_rwlock_wrlock_real (l);
-			Probe_pthread_rwlock_lockwr_Exit (l);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				TRACE_CONTENDED_LOCK(l, LOCK_STATS_RWLOCK_WR, pthread_rwlock_trywrlock_real (l),
+				  pthread_rwlock_wrlock_real (l), Probe_pthread_rwlock_lockwr_Entry,
+				  Probe_pthread_rwlock_lockwr_Exit);
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_rwlock_lockwr_Entry (l);
+				res = pthread_rwlock_wrlock_real (l);
+				Probe_pthread_rwlock_lockwr_Exit (l);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_rwlock_wrlock_real != NULL)
@@ -900,11 +1035,18 @@ int pthread_rwlock_trywrlock(pthread_rwlock_t *l)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_rwlock_lockwr_Entry (l);
-			res = pthread_rwlock_trywrlock_real (l);
-			Probe_pthread_rwlock_lockwr_Exit (l);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				TRACE_UNCONTENDED_TRYLOCK(l, LOCK_STATS_RWLOCK_WR, pthread_rwlock_trywrlock_real (l));
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_rwlock_lockwr_Entry (l);
+				res = pthread_rwlock_trywrlock_real (l);
+				Probe_pthread_rwlock_lockwr_Exit (l);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_rwlock_trywrlock_real != NULL)
@@ -936,11 +1078,20 @@ int pthread_rwlock_timedwrlock(pthread_rwlock_t *l, const struct timespec *t)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_rwlock_lockwr_Entry (l);
-			res = pthread_rwlock_timedwrlock_real (l, t);
-			Probe_pthread_rwlock_lockwr_Exit (l);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				TRACE_CONTENDED_LOCK(l, LOCK_STATS_RWLOCK_WR, pthread_rwlock_trywrlock_real (l),
+				  pthread_rwlock_timedwrlock_real (l, t), Probe_pthread_rwlock_lockwr_Entry,
+				  Probe_pthread_rwlock_lockwr_Exit);
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_rwlock_lockwr_Entry (l);
+				res = pthread_rwlock_timedwrlock_real (l, t);
+				Probe_pthread_rwlock_lockwr_Exit (l);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_rwlock_timedwrlock_real != NULL)
@@ -973,11 +1124,19 @@ int pthread_rwlock_unlock(pthread_rwlock_t *l)
 	{
 		if (!Backend_ispThreadFinished(THREADID))
 		{
-			Backend_Enter_Instrumentation ();
-			Probe_pthread_rwlock_unlock_Entry (l);
-			res = pthread_rwlock_unlock_real (l);
-			Probe_pthread_rwlock_unlock_Exit (l);
-			Backend_Leave_Instrumentation ();
+			if (Extrae_get_pthread_instrument_locks_contention())
+			{
+				Lock_Stats_Released (l);
+				res = pthread_rwlock_unlock_real (l);
+			}
+			else
+			{
+				Backend_Enter_Instrumentation ();
+				Probe_pthread_rwlock_unlock_Entry (l);
+				res = pthread_rwlock_unlock_real (l);
+				Probe_pthread_rwlock_unlock_Exit (l);
+				Backend_Leave_Instrumentation ();
+			}
 		}
 	}
 	else if (pthread_rwlock_unlock_real != NULL)
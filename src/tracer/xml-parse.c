@@ -93,6 +93,7 @@ static char UNUSED rcsid[] = "$Id$";
 #endif
 #if defined(PTHREAD_SUPPORT)
 # include "pthread_probe.h"
+# include "pthread_lock_stats.h"
 #endif
 #if defined(INSTRUMENT_IO)
 # include "io_wrapper.h"
@@ -847,6 +848,16 @@ static void Parse_XML_PTHREAD (int rank, xmlDocPtr xmldoc, xmlNodePtr current_ta
 		{
 			xmlChar *enabled = xmlGetProp_env (rank, tag, TRACE_ENABLED);
 			Extrae_pthread_instrument_locks ((enabled != NULL && !xmlStrcasecmp (enabled, xmlYES)));
+			if (enabled != NULL && !xmlStrcasecmp (enabled, xmlYES))
+			{
+				xmlChar *contention = xmlGetProp_env (rank, tag, TRACE_PTHREAD_LOCKS_CONTENTION);
+				if (contention != NULL && !xmlStrcasecmp (contention, xmlYES))
+				{
+					mfprintf (stdout, PACKAGE_NAME": Only contended pthread locks are traced, the rest are summarized per lock.\n");
+					Extrae_pthread_instrument_locks_contention (TRUE);
+				}
+				XML_FREE(contention);
+			}
 			XML_FREE(enabled);
 		}
 		/* Shall we gather counters in the UF calls? */
@@ -995,6 +1006,17 @@ static void Parse_XML_Buffer (int rank, xmlDocPtr xmldoc, xmlNodePtr current_tag
 			mfprintf (stdout, PACKAGE_NAME": Circular buffer %s.\n", circular_buffering?"enabled":"disabled");
 			XML_FREE(enabled);
 		}
+		/* Do we write the buffers asynchronously ? */
+		else if (!xmlStrcasecmp (tag->name, TRACE_ASYNC_FLUSH))
+		{
+			xmlChar *enabled = xmlGetProp_env (rank, tag, TRACE_ENABLED);
+			if (enabled != NULL && !xmlStrcasecmp (enabled, xmlYES))
+			{
+				async_flushing = 1;
+			}
+			mfprintf (stdout, PACKAGE_NAME": Asynchronous buffer flush %s.\n", async_flushing?"enabled":"disabled");
+			XML_FREE(enabled);
+		}
 		else
 		{
 			mfprintf (stderr, PACKAGE_NAME": XML unknown tag '%s' at <Buffer> level\n", tag->name);
@@ -2043,6 +2065,28 @@ short int Parse_XML_File (int rank, int world_size, const char *filename)
 								xtr_IO_enable_internals();
 							}
 							XML_FREE(internals);
+
+							xmlChar *aggregate = xmlGetProp_env (rank, current_tag, TRACE_IO_AGGREGATE);
+							if (aggregate != NULL && !xmlStrcasecmp (aggregate, xmlYES))
+							{
+								Extrae_set_trace_io_aggregate (TRUE);
+
+								xmlChar *quantum = xmlGetProp_env (rank, current_tag, TRACE_IO_QUANTUM);
+								if (quantum != NULL)
+								{
+									unsigned long long q = __Extrae_Utils_getTimeFromStr ((const char*) quantum,
+									  (const char*) TRACE_IO_QUANTUM, rank);
+									Extrae_set_trace_io_quantum (q);
+									if (q > 0)
+										mfprintf (stdout, PACKAGE_NAME": I/O calls are aggregated, summaries are emitted every %llu ns.\n", q);
+									else
+										mfprintf (stdout, PACKAGE_NAME": I/O calls are aggregated, summaries are emitted after each flush.\n");
+								}
+								else
+									mfprintf (stdout, PACKAGE_NAME": I/O calls are aggregated, summaries are emitted after each flush.\n");
+								XML_FREE(quantum);
+							}
+							XML_FREE(aggregate);
 						}
 						XML_FREE(enabled);
 
@@ -69,12 +69,14 @@
 #define TRACE_VARIABILITY               ((xmlChar*) "variability")
 #define TRACE_TYPE                      ((xmlChar*) "type")
 #define TRACE_CIRCULAR                  ((xmlChar*) "circular")
+#define TRACE_ASYNC_FLUSH               ((xmlChar*) "async-flush")
 #define TRACE_PREFIX                    ((xmlChar*) "trace-prefix")
 #define TRACE_MPI                       ((xmlChar*) "mpi")
 #define TRACE_SHMEM                     ((xmlChar*) "shmem")
 #define TRACE_OPENCL                    ((xmlChar*) "opencl")
 #define TRACE_CUDA                      ((xmlChar*) "cuda")
 #define TRACE_PTHREAD_LOCKS             ((xmlChar*) "locks")
+#define TRACE_PTHREAD_LOCKS_CONTENTION  ((xmlChar*) "contention")
 #define TRACE_PTHREAD                   ((xmlChar*) "pthread")
 #define TRACE_OMP_OMPT                  ((xmlChar*) "ompt")
 #define TRACE_OMP_LOCKS                 ((xmlChar*) "locks")
@@ -95,6 +97,8 @@
 #define TRACE_DYNAMIC_MEMORY_FREE       ((xmlChar*) "free")
 #define TRACE_IO                        ((xmlChar*) "input-output")
 #define TRACE_IO_INTERNALS              ((xmlChar*) "internals")
+#define TRACE_IO_AGGREGATE              ((xmlChar*) "aggregate")
+#define TRACE_IO_QUANTUM                ((xmlChar*) "quantum")
 #define TRACE_SYSCALL                   ((xmlChar*) "syscall")
 #define TRACE_LIST                      ((xmlChar*) "list")
 #define TRACE_EXCLUDE_AUTOMATIC_FUNCTIONS ((xmlChar*) "exclude-automatic-functions")
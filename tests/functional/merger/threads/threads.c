@@ -0,0 +1,60 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+
+#define NTHREADS 8
+#define NITERS 100
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned counter = 0;
+
+void *pthread_func(void *useless)
+{
+	unsigned u;
+
+	for (u = 0; u < NITERS; u++)
+	{
+		pthread_mutex_lock (&lock);
+		counter++;
+		pthread_mutex_unlock (&lock);
+	}
+	return useless;
+}
+
+int main()
+{
+	pthread_t pt[NTHREADS];
+	unsigned u;
+
+	for (u = 0; u < NTHREADS; u++)
+		if (pthread_create (&pt[u], NULL, pthread_func, NULL))
+			return 1;
+
+	for (u = 0; u < NTHREADS; u++)
+		if (pthread_join (pt[u], NULL))
+			return 2;
+
+	return counter != NTHREADS * NITERS;
+}
@@ -0,0 +1,26 @@
+#!/bin/bash
+
+source ../../helper_functions.bash
+
+rm -fr TRACE.* *.mpits set-0
+
+TRACE=threads
+
+./trace-ldpreload.sh ./threads || die "Error! The traced application failed"
+
+# Load the intermediate files of every thread one after the other, and then
+# on several threads. The resulting traces must be the same.
+../../../../src/merger/mpi2prv -f TRACE.mpits -threads 1 -o ${TRACE}-1.prv || die "Error! mpi2prv -threads 1 failed"
+../../../../src/merger/mpi2prv -f TRACE.mpits -threads 4 -o ${TRACE}-4.prv || die "Error! mpi2prv -threads 4 failed"
+
+# Skip the header, it contains the date of the merge
+tail -n +2 ${TRACE}-1.prv > ${TRACE}-1.body
+tail -n +2 ${TRACE}-4.prv > ${TRACE}-4.body
+
+diff ${TRACE}-1.body ${TRACE}-4.body > /dev/null || die "Error! The trace loaded on 4 threads differs"
+diff ${TRACE}-1.pcf ${TRACE}-4.pcf > /dev/null || die "Error! The PCF loaded on 4 threads differs"
+diff ${TRACE}-1.row ${TRACE}-4.row > /dev/null || die "Error! The ROW loaded on 4 threads differs"
+
+rm -fr TRACE.* set-0 ${TRACE}-?.prv ${TRACE}-?.pcf ${TRACE}-?.row ${TRACE}-?.body
+
+exit 0
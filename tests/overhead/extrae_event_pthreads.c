@@ -0,0 +1,84 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "extrae_user_events.h"
+
+/* Number of threads emitting events, may be changed through the first
+   argument to measure how the event rate scales with the threads */
+#define NTHREADS 8
+
+static int n = 1000000;
+static unsigned long long *elapsed;
+
+static void * emit_events (void *arg)
+{
+	long id = (long) arg;
+	struct timespec start, stop;
+	int i;
+
+	clock_gettime (CLOCK_MONOTONIC, &start);
+	for (i = 0; i < n; i++)
+		Extrae_event (1, i+1);
+	clock_gettime (CLOCK_MONOTONIC, &stop);
+
+	elapsed[id] = (stop.tv_sec * 1000000000ULL + stop.tv_nsec) -
+	  (start.tv_sec * 1000000000ULL + start.tv_nsec);
+
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	pthread_t *threads;
+	unsigned long long total = 0;
+	long t, nthreads = NTHREADS;
+
+	if (argc > 1 && atoi (argv[1]) > 0)
+		nthreads = atoi (argv[1]);
+
+	threads = (pthread_t*) malloc (nthreads * sizeof(pthread_t));
+	elapsed = (unsigned long long*) malloc (nthreads * sizeof(unsigned long long));
+	if (threads == NULL || elapsed == NULL)
+		return 1;
+
+	Extrae_init();
+	for (t = 0; t < nthreads; t++)
+		pthread_create (&threads[t], NULL, emit_events, (void*) t);
+	for (t = 0; t < nthreads; t++)
+	{
+		pthread_join (threads[t], NULL);
+		total += elapsed[t];
+	}
+	printf ("RESULT : Extrae_event() %Lu ns\n", total / (nthreads * (unsigned long long) n));
+	Extrae_fini();
+
+	free (threads);
+	free (elapsed);
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <stdlib.h>
+
+/* Compares the overhead and the accuracy of the time-stamp counter clock when
+   converted to ns with a division by the "cpu MHz" of /proc/cpuinfo and with
+   the multiply-shift factor that the tracer obtains by calibrating it against
+   the raw monotonic clock (ia32_Initialize in src/tracer/clocks/ia32_clock.c,
+   exported by the tracing library). */
+
+#if defined(CLOCK_MONOTONIC_RAW)
+# define REFERENCE_CLOCK CLOCK_MONOTONIC_RAW
+#else
+# define REFERENCE_CLOCK CLOCK_MONOTONIC
+#endif
+
+void ia32_Initialize (void);
+unsigned long long ia32_getTime (void);
+int ia32_isReliable (void);
+
+static unsigned long long proc_timebase_MHz = 2000;
+
+#if (defined(linux) || defined (__FreeBSD__) || defined (__APPLE__)) && \
+    ((__x86_64__) || defined(x86_64) || defined(__amd64__) || defined(amd64) || defined(__i386__))
+static __inline unsigned long long ia32_cputime (void)
+{
+# if defined (__x86_64__) || defined(x86_64) || defined(__amd64__) || defined(amd64)
+	unsigned long lo, hi;
+	/* We cannot use "=A", since this would use %rax on x86_64 */
+	__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((unsigned long long )hi << 32) | lo;
+# else
+	unsigned long long cycles;
+	__asm__ __volatile__ ("rdtsc" : "=A" (cycles));
+	return cycles;
+# endif
+}
+#else
+static __inline unsigned long long ia32_cputime (void)
+{
+	return 0;
+}
+#endif
+
+static unsigned long long reference_ns (void)
+{
+	struct timespec ts;
+
+	clock_gettime (REFERENCE_CLOCK, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void read_cpuinfo_MHz (void)
+{
+	FILE *fp;
+	char line[1024];
+	double MHz;
+
+	fp = fopen ("/proc/cpuinfo", "r");
+	if (fp == NULL)
+		return;
+	while (fgets (line, sizeof(line), fp) != NULL)
+		if (sscanf (line, "cpu MHz : %lf", &MHz) == 1)
+		{
+			proc_timebase_MHz = MHz;
+			break;
+		}
+	fclose (fp);
+}
+
+unsigned long long ia32_getTime_div (void)
+{
+	return (ia32_cputime() * 1000) / proc_timebase_MHz;
+}
+
+static unsigned long long overhead (unsigned long long (*f)(void))
+{
+	unsigned long long t1, t2;
+	volatile unsigned long long useless;
+	unsigned i, n = 1000000;
+
+	t1 = reference_ns();
+	for (i = 0; i < n; i++)
+		useless = f();
+	t2 = reference_ns();
+	(void) useless;
+
+	return (t2 - t1) / n;
+}
+
+/* Returns how many ns per second the given clock drifts from the reference */
+static long long drift (unsigned long long (*f)(void))
+{
+	unsigned long long r1, r2, c1, c2;
+	struct timespec period = { 0, 250000000L };
+
+	r1 = reference_ns(); c1 = f();
+	nanosleep (&period, NULL);
+	r2 = reference_ns(); c2 = f();
+
+	return (((long long) (c2 - c1) - (long long) (r2 - r1)) * 1000000000LL) / (long long) (r2 - r1);
+}
+
+int main (int argc, char *argv[])
+{
+	read_cpuinfo_MHz ();
+	ia32_Initialize ();
+
+	/* Only the RESULT line is collected by run_overhead_tests.sh */
+	printf ("INFO : rdtsc()/cpu_MHz %llu ns, drift %lld ns/s\n",
+	  overhead (ia32_getTime_div), drift (ia32_getTime_div));
+	if (!ia32_isReliable())
+	{
+		printf ("INFO : the time-stamp counter is not invariant or could not be calibrated\n");
+		return 1;
+	}
+	printf ("INFO : rdtsc()*mult>>shift drift %lld ns/s\n",
+	  drift (ia32_getTime));
+	printf ("RESULT : rdtsc()*mult>>shift %llu ns\n",
+	  overhead (ia32_getTime));
+
+	return 0;
+}
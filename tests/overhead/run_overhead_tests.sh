@@ -69,7 +69,7 @@ function run_test_java_extraej {
 export EXTRAE_HOME=@sub_EXTRAE_HOME@
 export EXTRAE_CONFIG_FILE=extrae.xml
 
-EXECUTABLES="./posix_clock ./ia32_rdtsc_clock ./extrae_event ./extrae_nevent4"
+EXECUTABLES="./posix_clock ./ia32_rdtsc_clock ./extrae_event ./extrae_event_pthreads ./extrae_nevent4"
 EXECUTABLES+=" @sub_COUNTERS_OVERHEAD_TESTS@"
 EXECUTABLES+=" @sub_CALLERS_OVERHEAD_TESTS@"
 EXECUTABLES_JAVA="JavaEvent JavaNEvent4"
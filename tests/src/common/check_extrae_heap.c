@@ -0,0 +1,225 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks that Extrae_Heap selects the same stream that the linear scan in
+   the merger would select (key, then tie, then lowest id) and reports the
+   time of both approaches for a growing number of synthetic input files.
+   Usage: extrae_heap [max_files [events_per_file]] */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <extrae_heap.h>
+
+typedef struct
+{
+	unsigned long long *keys;
+	int *ties;
+	unsigned count;
+	unsigned current;
+} stream_t;
+
+static double now (void)
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void generate (stream_t *s, unsigned nstreams, unsigned nevents)
+{
+	unsigned i, j;
+
+	for (i = 0; i < nstreams; i++)
+	{
+		unsigned long long t = rand() % 16;
+
+		s[i].count = nevents;
+		s[i].current = 0;
+		s[i].keys = (unsigned long long*) malloc (nevents*sizeof(unsigned long long));
+		s[i].ties = (int*) malloc (nevents*sizeof(int));
+		assert (s[i].keys != NULL && s[i].ties != NULL);
+		/* Small increments so that many keys collide among streams */
+		for (j = 0; j < nevents; j++)
+		{
+			t += rand() % 4;
+			s[i].keys[j] = t;
+			s[i].ties[j] = rand() % 3;
+		}
+	}
+}
+
+static void rewind_streams (stream_t *s, unsigned nstreams)
+{
+	unsigned i;
+
+	for (i = 0; i < nstreams; i++)
+		s[i].current = 0;
+}
+
+static void release (stream_t *s, unsigned nstreams)
+{
+	unsigned i;
+
+	for (i = 0; i < nstreams; i++)
+	{
+		free (s[i].keys);
+		free (s[i].ties);
+	}
+}
+
+static unsigned linear_merge (stream_t *s, unsigned nstreams, unsigned *order)
+{
+	unsigned n = 0;
+
+	while (1)
+	{
+		unsigned i, min = nstreams;
+
+		for (i = 0; i < nstreams; i++)
+		{
+			if (s[i].current == s[i].count)
+				continue;
+			if (min == nstreams ||
+			    s[i].keys[s[i].current] < s[min].keys[s[min].current] ||
+			    (s[i].keys[s[i].current] == s[min].keys[s[min].current] &&
+			     s[i].ties[s[i].current] < s[min].ties[s[min].current]))
+				min = i;
+		}
+		if (min == nstreams)
+			break;
+		if (order != NULL)
+			order[n] = min;
+		n++;
+		s[min].current++;
+	}
+	return n;
+}
+
+static unsigned heap_merge (Extrae_Heap_t *h, stream_t *s, unsigned nstreams,
+	unsigned *order)
+{
+	Extrae_Heap_Item_t *top;
+	unsigned i, n = 0;
+
+	Extrae_Heap_Clear (h);
+	for (i = 0; i < nstreams; i++)
+		if (s[i].count > 0)
+			Extrae_Heap_Push (h, s[i].keys[0], s[i].ties[0], i);
+
+	while ((top = Extrae_Heap_Top (h)) != NULL)
+	{
+		stream_t *min = &s[top->id];
+
+		if (order != NULL)
+			order[n] = top->id;
+		n++;
+		min->current++;
+		if (min->current < min->count)
+			Extrae_Heap_UpdateTop (h, min->keys[min->current], min->ties[min->current]);
+		else
+			Extrae_Heap_Pop (h);
+	}
+	return n;
+}
+
+static void check_basic (void)
+{
+	Extrae_Heap_t h;
+
+	Extrae_Heap_Init (&h);
+	assert (Extrae_Heap_Count(&h) == 0);
+	assert (Extrae_Heap_Top(&h) == NULL);
+
+	Extrae_Heap_Push (&h, 10, 0, 3);
+	Extrae_Heap_Push (&h, 5, 0, 7);
+	Extrae_Heap_Push (&h, 5, -1, 9);
+	Extrae_Heap_Push (&h, 5, -1, 2);
+	assert (Extrae_Heap_Count(&h) == 4);
+
+	assert (Extrae_Heap_Top(&h)->id == 2);
+	Extrae_Heap_Pop (&h);
+	assert (Extrae_Heap_Top(&h)->id == 9);
+	Extrae_Heap_UpdateTop (&h, 20, 0);
+	assert (Extrae_Heap_Top(&h)->id == 7);
+	Extrae_Heap_Pop (&h);
+	assert (Extrae_Heap_Top(&h)->id == 3);
+	Extrae_Heap_Pop (&h);
+	assert (Extrae_Heap_Top(&h)->id == 9);
+	assert (Extrae_Heap_Top(&h)->key == 20);
+	Extrae_Heap_Pop (&h);
+	assert (Extrae_Heap_Top(&h) == NULL);
+
+	Extrae_Heap_Destroy (&h);
+	assert (Extrae_Heap_Count(&h) == 0);
+}
+
+int main (int argc, char *argv[])
+{
+	unsigned max_files = (argc > 1) ? atoi(argv[1]) : 1024;
+	unsigned nevents = (argc > 2) ? atoi(argv[2]) : 64;
+	unsigned nfiles, i;
+	Extrae_Heap_t h;
+
+	check_basic ();
+
+	srand (1);
+	Extrae_Heap_Init (&h);
+
+	fprintf (stdout, "%10s %12s %12s %12s\n", "files", "events", "linear (s)", "heap (s)");
+	for (nfiles = 1; nfiles <= max_files; nfiles *= 4)
+	{
+		stream_t *s = (stream_t*) malloc (nfiles*sizeof(stream_t));
+		unsigned *order1, *order2, total = nfiles*nevents, n1, n2;
+		double t0, t1, t2;
+
+		assert (s != NULL);
+		order1 = (unsigned*) malloc (total*sizeof(unsigned));
+		order2 = (unsigned*) malloc (total*sizeof(unsigned));
+		assert (order1 != NULL && order2 != NULL);
+		generate (s, nfiles, nevents);
+
+		t0 = now();
+		n1 = linear_merge (s, nfiles, order1);
+		t1 = now();
+		rewind_streams (s, nfiles);
+		n2 = heap_merge (&h, s, nfiles, order2);
+		t2 = now();
+
+		assert (n1 == total && n2 == total);
+		for (i = 0; i < total; i++)
+			assert (order1[i] == order2[i]);
+
+		fprintf (stdout, "%10u %12u %12.6f %12.6f\n", nfiles, total, t1-t0, t2-t1);
+
+		release (s, nfiles);
+		free (s);
+		free (order1);
+		free (order2);
+	}
+
+	Extrae_Heap_Destroy (&h);
+
+	return 0;
+}
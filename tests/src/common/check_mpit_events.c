@@ -0,0 +1,167 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks that blocks of events encoded as in the compact .mpit files are
+   decoded back into the same events, that the header of the file tells its
+   encoding, and reports how large the encoded events are compared to raw
+   event_t. Usage: mpit_events [events] */
+
+#include "common.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "record.h"
+#include "mpit_header.h"
+#include "mpit_events.h"
+
+static void generate (event_t *events, unsigned n, int with_hwc)
+{
+	UINT64 time = 1000000000ULL;
+	unsigned i, j;
+
+	memset (events, 0, n*sizeof(event_t));
+	for (i = 0; i < n; i++)
+	{
+		event_t *ev = &events[i];
+
+		time += rand() % 5000;
+		ev->time = time;
+		/* Few types that often repeat, as in entry/exit pairs */
+		ev->event = 50000000 + (rand() % 4) * ((rand() % 2) ? 1 : -1);
+		ev->value = (rand() % 3) ? rand() % 2 : ((UINT64) rand() << 32) | rand();
+		if (rand() % 4 == 0)
+		{
+			ev->param.mpi_param.target = rand() % 64;
+			ev->param.mpi_param.size = rand();
+			ev->param.mpi_param.tag = -(rand() % 8);
+			ev->param.mpi_param.aux = ((INT64) rand() << 20) - rand();
+		}
+		if (with_hwc && rand() % 2)
+		{
+			ev->HWCReadSet = (rand() % 3) + 1;
+			if (rand() % 4 == 0)
+				ev->HWCReadSet = -ev->HWCReadSet;
+			for (j = 0; j < MAX_HWC; j++)
+				if (j < 4)
+					ev->HWCValues[j] = (long long) rand() * (rand() % 1000);
+		}
+	}
+}
+
+static size_t round_trip (const event_t *events, unsigned n, unsigned chunk)
+{
+	unsigned char *block = (unsigned char *) malloc (MPIT_BLOCK_MAX_SIZE(chunk));
+	event_t *decoded = (event_t *) malloc (chunk*sizeof(event_t));
+	size_t total = 0;
+	unsigned i;
+
+	assert (block != NULL && decoded != NULL);
+	for (i = 0; i < n; i += chunk)
+	{
+		unsigned count = (n - i < chunk) ? n - i : chunk;
+		MPIT_Block_t header;
+		size_t size;
+
+		size = MPIT_Events_Encode (&events[i], count, block);
+		assert (size <= MPIT_BLOCK_MAX_SIZE(count));
+		memcpy (&header, block, sizeof(MPIT_Block_t));
+		assert (header.NumEvents == count);
+		assert (header.Size + sizeof(MPIT_Block_t) == size);
+
+		assert (MPIT_Events_Decode (&header, block + sizeof(MPIT_Block_t), decoded) == 0);
+		assert (memcmp (decoded, &events[i], count*sizeof(event_t)) == 0);
+
+		/* A truncated block is detected */
+		if (header.Size > 0)
+		{
+			header.Size--;
+			assert (MPIT_Events_Decode (&header, block + sizeof(MPIT_Block_t), decoded) != 0);
+		}
+
+		total += size;
+	}
+
+	free (decoded);
+	free (block);
+	return total;
+}
+
+static void check_header (void)
+{
+	char name[] = "mpit_events_XXXXXX";
+	MPIT_Header_t header;
+	event_t ev;
+	int fd;
+
+	fd = mkstemp (name);
+	assert (fd != -1);
+
+	/* Files without header hold plain events */
+	memset (&ev, 0, sizeof(ev));
+	ev.time = 1234;
+	assert (write (fd, &ev, sizeof(ev)) == sizeof(ev));
+	assert (MPIT_Header_Version (fd) == MPIT_VERSION_RAW);
+
+	MPIT_Header_Init (&header);
+	MPIT_Header_Write (fd, &header);
+	assert (MPIT_Header_Version (fd) == MPIT_VERSION_COMPACT);
+
+	header.Version = MPIT_VERSION + 1;
+	MPIT_Header_Write (fd, &header);
+	assert (MPIT_Header_Version (fd) == -1);
+
+	close (fd);
+	unlink (name);
+}
+
+int main (int argc, char *argv[])
+{
+	unsigned n = (argc > 1) ? atoi(argv[1]) : 100000;
+	event_t *events = (event_t *) malloc (n*sizeof(event_t));
+	int with_hwc;
+
+	assert (events != NULL);
+	srand (1);
+
+	check_header ();
+
+	for (with_hwc = 0; with_hwc <= 1; with_hwc++)
+	{
+		size_t size;
+
+		generate (events, n, with_hwc);
+		assert (round_trip (events, 1, 1) > 0);
+		round_trip (events, n, 7);
+		size = round_trip (events, n, 1024);
+
+		fprintf (stdout, "%s counters: %u events, %zu bytes raw, %zu bytes encoded (%.2fx)\n",
+			with_hwc ? "with" : "without", n, n*sizeof(event_t), size,
+			(double) (n*sizeof(event_t)) / size);
+	}
+
+	free (events);
+	return 0;
+}
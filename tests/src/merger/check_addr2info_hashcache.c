@@ -0,0 +1,76 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks that the addr2info cache keeps addresses that alias in their low
+   bits (which evicted each other in the former direct-mapped cache) and
+   that recently used entries survive the eviction of the least recently
+   used ones. */
+
+#include "common.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include "addr2info_hashcache.h"
+
+#define ALIASING_ADDRESSES 4096
+#define STREAMED_ADDRESSES (1024*1024)
+
+int main (int argc, char *argv[])
+{
+	UINT64 base = 0x400000, hot = 0x7f0000001234ULL, a;
+	int line, function;
+	unsigned i;
+
+	UNREFERENCED_PARAMETER(argc);
+	UNREFERENCED_PARAMETER(argv);
+
+	Addr2Info_HashCache_Initialize ();
+
+	/* Addresses 32 KiB apart used to share the same slot */
+	for (i = 0; i < ALIASING_ADDRESSES; i++)
+		Addr2Info_HashCache_Insert (base + ((UINT64)i << 15), i, i+1);
+	for (i = 0; i < ALIASING_ADDRESSES; i++)
+	{
+		assert (Addr2Info_HashCache_Search (base + ((UINT64)i << 15), &line, &function));
+		assert (line == (int) i && function == (int) i+1);
+	}
+
+	/* Stream far more addresses than the cache holds while touching a hot
+	   one; LRU replacement must never evict it */
+	Addr2Info_HashCache_Insert (hot, 1, 2);
+	for (a = 0; a < STREAMED_ADDRESSES; a++)
+	{
+		Addr2Info_HashCache_Insert (0x10000000 + a*4, 0, 0);
+		assert (Addr2Info_HashCache_Search (hot, &line, &function));
+		assert (line == 1 && function == 2);
+	}
+
+	/* Cleaning invalidates every entry */
+	Addr2Info_HashCache_Clean ();
+	assert (!Addr2Info_HashCache_Search (hot, &line, &function));
+	assert (!Addr2Info_HashCache_Search (base, &line, &function));
+
+	Addr2Info_HashCache_ShowStatistics ();
+
+	return 0;
+}
@@ -0,0 +1,165 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks that the merger address space resolves sampled addresses to the
+   same allocation than a linear scan of the live regions does, and times
+   the replay of a synthetic stream of allocations, frees and memory
+   samples (as produced by the malloc wrapper and PEBS). Usage:
+   address_space [live_allocations] [samples] */
+
+#include "common.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "events.h"
+#include "address_space.h"
+
+#define CHECK_SLOTS 2048
+#define SLOT_SIZE   4096
+
+typedef struct
+{
+	uint64_t begin;
+	uint64_t end;
+	int live;
+} region_t;
+
+static double now (void)
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* Linear reference */
+static region_t * reference_search (region_t *r, unsigned n, uint64_t address)
+{
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+		if (r[i].live && r[i].begin <= address && address <= r[i].end)
+			return &r[i];
+	return NULL;
+}
+
+static void check_search (unsigned n)
+{
+	struct AddressSpace_st *as = AddressSpace_create();
+	region_t regions[CHECK_SLOTS];
+	uint64_t callers[MAX_CALLERS];
+	unsigned i, v;
+
+	/* Every slot may hold an allocation of a random size, so regions never
+	   overlap and the expected caller is unique */
+	for (i = 0; i < CHECK_SLOTS; i++)
+		regions[i].live = FALSE;
+
+	for (i = 0; i < n; i++)
+	{
+		unsigned s = rand() % CHECK_SLOTS;
+		uint64_t address, *found_callers;
+		uint32_t found_type;
+		region_t *ref;
+		int found;
+
+		switch (rand() % 3)
+		{
+			case 0: /* allocate or reallocate the slot */
+				if (regions[s].live)
+					AddressSpace_remove (as, regions[s].begin);
+				regions[s].begin = 0x10000000ULL + (uint64_t) s * SLOT_SIZE + rand() % 64;
+				regions[s].end = regions[s].begin + rand() % (SLOT_SIZE - 64);
+				regions[s].live = TRUE;
+				for (v = 0; v < MAX_CALLERS; v++)
+					callers[v] = s;
+				AddressSpace_add (as, regions[s].begin, regions[s].end, callers, s);
+				break;
+			case 1: /* free the slot */
+				if (regions[s].live)
+					AddressSpace_remove (as, regions[s].begin);
+				regions[s].live = FALSE;
+				break;
+			case 2: /* sample an address */
+				address = 0x10000000ULL + (uint64_t) s * SLOT_SIZE + rand() % SLOT_SIZE;
+				ref = reference_search (regions, CHECK_SLOTS, address);
+				found = AddressSpace_search (as, address, &found_callers, &found_type);
+				assert (found == (ref != NULL));
+				if (found)
+				{
+					assert (found_type == (uint32_t) (ref - regions));
+					assert (found_callers[MAX_CALLERS-1] == (uint64_t) (ref - regions));
+				}
+				break;
+		}
+	}
+}
+
+static void benchmark (unsigned nlive, unsigned nsamples)
+{
+	struct AddressSpace_st *as = AddressSpace_create();
+	uint64_t callers[MAX_CALLERS] = { 0 };
+	unsigned i, hits = 0;
+	double t0, t1, t2;
+
+	/* Allocations are spread over the address space with gaps between them */
+	t0 = now();
+	for (i = 0; i < nlive; i++)
+		AddressSpace_add (as, 0x10000000ULL + (uint64_t) i * 128,
+		  0x10000000ULL + (uint64_t) i * 128 + 95, callers, 0);
+	t1 = now();
+
+	/* Samples hit random allocations and, sometimes, the gaps between them.
+	   Every sample also churns one allocation, like a malloc/free pair */
+	for (i = 0; i < nsamples; i++)
+	{
+		unsigned j = rand() % nlive;
+		uint64_t address = 0x10000000ULL + (uint64_t) j * 128 + rand() % 128;
+
+		hits += AddressSpace_search (as, address, NULL, NULL);
+
+		AddressSpace_remove (as, 0x10000000ULL + (uint64_t) j * 128);
+		AddressSpace_add (as, 0x10000000ULL + (uint64_t) j * 128,
+		  0x10000000ULL + (uint64_t) j * 128 + 95, callers, 0);
+	}
+	t2 = now();
+
+	assert (hits > 0 && hits < nsamples);
+
+	fprintf (stdout, "%u live allocations: added in %.3f s, %u samples resolved in %.3f s\n",
+	  nlive, t1-t0, nsamples, t2-t1);
+}
+
+int main (int argc, char *argv[])
+{
+	unsigned nlive = (argc > 1) ? atoi(argv[1]) : 100000;
+	unsigned nsamples = (argc > 2) ? atoi(argv[2]) : 200000;
+
+	srand (1);
+
+	check_search (200000);
+	benchmark (nlive, nsamples);
+
+	return 0;
+}
@@ -0,0 +1,205 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks that the pending communication queues of the merger match sends
+   and receives in the same order than a linear FIFO scan does, including
+   receives posted with MPI_ANY_TAG, and times the matching of a trace with
+   many in-flight messages (halo exchanges over 26 neighbours with several
+   tags). Usage: communication_queues [in_flight_messages] */
+
+#include "common.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "communication_queues.h"
+
+#ifndef MPI_ANY_TAG
+# define MPI_ANY_TAG (-1)
+#endif
+
+#define NEIGHBOURS 26
+#define TAGS       8
+
+typedef struct
+{
+	event_t *ev;
+	int partner;
+	int tag;
+	int valid;
+} pending_t;
+
+static double now (void)
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/* Linear reference of the send side */
+static event_t * reference_send (pending_t *p, unsigned n, int receiver, int tag)
+{
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+		if (p[i].valid && p[i].partner == receiver &&
+		    (p[i].tag == tag || tag == MPI_ANY_TAG))
+		{
+			p[i].valid = FALSE;
+			return p[i].ev;
+		}
+	return NULL;
+}
+
+/* Linear reference of the receive side */
+static event_t * reference_recv (pending_t *p, unsigned n, int sender, int tag)
+{
+	unsigned i;
+
+	for (i = 0; i < n; i++)
+		if (p[i].valid && p[i].partner == sender &&
+		    (p[i].tag == tag || Get_EvTag(p[i].ev) == MPI_ANY_TAG))
+		{
+			p[i].valid = FALSE;
+			return p[i].ev;
+		}
+	return NULL;
+}
+
+static void check_matching (unsigned n)
+{
+	CommunicationQueue_t *qsend, *qrecv;
+	pending_t *sends, *recvs;
+	event_t *events, *b, *e;
+	off_t pos;
+	unsigned i, nsends = 0, nrecvs = 0, thread, vthread;
+
+	CommunicationQueues_Init (&qsend, &qrecv);
+	sends = (pending_t*) malloc (n*sizeof(pending_t));
+	recvs = (pending_t*) malloc (n*sizeof(pending_t));
+	events = (event_t*) malloc (n*sizeof(event_t));
+	assert (sends != NULL && recvs != NULL && events != NULL);
+
+	for (i = 0; i < n; i++)
+	{
+		int partner = rand() % 4;
+		int tag = rand() % 3;
+		event_t *ref;
+
+		switch (rand() % 4)
+		{
+			case 0: /* queue a send */
+				Get_EvTag(&events[i]) = tag;
+				sends[nsends].ev = &events[i];
+				sends[nsends].partner = partner;
+				sends[nsends].tag = tag;
+				sends[nsends++].valid = TRUE;
+				CommunicationQueues_QueueSend (qsend, &events[i], &events[i], i, 0, 0, partner, tag, 0);
+				break;
+			case 1: /* queue a receive, some of them for any tag */
+				if (rand() % 4 == 0)
+					tag = MPI_ANY_TAG;
+				Get_EvTag(&events[i]) = tag;
+				recvs[nrecvs].ev = &events[i];
+				recvs[nrecvs].partner = partner;
+				recvs[nrecvs].tag = tag;
+				recvs[nrecvs++].valid = TRUE;
+				CommunicationQueues_QueueRecv (qrecv, &events[i], &events[i], 0, 0, partner, tag, 0);
+				break;
+			case 2: /* a receive looks for its send */
+				if (rand() % 4 == 0)
+					tag = MPI_ANY_TAG;
+				ref = reference_send (sends, nsends, partner, tag);
+				CommunicationQueues_ExtractSend (qsend, partner, tag, &b, &e, &pos, &thread, &vthread, 0);
+				assert (b == ref);
+				break;
+			case 3: /* a send looks for its receive */
+				ref = reference_recv (recvs, nrecvs, partner, tag);
+				CommunicationQueues_ExtractRecv (qrecv, partner, tag, &b, &e, &thread, &vthread, 0);
+				assert (b == ref);
+				break;
+		}
+	}
+
+	CommunicationQueues_Clear (qsend);
+	CommunicationQueues_Clear (qrecv);
+	CommunicationQueues_ExtractSend (qsend, 0, MPI_ANY_TAG, &b, &e, &pos, &thread, &vthread, 0);
+	assert (b == NULL);
+
+	free (sends);
+	free (recvs);
+	free (events);
+}
+
+static void benchmark (unsigned n)
+{
+	CommunicationQueue_t *qsend, *qrecv;
+	event_t *events, *b, *e;
+	off_t pos;
+	unsigned i, thread, vthread;
+	double t0, t1, t2;
+
+	CommunicationQueues_Init (&qsend, &qrecv);
+	events = (event_t*) malloc (n*sizeof(event_t));
+	assert (events != NULL);
+
+	/* Every message is sent before any of them is received */
+	t0 = now();
+	for (i = 0; i < n; i++)
+	{
+		Get_EvTag(&events[i]) = (i / NEIGHBOURS) % TAGS;
+		CommunicationQueues_QueueSend (qsend, &events[i], &events[i], i, 0, 0,
+		  i % NEIGHBOURS, Get_EvTag(&events[i]), 0);
+	}
+	t1 = now();
+
+	/* Receives are posted from the last neighbour and tag to the first one */
+	for (i = 0; i < n; i++)
+	{
+		unsigned j = n - 1 - i;
+		CommunicationQueues_ExtractSend (qsend, j % NEIGHBOURS,
+		  (j / NEIGHBOURS) % TAGS, &b, &e, &pos, &thread, &vthread, 0);
+		assert (b != NULL && Get_EvTag(b) == (INT32) ((j / NEIGHBOURS) % TAGS));
+	}
+	t2 = now();
+
+	CommunicationQueues_ExtractSend (qsend, 0, MPI_ANY_TAG, &b, &e, &pos, &thread, &vthread, 0);
+	assert (b == NULL);
+
+	fprintf (stdout, "%u in-flight messages: queued in %.3f s, matched in %.3f s\n",
+	  n, t1-t0, t2-t1);
+
+	free (events);
+}
+
+int main (int argc, char *argv[])
+{
+	unsigned n = (argc > 1) ? atoi(argv[1]) : 1000000;
+
+	srand (1);
+	check_matching (100000);
+	benchmark (n);
+
+	return 0;
+}
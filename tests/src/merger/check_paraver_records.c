@@ -0,0 +1,228 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks that the records written to the intermediate files of the merger
+   are read back as they were written, including states and communications
+   rewritten in place once they were in the file (or still in the buffer),
+   and reports how large the encoded file is compared to raw paraver_rec_t.
+   Usage: paraver_records [records] */
+
+#include "common.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "paraver_records.h"
+#include "write_file_buffer.h"
+
+static void same_record (const paraver_rec_t *a, const paraver_rec_t *b)
+{
+	assert (a->type == b->type);
+	if (a->type == EVENT || a->type == STATE || a->type == UNFINISHED_STATE)
+	{
+		assert (a->time == b->time);
+		assert (a->value == b->value);
+		assert (a->cpu == b->cpu && a->ptask == b->ptask);
+		assert (a->task == b->task && a->thread == b->thread);
+		if (a->type == EVENT)
+			assert (a->event == b->event);
+		else if (a->type == STATE)
+			assert (a->end_time == b->end_time);
+	}
+	else
+		assert (memcmp (a, b, sizeof(paraver_rec_t)) == 0);
+}
+
+static void make_communication (paraver_rec_t *r, RecordType type,
+	unsigned long long time)
+{
+	memset (r, 0, sizeof(paraver_rec_t));
+	r->type = type;
+	r->time = time;
+	r->end_time = time + rand() % 100;
+	r->receive[LOGICAL_COMMUNICATION] = time + rand() % 1000;
+	r->receive[PHYSICAL_COMMUNICATION] = time + rand() % 2000;
+	r->value = rand() % 64;
+	r->event = rand() % 65536;
+	r->cpu = 1;
+	r->ptask = 1;
+	r->task = 1;
+	r->thread = 1 + rand() % 2;
+	r->cpu_r = 2;
+	r->ptask_r = 1;
+	r->task_r = 2 + rand() % 16;
+	r->thread_r = 1;
+}
+
+static void check_records (unsigned n)
+{
+	char name[] = "/tmp/paraver_records.XXXXXX";
+	paraver_rec_t *ref, rec, patch;
+	off_t *position, state_position = 0;
+	unsigned i, state = 0, pending = 0, *pending_idx;
+	unsigned long long time = 1000000;
+	WriteFileBuffer_t *wfb;
+	paraver_rec_context_t ctx;
+	unsigned char chunk[1000];
+	size_t begin = 0, end = 0, used;
+	off_t size;
+	int fd;
+
+	ref = malloc (n * sizeof(paraver_rec_t));
+	position = malloc (n * sizeof(off_t));
+	pending_idx = malloc (n * sizeof(unsigned));
+	assert (ref != NULL && position != NULL && pending_idx != NULL);
+
+	fd = mkstemp (name);
+	assert (fd >= 0);
+	/* A small buffer, so that rewrites hit both the file and the buffer */
+	wfb = WriteFileBuffer_new (fd, name, 16, sizeof(paraver_rec_t));
+
+	for (i = 0; i < n; i++)
+	{
+		int what = rand() % 10;
+
+		time += rand() % 3 ? rand() % 5000 : 0;
+		position[i] = WriteFileBuffer_getPosition (wfb);
+
+		if (what == 0 || i == 0)
+		{
+			/* Close the previous state and start a new one */
+			if (i > 0)
+			{
+				patch = ref[state];
+				patch.type = STATE;
+				patch.end_time = time;
+				WriteFileBuffer_writeAt (wfb, &patch, state_position);
+				ref[state] = patch;
+			}
+			memset (&rec, 0, sizeof(rec));
+			rec.type = UNFINISHED_STATE;
+			rec.time = time;
+			rec.value = rand() % 20;
+			rec.cpu = rec.ptask = rec.task = 1;
+			rec.thread = 1 + rand() % 2;
+			state = i;
+			state_position = position[i];
+		}
+		else if (what == 1)
+		{
+			/* Unmatched now, some of them matched later */
+			make_communication (&rec, UNMATCHED_COMMUNICATION, time);
+			pending_idx[pending++] = i;
+		}
+		else if (what == 2)
+			make_communication (&rec, COMMUNICATION, time);
+		else
+		{
+			memset (&rec, 0, sizeof(rec));
+			rec.type = EVENT;
+			rec.time = time;
+			rec.event = 50000000 + rand() % 100;
+			rec.value = rand() % 4 ? (UINT64) (rand() % 100) : ((UINT64) rand() << 32);
+			rec.cpu = rec.ptask = rec.task = 1;
+			rec.thread = 1 + rand() % 2;
+		}
+
+		ref[i] = rec;
+		WriteFileBuffer_write (wfb, &rec);
+
+		if (pending > 0 && rand() % 4 == 0)
+		{
+			unsigned j = rand() % pending;
+			unsigned k = pending_idx[j];
+
+			patch = ref[k];
+			patch.type = COMMUNICATION;
+			patch.cpu = 3;
+			patch.receive[LOGICAL_COMMUNICATION] = time + 1;
+			patch.receive[PHYSICAL_COMMUNICATION] = time + 2;
+			WriteFileBuffer_writeAt (wfb, &patch, position[k]);
+			ref[k] = patch;
+			pending_idx[j] = pending_idx[--pending];
+		}
+	}
+	WriteFileBuffer_flush (wfb);
+	assert (WriteFileBuffer_getNumRecords (wfb) == n);
+
+	/* Receives are also matched directly on the file (see MatchRecv) */
+	for (i = 0; i < pending; i++)
+	{
+		unsigned long long receives[NUM_COMMUNICATION_TYPE] = { 7, 8 };
+		ssize_t res;
+
+		res = pwrite (fd, receives, sizeof(receives),
+		  position[pending_idx[i]] + PRV_RECORD_RECEIVE_OFFSET);
+		assert (res == sizeof(receives));
+		ref[pending_idx[i]].receive[LOGICAL_COMMUNICATION] = 7;
+		ref[pending_idx[i]].receive[PHYSICAL_COMMUNICATION] = 8;
+	}
+
+	/* Read everything back in small chunks, so that records get split */
+	size = lseek (fd, 0, SEEK_END);
+	lseek (fd, 0, SEEK_SET);
+	ParaverRecord_InitContext (&ctx);
+	for (i = 0; i < n; )
+	{
+		used = ParaverRecord_Decode (&ctx, &chunk[begin], end - begin, &rec);
+		if (used > 0)
+		{
+			same_record (&ref[i], &rec);
+			begin += used;
+			i++;
+		}
+		else
+		{
+			ssize_t res;
+
+			memmove (chunk, &chunk[begin], end - begin);
+			end -= begin;
+			begin = 0;
+			res = read (fd, &chunk[end], sizeof(chunk) - end);
+			assert (res > 0);
+			end += res;
+		}
+	}
+	assert (begin == end && read (fd, chunk, 1) == 0);
+
+	fprintf (stdout, "%u records: %lld bytes encoded, %llu bytes as paraver_rec_t (%.2fx)\n",
+	  n, (long long) size, (unsigned long long) n * sizeof(paraver_rec_t),
+	  ((double) n * sizeof(paraver_rec_t)) / size);
+
+	WriteFileBuffer_delete (wfb);
+	free (pending_idx);
+	free (position);
+	free (ref);
+}
+
+int main (int argc, char *argv[])
+{
+	unsigned n = (argc > 1) ? atoi(argv[1]) : 100000;
+
+	srand (1);
+	check_records (n);
+
+	return 0;
+}
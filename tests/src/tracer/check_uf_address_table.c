@@ -0,0 +1,141 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks the table of user functions of the GCC instrumentation: every
+   address of the list is found (neither the Bloom filter nor the cuckoo
+   table has false negatives), addresses out of the list are not, and a list
+   whose insertions cannot settle makes the table be rebuilt with another
+   seed without losing any address. */
+
+#include "common.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "UF_address_table.h"
+
+#define N 100000
+
+static void * address_of (unsigned u)
+{
+	/* Routines are spread over the text segment, 16-byte aligned */
+	return (void*) (uintptr_t) (0x400000UL + 16UL * u);
+}
+
+static void check_membership (void)
+{
+	void **list = malloc (N * sizeof(void *));
+	UF_address_table_t *t;
+	unsigned u, maybe = 0;
+
+	assert (list != NULL);
+
+	/* Take every other routine, the rest are not in the list */
+	for (u = 0; u < N; u++)
+		list[u] = address_of (2 * u);
+
+	t = UF_address_table_new (list, N);
+	assert (t->count == N);
+
+	for (u = 0; u < N; u++)
+	{
+		assert (UF_address_table_maybe (t, address_of (2 * u)));
+		assert (UF_address_table_lookup (t, address_of (2 * u)));
+		assert (!UF_address_table_lookup (t, address_of (2 * u + 1)));
+		maybe += UF_address_table_maybe (t, address_of (2 * u + 1));
+	}
+	assert (!UF_address_table_lookup (t, NULL));
+
+	/* The filter has to reject most of the routines out of the list */
+	printf ("Bloom filter false positives: %.2f%%\n", (100.0 * maybe) / N);
+	assert (maybe < N / 4);
+
+	UF_address_table_free (t);
+	free (list);
+}
+
+static void check_duplicates (void)
+{
+	void *list[6];
+	UF_address_table_t *t;
+
+	list[0] = list[3] = address_of (1);
+	list[1] = list[4] = address_of (2);
+	list[2] = list[5] = address_of (3);
+
+	t = UF_address_table_new (list, 6);
+	assert (t->count == 3);
+	assert (UF_address_table_lookup (t, address_of (1)));
+	assert (UF_address_table_lookup (t, address_of (2)));
+	assert (UF_address_table_lookup (t, address_of (3)));
+	assert (!UF_address_table_lookup (t, address_of (4)));
+	UF_address_table_free (t);
+
+	/* Without a table (nothing to trace) nothing is found */
+	assert (!UF_address_table_lookup (NULL, address_of (1)));
+}
+
+/* Three addresses sharing both their slots with the first seed cannot be
+   placed in a table with two slots for them */
+static void check_rebuild (void)
+{
+	void *list[3];
+	UF_address_table_t *t;
+	uint64_t seed = UF_ADDRESS_TABLE_SEED(0), h, key = 0;
+	unsigned u, found = 0;
+
+	/* The smallest table has 16 slots per half */
+	for (u = 0; found < 3; u++)
+	{
+		h = UF_address_table_hash (seed, address_of (u));
+		h = (h & 15) | (((h >> 32) & 15) << 4);
+		if (found == 0)
+			key = h;
+		if (h == key)
+			list[found++] = address_of (u);
+	}
+
+	t = UF_address_table_new (list, 3);
+	printf ("Rebuilds for 3 colliding addresses: %u\n", t->rebuilds);
+	assert (t->rebuilds > 0);
+	assert (t->count == 3);
+	for (u = 0; u < 3; u++)
+	{
+		assert (UF_address_table_maybe (t, list[u]));
+		assert (UF_address_table_lookup (t, list[u]));
+	}
+	UF_address_table_free (t);
+}
+
+int main (int argc, char *argv[])
+{
+	UNREFERENCED_PARAMETER(argc);
+	UNREFERENCED_PARAMETER(argv);
+
+	check_membership ();
+	check_duplicates ();
+	check_rebuild ();
+
+	return 0;
+}
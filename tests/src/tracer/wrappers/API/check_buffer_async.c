@@ -0,0 +1,189 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks that a buffer flushed asynchronously writes every event exactly
+   once and that the file decodes back, while a second thread hands off more
+   events than fit in the handoff area whenever a write is in flight (the
+   synchronous writes must not overlap the asynchronous one).
+   Usage: buffer_async [events] */
+
+#include "common.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "record.h"
+#include "buffers.h"
+#include "mpit_header.h"
+#include "mpit_events.h"
+
+#define BUFFER_SIZE 100000
+#define OWNER_EV   1
+#define HANDOFF_EV 2
+
+static Buffer_t *buffer;
+static volatile UINT64 clock_time = 0;
+static volatile int owner_done = FALSE;
+static volatile int owner_paused = FALSE;
+static unsigned handed_off = 0;
+
+static void make_event (event_t *event, int type, UINT64 value)
+{
+	memset (event, 0, sizeof(event_t));
+	event->time = __sync_fetch_and_add (&clock_time, 1);
+	event->event = type;
+	event->value = value;
+}
+
+/* Hands off a burst of events (more than fit in the handoff area) every
+   time the owner pauses, which is right after it started a write */
+static void * handoff_thread (void *arg)
+{
+	event_t event;
+	int i;
+	UNREFERENCED_PARAMETER(arg);
+
+	while (!owner_done)
+	{
+		if (owner_paused)
+		{
+			for (i = 0; i < 2 * BUFFER_HANDOFF_SIZE; i++)
+			{
+				make_event (&event, HANDOFF_EV, handed_off++);
+				Buffer_HandoffSingle (buffer, &event);
+			}
+			owner_paused = FALSE;
+		}
+	}
+	return NULL;
+}
+
+static void check_file (char *file, unsigned events)
+{
+	unsigned char *seen_owner = calloc (events, 1);
+	unsigned char *seen_handoff = calloc (handed_off, 1);
+	unsigned char *data = NULL;
+	event_t *decoded = NULL;
+	size_t data_size = 0, decoded_size = 0;
+	unsigned u, total = 0;
+	MPIT_Block_t header;
+	int fd = open (file, O_RDONLY);
+
+	assert (fd >= 0 && seen_owner != NULL && seen_handoff != NULL);
+	assert (MPIT_Header_Version (fd) == MPIT_VERSION_COMPACT);
+	lseek (fd, sizeof(MPIT_Header_t), SEEK_SET);
+
+	while (read (fd, &header, sizeof(header)) == sizeof(header))
+	{
+		if (header.Size > data_size)
+		{
+			data_size = header.Size;
+			data = realloc (data, data_size);
+		}
+		if (header.NumEvents > decoded_size)
+		{
+			decoded_size = header.NumEvents;
+			decoded = realloc (decoded, decoded_size * sizeof(event_t));
+		}
+		assert (read (fd, data, header.Size) == (ssize_t) header.Size);
+		assert (MPIT_Events_Decode (&header, data, decoded) == 0);
+
+		for (u = 0; u < header.NumEvents; u++)
+		{
+			if (decoded[u].event == OWNER_EV)
+			{
+				assert (decoded[u].value < events && !seen_owner[decoded[u].value]);
+				seen_owner[decoded[u].value] = TRUE;
+			}
+			else
+			{
+				assert (decoded[u].event == HANDOFF_EV);
+				assert (decoded[u].value < handed_off && !seen_handoff[decoded[u].value]);
+				seen_handoff[decoded[u].value] = TRUE;
+			}
+			total++;
+		}
+	}
+	assert (total == events + handed_off);
+
+	close (fd);
+	free (seen_owner);
+	free (seen_handoff);
+	free (data);
+	free (decoded);
+}
+
+int main (int argc, char *argv[])
+{
+	char file[] = "/tmp/buffer_async.XXXXXX";
+	unsigned u, events = 1000000;
+	pthread_t thread;
+	event_t event;
+	int fd;
+
+	if (argc > 1)
+		events = atoi (argv[1]);
+
+	fd = mkstemp (file);
+	assert (fd >= 0);
+	close (fd);
+
+	buffer = new_Buffer (BUFFER_SIZE, file, FALSE);
+	Buffer_SetFlushCallback (buffer, Buffer_Flush);
+	if (!Buffer_EnableAsyncFlush (buffer))
+	{
+		/* Asynchronous flushes are not supported in this installation */
+		Buffer_Free (buffer);
+		unlink (file);
+		return 77;
+	}
+
+	pthread_create (&thread, NULL, handoff_thread, NULL);
+	for (u = 0; u < events; u++)
+	{
+		make_event (&event, OWNER_EV, u);
+		Buffer_InsertSingle (buffer, &event);
+
+		/* The write of the first half starts once it fills up */
+		if (u % BUFFER_SIZE == BUFFER_SIZE / 2 - 1)
+		{
+			owner_paused = TRUE;
+			while (owner_paused);
+		}
+	}
+	owner_done = TRUE;
+	pthread_join (thread, NULL);
+
+	Buffer_Flush (buffer);
+	Buffer_Close (buffer);
+	Buffer_Free (buffer);
+
+	check_file (file, events);
+	unlink (file);
+
+	return 0;
+}
@@ -0,0 +1,238 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks that the events handed off into a buffer by other threads are moved
+   into it with their own time (before the event that made the owner attend
+   them if they happened earlier), both in fixed cases and while a second
+   thread hands off events as the owner keeps inserting, without losing any.
+   Usage: buffer_handoff [events] */
+
+#include "common.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "record.h"
+#include "buffers.h"
+
+#if defined(LOCKLESS_INSERT)
+
+static Buffer_t *buffer;
+static volatile UINT64 clock_time = 0;
+static volatile int owner_done = FALSE;
+static int handed_off = 0;
+
+static void make_event (event_t *event, UINT64 time)
+{
+	memset (event, 0, sizeof(event_t));
+	event->time = time;
+	event->event = 1;
+}
+
+static void insert (UINT64 time)
+{
+	event_t event;
+	make_event (&event, time);
+	Buffer_InsertSingle (buffer, &event);
+}
+
+static void handoff (UINT64 time)
+{
+	event_t event;
+	make_event (&event, time);
+	Buffer_HandoffSingle (buffer, &event);
+}
+
+static void check_contents (UINT64 *expected, int n)
+{
+	BufferIterator_t *it = BIT_NewForward (buffer);
+	int i = 0;
+
+	while (!BIT_OutOfBounds(it))
+	{
+		assert (i < n);
+		assert (Get_EvTime(BIT_GetEvent(it)) == expected[i]);
+		i++;
+		BIT_Next (it);
+	}
+	assert (i == n);
+	BIT_Free (it);
+}
+
+static void check_fixed_cases (void)
+{
+	UINT64 first[] = { 10, 20, 15, 16, 30 };
+	UINT64 second[] = { 10, 20, 15, 16, 30, 35, 40, 50 };
+
+	buffer = new_Buffer (100, NULL, FALSE);
+
+	/* Handed off before the new event, older than the last one */
+	insert (10);
+	insert (20);
+	handoff (15);
+	handoff (16);
+	insert (30);
+	check_contents (first, 5);
+
+	/* Handed off after the new event */
+	handoff (40);
+	insert (35);
+	insert (50);
+	check_contents (second, 8);
+
+	Buffer_Free (buffer);
+}
+
+static void * handoff_thread (void *arg)
+{
+	UNREFERENCED_PARAMETER(arg);
+
+	while (!owner_done)
+	{
+		/* Do not let the handoff area fill up, there is no file to write it */
+		if (buffer->NumHandoffEvents < BUFFER_HANDOFF_SIZE)
+		{
+			handoff (__sync_fetch_and_add (&clock_time, 1));
+			handed_off++;
+		}
+	}
+	return NULL;
+}
+
+static int compare_times (const void *a, const void *b)
+{
+	UINT64 t1 = *(const UINT64 *) a, t2 = *(const UINT64 *) b;
+
+	return (t1 < t2) ? -1 : (t1 > t2);
+}
+
+static void check_concurrent (int events)
+{
+	pthread_t thread;
+	BufferIterator_t *it;
+	UINT64 *times;
+	int i, count = 0;
+
+	buffer = new_Buffer (4 * events, NULL, FALSE);
+	pthread_create (&thread, NULL, handoff_thread, NULL);
+
+	for (i = 0; i < events; i++)
+		insert (__sync_fetch_and_add (&clock_time, 1));
+	owner_done = TRUE;
+	pthread_join (thread, NULL);
+
+	/* Attend the last events handed off */
+	insert (__sync_fetch_and_add (&clock_time, 1));
+
+	/* Every time taken from the clock is in the buffer exactly once */
+	times = malloc (clock_time * sizeof(UINT64));
+	assert (times != NULL);
+	it = BIT_NewForward (buffer);
+	while (!BIT_OutOfBounds(it))
+	{
+		assert (count < (int) clock_time);
+		times[count++] = Get_EvTime(BIT_GetEvent(it));
+		BIT_Next (it);
+	}
+	BIT_Free (it);
+	assert (count == events + 1 + handed_off);
+	assert (count == (int) clock_time);
+
+	qsort (times, count, sizeof(UINT64), compare_times);
+	for (i = 0; i < count; i++)
+		assert (times[i] == (UINT64) i);
+	free (times);
+
+	Buffer_Free (buffer);
+}
+
+#if defined(HAVE_ONLINE)
+static void * owner_thread (void *arg)
+{
+	UNREFERENCED_PARAMETER(arg);
+
+	while (!owner_done)
+		insert (__sync_fetch_and_add (&clock_time, 1));
+	return NULL;
+}
+
+/* While the buffer is locked (the on-line analysis pauses the application),
+   the owner must not insert anything, not even an insertion that had already
+   started when the buffer was locked */
+static void check_pause (void)
+{
+	pthread_t thread;
+	event_t *tail;
+	int i, fill;
+
+	buffer = new_Buffer (1000, NULL, FALSE);
+	Buffer_SetFlushCallback (buffer, CALLBACK_OVERWRITE);
+	owner_done = FALSE;
+	pthread_create (&thread, NULL, owner_thread, NULL);
+
+	for (i = 0; i < 100; i++)
+	{
+		Buffer_Lock (buffer);
+		tail = Buffer_GetTail (buffer);
+		fill = Buffer_GetFillCount (buffer);
+		usleep (100);
+		assert (tail == Buffer_GetTail (buffer));
+		assert (fill == Buffer_GetFillCount (buffer));
+		Buffer_Unlock (buffer);
+		usleep (100);
+	}
+	owner_done = TRUE;
+	pthread_join (thread, NULL);
+
+	Buffer_Free (buffer);
+}
+#endif
+
+int main (int argc, char *argv[])
+{
+	int events = 100000;
+
+	if (argc > 1)
+		events = atoi (argv[1]);
+
+	check_fixed_cases ();
+	check_concurrent (events);
+#if defined(HAVE_ONLINE)
+	check_pause ();
+#endif
+
+	return 0;
+}
+
+#else
+
+int main (void)
+{
+	/* Events are only handed off with the lock-free insertion */
+	return 77;
+}
+
+#endif
@@ -0,0 +1,186 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks that the range iterators created through the time index of the
+   buffers have the same bounds as the ones found walking the buffer, while
+   the buffer wraps around, discards events and receives events out of time
+   order, and times both ways of creating them on a large buffer.
+   Usage: buffer_range [events] */
+
+#include "common.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "record.h"
+#include "buffers.h"
+
+static double now (void)
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static UINT64 clock_time = 1000000;
+
+/* Mostly increasing times, with some events stamped a while ago */
+static void next_event (event_t *event)
+{
+	memset (event, 0, sizeof(event_t));
+	clock_time += rand() % 10;
+	event->time = clock_time;
+	if (rand() % 20 == 0)
+		event->time -= rand() % 3000;
+	if (rand() % 5000 == 0)
+		event->time = rand() % 1000000;
+	event->event = 1;
+}
+
+static void compare_ranges (Buffer_t *indexed, Buffer_t *plain,
+	unsigned long long from, unsigned long long to)
+{
+	BufferIterator_t *it1 = BIT_NewRange (indexed, from, to);
+	BufferIterator_t *it2 = BIT_NewRange (plain, from, to);
+
+	assert (BIT_OutOfBounds(it1) == BIT_OutOfBounds(it2));
+	if (!BIT_OutOfBounds(it1))
+	{
+		assert (it1->StartBound - indexed->FirstEvt == it2->StartBound - plain->FirstEvt);
+		assert (it1->EndBound - indexed->FirstEvt == it2->EndBound - plain->FirstEvt);
+		assert (it1->CurrentElement - indexed->FirstEvt == it2->CurrentElement - plain->FirstEvt);
+	}
+
+	BIT_Free (it1);
+	BIT_Free (it2);
+}
+
+static void compare_some_ranges (Buffer_t *indexed, Buffer_t *plain)
+{
+	unsigned i;
+
+	compare_ranges (indexed, plain, 0, clock_time);
+	compare_ranges (indexed, plain, clock_time + 1, clock_time + 2);
+	for (i = 0; i < 20; i++)
+	{
+		unsigned long long from = clock_time - rand() % 20000;
+		unsigned long long to = from + rand() % 5000;
+		compare_ranges (indexed, plain, from, to);
+	}
+}
+
+static void check_against_linear (int size)
+{
+	Buffer_t *indexed = new_Buffer (size, NULL, FALSE);
+	Buffer_t *plain = new_Buffer (size, NULL, FALSE);
+	event_t event;
+	int i;
+
+	/* Overwrite the oldest events when full, like circular buffering */
+	Buffer_SetFlushCallback (indexed, Buffer_DiscardOldest);
+	Buffer_SetFlushCallback (plain, Buffer_DiscardOldest);
+
+	compare_some_ranges (indexed, plain);
+
+	for (i = 0; i < 20 * size; i++)
+	{
+		/* Index the events already there once the buffer got going */
+		if (i == size / 2)
+			Buffer_EnableTimeIndex (indexed);
+
+		next_event (&event);
+		Buffer_InsertSingle (indexed, &event);
+		Buffer_InsertSingle (plain, &event);
+
+		if (rand() % (size / 4 + 1) == 0)
+			compare_some_ranges (indexed, plain);
+
+		if (rand() % (4 * size) == 0)
+		{
+			Buffer_Discard10Pct (indexed);
+			Buffer_Discard10Pct (plain);
+		}
+		else if (rand() % (8 * size) == 0)
+		{
+			Buffer_DiscardAll (indexed);
+			Buffer_DiscardAll (plain);
+		}
+	}
+	compare_some_ranges (indexed, plain);
+
+	Buffer_Free (indexed);
+	Buffer_Free (plain);
+}
+
+static double time_ranges (Buffer_t *buffer, unsigned queries)
+{
+	double start = now();
+	unsigned i;
+
+	for (i = 0; i < queries; i++)
+	{
+		unsigned long long from = clock_time - rand() % 1000000;
+		BIT_Free (BIT_NewRange (buffer, from, from + 1000));
+	}
+	return now() - start;
+}
+
+int main (int argc, char *argv[])
+{
+	int sizes[] = { 1, 100, 256, 1000, 1024, 5000 };
+	int events = 1000000;
+	unsigned i;
+	Buffer_t *indexed, *plain;
+	event_t event;
+	double t_indexed, t_plain;
+
+	if (argc > 1)
+		events = atoi (argv[1]);
+
+	srand (7);
+	for (i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++)
+		check_against_linear (sizes[i]);
+
+	indexed = new_Buffer (events, NULL, FALSE);
+	plain = new_Buffer (events, NULL, FALSE);
+	Buffer_EnableTimeIndex (indexed);
+	for (i = 0; i < (unsigned) events; i++)
+	{
+		next_event (&event);
+		Buffer_InsertSingle (indexed, &event);
+		Buffer_InsertSingle (plain, &event);
+	}
+	compare_some_ranges (indexed, plain);
+
+	t_indexed = time_ranges (indexed, 10);
+	t_plain = time_ranges (plain, 10);
+	printf ("10 range iterators over %d events: %.6f s with the time index, %.6f s walking the buffer\n",
+	  events, t_indexed, t_plain);
+
+	Buffer_Free (indexed);
+	Buffer_Free (plain);
+
+	return 0;
+}
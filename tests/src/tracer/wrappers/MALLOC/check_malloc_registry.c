@@ -0,0 +1,173 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks the registry of tracked allocations against a linear reference
+   (adding, replacing sizes, removing in random order and growing the shards
+   past their initial size), and times several threads adding and removing
+   their own allocations concurrently.
+   Usage: malloc_registry [allocations_per_thread] */
+
+#include "common.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "malloc_registry.h"
+
+#define NTHREADS 4
+
+static Extrae_MallocRegistry_t registry;
+static unsigned per_thread = 200000;
+
+static double now (void)
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void check_against_reference (void)
+{
+	unsigned n = 50000, u, live = 0;
+	char **ptrs = malloc (n * sizeof(char *));
+	size_t *sizes = malloc (n * sizeof(size_t));
+	char *base = malloc (n * 16);
+	size_t size;
+
+	assert (ptrs != NULL && sizes != NULL && base != NULL);
+
+	Extrae_MallocRegistry_Init (&registry, malloc, free);
+	assert (Extrae_MallocRegistry_Count (&registry) == 0);
+	assert (!Extrae_MallocRegistry_Remove (&registry, base, NULL));
+
+	/* Addresses 16 bytes apart, like the ones returned by malloc */
+	for (u = 0; u < n; u++)
+	{
+		ptrs[u] = base + u * 16;
+		sizes[u] = u + 1;
+		Extrae_MallocRegistry_Add (&registry, ptrs[u], sizes[u]);
+	}
+	assert (Extrae_MallocRegistry_Count (&registry) == n);
+
+	/* Adding an address twice just updates its size */
+	for (u = 0; u < n; u += 3)
+	{
+		sizes[u] *= 2;
+		Extrae_MallocRegistry_Add (&registry, ptrs[u], sizes[u]);
+	}
+	assert (Extrae_MallocRegistry_Count (&registry) == n);
+
+	/* Remove half of them in random order, the rest must still be found */
+	srand (1);
+	for (u = 0; u < n / 2; u++)
+	{
+		unsigned i = rand() % n;
+
+		if (ptrs[i] != NULL)
+		{
+			assert (Extrae_MallocRegistry_Remove (&registry, ptrs[i], &size));
+			assert (size == sizes[i]);
+			assert (!Extrae_MallocRegistry_Remove (&registry, ptrs[i], NULL));
+			ptrs[i] = NULL;
+		}
+	}
+	for (u = 0; u < n; u++)
+		if (ptrs[u] != NULL)
+			live++;
+	assert (Extrae_MallocRegistry_Count (&registry) == live);
+
+	for (u = 0; u < n; u++)
+		if (ptrs[u] != NULL)
+		{
+			assert (Extrae_MallocRegistry_Remove (&registry, ptrs[u], &size));
+			assert (size == sizes[u]);
+		}
+	assert (Extrae_MallocRegistry_Count (&registry) == 0);
+
+	Extrae_MallocRegistry_Destroy (&registry);
+	free (base);
+	free (sizes);
+	free (ptrs);
+}
+
+static void * worker (void *arg)
+{
+	char *base = (char *) arg;
+	unsigned u;
+
+	for (u = 0; u < per_thread; u++)
+		Extrae_MallocRegistry_Add (&registry, base + u * 16, u);
+	for (u = 0; u < per_thread; u++)
+	{
+		size_t size;
+
+		assert (Extrae_MallocRegistry_Remove (&registry, base + u * 16, &size));
+		assert (size == u);
+	}
+
+	return NULL;
+}
+
+static void time_concurrent (void)
+{
+	pthread_t threads[NTHREADS];
+	char *bases[NTHREADS];
+	double begin, end;
+	long t;
+
+	Extrae_MallocRegistry_Init (&registry, malloc, free);
+
+	for (t = 0; t < NTHREADS; t++)
+	{
+		bases[t] = malloc (per_thread * 16);
+		assert (bases[t] != NULL);
+	}
+
+	begin = now();
+	for (t = 0; t < NTHREADS; t++)
+		pthread_create (&threads[t], NULL, worker, bases[t]);
+	for (t = 0; t < NTHREADS; t++)
+		pthread_join (threads[t], NULL);
+	end = now();
+
+	assert (Extrae_MallocRegistry_Count (&registry) == 0);
+	printf ("%d threads x %u allocations added and removed in %.3f s\n",
+	  NTHREADS, per_thread, end - begin);
+
+	for (t = 0; t < NTHREADS; t++)
+		free (bases[t]);
+	Extrae_MallocRegistry_Destroy (&registry);
+}
+
+int main (int argc, char *argv[])
+{
+	if (argc > 1)
+		per_thread = atoi (argv[1]);
+
+	check_against_reference ();
+	time_concurrent ();
+
+	return 0;
+}
@@ -0,0 +1,178 @@
+/*****************************************************************************\
+ *                        ANALYSIS PERFORMANCE TOOLS                         *
+ *                                   Extrae                                  *
+ *              Instrumentation package for parallel applications            *
+ *****************************************************************************
+ *     ___     This library is free software; you can redistribute it and/or *
+ *    /  __         modify it under the terms of the GNU LGPL as published   *
+ *   /  /  _____    by the Free Software Foundation; either version 2.1      *
+ *  /  /  /     \   of the License, or (at your option) any later version.   *
+ * (  (  ( B S C )                                                           *
+ *  \  \  \_____/   This library is distributed in hope that it will be      *
+ *   \  \__         useful but WITHOUT ANY WARRANTY; without even the        *
+ *    \___          implied warranty of MERCHANTABILITY or FITNESS FOR A     *
+ *                  PARTICULAR PURPOSE. See the GNU LGPL for more details.   *
+ *                                                                           *
+ * You should have received a copy of the GNU Lesser General Public License  *
+ * along with this library; if not, write to the Free Software Foundation,   *
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA          *
+ * The GNU LEsser General Public License is contained in the file COPYING.   *
+ *                                 ---------                                 *
+ *   Barcelona Supercomputing Center - Centro Nacional de Supercomputacion   *
+\*****************************************************************************/
+
+/* Checks the per-thread table of the contention-only mode of the pthread
+   locks: uncontended and contended acquisitions and the time waiting, the
+   time held by nested acquisitions and across a condition wait (which
+   releases and takes the mutex again without a new acquisition), releases
+   of locks that were never accounted, the reset after a summary keeping the
+   locks held, and the growth of the table past its initial size. */
+
+#include "common.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pthread_lock_table.h"
+#include "pthread_lock_stats.h"
+
+#define NLOCKS 1000
+
+static lock_stats_entry_t * entry_of (lock_stats_thread_t *t, void *lock)
+{
+	lock_stats_entry_t *e = Lock_Table_Lookup (t, lock);
+
+	assert (e != NULL);
+	return e;
+}
+
+static void check_contention (void)
+{
+	lock_stats_thread_t t;
+	lock_stats_entry_t *e;
+	int m;
+
+	memset (&t, 0, sizeof(t));
+
+	/* Two uncontended acquisitions held 10 and 20 */
+	Lock_Table_Acquired (&t, &m, LOCK_STATS_MUTEX, (void*) 0x10, FALSE, 0, 100);
+	Lock_Table_Released (&t, &m, 110);
+	Lock_Table_Acquired (&t, &m, LOCK_STATS_MUTEX, (void*) 0x20, FALSE, 0, 200);
+	Lock_Table_Released (&t, &m, 220);
+
+	/* A contended one that waited from 300 to 350 and was held 5 */
+	Lock_Table_Acquired (&t, &m, LOCK_STATS_MUTEX, (void*) 0x30, TRUE, 300, 350);
+	Lock_Table_Released (&t, &m, 355);
+
+	e = entry_of (&t, &m);
+	assert (e->acquisitions == 3);
+	assert (e->contended == 1);
+	assert (e->wait_time == 50);
+	assert (e->hold_time == 35);
+	assert (e->depth == 0);
+	/* The call site is the one of the first contended acquisition */
+	assert (e->caller == (void*) 0x30);
+	assert (t.num_dirty == 1);
+}
+
+static void check_nested_and_condition_wait (void)
+{
+	lock_stats_thread_t t;
+	lock_stats_entry_t *e;
+	int m, l;
+
+	memset (&t, 0, sizeof(t));
+
+	/* A recursive mutex is held from the outermost acquisition to its release */
+	Lock_Table_Acquired (&t, &m, LOCK_STATS_MUTEX, NULL, FALSE, 0, 100);
+	Lock_Table_Acquired (&t, &m, LOCK_STATS_MUTEX, NULL, FALSE, 0, 120);
+	Lock_Table_Released (&t, &m, 130);
+	Lock_Table_Released (&t, &m, 150);
+	e = entry_of (&t, &m);
+	assert (e->acquisitions == 2);
+	assert (e->hold_time == 50);
+
+	/* pthread_cond_wait releases the mutex at 220 and takes it back at 500,
+	   the time waiting for the condition is not held */
+	Lock_Table_Acquired (&t, &l, LOCK_STATS_MUTEX, NULL, FALSE, 0, 200);
+	Lock_Table_Released (&t, &l, 220);
+	Lock_Table_Resumed (&t, &l, 500);
+	Lock_Table_Released (&t, &l, 530);
+	e = entry_of (&t, &l);
+	assert (e->acquisitions == 1);
+	assert (e->contended == 0);
+	assert (e->hold_time == 50);
+	assert (e->depth == 0);
+
+	/* Releasing (or resuming) a lock never acquired is ignored */
+	Lock_Table_Released (&t, (void*) &t, 600);
+	Lock_Table_Resumed (&t, (void*) &t, 600);
+	assert (Lock_Table_Lookup (&t, (void*) &t) == NULL);
+	/* Releasing more than acquired is ignored too */
+	Lock_Table_Released (&t, &l, 700);
+	assert (entry_of (&t, &l)->hold_time == 50);
+}
+
+static void check_reset (void)
+{
+	lock_stats_thread_t t;
+	lock_stats_entry_t *e;
+	int m;
+
+	memset (&t, 0, sizeof(t));
+
+	/* The summary is emitted while the lock is held since 100 */
+	Lock_Table_Acquired (&t, &m, LOCK_STATS_MUTEX, NULL, TRUE, 90, 100);
+	Lock_Table_Reset (&t);
+	e = entry_of (&t, &m);
+	assert (t.num_dirty == 0 && !e->dirty);
+	assert (e->acquisitions == 0 && e->contended == 0 && e->wait_time == 0);
+	assert (e->depth == 1);
+
+	/* The release is accounted into the next summary */
+	Lock_Table_Released (&t, &m, 160);
+	assert (t.num_dirty == 1 && e->dirty);
+	assert (e->acquisitions == 0);
+	assert (e->hold_time == 60);
+}
+
+static void check_growth (void)
+{
+	lock_stats_thread_t t;
+	static int locks[NLOCKS];
+	int i;
+
+	memset (&t, 0, sizeof(t));
+
+	for (i = 0; i < NLOCKS; i++)
+		Lock_Table_Acquired (&t, &locks[i], LOCK_STATS_RWLOCK_RD, NULL, i % 2, 0, i);
+	for (i = 0; i < NLOCKS; i++)
+		Lock_Table_Released (&t, &locks[i], 2 * i);
+
+	assert (t.num_locks == NLOCKS);
+	assert (t.num_dirty == NLOCKS);
+	assert (2 * t.num_locks <= t.index_mask + 1);
+	for (i = 0; i < NLOCKS; i++)
+	{
+		lock_stats_entry_t *e = entry_of (&t, &locks[i]);
+
+		assert (e->lock == &locks[i]);
+		assert (e->kind == LOCK_STATS_RWLOCK_RD);
+		assert (e->acquisitions == 1);
+		assert (e->contended == (unsigned) (i % 2));
+		assert (e->hold_time == (unsigned) i);
+	}
+}
+
+int main (int argc, char *argv[])
+{
+	UNREFERENCED_PARAMETER(argc);
+	UNREFERENCED_PARAMETER(argv);
+
+	check_contention ();
+	check_nested_and_condition_wait ();
+	check_reset ();
+	check_growth ();
+
+	return 0;
+}